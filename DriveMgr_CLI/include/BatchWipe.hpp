@@ -0,0 +1,87 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DmgrLib.h"
+#include "WipeEngine.hpp"
+
+// ========== Batch wipe ==========
+
+/**
+ * @brief Tuning knobs of a BatchWipe run
+ */
+struct BatchWipeOptions {
+    WipeEngine::Scheme scheme = WipeEngine::Scheme::RandomZero;
+    unsigned per_bus = 0;                   ///< wipes running at once behind one controller or USB hub, 0 = 8 per controller, 2 per hub
+    size_t sample_blocks = 1024;            ///< random blocks of the statistical check, each one is hashed into the certificate
+    std::string certificate_dir;            ///< empty = dmgr_root/data/certificates
+};
+
+/**
+ * @brief Wipes several drives at once, e.g. all disks of a server that is decommissioned.
+ *
+ * Every drive runs the WipeEngine passes of the scheme on its own thread and keeps its own wipe
+ * journal, so an interrupted drive can be continued with --resume like a single wipe. Drives are
+ * grouped by the controller (PCI function) or USB hub they hang off in the sysfs device tree, and
+ * only per_bus of a group run at the same time so a shared link isnt split between too many drives.
+ *
+ * A finished drive gets a certificate: device identity, scheme, seed, timestamps, the confidence of
+ * the statistical check (WipeEngine::sampleVerify) and the SHA-256 of every block it read back.
+ */
+class BatchWipe {
+public:
+    using Options = BatchWipeOptions;
+
+    struct DriveResult {
+        std::string target;
+        std::string bus;                        ///< sysfs path of the controller or hub
+        bool success = false;
+        uint64_t bytes = 0;
+        double seconds = 0.0;
+        WipeEngine::SampleResult check;         ///< the statistical check after the passes
+        std::string certificate;                ///< path of the written certificate, empty on failure
+        std::string error;
+    };
+
+    /**
+     * @brief The controller or USB hub a drive is attached to, from the sysfs device path
+     * @returns the sysfs path of the PCI function or hub, "virtual" for devices without one (loop, dm, ...)
+     */
+    static std::string busOf(const std::string &target);
+
+    /**
+     * @brief Short name of a bus for tables, e.g. "0000:03:00.0" or "usb 2-1"
+     */
+    static std::string busLabel(const std::string &bus);
+
+    /**
+     * @brief Wipes every target, drawing one progress line per drive
+     * @returns one result per target, in the order given
+     */
+    static std::vector<DriveResult> run(const std::vector<std::string> &targets, const Options &opts = {});
+
+    /**
+     * @brief Prints the outcome and certificate of every drive
+     */
+    static void printSummary(const std::vector<DriveResult> &results);
+};
@@ -0,0 +1,180 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <openssl/sha.h>
+
+#include "DmgrLib.h"
+
+// ========== Block copy engine ==========
+
+class ProgressMeter;
+
+/**
+ * @brief SHA256 of one source chunk, recorded during the write
+ */
+struct BlockChunkDigest {
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> sha{};
+};
+
+/**
+ * @brief Tuning knobs of the BlockCopy engine
+ */
+struct BlockCopyOptions {
+    size_t chunk_size = 4 * 1024 * 1024;    ///< bytes per read/write/hash unit
+    unsigned verify_threads = 4;            ///< parallel readers used by verify()
+    size_t ring_slots = 8;                  ///< chunks buffered between the reader and the writers
+    unsigned stall_timeout_ms = 3000;       ///< how long a full ring waits for a slow writer before detaching it
+    bool compare_before_write = false;      ///< read each target chunk first and only write the ones that differ
+    bool decompress = false;                ///< a .xz/.gz/.zst source (by magic) is written decompressed, for image burns only
+
+    /**
+     * @brief Optional check of the first chunk before anything is written, e.g. the image signature of a
+     * compressed source that could not be checked up front. Returns false with why set to abort the copy.
+     */
+    std::function<bool(const unsigned char* data, size_t length, std::string &why)> validate_header;
+
+    uint64_t start_offset = 0;              ///< resume point, a multiple of chunk_size that is already on the targets
+    unsigned checkpoint_interval_ms = 5000; ///< how often the writers flush their target for checkpoint
+
+    /**
+     * @brief Called once every live target is flushed up to committed (absolute offset), with the digests
+     * completed since the previous call. Feeds the OperationJournal of resumable runs.
+     * targets are the positions (in the target list of copyMulti) committed holds for, a failed target
+     * stays at the last checkpoint it was part of.
+     */
+    std::function<void(uint64_t committed, const std::vector<BlockChunkDigest> &new_digests, const std::vector<size_t> &targets)> checkpoint;
+};
+
+/**
+ * @brief In-process replacement for the `dd ... && sync` calls used by ISO burning and cloning.
+ * Every source chunk is hashed while it is written, so verifying the target afterwards
+ * only costs one extra read of the target.
+ *
+ * One reader fills a ring of chunk buffers that is consumed by one writer thread per target,
+ * so writing the same image to many devices reads the source only once. A writer that falls a
+ * full ring behind is detached and continues with its own reads of the source, and a failing
+ * writer is dropped, so neither stalls the other targets.
+ *
+ * With compare_before_write every target chunk is read first and only written if it differs,
+ * which makes re-flashing a stick that holds an older build of the same image mostly reads.
+ *
+ * With decompress, a compressed source (.xz/.gz/.zst, detected by magic) is decompressed by its tool in a child
+ * process that runs concurrently with the writers, the reader consumes the pipe instead of the file.
+ * A stream can't be re-read, so there a target that stalls the ring fails instead of detaching.
+ */
+class BlockCopy {
+public:
+    using ChunkDigest = BlockChunkDigest;
+
+    /**
+     * @brief A contiguous byte range on the target
+     */
+    struct Range {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    using Options = BlockCopyOptions;
+
+    struct CopyResult {
+        bool success = false;
+        uint64_t bytes_copied = 0;
+        uint64_t bytes_unchanged = 0;           ///< with compare_before_write: bytes that already matched and were not written
+        std::vector<ChunkDigest> digests;       ///< only the chunks of this run when resuming from start_offset
+        std::string error;
+        bool read_error = false;                ///< the source could not be read, as opposed to a target or setup failure
+    };
+
+    /**
+     * @brief Outcome for one target of copyMulti()
+     */
+    struct TargetResult {
+        std::string target;
+        bool success = false;
+        bool detached = false;                  ///< fell behind the ring and read the source on its own
+        uint64_t bytes_written = 0;
+        uint64_t bytes_unchanged = 0;           ///< with compare_before_write: bytes that already matched and were not written
+        std::string error;
+    };
+
+    struct MultiCopyResult {
+        bool success = false;                   ///< true if the source was read completely and every target succeeded
+        uint64_t bytes_read = 0;
+        std::vector<ChunkDigest> digests;       ///< shared by all targets, the source is hashed once
+        std::vector<TargetResult> targets;
+        std::string error;                      ///< source side error, per target errors are in targets
+        bool read_error = false;                ///< reading the source failed somewhere
+    };
+
+    struct VerifyResult {
+        bool success = false;                   ///< true if every chunk matched
+        uint64_t bytes_verified = 0;
+        std::vector<Range> mismatches;          ///< sector exact if the source could be re-read, chunk exact otherwise
+        std::string error;
+    };
+
+    /**
+     * @brief Copies source to target chunk by chunk, hashing every chunk on the way
+     * @param source device or image file to read from
+     * @param target device or file to write to (files are created if missing)
+     * @returns CopyResult with the per chunk digests needed by verify()
+     */
+    static CopyResult copy(const std::string &source, const std::string &target, const Options &opts = {});
+
+    /**
+     * @brief Fan-out copy: reads source once and writes it to every target in parallel
+     * @param source device or image file to read from
+     * @param targets devices or files to write to
+     * @returns MultiCopyResult with the shared digests and one TargetResult per target (same order)
+     */
+    static MultiCopyResult copyMulti(const std::string &source, const std::vector<std::string> &targets, const Options &opts = {});
+
+    /**
+     * @brief Reads the target back with O_DIRECT on several threads and compares it with the digests from copy()
+     * @param target the device/file that was written
+     * @param digests the digests returned by copy()
+     * @param source if not empty and not compressed (opts.decompress), mismatching chunks are re-read from here to narrow the report down to 512 byte sectors
+     */
+    static VerifyResult verify(const std::string &target, const std::vector<ChunkDigest> &digests, const std::string &source = "", const Options &opts = {});
+
+    /**
+     * @brief Runs verify() for several targets of one copyMulti() concurrently
+     * @returns one VerifyResult per target, same order as targets
+     */
+    static std::vector<VerifyResult> verifyMulti(const std::vector<std::string> &targets, const std::vector<ChunkDigest> &digests, const std::string &source = "", const Options &opts = {});
+
+    /**
+     * @brief Prints the verify result (matched or every mismatching range) to the terminal
+     */
+    static void printVerifyReport(const VerifyResult &res);
+
+private:
+    /**
+     * @brief verify() without its own progress line, verifyMulti() feeds one shared meter
+     */
+    static VerifyResult verifyImpl(const std::string &target, const std::vector<ChunkDigest> &digests, const std::string &source, const Options &opts, ProgressMeter *meter);
+};
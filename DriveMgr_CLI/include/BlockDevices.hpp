@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// ========== Block device model ==========
+// what lsblk printed, read in-process from /sys/class/block, the udev database and the mount table
+
+/**
+ * @brief One disk, partition or virtual block device
+ */
+struct BlockDevice {
+    std::string name;                       ///< kernel name, e.g. "sdb1"
+    std::string path;                       ///< "/dev/sdb1"
+    std::string type;                       ///< like lsblk TYPE: disk, part, loop, rom, lvm, crypt, dm, raid1, ...
+    std::string parent;                     ///< kernel name of the whole disk of a partition, empty otherwise
+    unsigned major = 0;
+    unsigned minor = 0;
+
+    uint64_t size = 0;                      ///< bytes
+    uint64_t start = 0;                     ///< partitions: first byte on the disk
+    unsigned partition_number = 0;          ///< 0 for everything but partitions
+
+    bool read_only = false;
+    bool removable = false;                 ///< of the whole disk
+    bool rotational = false;                ///< of the whole disk
+
+    std::string model;
+    std::string vendor;
+    std::string serial;
+    std::string wwn;
+    std::string transport;                  ///< like lsblk TRAN: usb, sata, nvme, mmc, virtio, scsi, ... empty for virtual devices
+
+    std::string fstype;                     ///< udev's probe, the mount table as fallback
+    std::string uuid;
+    std::string label;
+    std::string mountpoint;                 ///< first mount, empty if not mounted
+
+    std::vector<std::string> partitions;    ///< disks: kernel names of the partitions, by number
+    std::vector<std::string> holders;       ///< devices stacked on this one (dm, md)
+    std::vector<std::string> slaves;        ///< devices this one is stacked on
+};
+
+class BlockDevices {
+public:
+    /**
+     * @brief Reads one device
+     * @param device "/dev/sdb1", any symlink to it (/dev/disk/by-id/...) or the kernel name
+     * @returns std::nullopt if it isnt a block device
+     */
+    static std::optional<BlockDevice> probe(const std::string &device);
+
+    /**
+     * @brief The partitions of a whole disk, by partition number
+     * @returns empty for partitions and disks without a partition table
+     */
+    static std::vector<BlockDevice> partitionsOf(const std::string &disk);
+
+    /**
+     * @brief Every block device of /sys/class/block, sorted by name
+     */
+    static std::vector<BlockDevice> scan();
+
+    /**
+     * @brief Formats like lsblk's SIZE column ("14.9G", "512M", "256G"), so fingerprints built from it keep matching
+     */
+    static std::string lsblkSize(uint64_t bytes);
+};
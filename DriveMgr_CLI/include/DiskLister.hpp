@@ -8,35 +8,99 @@
 #include <filesystem>
 #include <algorithm>
 #include <cctype>
+#include <optional>
+#include <unordered_map>
+#include <thread>
+
+#include "DriveTable.hpp"
+#include "InventoryCache.hpp"
 
 namespace fs = std::filesystem;
 
-struct DiskInfo {
-    std::string device;
-    std::string size;
-    std::string type;
-    std::string mount;
-    std::string fstype;
-    std::string status;
-};
+class DiskLister {
+public:
+    struct MountEntry {
+        std::string mountpoint;
+        std::string fstype;
+        std::string source;
+    };
 
-struct Row {
-    std::string device, size, type, mount, fstype, status;
-};
+    /**
+     * @brief The mounts of /proc/self/mountinfo, in mount order
+     */
+    struct MountIndex {
+        std::unordered_map<std::string, std::vector<MountEntry>> by_devnum;    ///< "major:minor"
+        std::unordered_map<std::string, std::vector<MountEntry>> by_source;    ///< unescaped source ("/dev/sda1"), a symlink source also under the node it resolves to
+
+        /**
+         * @brief Every mount of a device, by device number and then by its /dev path,
+         * which is all that names the device of filesystems reporting an anonymous 0:N number (btrfs)
+         * @param path e.g. "/dev/sda1"
+         */
+        std::vector<MountEntry> of(const std::string& majmin, const std::string& path) const;
+    };
 
-class DiskLister {
 private:
-    std::vector<DiskInfo> disks;
+    DriveTable disks;
+    MountIndex mount_index;
+
+    std::unordered_map<std::string, DriveStamp> stamps;    ///< by device, what the inventory cache validates a row with
+    std::string saved_cache;                                ///< last content written to the inventory cache
+
+    std::thread revalidator;
+    int revalidate_fd = -1;                 ///< eventfd, readable once the revalidator is done
+    std::vector<std::string> stale;         ///< revalidator result: disks to probe again (changed, new or gone)
+
+    static std::string readFile(const std::string& path);
+
+    /**
+     * @brief Drops loop and ram devices
+     */
+    static bool isListed(const std::string& dev);
+
+    /**
+     * @brief Reads one /sys/block/<dev> entry, safe to call from several threads
+     */
+    DiskInfo probeDisk(const std::string& dev) const;
+
+    /**
+     * @brief Reloads the mount index and probes every listed /sys/block entry into the table, in parallel
+     */
+    void scan();
+
+    /**
+     * @brief Compares the stamps of cached disks with sysfs, runs on the revalidator thread
+     * @param cached kernel name and stamp of every row shown from the cache
+     * @returns the disks whose row is stale, plus new ones and vanished ones
+     */
+    static std::vector<std::string> findStale(const std::vector<std::pair<std::string, DriveStamp>>& cached);
 
-    std::string readFile(const std::string& path);
-    std::string getMountPoint(const std::string& device);
-    std::string getFsType(const std::string& device);
+    /**
+     * @brief Fills mount and fstype of a disk (or its first mounted partition) from the mount index
+     */
+    void resolveMount(DiskInfo& info, const std::string& dev) const;
+
+    /**
+     * @brief First mount of the device, by number or by its /dev path, nullopt if it isnt mounted
+     */
+    std::optional<MountEntry> findMount(const std::string& majmin, const std::string& path) const;
 
 public:
     DiskLister() = default;
+    ~DiskLister();
+
+    DiskLister(const DiskLister&) = delete;
+    DiskLister& operator=(const DiskLister&) = delete;
+
+    /**
+     * @brief Parses /proc/self/mountinfo once, mount points and sources are unescaped
+     * @param path another mountinfo file, e.g. /proc/<pid>/mountinfo
+     */
+    static MountIndex loadMountIndex(const std::string& path = "/proc/self/mountinfo");
     
     /**
      * @brief Fetches all physical drives info from /sys/block/
+     * A disk that isnt mounted itself shows the first mounted partition's mount point and filesystem.
      * @return vector of DiskInfo with device data
      */
     std::vector<DiskInfo> getPhysicalDisksInfo();
@@ -48,13 +112,60 @@ public:
     std::vector<Row> getPhysicalDisksInfoAsRows();
 
     /**
-     * @brief Get cached disks info (after getPhysicalDisksInfo was called)
-     * @return const reference to disks vector
+     * @brief The cached disks as Row structs, without rescanning
+     */
+    std::vector<Row> getCachedDisksAsRows() const;
+
+    /**
+     * @brief Re-reads one disk after a hotplug event, inserting, replacing or dropping its cached entry
+     * @param dev kernel name of the whole disk, e.g. "sdb"
+     * @returns true if the cache changed
+     */
+    bool updateDisk(const std::string& dev);
+
+    /**
+     * @brief Reloads the mount index and the mount columns of the cached disks (mounting raises no uevent)
+     * @returns true if a mount point or filesystem type changed
      */
-    const std::vector<DiskInfo>& getCachedDisks() const;
+    bool refreshMounts();
+
+    /**
+     * @brief Get cached disks info (after getPhysicalDisksInfo or refresh was called)
+     * @return const reference to the disk table, sorted by device
+     */
+    const DriveTable& getCachedDisks() const;
 
     /**
      * @brief Refresh disk information (re-scan /sys/block/)
      */
     void refresh();
+
+    /**
+     * @brief Fills the table from the inventory cache of the last run, without probing anything
+     * The rows may be stale until startRevalidation() and finishRevalidation() ran.
+     * @returns false if there is no usable cache, the table is left empty then
+     */
+    bool loadCache();
+
+    /**
+     * @brief Writes the table to the inventory cache, if it differs from what was written last
+     */
+    void saveCache();
+
+    /**
+     * @brief Checks every cached row against sysfs on a background thread, revalidationFd() turns readable when it is done
+     */
+    void startRevalidation();
+
+    /**
+     * @brief -1 if no revalidation is running
+     */
+    int revalidationFd() const { return revalidate_fd; }
+
+    /**
+     * @brief Probes the disks the revalidation found stale and refreshes the mounts of the others, then saves the cache
+     * @param wait block until the revalidation finished; otherwise nothing happens while it still runs
+     * @returns true if the table changed
+     */
+    bool finishRevalidation(bool wait);
 };
\ No newline at end of file
@@ -213,6 +213,12 @@ public:
         std::optional<std::string> vendor;
         std::optional<std::string> fstype;
         std::optional<std::string> uuid;
+
+        std::optional<uint64_t> size_bytes;
+        std::optional<uint32_t> logical_sector_size;
+        std::optional<uint32_t> physical_sector_size;
+        std::optional<std::string> firmware;
+        std::optional<std::string> wwn;
     };
 
     /**
@@ -228,6 +234,11 @@ public:
         metadata.vendor = std::nullopt;
         metadata.fstype = std::nullopt;
         metadata.uuid = std::nullopt;
+        metadata.size_bytes = std::nullopt;
+        metadata.logical_sector_size = std::nullopt;
+        metadata.physical_sector_size = std::nullopt;
+        metadata.firmware = std::nullopt;
+        metadata.wwn = std::nullopt;
     }
 };
 
@@ -0,0 +1,139 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "DmgrLib.h"
+#include "utils/JsonWriter.hpp"
+
+// ========== Drive health ==========
+
+/**
+ * @brief One entry of the ATA SMART attribute table, with its threshold
+ */
+struct SmartAttribute {
+    uint8_t id = 0;
+    std::string name;                   ///< smartctl's name, "Unknown_Attribute" for vendor specific ids
+    uint16_t flags = 0;
+    uint8_t value = 0;                  ///< normalized, higher is better
+    uint8_t worst = 0;
+    uint8_t threshold = 0;              ///< 0 = the attribute can't fail
+    uint64_t raw = 0;                   ///< the 48 bit raw field
+
+    bool prefailure() const { return flags & 0x01; }
+    bool failingNow() const { return threshold != 0 && value <= threshold; }
+    bool failedInPast() const { return threshold != 0 && worst <= threshold; }
+};
+
+/**
+ * @brief The NVMe SMART / Health Information log page (02h), 128 bit counters saturate at UINT64_MAX
+ */
+struct NvmeHealthLog {
+    uint8_t critical_warning = 0;       ///< bit 0 spare, 1 temperature, 2 reliability, 3 read-only, 4 volatile backup, 5 PMR
+    int temperature = 0;                ///< composite temperature, Celsius
+    uint8_t available_spare = 0;        ///< percent
+    uint8_t spare_threshold = 0;        ///< percent
+    uint8_t percentage_used = 0;        ///< may exceed 100
+    uint64_t data_units_read = 0;       ///< thousands of 512 byte units
+    uint64_t data_units_written = 0;
+    uint64_t host_reads = 0;
+    uint64_t host_writes = 0;
+    uint64_t power_cycles = 0;
+    uint64_t power_on_hours = 0;
+    uint64_t unsafe_shutdowns = 0;
+    uint64_t media_errors = 0;
+    uint64_t error_log_entries = 0;
+    uint32_t warning_temp_minutes = 0;
+    uint32_t critical_temp_minutes = 0;
+};
+
+struct HealthReport {
+    enum class Protocol {
+        None, Ata, Nvme
+    };
+
+    enum class Verdict {
+        Passed,
+        Failed,             ///< the drive says so: SMART threshold exceeded or an NVMe critical warning
+        Unknown             ///< no SMART, no permission, or the bridge doesn't pass the commands
+    };
+
+    std::string device;
+    Protocol protocol = Protocol::None;
+    Verdict verdict = Verdict::Unknown;
+
+    bool smart_supported = false;       ///< ATA: IDENTIFY word 82, NVMe: always
+    bool smart_enabled = false;
+
+    std::optional<int> temperature;     ///< Celsius
+    std::optional<uint64_t> power_on_hours;
+
+    std::vector<SmartAttribute> attributes;     ///< ATA only, in table order
+    std::optional<NvmeHealthLog> nvme;
+
+    std::vector<std::string> warnings;  ///< reallocated/pending sectors, low spare, ... even if the verdict is Passed
+    std::string error;                  ///< why the verdict is Unknown
+};
+
+/**
+ * @brief Reads SMART health without smartctl.
+ *
+ * ATA drives (directly on libata or behind a SAT USB bridge) get SMART RETURN STATUS, READ DATA and
+ * READ THRESHOLDS through ATA PASS-THROUGH (16); NVMe drives the SMART / Health log page through the
+ * admin ioctl. Nothing forks, so many drives can be checked at once with readMany().
+ */
+class DriveHealth {
+public:
+    /**
+     * @brief smartctl's name of an ATA attribute id
+     */
+    static std::string attributeName(uint8_t id);
+
+    static std::string verdictName(HealthReport::Verdict verdict);
+
+    /**
+     * @brief Reads the health of one whole disk (needs root)
+     */
+    static HealthReport read(const std::string &device);
+
+    /**
+     * @brief read() for every device, threads at a time
+     * @returns the reports in the order of devices
+     */
+    static std::vector<HealthReport> readMany(const std::vector<std::string> &devices, unsigned threads = 16);
+
+    /**
+     * @brief The full report: verdict, warnings and the attribute table or NVMe log
+     */
+    static void printReport(const HealthReport &report);
+
+    /**
+     * @brief One line per drive: verdict, temperature, power on hours and the first warning
+     */
+    static void printSummary(const std::vector<HealthReport> &reports);
+
+    /**
+     * @brief One "health" record (--json): the verdict, warnings and the attribute table or NVMe log
+     */
+    static void writeJson(JsonWriter &out, const HealthReport &report);
+};
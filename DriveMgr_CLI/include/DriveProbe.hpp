@@ -0,0 +1,87 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "DmgrLib.h"
+#include "BlockDevices.hpp"
+#include "utils/JsonWriter.hpp"
+
+// ========== Native drive probe ==========
+
+/**
+ * @brief Capacity, geometry and identity of a block device, as the device itself reports them
+ */
+struct DriveIdentity {
+    std::string device;                 ///< the node that was probed
+    std::string disk;                   ///< the whole disk the identity was read from (differs for partitions)
+
+    uint64_t size = 0;                  ///< bytes, BLKGETSIZE64
+    uint32_t logical_sector = 0;        ///< BLKSSZGET
+    uint32_t physical_sector = 0;       ///< BLKPBSZGET
+
+    /**
+     * @brief Where vendor/model/serial came from: "nvme" (identify controller), "ata" (IDENTIFY DEVICE
+     * through SAT), "scsi" (INQUIRY and VPD pages) or "sysfs" for devices without a command set (virtio, loop, dm, mmc)
+     */
+    std::string source;
+
+    std::string vendor;
+    std::string model;
+    std::string serial;
+    std::string firmware;
+    std::string wwn;                    ///< "0x..." for NAA/ATA world wide names, "eui." for NVMe
+};
+
+/**
+ * @brief Reads a drive's identity with ioctls instead of lsblk/smartctl.
+ *
+ * Size and sector sizes come from the block layer (BLKGETSIZE64, BLKSSZGET, BLKPBSZGET). The identity
+ * is asked from the hardware: NVMe identify controller/namespace through the admin ioctl, IDENTIFY
+ * DEVICE for ATA disks behind libata's SCSI translation, and standard INQUIRY with the unit serial
+ * (0x80) and device identification (0x83) VPD pages for everything else that speaks SCSI. Devices
+ * without a command set fall back to sysfs and the udev database (BlockDevices).
+ *
+ * The device is opened read-only; the NVMe admin ioctl and SG_IO on most nodes need root. A node
+ * that cant be opened at all still gets size and sector sizes from sysfs.
+ */
+class DriveProbe {
+public:
+    /**
+     * @param device "/dev/sdb", a partition of it, or any symlink to either
+     * @param err set to the reason if the device cant be opened; if sysfs knows it, the sysfs
+     * geometry and identity are returned nonetheless
+     */
+    static std::optional<DriveIdentity> probe(const std::string &device, std::string &err);
+
+    /**
+     * @brief probe() plus type, mount point, filesystem and UUID from the block device model,
+     * written into metadata. Fields nobody reported are set to "N/A".
+     */
+    static bool fillMetadata(const std::string &device, DriveMetadataStruct::DriveMetadata &metadata, std::string &err);
+
+    /**
+     * @brief One "metadata" record (--json): the identity plus what the block device model knows
+     * @param dev nullptr if BlockDevices cant read the device; empty fields are written as null
+     */
+    static void writeJson(JsonWriter &out, const DriveIdentity &id, const BlockDevice* dev);
+};
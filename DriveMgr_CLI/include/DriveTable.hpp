@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/StringPool.hpp"
+
+struct DiskInfo {
+    std::string device;
+    std::string size;
+    std::string type;
+    std::string mount;
+    std::string fstype;
+    std::string status;
+    uint64_t bytes = 0;         ///< size in bytes, what the size column sorts by
+};
+
+struct Row {
+    std::string device, size, type, mount, fstype, status;
+};
+
+// ========== Drive table ==========
+
+/**
+ * @brief The disks of a DiskLister, one array per column, sorted by device name.
+ *
+ * Hosts with multipath, dm and many LUNs have thousands of block devices whose type, filesystem,
+ * status and size strings mostly repeat; every text column holds StringPool ids instead of strings.
+ * Filtering and sorting work on an index view, the table itself keeps device order.
+ */
+class DriveTable {
+public:
+    enum class Column {
+        Device, Size, Type, Mount, FsType, Status,
+        Count   ///< number of columns, not a column
+    };
+
+    static const char* columnName(Column column);
+
+    size_t size() const { return devices.size(); }
+    bool empty() const { return devices.empty(); }
+
+    void clear();
+    void reserve(size_t n);
+
+    /**
+     * @brief Position of device ("/dev/sdb") or where it would be inserted
+     */
+    size_t lowerBound(const std::string &device) const;
+
+    /**
+     * @brief Position of device, size() if it isnt in the table
+     */
+    size_t find(const std::string &device) const;
+
+    /**
+     * @brief Inserts at the position lowerBound() gives, or replaces the entry of the same device
+     */
+    void put(const DiskInfo &info);
+
+    void append(const DiskInfo &info);
+    void erase(size_t pos);
+
+    /**
+     * @returns true if mount point or filesystem type changed
+     */
+    bool setMount(size_t pos, const std::string &mount, const std::string &fstype);
+
+    const std::string& text(Column column, size_t pos) const;
+    uint64_t bytes(size_t pos) const { return byte_sizes[pos]; }
+
+    DiskInfo info(size_t pos) const;
+    Row row(size_t pos) const;
+
+    /**
+     * @brief Positions of the rows matching filter, stably sorted by key (equal keys keep device order)
+     * @param filter case insensitive substring of any column, empty matches everything
+     */
+    std::vector<uint32_t> view(const std::string &filter, Column key, bool descending) const;
+
+private:
+    StringPool pool;
+
+    std::vector<StringPool::Id> devices;
+    std::vector<StringPool::Id> sizes;
+    std::vector<StringPool::Id> types;
+    std::vector<StringPool::Id> mounts;
+    std::vector<StringPool::Id> fstypes;
+    std::vector<StringPool::Id> statuses;
+    std::vector<uint64_t> byte_sizes;
+
+    const std::vector<StringPool::Id>& column(Column column) const;
+    void assign(size_t pos, const DiskInfo &info);
+};
@@ -0,0 +1,107 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "DmgrLib.h"
+#include "WipeEngine.hpp"
+
+// ========== Free space wipe ==========
+
+/**
+ * @brief Tuning knobs of a FreeSpaceWipe run
+ */
+struct FreeSpaceWipeOptions {
+    WipeEngine::Pattern pattern = WipeEngine::Pattern::Zero;
+    bool discard = false;                           ///< discard the free blocks instead of writing them (BLKDISCARD unmounted, FITRIM mounted)
+    size_t chunk_size = 16 * 1024 * 1024;           ///< bytes per write
+    uint64_t fill_file_size = 1024ull * 1024 * 1024;    ///< mounted: size of every filler file
+    std::optional<WipeSeed> seed;                   ///< stream of a random pass, a fresh one if unset
+};
+
+/**
+ * @brief Destroys deleted data of a filesystem without touching the files it still holds.
+ *
+ * An unmounted ext2/3/4 or FAT12/16/32 filesystem is opened exclusively and its allocation bitmap
+ * (block bitmaps, the FAT) read; only the free blocks are overwritten or discarded. The bitmap of
+ * an ext4 block group that was never initialized (BLOCK_UNINIT) is rebuilt from the group layout,
+ * so whatever was on the device before mkfs goes as well.
+ *
+ * A mounted filesystem (or any directory) is filled with large preallocated files written with
+ * O_DIRECT until it runs out of space; the files are removed again afterwards. Slack at the end of
+ * live files and free fragments smaller than a filesystem block are out of reach of both modes.
+ */
+class FreeSpaceWipe {
+public:
+    using Options = FreeSpaceWipeOptions;
+    using Range = WipeEngine::Range;
+
+    enum class FsType {
+        Unknown, Ext, Fat12, Fat16, Fat32
+    };
+
+    /**
+     * @brief The free blocks of an unmounted filesystem
+     */
+    struct FreeMap {
+        FsType type = FsType::Unknown;
+        uint64_t block_size = 0;                    ///< ext block or FAT cluster
+        uint64_t total_bytes = 0;                   ///< bytes the allocation map covers
+        uint64_t free_bytes = 0;
+        std::vector<Range> free;                    ///< byte ranges on the device, merged
+        std::string error;
+    };
+
+    struct Result {
+        bool success = false;
+        bool mounted = false;
+        bool discarded = false;
+        std::string mountpoint;
+        FsType type = FsType::Unknown;
+        uint64_t bytes = 0;                         ///< overwritten or discarded
+        size_t files = 0;                           ///< filler files of a mounted run
+        double seconds = 0.0;
+        std::string error;
+    };
+
+    static std::string fsTypeName(FsType type);
+
+    /**
+     * @brief Where a block device is mounted, matched by device number or mount source in /proc/self/mountinfo
+     * @returns the first mount point, empty if it isnt mounted
+     */
+    static std::string mountPointOf(const std::string &device);
+
+    /**
+     * @brief Reads the allocation map of the ext or FAT filesystem on an unmounted device (or image)
+     */
+    static FreeMap readFreeMap(const std::string &device);
+
+    /**
+     * @brief Wipes the free space of target: the bitmap path for unmounted devices,
+     * filler files for mounted devices and directories
+     */
+    static Result run(const std::string &target, const Options &opts = {});
+
+    static void printReport(const Result &res);
+};
@@ -0,0 +1,128 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DmgrLib.h"
+
+// ========== Hardware assisted erase ==========
+
+/**
+ * @brief Erases a drive with the device's own commands instead of writing every block.
+ *
+ * Candidates, strongest first: NVMe sanitize (crypto/block erase), NVMe Format NVM with secure
+ * erase, ATA SANITIZE (crypto scramble/block erase), and the block layer's BLKSECDISCARD, BLKZEROOUT
+ * and BLKDISCARD. What a target offers is read from sysfs (queue/discard_*, write_zeroes_max_bytes)
+ * and the identify data of the device. Sanitize and format always hit the whole disk (sanitize even
+ * the whole NVMe subsystem), so they are only offered for whole disks without other namespaces.
+ *
+ * A few hundred blocks are sampled before the erase and read back afterwards; a block that still
+ * holds its old (non uniform) content fails the erase.
+ */
+class HardwareErase {
+public:
+    enum class Method {
+        NvmeSanitizeCrypto,
+        NvmeSanitizeBlock,
+        NvmeFormatCrypto,
+        NvmeFormatErase,
+        AtaSanitizeCrypto,
+        AtaSanitizeBlock,
+        SecureDiscard,
+        ZeroOut,
+        Discard
+    };
+
+    struct Capabilities {
+        bool block_device = false;
+        bool partition = false;
+        bool rotational = false;
+        uint64_t size = 0;
+        uint64_t discard_granularity = 0;       ///< queue/discard_granularity
+        uint64_t discard_max_bytes = 0;         ///< queue/discard_max_bytes, 0 = no discard
+        uint64_t write_zeroes_max_bytes = 0;    ///< queue/write_zeroes_max_bytes, 0 = BLKZEROOUT would write zero pages
+        std::string transport;                  ///< "nvme", "ata" or empty
+        std::vector<Method> methods;            ///< usable on this target, strongest first
+        std::vector<std::string> notes;         ///< why stronger methods were left out
+    };
+
+    struct SampleReport {
+        size_t checked = 0;
+        size_t zeroed = 0;                      ///< read back as zeros
+        size_t changed = 0;                     ///< different from before, but not zeros (crypto erase, 0xFF, ...)
+        size_t inconclusive = 0;                ///< uniform before and after, e.g. zeros that were zeros already
+        size_t unreadable = 0;
+        std::vector<uint64_t> failed;           ///< offsets that still hold their old content (or arent zeros after BLKZEROOUT)
+        std::vector<std::array<unsigned char, 32>> digests;     ///< SHA-256 of every sampled block after the erase, in sample order
+        std::vector<uint64_t> offsets;          ///< the sampled offsets
+        bool success = false;
+    };
+
+    struct Result {
+        bool success = false;
+        bool unsupported = false;               ///< the device refused the method, a weaker one may still work
+        Method method = Method::Discard;
+        double seconds = 0.0;
+        SampleReport samples;
+        std::string error;
+    };
+
+    static std::string methodName(Method method);
+
+    /**
+     * @brief true if the method guarantees zeros on read back (only BLKZEROOUT does)
+     */
+    static bool readsZeros(Method method);
+
+    /**
+     * @brief true for the methods that erase the media itself (sanitize, format, secure discard) rather than unmapping it
+     */
+    static bool destroysMedia(Method method);
+
+    /**
+     * @brief Reads sysfs and the device's identify data to find what the target supports
+     */
+    static Capabilities probe(const std::string &target);
+
+    /**
+     * @brief Runs one method on the target (no sampling)
+     */
+    static Result erase(const std::string &target, Method method, const Capabilities &caps);
+
+    /**
+     * @brief Samples the target, runs the strongest supported method (falling back to weaker ones
+     * the device refuses) and checks the samples
+     * @param sample_count random blocks read before and after, the first and last block are always added
+     */
+    static Result run(const std::string &target, size_t sample_count = 256);
+
+    /**
+     * @brief Prints the probed methods of a target
+     */
+    static void printCapabilities(const std::string &target, const Capabilities &caps);
+
+    /**
+     * @brief Prints method, duration and sample check of a run
+     */
+    static void printReport(const Result &res);
+};
@@ -0,0 +1,80 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "DriveTable.hpp"
+
+// ========== Drive inventory cache ==========
+
+/**
+ * @brief What a cached row is only valid for: the same hardware at the same place with the same size.
+ * Everything in it is one short sysfs read, so checking thousands of disks costs next to nothing.
+ */
+struct DriveStamp {
+    std::string devt;           ///< "major:minor" of /sys/block/<dev>/dev
+    std::string syspath;        ///< the /sys/devices/... path /sys/block/<dev> resolves to (controller, port, LUN)
+    std::string identity;       ///< "wwid=...", "serial=..." or empty for devices without either
+    uint64_t bytes = 0;
+
+    bool operator==(const DriveStamp &other) const {
+        return devt == other.devt && syspath == other.syspath && identity == other.identity && bytes == other.bytes;
+    }
+    bool operator!=(const DriveStamp &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief The drive list of the last run, so the selection menu is on screen before any drive was probed.
+ *
+ * dmgr_root/data/inventory.cache holds one line per disk: the DiskInfo columns plus its DriveStamp.
+ * It is rewritten atomically whenever the table changed. A loaded entry is only shown until the
+ * background revalidation compared its stamp with sysfs, entries whose stamp differs are probed again.
+ */
+class InventoryCache {
+public:
+    struct Entry {
+        DiskInfo info;
+        DriveStamp stamp;
+    };
+
+    /**
+     * @brief dmgr_root/data/inventory.cache
+     */
+    static std::string defaultPath();
+
+    /**
+     * @brief Reads the stamp of a disk from sysfs
+     * @param dev kernel name, e.g. "sdb"
+     * @returns std::nullopt if /sys/block/<dev> is gone
+     */
+    static std::optional<DriveStamp> stamp(const std::string &dev);
+
+    /**
+     * @param err set to the reason if the cache is missing, damaged or from another version
+     */
+    static std::optional<std::vector<Entry>> load(const std::string &path, std::string &err);
+
+    static std::string serialize(const std::vector<Entry> &entries);
+
+    static bool save(const std::string &path, const std::string &data);
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ========== Block device I/O statistics ==========
+// iostat -x from the kernel's per-device counters, without sysstat
+
+/**
+ * @brief The counters of one /sys/block/<dev>/stat or /proc/diskstats line (Documentation/admin-guide/iostats.rst)
+ */
+struct DiskStat {
+    std::string name;
+    uint64_t reads = 0;                 ///< completed
+    uint64_t read_merges = 0;
+    uint64_t read_sectors = 0;          ///< always 512 byte units
+    uint64_t read_ms = 0;
+    uint64_t writes = 0;
+    uint64_t write_merges = 0;
+    uint64_t write_sectors = 0;
+    uint64_t write_ms = 0;
+    uint64_t in_flight = 0;             ///< a gauge, not a counter
+    uint64_t io_ms = 0;                 ///< time the device had I/O outstanding
+    uint64_t weighted_ms = 0;           ///< io_ms weighted by the requests in flight
+    uint64_t discards = 0;              ///< kernel 4.18+
+    uint64_t discard_sectors = 0;
+    uint64_t flushes = 0;               ///< kernel 5.5+
+};
+
+/**
+ * @brief What iostat -x prints for a device over one interval
+ */
+struct IoRates {
+    std::string name;
+    double r_s = 0, w_s = 0, d_s = 0, f_s = 0;          ///< completed requests per second (read, write, discard, flush)
+    double rkb_s = 0, wkb_s = 0, dkb_s = 0;             ///< KiB per second
+    double rrqm_s = 0, wrqm_s = 0;                      ///< merged requests per second
+    double r_await = 0, w_await = 0;                    ///< average latency of a request, ms
+    double rareq_sz = 0, wareq_sz = 0;                  ///< average request size, KiB
+    double aqu_sz = 0;                                  ///< average queue depth
+    double util = 0;                                    ///< percent of the interval the device was busy
+    uint64_t in_flight = 0;
+
+    bool idle() const { return r_s == 0 && w_s == 0 && d_s == 0 && f_s == 0 && in_flight == 0; }
+};
+
+/**
+ * @brief Samples the counters of a fixed set of devices.
+ *
+ * The stat files stay open and are re-read with pread(), so a sample costs one read per disk plus one
+ * of /proc/diskstats when partitions are included; nothing is opened or listed after the constructor.
+ */
+class IoStatSampler {
+public:
+    /**
+     * @param devices kernel names ("sda", "nvme0n1", "sda1"); empty means every /sys/block entry but loop and ram
+     * @param partitions also sample partitions, read from /proc/diskstats
+     */
+    IoStatSampler(const std::vector<std::string> &devices, bool partitions);
+    ~IoStatSampler();
+
+    IoStatSampler(const IoStatSampler&) = delete;
+    IoStatSampler& operator=(const IoStatSampler&) = delete;
+
+    /**
+     * @brief Reads all counters, in the order of the device list (partitions after their disk)
+     */
+    std::vector<DiskStat> sample();
+
+    /**
+     * @brief Why a stat file couldnt be opened by the constructor, empty if all of them were;
+     * a device without one is sampled as all zeros
+     */
+    const std::string& error() const { return open_error; }
+
+    /**
+     * @brief Rates between two samples seconds apart; a device missing from prev (or whose counters went
+     * backwards, i.e. it was re-added) gets zeros
+     */
+    static std::vector<IoRates> rates(const std::vector<DiskStat> &prev, const std::vector<DiskStat> &cur, double seconds);
+
+    /**
+     * @brief Parses the counters of a stat file, without the major/minor/name columns /proc/diskstats has
+     */
+    static std::optional<DiskStat> parseStat(const std::string &name, const char* line);
+
+private:
+    struct Source {
+        std::string name;
+        int fd = -1;
+    };
+
+    std::vector<Source> disks;
+    bool partitions = false;
+    int diskstats_fd = -1;
+    std::unordered_map<std::string, std::string> partition_disk;   ///< partition name -> its disk, of the sampled disks
+    std::string buf;
+    std::string open_error;
+};
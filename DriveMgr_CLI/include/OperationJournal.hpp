@@ -0,0 +1,130 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "BlockCopy.hpp"
+#include "DmgrLib.h"
+
+// ========== Operation journal ==========
+
+/**
+ * @brief On-disk progress record of a clone, burn, wipe or image run, so `--resume` can continue it.
+ *
+ * The journal is a small key=value header that is rewritten atomically (tmp file, fsync, rename)
+ * every time the engine reports a checkpoint, plus an append-only sidecar (".sha") with the chunk
+ * digests of the committed part. The engine flushes the target before it reports a checkpoint, so
+ * everything below `committed` is on the device when the header says so. Digests past `committed`
+ * (written before a crash hit the header) are ignored on load.
+ *
+ * Source and target are recorded with an identity string (size, hardware ids, and a hash of sampled
+ * blocks for sources), a resume is refused if either of them changed in the meantime.
+ */
+class OperationJournal {
+public:
+    enum class Operation {
+        Clone, Burn, Wipe, Image
+    };
+
+    struct State {
+        Operation op = Operation::Clone;
+        std::string source;                     ///< empty for wipes
+        std::string source_id;
+        std::string target;
+        std::string target_id;
+        uint64_t block_size = 0;                ///< chunk size of the engine, a resume has to use the same one
+        uint64_t total = 0;                     ///< bytes the operation covers, 0 if unknown (compressed source)
+        unsigned pass = 0;                      ///< wipes: index of the running pass
+        std::string scheme;                     ///< wipes: WipeEngine scheme name
+        std::string seed;                       ///< wipes: hex seed of the random pass, so a resume continues the same stream
+        uint64_t committed = 0;                 ///< everything below this offset is done and flushed (in the running pass)
+        std::string map_path;                   ///< images: the rescue map, it holds the completed ranges itself
+        bool compare_before_write = false;      ///< copies: the BlockCopy options the run was started with
+        bool decompress = false;
+        bool validate_header = false;           ///< burns: the image signature check was on
+        std::vector<BlockCopy::ChunkDigest> digests;    ///< copies: digests of the chunks below committed
+    };
+
+    static std::string operationName(Operation op);
+
+    /**
+     * @brief dmgr_root/data/journal/<operation>_<source>_to_<target>.journal
+     */
+    static std::string defaultPath(Operation op, const std::string &source, const std::string &target);
+
+    /**
+     * @brief Identity of a device or file: size, hardware ids (WWN/serial/model) or inode
+     * @param with_content also hash a few sampled blocks, only for sources (targets change during the run)
+     */
+    static std::string identify(const std::string &path, bool with_content);
+
+    /**
+     * @brief Every journal left behind by an interrupted run
+     */
+    static std::vector<std::string> pending();
+
+    /**
+     * @brief Reads a journal and the digests of its committed part
+     * @param err set to the reason if the journal cant be used
+     */
+    static std::optional<State> load(const std::string &path, std::string &err);
+
+    /**
+     * @brief Checks that source and target are the same devices with the same content as when the journal was written
+     * For copies the last committed chunk is also read back from the target and compared with its digest.
+     * @param why set to the reason if they changed
+     */
+    static bool validate(const State &state, std::string &why);
+
+    explicit OperationJournal(std::string path);
+
+    /**
+     * @brief Starts a fresh journal (committed = 0, no digests)
+     */
+    bool begin(const State &state);
+
+    /**
+     * @brief Continues a loaded journal, new digests are appended to the existing ones
+     */
+    bool resume(const State &state);
+
+    /**
+     * @brief Records progress, the engine has already flushed the target up to committed
+     * @param new_digests digests completed since the previous commit
+     */
+    bool commit(uint64_t committed, unsigned pass, const std::vector<BlockCopy::ChunkDigest> &new_digests = {});
+
+    /**
+     * @brief Deletes the journal, its digests and the rescue map of an image run once the operation finished or was discarded
+     */
+    void remove();
+
+    const std::string &path() const { return journal_path; }
+
+private:
+    std::string journal_path;
+    State header;                               ///< digests are not kept here, they go straight to the sidecar
+
+    bool writeHeader() const;
+    bool appendDigests(const std::vector<BlockCopy::ChunkDigest> &digests) const;
+};
@@ -0,0 +1,102 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DmgrLib.h"
+
+// ========== Rescue imaging engine ==========
+
+/**
+ * @brief Tuning knobs of the RescueImager
+ */
+struct RescueOptions {
+    size_t copy_block = 1024 * 1024;        ///< read size of the fast copy passes
+    size_t skip_min = 64 * 1024;            ///< first jump after a read error in pass 1, doubles on every further error
+    unsigned read_timeout_ms = 10000;       ///< a read that takes longer counts as failed and is abandoned
+    unsigned retry_passes = 1;              ///< extra passes over the sectors that are still bad after scraping
+    unsigned max_hung_reads = 4;            ///< stop (map kept) once this many reads hang in the kernel
+};
+
+/**
+ * @brief ddrescue style imaging for sources with unreadable sectors.
+ *
+ * Pass 1 copies with large reads and jumps over areas that fail, pass 2 reads the skipped
+ * areas, the trim pass reads sector by sector inwards from both edges of every failed block
+ * and the scrape pass reads what is left of them one sector at a time. Bad sectors are
+ * retried retry_passes times at the end.
+ *
+ * The state of every byte (non-tried, non-trimmed, non-scraped, bad, finished) is kept in a
+ * map file in GNU ddrescue's mapfile format, so an interrupted run continues where it stopped
+ * and the map can be inspected with the usual ddrescue tools. Comment lines in the map record
+ * which source and target it belongs to, a map made for other devices is refused.
+ */
+class RescueImager {
+public:
+    using Options = RescueOptions;
+
+    /**
+     * @brief Block states, the characters are the ones ddrescue writes into its mapfiles
+     */
+    enum class BlockStatus : char {
+        NonTried = '?', NonTrimmed = '*', NonScraped = '/', BadSector = '-', Finished = '+'
+    };
+
+    struct Block {
+        uint64_t pos = 0;
+        uint64_t size = 0;
+        BlockStatus status = BlockStatus::NonTried;
+    };
+
+    struct Result {
+        bool success = false;                   ///< true if every byte of the source was rescued
+        bool completed = false;                 ///< true if all passes ran, false if the run was stopped early
+        bool resumed = false;                   ///< true if an existing map was continued
+        uint64_t source_size = 0;
+        uint64_t bytes_rescued = 0;
+        uint64_t bytes_bad = 0;                 ///< bytes in bad sectors ('-'), that failed every pass
+        uint64_t bytes_non_tried = 0;           ///< bytes no pass got to ('?'), only left by a stopped run
+        uint64_t bytes_pending = 0;             ///< bytes of failed blocks not yet trimmed or scraped ('*', '/')
+        std::vector<Block> bad_areas;           ///< everything that is not finished, merged
+        std::string map_path;
+        std::string error;
+    };
+
+    /**
+     * @brief Images source onto target, skipping and later narrowing down unreadable areas
+     * @param source device or image to read from
+     * @param target file or device to write to (files are created, existing data is kept when resuming)
+     * @param map_path mapfile to resume from and to keep updated, removed once every byte is rescued
+     */
+    static Result rescue(const std::string &source, const std::string &target, const std::string &map_path, const Options &opts = {});
+
+    /**
+     * @brief Map file location for a run that has no natural place for it (e.g. cloning device to device)
+     * @returns <dmgr_root>/data/rescue/<source>_to_<target>.map
+     */
+    static std::string defaultMapPath(const std::string &source, const std::string &target);
+
+    /**
+     * @brief Prints the rescued/bad totals and the unreadable ranges to the terminal
+     */
+    static void printReport(const Result &res);
+};
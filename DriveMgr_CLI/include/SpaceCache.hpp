@@ -0,0 +1,52 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "SpaceWalker.hpp"
+
+// ========== Directory usage cache ==========
+
+/**
+ * @brief The SpaceTree of the last walk of a root, so the next one only lists what changed.
+ *
+ * Binary and in native byte order (it never leaves the machine): a header with the root and its
+ * st_dev, then per directory its parent, inode, mtime, own counters, name, largest files and hard
+ * links. Children lists and totals are rebuilt on load. Written atomically after every walk.
+ */
+class SpaceCache {
+public:
+    /**
+     * @brief dmgr_root/data/space/<root>.cache, '/' written as '_', '_' as "%5F" and '%' as "%25"
+     */
+    static std::string defaultPath(const std::string &root);
+
+    static std::string serialize(const SpaceTree &tree);
+
+    /**
+     * @param err set to the reason if data is not a complete cache of this version
+     */
+    static std::optional<SpaceTree> parse(const std::string &data, std::string &err);
+
+    static std::optional<SpaceTree> load(const std::string &path, std::string &err);
+
+    static bool save(const std::string &path, const SpaceTree &tree);
+};
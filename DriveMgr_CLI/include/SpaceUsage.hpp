@@ -0,0 +1,84 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockDevices.hpp"
+#include "utils/JsonWriter.hpp"
+
+// ========== Filesystem space ==========
+
+/**
+ * @brief Space and inode figures of one mounted filesystem, in bytes, as statvfs reports them
+ */
+struct FsUsage {
+    std::string device;                     ///< the partition (or whole disk) node
+    std::string fstype;
+    std::vector<std::string> mountpoints;   ///< every mount of it in mount order, bind mounts and subvolumes included
+
+    uint64_t block_size = 0;                ///< f_frsize, the unit of the counters below
+    uint64_t total = 0;
+    uint64_t used = 0;                      ///< total minus free
+    uint64_t free = 0;                      ///< including the blocks reserved for root
+    uint64_t available = 0;                 ///< what unprivileged users can still write
+
+    uint64_t inodes = 0;                    ///< 0 for filesystems without a fixed inode table (btrfs, vfat)
+    uint64_t inodes_used = 0;
+    uint64_t inodes_free = 0;
+
+    bool read_only = false;
+    std::string error;                      ///< set if none of the mount points could be queried
+
+    /**
+     * @brief df's Use%: used / (used + available), rounded up, so the root reserve counts as full
+     */
+    unsigned usedPercent() const;
+
+    unsigned inodesUsedPercent() const;
+};
+
+/**
+ * @brief Filesystem usage without df: statvfs on the mount points /proc/self/mountinfo lists for a device.
+ */
+class SpaceUsage {
+public:
+    /** @brief Space or inode use from which a filesystem is reported as running full */
+    static constexpr unsigned WARN_PERCENT = 90;
+
+    /**
+     * @brief Fills the counters of usage from statvfs(mountpoint)
+     * @param err set to the reason if the mount point cant be queried
+     */
+    static bool query(const std::string &mountpoint, FsUsage &usage, std::string &err);
+
+    /**
+     * @brief Every mounted filesystem of a disk: the disk itself and its partitions, in that order.
+     * Mounts are matched by device number; btrfs, whose mounts carry an anonymous one, by source path.
+     * A filesystem mounted in several places is queried once, its first reachable mount point counts.
+     */
+    static std::vector<FsUsage> ofDisk(const BlockDevice &disk, const std::vector<BlockDevice> &partitions);
+
+    /**
+     * @brief One "space" record (--json), byte counts as they are plus df's percentages
+     */
+    static void writeJson(JsonWriter &out, const FsUsage &usage);
+};
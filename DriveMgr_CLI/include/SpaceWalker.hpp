@@ -0,0 +1,144 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class ProgressMeter;
+
+// ========== Directory space usage ==========
+
+/**
+ * @brief A file among the largest of its directory
+ */
+struct SpaceFile {
+    std::string name;
+    uint64_t bytes = 0;                 ///< allocated, what du counts
+    uint64_t apparent = 0;              ///< st_size
+};
+
+/**
+ * @brief A file with more than one link, counted in the directory where it was seen first. Every
+ * directory keeps all of its links, so an incremental walk can move the count when that one is gone.
+ */
+struct SpaceLink {
+    uint64_t ino = 0;
+    uint64_t bytes = 0;
+    uint64_t apparent = 0;
+    bool counted = false;               ///< in the own counters of this directory
+};
+
+/**
+ * @brief One directory of a SpaceTree
+ */
+struct SpaceDir {
+    std::string name;                   ///< the root holds the path that was walked
+    uint32_t parent = 0;                ///< index in SpaceTree::dirs, the root is its own parent
+    uint64_t ino = 0;
+    int64_t mtime_ns = 0;
+
+    // what is directly in the directory: files, symlinks, specials and the directory's own blocks
+    uint64_t own_bytes = 0;
+    uint64_t own_apparent = 0;
+    uint64_t own_files = 0;
+
+    // the directory and everything below it
+    uint64_t bytes = 0;
+    uint64_t apparent = 0;
+    uint64_t files = 0;
+    uint64_t dirs = 0;                  ///< subdirectories, not counting itself
+
+    std::vector<uint32_t> children;     ///< subdirectories, by size descending once the walk finished
+    std::vector<SpaceFile> largest;     ///< the biggest files directly inside, descending, at most SpaceWalker::TOP_FILES
+    std::vector<SpaceLink> links;       ///< hard linked files counted in own_*, so a reused directory can claim them again
+    bool unreadable = false;            ///< couldnt be opened or listed, only its own blocks are counted
+};
+
+/**
+ * @brief Result of a walk: every directory of one filesystem below the root, parents before children
+ */
+struct SpaceTree {
+    std::string root;
+    uint64_t dev = 0;                   ///< st_dev of the walked filesystem
+    std::vector<SpaceDir> dirs;         ///< dirs[0] is the root
+
+    uint64_t hardlinks = 0;             ///< extra links of files already counted elsewhere
+    uint64_t mountpoints = 0;           ///< directories of other filesystems that were skipped
+    uint64_t errors = 0;                ///< directories or entries that couldnt be read
+    uint64_t reused = 0;                ///< directories taken over from the previous tree without listing them
+    double seconds = 0;
+
+    /**
+     * @brief "/mnt/data/home/user", the root path followed by the names down to dir
+     */
+    std::string path(uint32_t dir) const;
+
+    /**
+     * @brief Sums the own counters up the tree and sorts every children list by size, descending
+     */
+    void finish();
+};
+
+/**
+ * @brief Tuning knobs of a SpaceWalker run
+ */
+struct SpaceWalkerOptions {
+    unsigned threads = 0;               ///< 0 = twice the CPUs, at least 4 and at most 32; listing is latency bound
+    ProgressMeter* meter = nullptr;     ///< gets the allocated bytes as they are counted
+
+    /**
+     * @brief An earlier walk of the same root. A directory whose inode and mtime didnt change keeps its
+     * files from there and only its subdirectories are stat'ed, nothing in it is listed.
+     */
+    const SpaceTree* previous = nullptr;
+
+    /** @brief Directories (by inode) to list again even if their mtime didnt change: files in them grew or shrank */
+    const std::unordered_set<uint64_t>* dirty = nullptr;
+};
+
+/**
+ * @brief du-style walk of one filesystem, on a work-stealing thread pool.
+ *
+ * Every worker owns a deque of opened directories: it lists the newest one itself (depth first,
+ * so few directories are open at a time) and idle workers steal the oldest ones of the others,
+ * which are the big subtrees near the root. Directories are read with getdents64 into a per-thread
+ * buffer and entries are stat'ed with fstatat relative to the directory fd, so no path is ever
+ * resolved twice. Directories of other filesystems (mount points) are skipped, files with more
+ * than one link are counted at their first sighting only.
+ *
+ * With a previous tree the walk is incremental: adding, removing or renaming an entry changes the
+ * mtime of its directory, so unchanged directories are taken over as they were. A file that only
+ * grew in place doesnt touch its directory, such changes need a full walk or the dirty set (live mode).
+ */
+class SpaceWalker {
+public:
+    using Options = SpaceWalkerOptions;
+
+    /** @brief Files kept per directory for the tree view */
+    static constexpr size_t TOP_FILES = 10;
+
+    /**
+     * @param root a directory, usually a mount point
+     * @param err set to the reason if root cant be opened
+     */
+    static bool walk(const std::string &root, const Options &opts, SpaceTree &tree, std::string &err);
+};
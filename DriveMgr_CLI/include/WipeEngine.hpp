@@ -0,0 +1,200 @@
+/*
+ * DriveMgr - Linux Drive Management Utility
+ * Copyright (C) 2025 Dogwalker-kryt
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "DmgrLib.h"
+
+// ========== Wipe engine ==========
+
+/**
+ * @brief Key and nonce of the AES-CTR stream of a random pass, the same seed regenerates the same data
+ */
+using WipeSeed = std::array<unsigned char, 24>;
+
+/**
+ * @brief Tuning knobs of the WipeEngine
+ */
+struct WipeOptions {
+    size_t chunk_size = 16 * 1024 * 1024;   ///< bytes per write
+    unsigned generator_threads = 0;         ///< threads producing random chunks ahead of the writers, 0 = up to 4 by core count
+    unsigned write_depth = 4;               ///< chunks written at once, each by its own thread, so the device sees a queue
+    size_t ring_slots = 0;                  ///< chunks buffered between generators and writers, 0 = twice the generators (at least write_depth + generators)
+    unsigned verify_threads = 4;            ///< parallel readers of verify()
+    std::optional<WipeSeed> seed;           ///< stream of a random pass, a fresh one is drawn from getrandom() if unset
+    uint64_t start_offset = 0;              ///< resume point, everything below it was already overwritten
+    unsigned checkpoint_interval_ms = 5000; ///< how often the target is flushed for checkpoint
+    int fd = -1;                            ///< target opened read-write by the caller (e.g. with O_EXCL so nobody mounts it meanwhile), fill() writes through it instead of opening the path
+
+    /** @brief called with the offset up to which the target is flushed, feeds the OperationJournal */
+    std::function<void(uint64_t committed)> checkpoint;
+
+    /** @brief replaces the progress line with the bytes done so far, for callers drawing several drives at once (called from the verify threads too) */
+    std::function<void(uint64_t done)> progress;
+};
+
+/**
+ * @brief What WipeEngine::sampleVerify() reads
+ */
+struct WipeSampleOptions {
+    size_t count = 4096;                    ///< random blocks across the whole range, the first and last block are always added
+    uint64_t stride = 0;                    ///< also read every stride-th block, 0 = only random blocks
+    unsigned threads = 16;                  ///< parallel readers, random reads need queue depth
+    double confidence = 0.99;               ///< of the reported bound on the unwiped share
+    bool keep_blocks = false;               ///< return every sampled block with its SHA-256 (for certificates)
+    size_t max_blocks = 1 << 20;            ///< cap on the blocks read (4 GiB), a larger count or a finer stride is thinned to fit
+};
+
+/**
+ * @brief In-process replacement for the `dd if=/dev/{urandom,zero} of=<drive> && sync` overwrite passes.
+ *
+ * Random data is AES-128-CTR keystream from OpenSSL (AES-NI where available), keyed by a seed and
+ * addressed by the byte offset, so generator threads can produce chunks out of order ahead of the
+ * writers and verify() can regenerate any block without storing it. write_depth writers keep that
+ * many O_DIRECT writes in flight, checkpoints only ever cover the gap free prefix of completed
+ * chunks. Progress goes to a ProgressMeter and only the wiped device is flushed.
+ */
+class WipeEngine {
+public:
+    using Options = WipeOptions;
+    using Seed = WipeSeed;
+    using SampleOptions = WipeSampleOptions;
+
+    enum class Pattern {
+        Zero, Random
+    };
+
+    /**
+     * @brief The pass combinations offered by overwriteDriveData()
+     */
+    enum class Scheme {
+        Random,             ///< one random pass
+        Zero,               ///< one zero pass
+        RandomVerify,       ///< one random pass, read back and compared with the regenerated stream
+        RandomZero          ///< a random pass followed by a zero pass
+    };
+
+    struct Range {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    struct Result {
+        bool success = false;
+        uint64_t bytes_written = 0;             ///< offset the pass got to
+        Seed seed{};                            ///< stream of a random pass, needed by verify()
+        std::string error;
+    };
+
+    /**
+     * @brief One block read back after a wipe, the evidence a wipe certificate lists
+     */
+    struct SampledBlock {
+        uint64_t offset = 0;
+        std::array<unsigned char, 32> sha256{};
+        bool readable = false;
+        bool matches = false;                   ///< holds the expected zeros or stream
+    };
+
+    struct SampleResult {
+        bool success = false;
+        uint64_t blocks_checked = 0;
+        uint64_t blocks_bad = 0;
+        uint64_t random_checked = 0;            ///< the random part of blocks_checked, the statistics only hold for it
+        uint64_t random_bad = 0;
+        double confidence = 0.0;
+        double max_unwiped = 0.0;               ///< share of the drive that may be unwiped: the bound at confidence if no random block failed, else the estimate
+        uint64_t max_missed_run = 0;            ///< longest unwiped run (bytes) that fits between two stride blocks, 0 without stride
+        std::vector<Range> mismatches;          ///< sector exact, failing blocks are followed into their neighbours
+        std::vector<SampledBlock> blocks;       ///< only with keep_blocks, in offset order
+        double seconds = 0.0;
+        std::string error;
+    };
+
+    struct VerifyResult {
+        bool success = false;
+        uint64_t bytes_verified = 0;
+        std::vector<Range> mismatches;          ///< sector exact
+        std::string error;
+    };
+
+    static std::string schemeName(Scheme scheme);
+
+    /**
+     * @brief Parses "random", "zero", "random-verify" or "random-zero"
+     */
+    static std::optional<Scheme> parseScheme(const std::string &name);
+
+    /**
+     * @brief Passes of a scheme in order (the verify step of RandomVerify is not a pass)
+     */
+    static std::vector<Pattern> passes(Scheme scheme);
+
+    /**
+     * @brief Draws a fresh seed from the kernel CSPRNG
+     */
+    static Seed newSeed();
+
+    static std::string seedToHex(const Seed &seed);
+
+    static std::optional<Seed> seedFromHex(const std::string &hex);
+
+    /**
+     * @brief Writes the random stream of seed for [offset, offset + len) into buf
+     * @param offset multiple of 16 (the AES block size)
+     */
+    static bool generate(const Seed &seed, uint64_t offset, unsigned char* buf, size_t len);
+
+    /**
+     * @brief Overwrites the whole target with pattern
+     * @param target block device (or file, which is overwritten up to its current size)
+     */
+    static Result fill(const std::string &target, Pattern pattern, const Options &opts = {});
+
+    /**
+     * @brief Reads the target back on several threads and compares it with zeros or the regenerated stream of seed
+     * @param seed the seed of the random pass, std::nullopt to expect zeros
+     */
+    static VerifyResult verify(const std::string &target, const std::optional<Seed> &seed, const Options &opts = {});
+
+    /**
+     * @brief Statistical check of a wipe: reads random (and optionally every stride-th) DIRECT_ALIGN block in parallel
+     * and compares them with zeros or the regenerated stream of seed
+     * Takes seconds instead of a full read back. If none of n random blocks fails, at most 1 - (1 - confidence)^(1/n)
+     * of the drive can be unwiped; with a stride no unwiped run longer than the stride can have been missed at all.
+     * @param seed the seed of the last (random) pass, std::nullopt to expect zeros
+     */
+    static SampleResult sampleVerify(const std::string &target, const std::optional<Seed> &seed, const SampleOptions &sopts = {}, const Options &opts = {});
+
+    /**
+     * @brief Prints confidence, coverage and the non-conforming ranges of a sampleVerify() run
+     */
+    static void printSampleReport(const SampleResult &res);
+
+    /**
+     * @brief Prints the verify result (matched or every mismatching range) to the terminal
+     */
+    static void printVerifyReport(const VerifyResult &res);
+};
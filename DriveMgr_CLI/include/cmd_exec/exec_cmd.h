@@ -69,7 +69,7 @@ public:
 
         // Execute via low-level runner
         ExecResult r = run_command(final_cmd.c_str());
-        b_done = true;
+        SimpleSpinner::stop(b_done);
         
         // Spinner
         if (spinner.joinable()) {
@@ -40,6 +40,9 @@ namespace Globals{
     /** @brief Global variable to hold the path to the configuration source file, set by --config-src flag */
     extern std::string g_config_src_path;
 
+    /** @brief Global variable to hold the I/O QoS spec set by --io-qos, overrides the IO_QOS* config values for every operation */
+    extern std::string g_io_qos_spec;
+
 
     // === program state globals ===
 
@@ -52,6 +55,9 @@ namespace Globals{
     /** @brief Global varibale to enable/disable debug messages */
     extern bool g_debug;
 
+    /** @brief Global variable to indicate NDJSON output of the read-only operations, set by --json flag; stdout then carries nothing else */
+    extern bool g_json;
+
 
     // === altTerminal Screen ===
     /**
@@ -4,6 +4,14 @@
 #include "utils/debug.h"
 #include "cmd_exec/exec_cmd.h"
 #include "utils/StringUtils.hpp"
+#include "utils/IoQos.hpp"
+#include "OperationJournal.hpp"
+#include "FreeSpaceWipe.hpp"
+#include "DiskLister.hpp"
+#include "BlockDevices.hpp"
+#include "IoStats.hpp"
+#include "SpaceCache.hpp"
+#include "utils/JsonWriter.hpp"
 
 // ========== Test Framework ==========
 // v0.9.0 - Simple test harness with result tracking and reporting
@@ -339,6 +347,464 @@ TestResult test_StrUtils_toUpperCase() {
 
 
 
+// ========== I/O QoS Tests ==========
+TestResult test_IoQos_parse() {
+    std::string err;
+    const auto p = IoQos::parse("best-effort:6,wbps=50M,wiops=2000", err);
+
+    if (!p || p->io_class != IoQosPolicy::Class::BestEffort || p->level != 6 || p->wbps != 50ull << 20 || p->wiops != 2000 || p->rbps != 0) {
+        return {"test_IoQos_parse", false, "best-effort:6,wbps=50M,wiops=2000 parsed wrong: " + err};
+    }
+
+    const auto t = IoQos::parse("IDLE, rbps=16777215T", err);
+
+    if (!t || t->io_class != IoQosPolicy::Class::Idle || t->rbps != 16777215ull << 40) {
+        return {"test_IoQos_parse", false, "idle,rbps=16777215T parsed wrong: " + err};
+    }
+
+    for (const std::string bad : {"be:8", "fast", "wbps", "wbps=10X", "wbps=16777216T", "riops=99999999999999999999", "idle,nice=3"}) {
+        if (IoQos::parse(bad, err)) return {"test_IoQos_parse", false, "accepted invalid spec: " + bad};
+    }
+
+    return {"test_IoQos_parse", true, ""};
+}
+
+// ========== Operation Journal Tests ==========
+TestResult test_OperationJournal_roundtrip() {
+    const std::string path = "/tmp/test_drivemgr_journal_12345.journal";
+    OperationJournal journal(path);
+
+    OperationJournal::State state;
+    state.op = OperationJournal::Operation::Burn;
+    state.source = "/tmp/image.iso";
+    state.source_id = "file ino=1:2 size=4096";
+    state.target = "/dev/sdz";
+    state.target_id = "blk size=8192 serial=X";
+    state.block_size = 2048;
+    state.total = 4096;
+    state.compare_before_write = true;
+    state.decompress = true;
+    state.validate_header = true;
+
+    BlockCopy::ChunkDigest d;
+    d.length = 2048;
+    d.sha.fill(0xab);
+
+    if (!journal.begin(state) || !journal.commit(2048, 0, {d})) {
+        journal.remove();
+        return {"test_OperationJournal_roundtrip", false, "Cannot write the journal at " + path};
+    }
+
+    std::string err;
+    const auto loaded = OperationJournal::load(path, err);
+    journal.remove();
+
+    if (!loaded) return {"test_OperationJournal_roundtrip", false, "load failed: " + err};
+
+    if (loaded->op != state.op || loaded->source != state.source || loaded->target_id != state.target_id || loaded->block_size != 2048
+        || loaded->committed != 2048 || loaded->digests.size() != 1 || loaded->digests[0].sha != d.sha) {
+        return {"test_OperationJournal_roundtrip", false, "header or digests changed on the way through the file"};
+    }
+
+    if (!loaded->compare_before_write || !loaded->decompress || !loaded->validate_header) {
+        return {"test_OperationJournal_roundtrip", false, "burn options were not kept"};
+    }
+
+    if (fileExists(path) || fileExists(path + ".sha")) return {"test_OperationJournal_roundtrip", false, "remove() left files behind"};
+
+    return {"test_OperationJournal_roundtrip", true, ""};
+}
+
+TestResult test_OperationJournal_rejects_damaged() {
+    const std::string path = "/tmp/test_drivemgr_journal_damaged_12345.journal";
+    std::string err;
+
+    std::ofstream(path) << "version=1\noperation=clone\ntarget=/dev/sdz\n";
+    const bool incomplete = OperationJournal::load(path, err).has_value();
+
+    std::ofstream(path) << "version=99\noperation=clone\n";
+    const bool future = OperationJournal::load(path, err).has_value();
+
+    // claims a committed range the digest sidecar doesnt have
+    std::ofstream(path) << "version=1\noperation=clone\nsource=/a\ntarget=/b\ntarget_id=x\nblock_size=512\ntotal=1024\npass=0\ncommitted=512\n";
+    const bool uncovered = OperationJournal::load(path, err).has_value();
+
+    std::remove(path.c_str());
+
+    if (incomplete || future || uncovered) return {"test_OperationJournal_rejects_damaged", false, "accepted a damaged journal"};
+
+    return {"test_OperationJournal_rejects_damaged", true, ""};
+}
+
+// ========== Free Space Map Tests ==========
+TestResult test_FreeSpaceWipe_fat_map() {
+    const std::string path = "/tmp/test_drivemgr_fat16_12345.img";
+
+    // FAT16: 512 byte sectors, 1 sector per cluster, 1 reserved sector, one 20 sector FAT, 16 root entries, 5000 clusters
+    const uint64_t total = 1 + 20 + 1 + 5000;
+    std::vector<unsigned char> img(total * 512, 0);
+
+    auto put16 = [&](size_t at, uint16_t v) { img[at] = v & 0xff; img[at + 1] = v >> 8; };
+    auto put32 = [&](size_t at, uint32_t v) { for (int i = 0; i < 4; ++i) img[at + i] = (v >> (8 * i)) & 0xff; };
+
+    std::memcpy(&img[3], "MSDOS5.0", 8);
+    put16(11, 512);
+    img[13] = 1;
+    put16(14, 1);
+    img[16] = 1;
+    put16(17, 16);
+    put16(19, 0);
+    put32(32, static_cast<uint32_t>(total));
+    put16(22, 20);
+    put16(510, 0xAA55);
+
+    // clusters 2, 3 and 10 are in use
+    for (unsigned n : {2u, 3u, 10u}) put16(512 + 2 * n, 0xFFFF);
+
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(img.data()), static_cast<std::streamsize>(img.size()));
+    const auto map = FreeSpaceWipe::readFreeMap(path);
+    std::remove(path.c_str());
+
+    if (!map.error.empty()) return {"test_FreeSpaceWipe_fat_map", false, map.error};
+    if (map.type != FreeSpaceWipe::FsType::Fat16 || map.block_size != 512) return {"test_FreeSpaceWipe_fat_map", false, "wrong FAT type or cluster size"};
+
+    const uint64_t data_start = 22 * 512;
+
+    if (map.free.size() != 2 || map.free[0].offset != data_start + 2 * 512 || map.free[0].length != 6 * 512
+        || map.free[1].offset != data_start + 9 * 512 || map.free_bytes != (5000 - 3) * 512ull) {
+        return {"test_FreeSpaceWipe_fat_map", false, "free ranges dont match the FAT"};
+    }
+
+    return {"test_FreeSpaceWipe_fat_map", true, ""};
+}
+
+TestResult test_FreeSpaceWipe_ext_map() {
+    const std::string path = "/tmp/test_drivemgr_ext_12345.img";
+
+    // one group of 2048 1 KiB blocks: superblock in block 1, descriptors in 2, bitmaps in 3 and 4, inode table in 5-6
+    const uint64_t blocks = 2048;
+    std::vector<unsigned char> img(blocks * 1024, 0);
+
+    auto put16 = [&](size_t at, uint16_t v) { img[at] = v & 0xff; img[at + 1] = v >> 8; };
+    auto put32 = [&](size_t at, uint32_t v) { for (int i = 0; i < 4; ++i) img[at + i] = (v >> (8 * i)) & 0xff; };
+
+    const size_t sb = 1024;
+    put32(sb + 0x04, blocks);
+    put32(sb + 0x14, 1);
+    put32(sb + 0x18, 0);
+    put32(sb + 0x20, 8192);
+    put32(sb + 0x28, 16);
+    put16(sb + 0x38, 0xEF53);
+    put16(sb + 0x3A, 1);
+
+    const size_t gd = 2 * 1024;
+    put32(gd + 0x00, 3);
+    put32(gd + 0x04, 4);
+    put32(gd + 0x08, 5);
+
+    // the bitmap marks blocks 1-100 used
+    for (unsigned b = 0; b < 100; ++b) img[3 * 1024 + b / 8] |= static_cast<unsigned char>(1u << (b % 8));
+
+    auto readImage = [&]() {
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(img.data()), static_cast<std::streamsize>(img.size()));
+        auto map = FreeSpaceWipe::readFreeMap(path);
+        std::remove(path.c_str());
+        return map;
+    };
+
+    auto map = readImage();
+    if (!map.error.empty()) return {"test_FreeSpaceWipe_ext_map", false, map.error};
+
+    if (map.type != FreeSpaceWipe::FsType::Ext || map.free.size() != 1 || map.free[0].offset != 101 * 1024 || map.free_bytes != (blocks - 101) * 1024) {
+        return {"test_FreeSpaceWipe_ext_map", false, "free ranges dont match the block bitmap"};
+    }
+
+    // BLOCK_UNINIT with checksummed descriptors: the bitmap on disk is ignored and rebuilt from the metadata
+    put32(sb + 0x64, 0x0010);
+    put16(gd + 0x12, 0x0002);
+
+    map = readImage();
+    if (!map.error.empty()) return {"test_FreeSpaceWipe_ext_map", false, map.error};
+
+    if (map.free.size() != 1 || map.free[0].offset != 7 * 1024 || map.free_bytes != (blocks - 7) * 1024) {
+        return {"test_FreeSpaceWipe_ext_map", false, "an uninitialized group was not rebuilt from its metadata"};
+    }
+
+    // bigalloc with 16 blocks per cluster: the bitmap counts clusters, reading it as blocks would free used data
+    put32(sb + 0x64, 0x0010 | 0x0200);
+    put32(sb + 0x1C, 4);
+    put32(sb + 0x24, 512);
+    map = readImage();
+    if (map.error != "ext filesystems with bigalloc are not supported") return {"test_FreeSpaceWipe_ext_map", false, "bigalloc was not rejected: " + map.error};
+    put32(sb + 0x64, 0x0010);
+
+    // not cleanly unmounted
+    put16(sb + 0x3A, 0);
+    if (readImage().error.empty()) return {"test_FreeSpaceWipe_ext_map", false, "accepted a filesystem that wasnt cleanly unmounted"};
+
+    return {"test_FreeSpaceWipe_ext_map", true, ""};
+}
+
+// ========== Mount Index Tests ==========
+TestResult test_DiskLister_mount_index() {
+    const std::string path = "/tmp/test_drivemgr_mountinfo_12345";
+
+    std::ofstream(path) << "36 35 8:1 / /mnt/my\\040disk rw,relatime shared:1 - ext4 /dev/sdz1 rw\n"
+                        << "37 35 0:52 / /mnt/pool rw,relatime - btrfs /dev/sdz2 rw,space_cache=v2\n"
+                        << "38 35 0:52 /home /home rw,relatime - btrfs /dev/sdz2 rw\n"
+                        << "39 35 0:53 / /mnt/back\\134slash rw - fuse.sshfs host:/a\\040b rw\n";
+
+    const auto index = DiskLister::loadMountIndex(path);
+    std::remove(path.c_str());
+
+    const auto ext = index.of("8:1", "/dev/sdz1");
+    if (ext.size() != 1 || ext[0].mountpoint != "/mnt/my disk" || ext[0].fstype != "ext4") {
+        return {"test_DiskLister_mount_index", false, "escaped mount point was not decoded"};
+    }
+
+    // the partition of a btrfs mount has its own number (8:2), the mount shows 0:52
+    const auto btrfs = index.of("8:2", "/dev/sdz2");
+    if (btrfs.size() != 2 || btrfs[0].mountpoint != "/mnt/pool" || btrfs[1].mountpoint != "/home") {
+        return {"test_DiskLister_mount_index", false, "btrfs mounts were not found by their source"};
+    }
+
+    const auto fuse = index.of("0:53", "");
+    if (fuse.size() != 1 || fuse[0].mountpoint != "/mnt/back\\slash" || fuse[0].source != "host:/a b") {
+        return {"test_DiskLister_mount_index", false, "escaped backslash or source was not decoded"};
+    }
+
+    if (!index.of("8:3", "/dev/sdz3").empty()) return {"test_DiskLister_mount_index", false, "found mounts of an unmounted device"};
+
+    return {"test_DiskLister_mount_index", true, ""};
+}
+
+// ========== Block Device Tests ==========
+TestResult test_BlockDevices_lsblkSize() {
+    // what lsblk prints for these sizes
+    const std::vector<std::pair<uint64_t, std::string>> cases = {
+        {0, "0B"}, {512, "512B"}, {1023, "1023B"}, {1024, "1K"}, {1536, "1.5K"}, {1048575, "1024K"},
+        {521142272, "497M"}, {274877906944ULL, "256G"}, {500107862016ULL, "465.8G"}, {1000204886016ULL, "931.5G"},
+        {UINT64_MAX, "16E"},
+    };
+
+    for (const auto &[bytes, expected] : cases) {
+        const std::string got = BlockDevices::lsblkSize(bytes);
+        if (got != expected) return {"test_BlockDevices_lsblkSize", false, std::to_string(bytes) + " gave " + got + ", lsblk prints " + expected};
+    }
+
+    return {"test_BlockDevices_lsblkSize", true, ""};
+}
+
+// ========== Drive Table Tests ==========
+TestResult test_StringPool_intern() {
+    static_assert(!std::is_copy_constructible_v<StringPool> && std::is_move_constructible_v<StringPool>);
+
+    StringPool pool;
+    if (pool.intern("") != StringPool::EMPTY || pool.size() != 1) return {"test_StringPool_intern", false, "the empty string is not id 0"};
+
+    std::vector<StringPool::Id> ids;
+    for (int i = 0; i < 1000; ++i) ids.push_back(pool.intern("string number " + std::to_string(i)));
+
+    if (pool.intern(std::string("string number 7")) != ids[7] || pool.size() != 1001) return {"test_StringPool_intern", false, "a repeated string got a new id"};
+
+    // the lookups go through views into the moved strings
+    StringPool moved(std::move(pool));
+
+    for (int i = 0; i < 1000; i += 97) {
+        const std::string s = "string number " + std::to_string(i);
+        if (moved.intern(s) != ids[i] || moved.str(ids[i]) != s) return {"test_StringPool_intern", false, "ids changed after a move"};
+    }
+
+    moved.clear();
+    if (moved.size() != 1 || moved.intern("x") != 1) return {"test_StringPool_intern", false, "clear() didnt start over"};
+
+    return {"test_StringPool_intern", true, ""};
+}
+
+TestResult test_DriveTable_view() {
+    DriveTable table;
+    table.put({"/dev/sdc", "1T", "disk", "", "", "OK", 1ULL << 40});
+    table.put({"/dev/sda", "256G", "disk", "/", "ext4", "OK", 256ULL << 30});
+    table.put({"/dev/nvme0n1", "512G", "nvme", "/home", "btrfs", "OK", 512ULL << 30});
+    table.put({"/dev/sdb", "8G", "usb", "/media/stick", "vfat", "OK", 8ULL << 30});
+
+    using Col = DriveTable::Column;
+    auto devicesOf = [&](const std::vector<uint32_t> &v) {
+        std::string out;
+        for (auto pos : v) out += table.text(Col::Device, pos) + " ";
+        return out;
+    };
+
+    const auto all = devicesOf(table.view("", Col::Device, false));
+    if (all != "/dev/nvme0n1 /dev/sda /dev/sdb /dev/sdc ") return {"test_DriveTable_view", false, "not in device order: " + all};
+
+    const auto by_size = devicesOf(table.view("", Col::Size, true));
+    if (by_size != "/dev/sdc /dev/nvme0n1 /dev/sda /dev/sdb ") return {"test_DriveTable_view", false, "not sorted by bytes: " + by_size};
+
+    // equal types keep device order
+    const auto by_type = devicesOf(table.view("", Col::Type, false));
+    if (by_type != "/dev/sda /dev/sdc /dev/nvme0n1 /dev/sdb ") return {"test_DriveTable_view", false, "sort by type isnt stable: " + by_type};
+
+    const auto filtered = devicesOf(table.view("EXT", Col::Device, false));
+    if (filtered != "/dev/sda ") return {"test_DriveTable_view", false, "case insensitive filter matched " + filtered};
+
+    if (!table.view("no such thing", Col::Device, false).empty()) return {"test_DriveTable_view", false, "a filter matching nothing returned rows"};
+
+    return {"test_DriveTable_view", true, ""};
+}
+
+// ========== I/O Statistics Tests ==========
+TestResult test_IoStatSampler_rates() {
+    DiskStat p{"sdz"}, c{"sdz"};
+    p.reads = 100; p.read_sectors = 2000; p.read_ms = 50; p.writes = 50;
+    c.reads = 300; c.read_sectors = 6000; c.read_ms = 450; c.writes = 10;   // writes went backwards: re-added
+    c.io_ms = 1000; c.weighted_ms = 3000; c.in_flight = 4;
+
+    DiskStat added{"sdy"};
+    added.reads = 500;
+    added.in_flight = 1;
+
+    const auto rates = IoStatSampler::rates({p}, {c, added}, 2.0);
+    if (rates.size() != 2) return {"test_IoStatSampler_rates", false, "expected one rate per current device"};
+
+    const IoRates &r = rates[0];
+    auto near = [](double a, double b) { return std::fabs(a - b) < 1e-9; };
+
+    if (!near(r.r_s, 100) || !near(r.rkb_s, 1000) || !near(r.r_await, 2) || !near(r.rareq_sz, 10)) {
+        return {"test_IoStatSampler_rates", false, "read rates dont match iostat's formulas"};
+    }
+
+    if (!near(r.util, 50) || !near(r.aqu_sz, 1.5) || r.in_flight != 4) return {"test_IoStatSampler_rates", false, "util, queue size or in flight are off"};
+    if (r.w_s != 0 || r.w_await != 0) return {"test_IoStatSampler_rates", false, "a counter that went backwards gave a rate"};
+    if (rates[1].r_s != 0 || rates[1].in_flight != 1) return {"test_IoStatSampler_rates", false, "a device missing from the previous sample gave a rate"};
+
+    IoStatSampler missing({"no_such_disk_12345"}, false);
+    if (missing.error().empty()) return {"test_IoStatSampler_rates", false, "a device without a stat file was not reported"};
+
+    return {"test_IoStatSampler_rates", true, ""};
+}
+
+// ========== Directory Usage Cache Tests ==========
+TestResult test_SpaceCache_parse() {
+    SpaceTree tree;
+    tree.root = "/mnt/data";
+    tree.dev = 2049;
+    tree.dirs.resize(3);
+
+    tree.dirs[0].name = "/mnt/data";
+    tree.dirs[0].parent = 0;
+    tree.dirs[0].ino = 2;
+    tree.dirs[0].mtime_ns = 100;
+    tree.dirs[0].own_bytes = 4096;
+    tree.dirs[0].own_apparent = 4096;
+    tree.dirs[0].own_files = 1;
+
+    tree.dirs[1].name = "home";
+    tree.dirs[1].parent = 0;
+    tree.dirs[1].ino = 3;
+    tree.dirs[1].mtime_ns = 200;
+    tree.dirs[1].own_bytes = 8192;
+    tree.dirs[1].own_apparent = 9000;
+    tree.dirs[1].own_files = 2;
+
+    tree.dirs[2].name = "user";
+    tree.dirs[2].parent = 1;
+    tree.dirs[2].ino = 4;
+    tree.dirs[2].mtime_ns = 300;
+    tree.dirs[2].own_bytes = 1 << 20;
+    tree.dirs[2].own_apparent = 1 << 20;
+    tree.dirs[2].own_files = 5;
+
+    tree.dirs[2].largest.push_back({"big.iso", 1 << 19, 1 << 19});
+    tree.dirs[2].links.push_back({77, 4096, 10, true});
+
+    const std::string data = SpaceCache::serialize(tree);
+    std::string err;
+    const auto loaded = SpaceCache::parse(data, err);
+
+    if (!loaded) return {"test_SpaceCache_parse", false, "a fresh cache didnt parse: " + err};
+
+    if (loaded->root != tree.root || loaded->dev != tree.dev || loaded->dirs.size() != 3 || loaded->dirs[2].name != "user"
+        || loaded->dirs[2].largest.size() != 1 || loaded->dirs[2].largest[0].name != "big.iso" || loaded->dirs[2].links.size() != 1 || !loaded->dirs[2].links[0].counted) {
+        return {"test_SpaceCache_parse", false, "directories changed on the way through the cache"};
+    }
+
+    // children and totals are rebuilt
+    if (loaded->dirs[0].bytes != 4096 + 8192 + (1 << 20) || loaded->dirs[0].files != 8 || loaded->dirs[0].dirs != 2 || loaded->dirs[1].children.size() != 1) {
+        return {"test_SpaceCache_parse", false, "totals or children were not rebuilt"};
+    }
+
+    for (const size_t cut : {size_t{4}, size_t{20}, data.size() / 2, data.size() - 1}) {
+        if (SpaceCache::parse(data.substr(0, cut), err)) return {"test_SpaceCache_parse", false, "accepted a cache cut at " + std::to_string(cut)};
+    }
+
+    if (SpaceCache::parse(data + "x", err)) return {"test_SpaceCache_parse", false, "accepted trailing bytes"};
+
+    std::string other = data;
+    other[0] = 'X';
+    if (SpaceCache::parse(other, err)) return {"test_SpaceCache_parse", false, "accepted a wrong magic"};
+
+    // a parent after its child would loop in path() and finish()
+    tree.dirs[1].parent = 2;
+    if (SpaceCache::parse(SpaceCache::serialize(tree), err)) return {"test_SpaceCache_parse", false, "accepted a child before its parent"};
+
+    if (SpaceCache::defaultPath("/a_b") == SpaceCache::defaultPath("/a/b") || SpaceCache::defaultPath("/") == SpaceCache::defaultPath("/root")
+        || SpaceCache::defaultPath("/a%5Fb") == SpaceCache::defaultPath("/a_b")) {
+        return {"test_SpaceCache_parse", false, "two roots share a cache file"};
+    }
+
+    const std::string long_root = "/" + std::string(300, 'x');
+    if (std::filesystem::path(SpaceCache::defaultPath(long_root)).filename().string().size() > 255
+        || SpaceCache::defaultPath(long_root) == SpaceCache::defaultPath(long_root + "y")) {
+        return {"test_SpaceCache_parse", false, "a long root gave an invalid or shared file name"};
+    }
+
+    return {"test_SpaceCache_parse", true, ""};
+}
+
+// ========== JSON Output Tests ==========
+TestResult test_JsonWriter_escaping() {
+    auto json = [](const std::string &s) {
+        std::ostringstream os;
+        JsonWriter(os).value(s);
+        return os.str();
+    };
+
+    const std::string R = "\\ufffd";
+
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"plain", "\"plain\""},
+        {"a\"b\\c", "\"a\\\"b\\\\c\""},
+        {"\n\r\t\x01\x1f", "\"\\n\\r\\t\\u0001\\u001f\""},
+        {"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80", "\"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\""},   // 2, 3 and 4 byte sequences pass
+        {"\xf5\x80\x80\x80", "\"" + R + R + R + R + "\""},                                       // lead bytes past U+10FFFF
+        {"\xf8\x80\x80", "\"" + R + R + R + "\""},
+        {"\xff", "\"" + R + "\""},
+        {"\xc0\x80", "\"" + R + R + "\""},                                                       // overlong
+        {"\xe0\x80\x80", "\"" + R + R + R + "\""},
+        {"\xf0\x80\x80\x80", "\"" + R + R + R + R + "\""},
+        {"\xed\xa0\x80", "\"" + R + R + R + "\""},                                               // surrogate
+        {"\xf4\x90\x80\x80", "\"" + R + R + R + R + "\""},                                       // U+110000
+        {"a\xe2\x82", "\"a" + R + R + "\""},                                                     // cut short
+    };
+
+    for (const auto &[in, expected] : cases) {
+        const std::string got = json(in);
+        if (got != expected) return {"test_JsonWriter_escaping", false, "wrote " + got + " instead of " + expected};
+    }
+
+    std::ostringstream os;
+    JsonWriter out(os);
+    out.beginObject().field("record", "x").field("n", -3).field("list", std::vector<std::string>{"a", "b"})
+       .field("none", std::optional<int>{}).field("ok", true).endObject().endRecord();
+
+    if (os.str() != "{\"record\":\"x\",\"n\":-3,\"list\":[\"a\",\"b\"],\"none\":null,\"ok\":true}\n") {
+        return {"test_JsonWriter_escaping", false, "record was written as " + os.str()};
+    }
+
+    return {"test_JsonWriter_escaping", true, ""};
+}
+
 std::vector<TestResult> run_all_tests_internal() {
     std::vector<TestResult> results;
 
@@ -375,6 +841,36 @@ std::vector<TestResult> run_all_tests_internal() {
     results.push_back(test_StrUtils_toLowerCase());
     results.push_back(test_StrUtils_toUpperCase());
 
+    std::cout << "\n" << CYAN << "[I/O QoS Tests]" << RESET << "\n";
+    results.push_back(test_IoQos_parse());
+
+    std::cout << "\n" << CYAN << "[Operation Journal Tests]" << RESET << "\n";
+    results.push_back(test_OperationJournal_roundtrip());
+    results.push_back(test_OperationJournal_rejects_damaged());
+
+    std::cout << "\n" << CYAN << "[Free Space Map Tests]" << RESET << "\n";
+    results.push_back(test_FreeSpaceWipe_fat_map());
+    results.push_back(test_FreeSpaceWipe_ext_map());
+
+    std::cout << "\n" << CYAN << "[Mount Index Tests]" << RESET << "\n";
+    results.push_back(test_DiskLister_mount_index());
+
+    std::cout << "\n" << CYAN << "[Block Device Tests]" << RESET << "\n";
+    results.push_back(test_BlockDevices_lsblkSize());
+
+    std::cout << "\n" << CYAN << "[Drive Table Tests]" << RESET << "\n";
+    results.push_back(test_StringPool_intern());
+    results.push_back(test_DriveTable_view());
+
+    std::cout << "\n" << CYAN << "[I/O Statistics Tests]" << RESET << "\n";
+    results.push_back(test_IoStatSampler_rates());
+
+    std::cout << "\n" << CYAN << "[Directory Usage Cache Tests]" << RESET << "\n";
+    results.push_back(test_SpaceCache_parse());
+
+    std::cout << "\n" << CYAN << "[JSON Output Tests]" << RESET << "\n";
+    results.push_back(test_JsonWriter_escaping());
+
     return results;
 }
 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../IoStats.hpp"
+
+// ========== Live I/O statistics ==========
+
+struct IoDashboardOptions {
+    unsigned interval_ms = 1000;
+    unsigned count = 0;                     ///< intervals to show, 0 = until q (or Ctrl-C)
+    bool partitions = false;
+    bool hide_idle = false;
+    std::vector<std::string> devices;       ///< kernel names, empty = every disk
+};
+
+/**
+ * @brief iostat -x like view of the block devices.
+ *
+ * On a terminal the table is drawn once and then only the lines whose text changed are rewritten, at
+ * absolute cursor positions. Keys: q quit, +/- interval, p partitions, i hide idle devices.
+ * Piped, one table per interval is printed like iostat does.
+ */
+class IoDashboard {
+public:
+    using Options = IoDashboardOptions;
+
+    /**
+     * @returns false if a device cant be sampled, err says why
+     */
+    static bool run(const Options &opts, std::string &err);
+
+    static std::string header();
+
+    static std::string formatRow(const IoRates &r);
+};
@@ -3,31 +3,72 @@
 #include "../cmd_exec/exec_cmd.h"
 #include "../DmgrLib.h"
 #include "../DiskLister.hpp"
+#include "../utils/HotplugMonitor.hpp"
+#include "../utils/JsonWriter.hpp"
 
 // ========== TUI drive selection/listing ==========
 
 class ListDrivesUtil {
     private:
-        struct Row {
-            std::string device, size, type, mount, fstype, status;
-        };
+        inline static std::vector<uint32_t> view{};        ///< table positions of the listed rows, filtered and sorted
+        inline static std::vector<std::string> drives{};    ///< every cached drive, sorted, to diff against Globals::g_last_drives
 
-        inline static std::vector<ListDrivesUtil::Row> rows{};
-        
-        struct DriveCache {
-            size_t run_count_idx;
-            std::vector<Row> rows;
-        };
+        inline static bool scanned = false;
+        inline static std::string change_note;     ///< drives that came or went with the last update, shown under the TUI list
 
-        inline static DriveCache drive_cache{};
         inline static DiskLister disk_lister{};
+        inline static HotplugMonitor hotplug{};
+
+        // TUI list state: only the rows of the window starting at top are on screen
+        inline static std::string filter;
+        inline static bool editing = false;         ///< typing a filter after '/'
+        inline static DriveTable::Column sort_key = DriveTable::Column::Device;
+        inline static bool descending = false;
+        inline static size_t top = 0;
+        inline static size_t window = 0;            ///< rows drawn by the last drawTuiRows()
+
+        /**
+         * @brief Brings the table up to date: the inventory cache (or a full scan without one) and the hotplug
+         * monitor start on the first call, afterwards the revalidation result and the queued uevents are applied.
+         * Without a monitor every call rescans.
+         * @returns true if the table changed
+         */
+        static bool syncDrives();
+
+        /**
+         * @brief Rebuilds drives and the view from the DiskLister table and notes the difference to Globals::g_last_drives
+         */
+        static void rebuildRows();
+
+        /**
+         * @brief Device of a view position
+         */
+        static const std::string& deviceAt(size_t pos);
+
+        /**
+         * @brief Rows the window may use: terminal height minus header, status line and some room for the prompt
+         */
+        static size_t windowHeight();
+
+        static void printTuiLine(size_t pos, bool is_selected);
+
+        /**
+         * @brief Draws the visible window, scrolled so selected is on screen, and the status line below it.
+         * Leaves the cursor on the first row.
+         */
+        static void drawTuiRows(size_t selected);
+
+        /**
+         * @brief Repaints the two rows a cursor move inside the window touches, instead of the whole window
+         */
+        static void moveSelection(size_t from, size_t to);
 
         /**
          * @brief This is the Tui menu logic from the listDrive function finaly put in its own function
-         * @param drives use the std::vector<std::string> where you stored your fetched drives
-         * @param rows use the std::verctor<Row> rows, that is only in this class avilable
+         * Works on the view, which hotplug events, the filter (/) and the sort key (s, r) update while the menu is open.
+         * @returns the selected drive
          */
-        static std::string tuiForListDrives(const std::vector<std::string> &drives, std::vector<ListDrivesUtil::Row> &rows);
+        static std::string tuiForListDrives();
 
         static void printDriveRow(int idx, const Row& r);
         
@@ -41,4 +82,11 @@ class ListDrivesUtil {
         static std::string listDrives(bool input_mode);
 
         static std::string listDaDrives(bool input_mode);
+
+        /**
+         * @brief --list-drives --json: one "drive" record per disk, in device order, written from the table columns.
+         * Like the printed list it starts from the inventory cache and waits for the revalidation.
+         * @returns the number of drives written
+         */
+        static size_t writeDrivesJson(JsonWriter &out);
 };
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../DmgrLib.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ========== Throughput/ETA progress line ==========
+
+/**
+ * @brief Progress line for long running byte oriented operations (wipe, clone, image, burn, scan).
+ * The engine only bumps an atomic counter with add(), a render thread draws
+ * "done / total (pct)  current MB/s (avg MB/s)  ETA" and sleeps on a condition variable,
+ * so finish() returns immediately instead of waiting for the next redraw.
+ */
+class ProgressMeter {
+public:
+    /**
+     * @brief Current (smoothed) and average rate of a byte counter
+     * Also used directly by renderers that draw several bars themselves (fan-out copy).
+     */
+    class RateTracker {
+    private:
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point last_time = started;     ///< last sample that went into the smoothed rate
+        std::chrono::steady_clock::time_point last_seen = started;     ///< last update() call
+        uint64_t last_done = 0;
+        uint64_t total_done = 0;
+        double smoothed = 0.0;                  ///< bytes per second
+        bool have_rate = false;
+
+    public:
+        /** @brief feed the counter value, cheap enough to call on every redraw */
+        void update(uint64_t done);
+
+        /** @brief bytes per second over the last few seconds */
+        double current() const { return have_rate ? smoothed : average(); }
+
+        /** @brief bytes per second since construction */
+        double average() const;
+
+        uint64_t done() const { return total_done; }
+    };
+
+    /**
+     * @brief "1.2 GiB / 14.9 GiB (8%)  31.0 MB/s (avg 30.5 MB/s)  ETA 0:07:31"
+     * @param total 0 if unknown, percentage and ETA are left out then
+     */
+    static std::string formatStats(uint64_t total, const RateTracker &rate);
+
+    /**
+     * @brief formats seconds as H:MM:SS
+     */
+    static std::string formatDuration(double seconds);
+
+    ProgressMeter(std::string label, uint64_t total, std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+    ~ProgressMeter();
+
+    ProgressMeter(const ProgressMeter&) = delete;
+    ProgressMeter& operator=(const ProgressMeter&) = delete;
+
+    /** @brief starts the render thread */
+    void start();
+
+    /** @brief called by the engine for every completed unit of work, lock free */
+    void add(uint64_t bytes) { done_bytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+    /** @brief for engines that track an absolute position instead of increments */
+    void set(uint64_t bytes) { done_bytes.store(bytes, std::memory_order_relaxed); }
+
+    void setTotal(uint64_t bytes) { total_bytes.store(bytes, std::memory_order_relaxed); }
+
+    /** @brief short text shown after the numbers (e.g. the current pass), redraws right away */
+    void setStatus(const std::string &status);
+
+    /** @brief prints a line above the progress line without garbling it */
+    void print(const std::string &line);
+
+    /** @brief stops the render thread and leaves the final numbers on screen */
+    void finish();
+
+    uint64_t done() const { return done_bytes.load(std::memory_order_relaxed); }
+
+private:
+    std::string label;
+    std::chrono::milliseconds interval;
+    std::atomic<uint64_t> done_bytes{0};
+    std::atomic<uint64_t> total_bytes{0};
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string status;
+    bool dirty = false;
+    bool finished = false;
+    std::thread renderer;
+    RateTracker rate;
+
+    /** @brief draws the line, mtx must be held */
+    void render();
+
+    void renderLoop();
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../SpaceWalker.hpp"
+#include "../utils/SpaceMonitor.hpp"
+#include "../utils/JsonWriter.hpp"
+
+// ========== Directory usage tree ==========
+
+/**
+ * @brief ncdu-like view of a SpaceTree: the subdirectories and largest files of one directory, by size.
+ *
+ * Interactive on a terminal: arrows (or j/k) move, Enter or right opens a directory, left or
+ * Backspace goes up, q quits. Piped, print() writes the top entries as an indented tree.
+ *
+ * Live, the directories a SpaceMonitor reports are collected until things calm down for half a second
+ * (two at most), then the tree is walked again incrementally with them marked dirty and redrawn on the
+ * same path.
+ */
+class SpaceBrowser {
+public:
+    /**
+     * @brief One line of a directory: a subdirectory, a file, or the rest of its files taken together
+     */
+    struct Entry {
+        std::string name;
+        uint64_t bytes = 0;
+        int64_t dir = -1;               ///< index in SpaceTree::dirs, -1 for files
+    };
+
+    /**
+     * @brief Subdirectories and the kept largest files of dir, by size descending; the files that were not
+     * kept (and the directory's own blocks) are summed up in one "<other files>" entry
+     */
+    static std::vector<Entry> entries(const SpaceTree &tree, uint32_t dir);
+
+    /**
+     * @brief "  12.3 GiB  45.6%  [#########           ]  name/"
+     */
+    static std::string formatEntry(const Entry &entry, uint64_t parent_bytes);
+
+    /**
+     * @brief top entries of every directory, down to depth levels below the root
+     */
+    static void print(const SpaceTree &tree, size_t top, unsigned depth);
+
+    /**
+     * @brief --du --json: a "walk" record with the totals, then a "dir" record for the root and, depth levels
+     * down, for the top largest subdirectories of each, parents first
+     */
+    static void writeJson(JsonWriter &out, const SpaceTree &tree, size_t top, unsigned depth);
+
+    /**
+     * @param tree updated in place in live mode
+     * @param monitor nullptr for a static view
+     * @param opts walker options for the live updates
+     */
+    static void browse(SpaceTree &tree, SpaceMonitor* monitor = nullptr, const SpaceWalker::Options &opts = {});
+};
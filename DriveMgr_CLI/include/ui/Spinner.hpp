@@ -4,6 +4,8 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 class SimpleSpinner {
 private:
@@ -11,7 +13,10 @@ private:
     static std::array<std::string, 4> frames;
     static int idx;
 
-    static void tick();
+    static std::mutex mtx;
+    static std::condition_variable cv;
+
+    static void tick(std::chrono::steady_clock::duration elapsed);
 
     static void done();
 
@@ -19,6 +24,11 @@ public:
 
     static void progressSpinner(std::atomic<bool> &b_done);
 
+    /**
+     * @brief Sets b_done and wakes the spinner, so it doesnt finish its current frame first
+     */
+    static void stop(std::atomic<bool> &b_done);
+
 };
 
-#define SPINNER(b_done) SimpleSpinner::progressSpinner(b_done);
\ No newline at end of file
+#define SPINNER(b_done) SimpleSpinner::progressSpinner(b_done);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+// ========== Low level block I/O helpers ==========
+// shared by the native engines (BlockCopy, ...) so none of them has to shell out to dd
+
+namespace BlockIOUtils {
+    /** @brief Alignment that satisfies O_DIRECT on every device we care about */
+    constexpr size_t DIRECT_ALIGN = 4096;
+
+    /** @brief Sector size used for precise range reporting */
+    constexpr size_t SECTOR_SIZE = 512;
+
+    /**
+     * @brief Heap buffer aligned to DIRECT_ALIGN, usable for O_DIRECT reads and writes
+     */
+    class AlignedBuffer {
+    private:
+        unsigned char* buf = nullptr;
+        size_t len = 0;
+
+    public:
+        explicit AlignedBuffer(size_t size);
+        ~AlignedBuffer();
+
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+        unsigned char* data() { return buf; }
+        const unsigned char* data() const { return buf; }
+        size_t size() const { return len; }
+        bool valid() const { return buf != nullptr; }
+    };
+
+    /**
+     * @brief Rounds n up to the next multiple of align (align must be a power of two)
+     */
+    inline uint64_t roundUp(uint64_t n, uint64_t align) { return (n + align - 1) & ~(align - 1); }
+
+    /**
+     * @brief pread() that retries on EINTR and short reads until len bytes or EOF
+     * @returns bytes read (less than len at EOF or if an error follows a partial read), -1 on error with errno set
+     */
+    ssize_t preadFull(int fd, unsigned char* buf, size_t len, uint64_t offset);
+
+    /**
+     * @brief read() for pipes and other unseekable fds, retries on EINTR and short reads until len bytes or EOF
+     * @returns bytes read (less than len only at EOF), -1 on error with errno set
+     */
+    ssize_t readFull(int fd, unsigned char* buf, size_t len);
+
+    /**
+     * @brief pwrite() that retries on EINTR and short writes
+     * @returns true if all len bytes were written, false with errno set otherwise
+     */
+    bool pwriteFull(int fd, const unsigned char* buf, size_t len, uint64_t offset);
+
+    /**
+     * @brief Size of a block device (BLKGETSIZE64) or regular file (st_size)
+     * @returns size in bytes, 0 if it couldnt be determined
+     */
+    uint64_t sizeOfFd(int fd);
+
+    /**
+     * @brief sizeOfFd() for a path
+     * @returns size in bytes, 0 if it couldnt be opened or determined
+     */
+    uint64_t sizeOfPath(const std::string &path);
+
+    /**
+     * @brief Opens path for reading with O_DIRECT so reads bypass the page cache
+     * Falls back to a buffered fd with the cached pages dropped if the filesystem refuses O_DIRECT.
+     * @param is_direct set to true if the returned fd really uses O_DIRECT
+     * @returns fd or -1 with errno set
+     */
+    int openDirectRead(const std::string &path, bool &is_direct);
+
+    /**
+     * @brief Writes data to path.tmp, flushes it and renames it over path, then flushes the directory entry
+     * Readers see either the old or the new file, never a torn one.
+     */
+    bool replaceFile(const std::string &path, const std::string &data);
+
+    /**
+     * @brief lowercase hex of len bytes
+     */
+    std::string toHex(const unsigned char* data, size_t len);
+
+    /**
+     * @brief formats a byte count as a human readable string (e.g. "3.7 GiB")
+     */
+    std::string humanBytes(uint64_t bytes);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+
+// ========== Compressed image sources ==========
+// lets the burn paths take .img.xz/.img.gz/.img.zst directly, the image is decompressed
+// by the format's own tool in a child process while BlockCopy writes what comes out of the pipe
+
+namespace CompressedImage {
+    enum class Format {
+        None, Xz, Gzip, Zstd
+    };
+
+    /**
+     * @brief Detects the compression from the magic bytes (the file extension is not trusted)
+     * @returns Format::None for uncompressed or unreadable files
+     */
+    Format detect(const std::string &path);
+
+    std::string formatName(Format format);
+
+    /**
+     * @brief A running decompressor, its stdout is the decompressed image
+     */
+    struct Decompressor {
+        pid_t pid = -1;
+        int fd = -1;            ///< read end of the child's stdout
+        int err_fd = -1;        ///< read end of the child's stderr, read once it exited
+        std::string tool;       ///< e.g. "xz -dc -T0", for messages
+    };
+
+    /**
+     * @brief Starts the decompressor for path, without a shell
+     * xz runs with -T0 (multithreaded for multi-block files, xz >= 5.4), gzip prefers pigz
+     * (separate read/inflate/write/check threads) and zstd uses the zstd CLI.
+     * @param err set to the reason if no tool could be started
+     */
+    std::optional<Decompressor> spawn(const std::string &path, Format format, std::string &err);
+
+    /**
+     * @brief Closes the pipes and reaps the child
+     * @param consumed true if the whole stream was read, otherwise the child was cut off on purpose and its exit status is ignored
+     * @param err set to the tool's error output if it failed
+     * @returns true if the tool exited successfully (or was cut off with consumed = false)
+     */
+    bool finish(Decompressor &dec, bool consumed, std::string &err);
+
+    /**
+     * @brief Decompressed size if the format records it reliably (xz index), 0 if unknown
+     */
+    uint64_t decompressedSize(const std::string &path, Format format);
+
+    /**
+     * @brief true if the tool for format is installed (pigz or gzip for Gzip)
+     */
+    bool toolAvailable(Format format);
+}
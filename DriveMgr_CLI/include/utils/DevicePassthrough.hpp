@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+// ========== Device command passthrough ==========
+// raw ATA (through the SCSI/ATA translation layer, SG_IO) and NVMe admin commands,
+// for the things the block layer has no ioctl for (identify, sanitize, format)
+
+namespace DevicePassthrough {
+    enum class Status {
+        Ok,
+        Unsupported,        ///< the device (or the bridge in front of it) rejected the command
+        Failed
+    };
+
+    /**
+     * @brief Taskfile of an ATA command, the output registers are written back after the command
+     */
+    struct AtaRegisters {
+        bool ext = false;               ///< 48-bit command
+        uint16_t features = 0;
+        uint16_t count = 0;
+        uint64_t lba = 0;
+        uint8_t device = 0;
+        uint8_t command = 0;
+
+        uint8_t status = 0;             ///< returned
+        uint8_t error = 0;              ///< returned
+    };
+
+    /**
+     * @brief ATA PASS-THROUGH (16)
+     * @param buf data-in buffer of len bytes (PIO), nullptr for a non-data command whose output registers are read back
+     * @param err set to the reason unless Status::Ok
+     */
+    Status ataCommand(int fd, AtaRegisters &regs, unsigned char* buf, size_t len, unsigned timeout_ms, std::string &err);
+
+    /**
+     * @brief IDENTIFY DEVICE, 256 little endian words
+     */
+    Status ataIdentify(int fd, std::array<uint16_t, 256> &words, std::string &err);
+
+    /**
+     * @brief SCSI INQUIRY, the standard data or (evpd) the vital product data page
+     * @param len allocation length, the device may return less (see the page's own length field)
+     */
+    Status scsiInquiry(int fd, bool evpd, uint8_t page, unsigned char* buf, uint16_t len, std::string &err);
+
+    struct NvmeCommand {
+        uint8_t opcode = 0;
+        uint32_t nsid = 0;
+        uint32_t cdw10 = 0;
+        uint32_t cdw11 = 0;
+        void* data = nullptr;           ///< data-in buffer
+        uint32_t data_len = 0;
+        uint32_t timeout_ms = 0;        ///< 0 = the driver's admin timeout
+
+        uint32_t result = 0;            ///< dword 0 of the completion
+    };
+
+    /**
+     * @brief Submits an admin command through NVME_IOCTL_ADMIN_CMD on a namespace or controller node
+     */
+    Status nvmeAdmin(int fd, NvmeCommand &cmd, std::string &err);
+
+    /**
+     * @brief Identify with the given CNS (0 namespace, 1 controller, 2 active namespace list)
+     */
+    Status nvmeIdentify(int fd, uint32_t cns, uint32_t nsid, std::array<unsigned char, 4096> &out, std::string &err);
+
+    /**
+     * @brief Get Log Page, len must be a multiple of 4
+     */
+    Status nvmeLogPage(int fd, uint8_t lid, uint32_t nsid, unsigned char* buf, uint32_t len, std::string &err);
+
+    /**
+     * @brief Namespace id of an NVMe block device node (NVME_IOCTL_ID)
+     */
+    std::optional<uint32_t> nvmeNamespaceId(int fd);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ========== Block device hotplug ==========
+// keeps the drive list current while the program runs, without rescanning every drive
+
+/**
+ * @brief Listens for kernel uevents (NETLINK_KOBJECT_UEVENT) of the block subsystem and for mount table changes.
+ *
+ * A background thread queues the events; notifyFd() turns readable while the queue holds any, so a TUI
+ * can poll() it next to stdin and apply them with drain().
+ */
+class HotplugMonitor {
+public:
+    struct Event {
+        enum class Action {
+            Add, Remove, Change,
+            Mounts,             ///< /proc/self/mountinfo changed, mounts raise no uevent
+            Resync              ///< events were lost (socket overrun, renames), rescan everything
+        };
+
+        Action action = Action::Change;
+        std::string name;       ///< kernel name, e.g. "sdb1"
+        std::string disk;       ///< the whole disk it belongs to, e.g. "sdb"
+        std::string devtype;    ///< "disk" or "partition"
+        std::string devpath;    ///< below /sys, e.g. "/devices/.../block/sdb/sdb1"
+    };
+
+    HotplugMonitor() = default;
+    ~HotplugMonitor();
+
+    HotplugMonitor(const HotplugMonitor&) = delete;
+    HotplugMonitor& operator=(const HotplugMonitor&) = delete;
+
+    /**
+     * @brief Opens the uevent socket and starts the listener thread
+     * @param err set to the reason if the socket cant be opened (e.g. inside some containers)
+     */
+    bool start(std::string &err);
+
+    void stop();
+
+    bool running() const { return listener.joinable(); }
+
+    /**
+     * @brief Readable while events are queued, -1 if the monitor isnt running
+     */
+    int notifyFd() const { return notify_fd; }
+
+    /**
+     * @brief Takes the queued events, in arrival order
+     */
+    std::vector<Event> drain();
+
+    /**
+     * @brief Parses one uevent datagram ("add@/devices/...\0ACTION=add\0SUBSYSTEM=block\0...")
+     * @returns std::nullopt for anything but block devices
+     */
+    static std::optional<Event> parse(const char* msg, size_t len);
+
+private:
+    int sock = -1;
+    int mounts_fd = -1;
+    int notify_fd = -1;     ///< eventfd, counts queued events
+    int stop_fd = -1;       ///< eventfd, wakes the listener on stop()
+
+    std::thread listener;
+    std::mutex mtx;
+    std::vector<Event> queue;
+
+    void listen();
+    void push(Event event);
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// ========== I/O quality of service ==========
+// keeps clone/burn/wipe/image jobs from starving the real workload of the host
+
+/**
+ * @brief How much of the disks an operation may use
+ */
+struct IoQosPolicy {
+    enum class Class {
+        Normal, BestEffort, Idle
+    };
+
+    /// ioprio of the engine threads. It orders their reads and O_DIRECT writes in BFQ, buffered writes are
+    /// issued later by the kernel writeback threads and only the io.max limits below reach those
+    Class io_class = Class::Normal;
+    int level = 4;                  ///< best-effort priority, 0 (highest) to 7 (lowest)
+    uint64_t rbps = 0;              ///< io.max read bytes/s, 0 = unlimited
+    uint64_t wbps = 0;              ///< io.max write bytes/s
+    uint64_t riops = 0;             ///< io.max read IOs/s
+    uint64_t wiops = 0;             ///< io.max write IOs/s
+
+    bool limited() const { return rbps || wbps || riops || wiops; }
+    bool active() const { return io_class != Class::Normal || limited(); }
+};
+
+class IoQos {
+public:
+    enum class Operation {
+        Clone, Burn, Wipe, Image
+    };
+
+    /**
+     * @brief Parses "class[:level][,key=value...]", e.g. "idle", "best-effort:6,wbps=50M,wiops=2000"
+     * Rates accept K/M/G/T suffixes (powers of 1024), values that overflow 64 bits are rejected.
+     * @param err set to the reason if parsing fails
+     */
+    static std::optional<IoQosPolicy> parse(const std::string &spec, std::string &err);
+
+    /**
+     * @brief Formats a policy back into the spec syntax (for the config view and logs)
+     */
+    static std::string describe(const IoQosPolicy &policy);
+
+    static void setPolicy(Operation op, const IoQosPolicy &policy);
+
+    static IoQosPolicy policy(Operation op);
+
+    /**
+     * @brief Applies the I/O priority of the active Scope to the calling thread
+     * Engines call this at the start of every worker thread, it is a no-op without a Scope.
+     */
+    static void enterThread();
+
+    /**
+     * @brief Applies an operation's policy for its lifetime.
+     * Sets the ioprio of the constructing thread (restored on destruction) and, if the policy has
+     * limits and cgroup v2 is mounted, moves the process into a cgroup whose io.max limits the given
+     * devices: a transient systemd scope, or without systemd a child of the root cgroup (the io
+     * controller is switched off there again if we switched it on). The process moves back on
+     * destruction. Failures only cost the limit, the operation itself still runs.
+     * A Scope created while another one is alive does nothing.
+     */
+    class Scope {
+    private:
+        IoQosPolicy pol;
+        bool active = false;
+        int saved_ioprio = -1;
+        std::string cgroup_dir;             ///< the limited cgroup, empty if none was joined
+        std::string original_cgroup_dir;    ///< where the process came from
+        std::string scope_unit;             ///< the transient systemd scope, empty without systemd
+        bool enabled_root_io = false;       ///< we wrote +io to the root cgroup.subtree_control
+
+        void setupCgroup(const std::vector<std::string> &paths);
+        void restoreRootController();
+
+    public:
+        /**
+         * @param paths every device or file the operation reads or writes, mapped to their whole disks for io.max
+         */
+        Scope(Operation op, const std::vector<std::string> &paths);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
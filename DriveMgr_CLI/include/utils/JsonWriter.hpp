@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// ========== NDJSON output ==========
+// what --json prints: one JSON object per line, written as the collectors produce the values
+
+/**
+ * @brief Streaming JSON writer. Keys and values go straight to the stream, escaped on the way;
+ * nothing is put together in a string first. Commas and colons are inserted as needed.
+ *
+ *     out.beginObject().field("record", "drive").field("bytes", size).endObject().endRecord();
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream &out) : out(out) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    /**
+     * @brief Member name of the next value, inside an object
+     */
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view s);
+    JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+    JsonWriter& value(const std::string &s) { return value(std::string_view(s)); }
+    JsonWriter& value(bool b);
+    JsonWriter& null();
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    JsonWriter& value(T n) {
+        if constexpr (std::is_signed_v<T>) return integer(static_cast<int64_t>(n));
+        else return integer(static_cast<uint64_t>(n));
+    }
+
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T &v) {
+        key(name);
+        return value(v);
+    }
+
+    /** @brief null for an empty optional */
+    template <typename T>
+    JsonWriter& field(std::string_view name, const std::optional<T> &v) {
+        key(name);
+        return v ? value(*v) : null();
+    }
+
+    /**
+     * @brief An array of strings
+     */
+    JsonWriter& field(std::string_view name, const std::vector<std::string> &v);
+
+    /**
+     * @brief Ends a top level object with a newline, the stream is flushed so a reader sees whole records
+     * @param flush false for records that follow each other quickly (table rows)
+     */
+    void endRecord(bool flush = true);
+
+    void flush() { out.flush(); }
+
+private:
+    std::ostream &out;
+    std::vector<bool> first;            ///< per open object or array: nothing written in it yet
+    bool after_key = false;
+
+    /** @brief The comma before a value or key, if it isnt the first of its container */
+    void separate();
+
+    void string(std::string_view s);
+    JsonWriter& integer(int64_t n);
+    JsonWriter& integer(uint64_t n);
+};
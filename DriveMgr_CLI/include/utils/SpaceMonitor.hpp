@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// ========== Filesystem change monitor ==========
+// tells the live directory usage view which directories to list again
+
+/**
+ * @brief fanotify watch of a whole filesystem (FAN_MARK_FILESYSTEM) reporting directory file handles
+ * (FAN_REPORT_DIR_FID): entries created, deleted or moved and files modified.
+ *
+ * fd() turns readable when events are queued; drain() turns them into the inode numbers of the
+ * directories they happened in. Needs CAP_SYS_ADMIN and kernel 5.9+.
+ */
+class SpaceMonitor {
+public:
+    SpaceMonitor() = default;
+    ~SpaceMonitor();
+
+    SpaceMonitor(const SpaceMonitor&) = delete;
+    SpaceMonitor& operator=(const SpaceMonitor&) = delete;
+
+    /**
+     * @param root any directory of the filesystem, also used to open the reported handles
+     * @param err set to the reason if fanotify is unavailable
+     */
+    bool start(const std::string &root, std::string &err);
+
+    void stop();
+
+    int fd() const { return fan_fd; }
+
+    /**
+     * @brief Reads every queued event, adding the inode of each affected directory to dirty
+     * @returns false if the kernel dropped events (queue overflow), anything may have changed then
+     */
+    bool drain(std::unordered_set<uint64_t> &dirty);
+
+private:
+    int fan_fd = -1;
+    int root_fd = -1;
+    std::unordered_map<std::string, uint64_t> handle_ino;      ///< raw file handle -> inode, open_by_handle_at is not free
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// ========== String interning ==========
+// columns with few distinct values (type, fstype, status, mount points) stored as 4 byte ids
+
+class StringPool {
+public:
+    using Id = uint32_t;
+
+    /** @brief Id of the empty string, always present */
+    static constexpr Id EMPTY = 0;
+
+    StringPool();
+
+    // index views the strings in place: a copy would look up through the other pool's strings,
+    // a move hands over the deque's blocks and keeps them valid
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    /**
+     * @brief Id of s, adding it on first use
+     */
+    Id intern(std::string_view s);
+
+    const std::string& str(Id id) const { return strings[id]; }
+
+    /** @brief Distinct strings held, the empty one included */
+    size_t size() const { return strings.size(); }
+
+    void clear();
+
+private:
+    std::deque<std::string> strings;                    ///< a deque never moves its elements, index keys point into them
+    std::unordered_map<std::string_view, Id> index;
+};
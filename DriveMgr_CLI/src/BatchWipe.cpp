@@ -0,0 +1,506 @@
+#include "../include/BatchWipe.hpp"
+#include "../include/OperationJournal.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/utils/IoQos.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <openssl/sha.h>
+#include <regex>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace BlockIOUtils;
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr unsigned DEFAULT_PER_CONTROLLER = 8;
+    constexpr unsigned DEFAULT_PER_USB_HUB = 2;
+    constexpr int CERTIFICATE_VERSION = 1;
+
+    enum class DriveState {
+        Queued, Running, Done, Failed
+    };
+
+    /**
+     * @brief Wakes the table renderer when a drive made progress or changed its phase
+     */
+    struct Redraw {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool changed = false;
+        bool finished = false;
+
+        void signal(bool last = false) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                changed = true;
+                finished = finished || last;
+            }
+
+            cv.notify_one();
+        }
+    };
+
+    /**
+     * @brief Progress of one drive, written by its wipe thread and read by the table renderer
+     */
+    struct Slot {
+        std::string target;
+        std::string bus;
+        uint64_t size = 0;
+        int fd = -1;                            ///< exclusive claim on a block device, held until its wipe ends
+        Redraw* redraw = nullptr;
+
+        std::atomic<uint64_t> done{0};
+
+        std::mutex mtx;
+        std::string phase = "waiting for its bus";
+        uint64_t phase_total = 0;
+        unsigned phase_id = 0;                  ///< bumped on every phase change so the renderer restarts the rate
+        DriveState state = DriveState::Queued;
+
+        ProgressMeter::RateTracker rate;        ///< only touched by the renderer
+        unsigned rate_phase = 0;
+
+        void setPhase(const std::string &name, uint64_t total) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                phase = name;
+                phase_total = total;
+                ++phase_id;
+                done.store(0, std::memory_order_relaxed);
+            }
+
+            redraw->signal();
+        }
+
+        void setState(DriveState s) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                state = s;
+            }
+
+            redraw->signal();
+        }
+
+        void setDone(uint64_t bytes) {
+            done.store(bytes, std::memory_order_relaxed);
+            redraw->signal();
+        }
+    };
+
+    /**
+     * @brief Counting gate per bus, a wipe waits until fewer than the bus limit are running on its bus
+     */
+    class BusGate {
+    private:
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::map<std::string, unsigned> running;
+
+    public:
+        void acquire(const std::string &bus, unsigned limit) {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return running[bus] < limit; });
+            ++running[bus];
+        }
+
+        void release(const std::string &bus) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                --running[bus];
+            }
+
+            cv.notify_all();
+        }
+    };
+
+    bool isUsbBus(const std::string &bus) {
+        return bus.find("/usb") != std::string::npos;
+    }
+
+    unsigned limitFor(const std::string &bus, const BatchWipeOptions &opts) {
+        if (opts.per_bus > 0) return opts.per_bus;
+        return isUsbBus(bus) ? DEFAULT_PER_USB_HUB : DEFAULT_PER_CONTROLLER;
+    }
+
+    /**
+     * @brief Opens a block device exclusively, so it cant be mounted or assembled while it is wiped
+     * @param busy set if someone else already holds it (mounted, in a RAID, a dm target, ...)
+     * @returns the fd, -1 for files and devices that cant be opened (the wipe reports those itself)
+     */
+    int claim(const std::string &target, bool &busy) {
+        busy = false;
+
+        struct stat st{};
+        if (stat(target.c_str(), &st) != 0 || !S_ISBLK(st.st_mode)) return -1;
+
+        const int fd = open(target.c_str(), O_RDWR | O_EXCL | O_CLOEXEC);
+        if (fd < 0) busy = errno == EBUSY;
+
+        return fd;
+    }
+
+    std::string isoTime(std::chrono::system_clock::time_point tp) {
+        const std::time_t t = std::chrono::system_clock::to_time_t(tp);
+        std::tm utc{};
+        gmtime_r(&t, &utc);
+
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        return buf;
+    }
+
+    std::string hostName() {
+        char buf[256] = {};
+        if (gethostname(buf, sizeof(buf) - 1) != 0) return "unknown";
+        return buf;
+    }
+
+    struct CertificateInfo {
+        std::string identity;
+        std::string seed;                       ///< empty without a random pass
+        std::chrono::system_clock::time_point started;
+        std::chrono::system_clock::time_point finished;
+        bool fully_verified = false;
+    };
+
+    /**
+     * @brief Writes the certificate of a wiped drive, its last line is the SHA-256 of everything above it
+     * @returns the path, empty if it couldnt be written
+     */
+    std::string writeCertificate(const BatchWipe::DriveResult &r, const BatchWipeOptions &opts, const CertificateInfo &info) {
+        const fs::path dir = opts.certificate_dir.empty() ? Globals::dmgr_root / "data" / "certificates" : fs::path(opts.certificate_dir);
+
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+
+        std::string stamp = isoTime(info.finished);
+        stamp.erase(std::remove(stamp.begin(), stamp.end(), ':'), stamp.end());
+
+        const fs::path path = dir / ("wipe_" + fs::path(r.target).filename().string() + "_" + stamp + ".cert");
+
+        std::ostringstream out;
+        out << "# DriveMgr wipe certificate\n"
+            << "version=" << CERTIFICATE_VERSION << "\n"
+            << "host=" << hostName() << "\n"
+            << "device=" << r.target << "\n"
+            << "identity=" << info.identity << "\n"
+            << "bus=" << r.bus << "\n"
+            << "scheme=" << WipeEngine::schemeName(opts.scheme) << "\n";
+
+        std::string passes;
+        for (auto p : WipeEngine::passes(opts.scheme)) passes += (passes.empty() ? "" : ",") + std::string(p == WipeEngine::Pattern::Zero ? "zero" : "random");
+
+        out << "passes=" << passes << "\n";
+        if (!info.seed.empty()) out << "seed=" << info.seed << "\n";
+
+        out << "started=" << isoTime(info.started) << "\n"
+            << "finished=" << isoTime(info.finished) << "\n"
+            << "bytes=" << r.bytes << "\n"
+            << "verification=" << (info.fully_verified ? "full" : "sampled") << "\n"
+            << "samples=" << r.check.blocks.size() << "\n"
+            << "confidence=" << r.check.confidence << "\n"
+            << "max_unwiped_share=" << r.check.max_unwiped << "\n";
+
+        // offset, SHA-256 of the block as read back, and whether it held the expected pattern
+        for (const auto &b : r.check.blocks) {
+            out << "sample=" << b.offset << " " << (b.readable ? toHex(b.sha256.data(), b.sha256.size()) : "unreadable") << " " << (b.matches ? "ok" : "MISMATCH") << "\n";
+        }
+
+        out << "result=" << (r.success ? "wiped" : "failed") << "\n";
+
+        const std::string body = out.str();
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        SHA256(reinterpret_cast<const unsigned char*>(body.data()), body.size(), digest);
+
+        if (!replaceFile(path.string(), body + "sha256=" + toHex(digest, sizeof(digest)) + "\n")) return "";
+        return path.string();
+    }
+
+    /**
+     * @brief Runs the scheme on one drive, the journaled pass loop of overwriteDriveData without terminal output
+     */
+    BatchWipe::DriveResult wipeDrive(Slot &slot, const BatchWipeOptions &opts, BusGate &gate) {
+        BatchWipe::DriveResult r;
+        r.target = slot.target;
+        r.bus = slot.bus;
+
+        gate.acquire(slot.bus, limitFor(slot.bus, opts));
+        slot.setState(DriveState::Running);
+        IoQos::enterThread();
+
+        const auto wall_started = std::chrono::system_clock::now();
+        const auto started = std::chrono::steady_clock::now();
+        const auto passes = WipeEngine::passes(opts.scheme);
+
+        WipeEngine::Options wopts;
+        wopts.fd = slot.fd;
+        wopts.progress = [&slot](uint64_t done) { slot.setDone(done); };
+
+        OperationJournal journal(OperationJournal::defaultPath(OperationJournal::Operation::Wipe, "", slot.target));
+        OperationJournal::State state;
+        state.op = OperationJournal::Operation::Wipe;
+        state.target = slot.target;
+        state.target_id = OperationJournal::identify(slot.target, false);
+        state.block_size = wopts.chunk_size;
+        state.total = slot.size;
+        state.scheme = WipeEngine::schemeName(opts.scheme);
+        state.seed = WipeEngine::seedToHex(WipeEngine::newSeed());
+
+        if (!Globals::g_dry_run) journal.begin(state);
+
+        wopts.seed = WipeEngine::seedFromHex(state.seed);
+        bool has_random = false;
+
+        for (unsigned pass = 0; pass < passes.size() && r.error.empty(); ++pass) {
+            const bool random = passes[pass] == WipeEngine::Pattern::Random;
+            has_random = has_random || random;
+
+            slot.setPhase("pass " + std::to_string(pass + 1) + "/" + std::to_string(passes.size()) + (random ? " random" : " zeros"), slot.size);
+
+            wopts.checkpoint = [&journal, pass](uint64_t committed) { journal.commit(committed, pass); };
+            if (pass > 0 && !Globals::g_dry_run) journal.commit(0, pass);
+
+            const auto res = WipeEngine::fill(slot.target, passes[pass], wopts);
+            r.bytes += res.bytes_written;
+            if (!res.success) r.error = res.error;
+        }
+
+        const bool last_random = !passes.empty() && passes.back() == WipeEngine::Pattern::Random;
+        const std::optional<WipeEngine::Seed> expected = last_random ? wopts.seed : std::nullopt;
+        bool fully_verified = false;
+
+        if (r.error.empty() && opts.scheme == WipeEngine::Scheme::RandomVerify) {
+            slot.setPhase("verify", slot.size);
+
+            const auto vr = WipeEngine::verify(slot.target, expected, wopts);
+            fully_verified = vr.success;
+
+            if (!vr.success) r.error = vr.error.empty() ? std::to_string(vr.mismatches.size()) + " range(s) dont hold the written data" : vr.error;
+        }
+
+        if (r.error.empty() && !Globals::g_dry_run) {
+            slot.setPhase("sampling", (opts.sample_blocks + 2) * DIRECT_ALIGN);
+            WipeEngine::SampleOptions sopts;
+            sopts.count = opts.sample_blocks;
+            sopts.keep_blocks = true;
+
+            r.check = WipeEngine::sampleVerify(slot.target, expected, sopts, wopts);
+
+            if (!r.check.error.empty()) r.error = r.check.error;
+            else if (!r.check.success) r.error = std::to_string(r.check.blocks_bad) + " of " + std::to_string(r.check.blocks_checked) + " sampled blocks dont hold the wipe pattern";
+        }
+
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        r.success = r.error.empty();
+
+        if (r.success && !Globals::g_dry_run) {
+            journal.remove();
+
+            CertificateInfo info;
+            info.identity = state.target_id;
+            info.seed = has_random ? state.seed : "";
+            info.started = wall_started;
+            info.finished = std::chrono::system_clock::now();
+            info.fully_verified = fully_verified;
+
+            r.certificate = writeCertificate(r, opts, info);
+            if (r.certificate.empty()) LOG_WARNING("Could not write the wipe certificate of " + slot.target);
+        }
+
+        if (r.success) LOG_SUCCESS("Batch wipe of " + slot.target + " completed (" + WipeEngine::schemeName(opts.scheme) + ")");
+        else LOG_ERROR("Batch wipe of " + slot.target + " failed: " + r.error);
+
+        if (slot.fd >= 0) close(slot.fd);
+        slot.fd = -1;
+
+        slot.setPhase(r.success ? "done" : "FAILED", 0);
+        slot.setState(r.success ? DriveState::Done : DriveState::Failed);
+        gate.release(slot.bus);
+
+        return r;
+    }
+
+    /**
+     * @brief Redraws the table, one line per drive
+     */
+    void printTable(std::vector<std::unique_ptr<Slot>> &slots, bool first) {
+        if (!first) std::cout << "\033[" << slots.size() << "A";
+
+        size_t name_width = 6, bus_width = 3, phase_width = 5;
+
+        for (const auto &s : slots) {
+            std::lock_guard<std::mutex> lock(s->mtx);
+            name_width = std::max(name_width, s->target.size());
+            bus_width = std::max(bus_width, BatchWipe::busLabel(s->bus).size());
+            phase_width = std::max(phase_width, s->phase.size());
+        }
+
+        for (auto &s : slots) {
+            std::string phase;
+            uint64_t total;
+            DriveState state;
+
+            {
+                std::lock_guard<std::mutex> lock(s->mtx);
+                phase = s->phase;
+                total = s->phase_total;
+                state = s->state;
+
+                if (s->rate_phase != s->phase_id) {
+                    s->rate = ProgressMeter::RateTracker();
+                    s->rate_phase = s->phase_id;
+                }
+            }
+
+            s->rate.update(s->done.load(std::memory_order_relaxed));
+
+            std::cout << "\r\033[K  " << std::left << std::setw(static_cast<int>(name_width + 2)) << s->target
+                      << std::setw(static_cast<int>(bus_width + 2)) << BatchWipe::busLabel(s->bus);
+
+            if (state == DriveState::Failed) std::cout << RED << phase << RESET;
+            else if (state == DriveState::Done) std::cout << GREEN << phase << RESET;
+            else std::cout << std::setw(static_cast<int>(phase_width + 2)) << phase;
+
+            if (state == DriveState::Running && total > 0) std::cout << ProgressMeter::formatStats(total, s->rate);
+
+            std::cout << "\n";
+        }
+
+        std::cout << std::flush;
+    }
+}
+
+std::string BatchWipe::busOf(const std::string &target) {
+    struct stat st{};
+    if (stat(target.c_str(), &st) != 0 || !S_ISBLK(st.st_mode)) return "virtual";
+
+    std::error_code ec;
+    const fs::path dev = fs::canonical("/sys/dev/block/" + std::to_string(major(st.st_rdev)) + ":" + std::to_string(minor(st.st_rdev)), ec);
+    if (ec) return "virtual";
+
+    // usb devices are named like "2-1.3", their interfaces "2-1.3:1.0", and the hub is the parent of the device
+    static const std::regex usb_device(R"(\d+-[\d.]+)");
+    static const std::regex pci_function(R"([0-9a-f]{4}:[0-9a-f]{2}:[0-9a-f]{2}\.[0-7])");
+
+    fs::path prefix, usb_hub, pci;
+
+    for (const auto &part : dev) {
+        const std::string name = part.string();
+
+        if (std::regex_match(name, usb_device)) usb_hub = prefix;
+        prefix /= part;
+        if (std::regex_match(name, pci_function)) pci = prefix;
+    }
+
+    if (!usb_hub.empty()) return usb_hub.string();
+    if (!pci.empty()) return pci.string();
+
+    return "virtual";
+}
+
+std::string BatchWipe::busLabel(const std::string &bus) {
+    if (bus == "virtual") return bus;
+
+    const std::string name = fs::path(bus).filename().string();
+    return isUsbBus(bus) ? "usb " + name : name;
+}
+
+std::vector<BatchWipe::DriveResult> BatchWipe::run(const std::vector<std::string> &targets, const Options &opts) {
+    std::vector<DriveResult> results(targets.size());
+    std::vector<std::unique_ptr<Slot>> slots;
+    Redraw redraw;
+
+    for (const auto &t : targets) {
+        auto slot = std::make_unique<Slot>();
+        slot->redraw = &redraw;
+        slot->target = t;
+        slot->bus = busOf(t);
+        slot->size = sizeOfPath(t);
+        slots.push_back(std::move(slot));
+    }
+
+    IoQos::Scope qos(IoQos::Operation::Wipe, targets);
+    BusGate gate;
+    std::vector<std::thread> workers;
+
+    for (size_t i = 0; i < slots.size(); ++i) {
+        Slot &slot = *slots[i];
+
+        // claimed up front so a mounted drive fails right away instead of when its bus frees up,
+        // and the claim is kept so nothing mounts it between this check and the wipe
+        bool busy = false;
+        if (slot.size > 0) slot.fd = claim(slot.target, busy);
+
+        if (slot.size == 0 || busy) {
+            results[i].target = slot.target;
+            results[i].bus = slot.bus;
+            results[i].error = slot.size == 0 ? "Cannot determine the size of " + slot.target : slot.target + " is in use (mounted or held by another device)";
+            slot.setPhase("FAILED", 0);
+            slot.setState(DriveState::Failed);
+            LOG_ERROR("Batch wipe skipped " + slot.target + ": " + results[i].error);
+            continue;
+        }
+
+        workers.emplace_back([&, i] { results[i] = wipeDrive(*slots[i], opts, gate); });
+    }
+
+    std::thread waiter([&] {
+        for (auto &w : workers) w.join();
+        redraw.signal(true);
+    });
+
+    // the engines print their dry-run notes instead of progress, a table would only garble them
+    for (bool first = true; !Globals::g_dry_run; first = false) {
+        std::unique_lock<std::mutex> lock(redraw.mtx);
+        if (!first) redraw.cv.wait(lock, [&] { return redraw.changed || redraw.finished; });
+
+        const bool finished = redraw.finished;
+        redraw.changed = false;
+        lock.unlock();
+
+        printTable(slots, first);
+        if (finished) break;
+
+        // progress arrives per chunk from every drive, the table is redrawn at most this often
+        lock.lock();
+        redraw.cv.wait_for(lock, std::chrono::milliseconds(200), [&] { return redraw.finished; });
+    }
+
+    waiter.join();
+    return results;
+}
+
+void BatchWipe::printSummary(const std::vector<DriveResult> &results) {
+    size_t ok = 0;
+
+    std::cout << BOLD << "\n[Batch wipe summary]" << RESET << "\n";
+
+    for (const auto &r : results) {
+        if (r.success) {
+            ++ok;
+            std::cout << "  " << GREEN << "[WIPED]  " << RESET << r.target << "  " << ProgressMeter::formatDuration(r.seconds);
+            if (!r.certificate.empty()) std::cout << "  certificate: " << r.certificate;
+            std::cout << "\n";
+        } else {
+            std::cout << "  " << RED << "[FAILED] " << RESET << r.target << "  " << r.error << "\n";
+        }
+    }
+
+    std::cout << "\n" << ok << " of " << results.size() << " drive(s) wiped\n";
+}
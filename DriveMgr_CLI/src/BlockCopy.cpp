@@ -0,0 +1,854 @@
+#include "../include/BlockCopy.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+#include "../include/utils/IoQos.hpp"
+#include "../include/utils/CompressedImage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace BlockIOUtils;
+
+// ========== copy ==========
+
+namespace {
+    struct RingSlot {
+        AlignedBuffer buf;
+        uint64_t offset = 0;
+        size_t length = 0;
+
+        explicit RingSlot(size_t size) : buf(size) {}
+    };
+
+    /**
+     * @brief State of one target writer, everything but bytes_written is guarded by FanOutJob::mtx
+     */
+    struct WriterState {
+        std::string target;
+        int fd = -1;
+        bool is_regular = false;
+        uint64_t next_chunk = 0;                ///< chunks this writer has completely handled
+        uint64_t detached_at = UINT64_MAX;      ///< first chunk that has to come from the writers own source reads
+        uint64_t synced_chunks = 0;             ///< chunks flushed to the target, for checkpoints
+        bool failed = false;
+        bool finished = false;
+        bool in_ring = false;                   ///< writing chunk next_chunk straight out of its ring slot
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<uint64_t> bytes_unchanged{0};   ///< part of bytes_written that already matched and was skipped
+        std::string error;
+
+        bool detached() const { return detached_at != UINT64_MAX; }
+
+        ProgressMeter::RateTracker rate;        ///< only touched by the progress loop
+    };
+
+    struct FanOutJob {
+        std::string source;
+        BlockCopy::Options opts;
+        uint64_t total = 0;                     ///< 0 if unknown (most compressed sources)
+        uint64_t start_chunk = 0;               ///< first chunk of this run, digests[i] belongs to chunk start_chunk + i
+        bool streamed = false;                  ///< source is read from the decompressor pipe
+        CompressedImage::Decompressor dec;
+
+        std::mutex mtx;
+        std::condition_variable data_cv;        ///< reader -> writers: new chunk or EOF
+        std::condition_variable space_cv;       ///< writers -> reader: a slot became free
+        std::condition_variable done_cv;        ///< writers -> progress loop
+
+        std::vector<std::unique_ptr<RingSlot>> slots;
+        std::vector<std::unique_ptr<WriterState>> writers;
+        std::vector<BlockCopy::ChunkDigest> digests;
+
+        uint64_t produced = 0;                  ///< chunks published into the ring
+        bool eof = false;
+        bool reader_done = false;
+        size_t writers_done = 0;
+        std::string source_error;
+        std::atomic<bool> read_error{false};    ///< reading the source itself failed, by the reader or a detached writer
+        std::atomic<uint64_t> bytes_read{0};
+
+        std::mutex checkpoint_mtx;              ///< serializes checkpoint calls, taken before mtx
+        uint64_t committed_chunks = 0;          ///< what the last checkpoint reported
+    };
+
+    /**
+     * @brief true if no live writer still needs the slot that chunk k is about to overwrite
+     */
+    bool slotFree(const FanOutJob &job, uint64_t k) {
+        for (const auto &w : job.writers) {
+            // a writer that was detached or given up mid-write still reads its slot until it clears in_ring
+            if (w->in_ring && w->next_chunk + job.slots.size() <= k) return false;
+            if (w->failed || w->finished || w->detached()) continue;
+            if (w->next_chunk + job.slots.size() <= k) return false;
+        }
+        return true;
+    }
+
+    bool anyWriterAlive(const FanOutJob &job) {
+        for (const auto &w : job.writers) {
+            if (!w->failed && !w->finished) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Reports the chunks every live target has flushed to opts.checkpoint, if that moved forward
+     */
+    void maybeCheckpoint(FanOutJob &job) {
+        std::lock_guard<std::mutex> cp_lock(job.checkpoint_mtx);
+        std::vector<BlockCopy::ChunkDigest> fresh;
+        std::vector<size_t> live;
+        uint64_t committed = UINT64_MAX;
+
+        {
+            std::lock_guard<std::mutex> lock(job.mtx);
+
+            for (size_t i = 0; i < job.writers.size(); ++i) {
+                if (job.writers[i]->failed) continue;
+                committed = std::min(committed, job.writers[i]->synced_chunks);
+                live.push_back(i);
+            }
+
+            // a detached writer can be ahead of the ring, there are no digests for that part yet
+            committed = std::min(committed, job.produced);
+            if (committed == UINT64_MAX || committed <= job.committed_chunks) return;
+
+            fresh.assign(job.digests.begin() + static_cast<std::ptrdiff_t>(job.committed_chunks - job.start_chunk),
+                         job.digests.begin() + static_cast<std::ptrdiff_t>(committed - job.start_chunk));
+            job.committed_chunks = committed;
+        }
+
+        uint64_t end = 0;
+        for (const auto &d : fresh) end = d.offset + d.length;
+
+        job.opts.checkpoint(end, fresh, live);
+    }
+
+    void readerLoop(FanOutJob &job) {
+        IoQos::enterThread();
+        const int fd = job.streamed ? job.dec.fd : open(job.source.c_str(), O_RDONLY | O_CLOEXEC);
+        bool consumed = false;
+
+        if (fd < 0) {
+            std::lock_guard<std::mutex> lock(job.mtx);
+            job.source_error = "Cannot open source " + job.source + ": " + strerror(errno);
+        }
+
+        // a resumed stream has to be decompressed up to the resume point again
+        if (fd >= 0 && job.streamed && job.start_chunk > 0) {
+            RingSlot &slot = *job.slots[0];
+
+            for (uint64_t k = 0; k < job.start_chunk; ++k) {
+                if (readFull(fd, slot.buf.data(), job.opts.chunk_size) != static_cast<ssize_t>(job.opts.chunk_size)) {
+                    std::lock_guard<std::mutex> lock(job.mtx);
+                    job.source_error = "Source " + job.source + " ended before the resume point";
+                    break;
+                }
+            }
+        }
+
+        for (uint64_t k = job.start_chunk; fd >= 0 && job.source_error.empty(); ++k) {
+            RingSlot &slot = *job.slots[k % job.slots.size()];
+
+            {
+                std::unique_lock<std::mutex> lock(job.mtx);
+
+                while (!slotFree(job, k)) {
+                    if (job.space_cv.wait_for(lock, std::chrono::milliseconds(job.opts.stall_timeout_ms)) != std::cv_status::timeout) continue;
+
+                    // a slow target must not hold back the others, it continues from its own source reads.
+                    // If every attached target is that slow there is nobody to hold back, keep waiting
+                    size_t attached = 0;
+                    std::vector<WriterState*> stalled;
+
+                    for (auto &w : job.writers) {
+                        if (w->failed || w->finished || w->detached()) continue;
+                        ++attached;
+                        if (w->next_chunk + job.slots.size() <= k) stalled.push_back(w.get());
+                    }
+
+                    if (stalled.size() >= attached) continue;
+
+                    for (WriterState* w : stalled) {
+
+                        if (job.streamed) {
+                            w->failed = true;
+                            w->error = "Target " + w->target + " stalled while writing a compressed image, which cannot be re-read for it alone";
+                            LOG_WARNING(w->error);
+                            continue;
+                        }
+
+                        w->detached_at = w->next_chunk;
+                        LOG_WARNING("Target " + w->target + " is too slow for the shared ring, detached at chunk " + std::to_string(w->next_chunk));
+                    }
+
+                    job.data_cv.notify_all();
+                }
+
+                if (!anyWriterAlive(job)) break;
+            }
+
+            const ssize_t n = job.streamed ? readFull(fd, slot.buf.data(), job.opts.chunk_size)
+                : preadFull(fd, slot.buf.data(), job.opts.chunk_size, k * job.opts.chunk_size);
+
+            if (n < 0) {
+                std::lock_guard<std::mutex> lock(job.mtx);
+                job.source_error = "Read error on " + job.source + " at offset " + std::to_string(k * job.opts.chunk_size) + ": " + strerror(errno);
+                job.read_error = true;
+                break;
+            }
+
+            // nothing has been written yet, an image that fails the check never touches the targets
+            if (k == 0 && job.opts.validate_header) {
+                std::string why;
+
+                if (!job.opts.validate_header(slot.buf.data(), static_cast<size_t>(n), why)) {
+                    std::lock_guard<std::mutex> lock(job.mtx);
+                    job.source_error = why;
+                    break;
+                }
+            }
+
+            if (n == 0) { consumed = true; break; }
+
+            // hash once for every target while the chunk is still hot in cache
+            BlockCopy::ChunkDigest digest;
+            digest.offset = k * job.opts.chunk_size;
+            digest.length = static_cast<uint32_t>(n);
+            SHA256(slot.buf.data(), static_cast<size_t>(n), digest.sha.data());
+
+            slot.offset = digest.offset;
+            slot.length = static_cast<size_t>(n);
+
+            {
+                std::lock_guard<std::mutex> lock(job.mtx);
+                job.digests.push_back(digest);
+                job.produced = k + 1;
+            }
+
+            job.bytes_read += static_cast<uint64_t>(n);
+            job.data_cv.notify_all();
+
+            if (static_cast<size_t>(n) < job.opts.chunk_size) { consumed = true; break; } // short read means EOF
+        }
+
+        if (job.streamed) {
+            // a corrupt archive only shows up in the tool's exit status
+            std::string err;
+
+            if (!CompressedImage::finish(job.dec, consumed, err)) {
+                std::lock_guard<std::mutex> lock(job.mtx);
+                if (job.source_error.empty()) job.source_error = "Decompressing " + job.source + " failed: " + err;
+            }
+        } else if (fd >= 0) {
+            close(fd);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(job.mtx);
+            job.eof = true;
+            job.reader_done = true;
+        }
+
+        job.data_cv.notify_all();
+        job.done_cv.notify_all();
+    }
+
+    void writerLoop(FanOutJob &job, WriterState &w) {
+        IoQos::enterThread();
+        AlignedBuffer own_buf(job.opts.chunk_size);
+        AlignedBuffer cmp_buf(job.opts.compare_before_write ? job.opts.chunk_size : 0);
+        int src_fd = -1;
+        auto last_sync = std::chrono::steady_clock::now();
+
+        auto fail = [&](const std::string &msg) {
+            std::lock_guard<std::mutex> lock(job.mtx);
+            w.failed = true;
+            w.error = msg;
+        };
+
+        // compare-before-write: a chunk the target already holds is not written again
+        auto writeChunk = [&](const unsigned char* data, size_t length, uint64_t offset) -> bool {
+            if (cmp_buf.valid()) {
+                const ssize_t n = preadFull(w.fd, cmp_buf.data(), length, offset);
+
+                if (n == static_cast<ssize_t>(length) && std::memcmp(cmp_buf.data(), data, length) == 0) {
+                    w.bytes_unchanged += length;
+                    return true;
+                }
+            }
+
+            return pwriteFull(w.fd, data, length, offset);
+        };
+
+        // detached path: read chunk j from the source ourselves
+        auto readOwn = [&](uint64_t j) -> ssize_t {
+            if (src_fd < 0) src_fd = open(job.source.c_str(), O_RDONLY | O_CLOEXEC);
+            if (src_fd < 0) return -1;
+            return preadFull(src_fd, own_buf.data(), job.opts.chunk_size, j * job.opts.chunk_size);
+        };
+
+        for (uint64_t j = job.start_chunk; ; ++j) {
+            bool from_ring = false;
+
+            {
+                std::unique_lock<std::mutex> lock(job.mtx);
+                job.data_cv.wait(lock, [&] { return w.detached() || job.produced > j || job.eof; });
+
+                if (!w.detached() && job.produced <= j) break; // EOF and everything written
+                if (w.failed) break; // given up by the reader
+
+                from_ring = !w.detached();
+                w.in_ring = from_ring;
+            }
+
+            uint64_t offset = j * job.opts.chunk_size;
+            size_t length = 0;
+            bool ok = true;
+
+            if (from_ring) {
+                RingSlot &slot = *job.slots[j % job.slots.size()];
+                length = slot.length;
+                ok = writeChunk(slot.buf.data(), length, offset);
+
+                // the reader may reuse the slot from here on, even if we were detached meanwhile
+                {
+                    std::lock_guard<std::mutex> lock(job.mtx);
+                    w.in_ring = false;
+                }
+
+                job.space_cv.notify_all();
+            }
+
+            if (ok && !from_ring) {
+                if (!own_buf.valid()) { fail("Failed to allocate write buffer"); break; }
+
+                const ssize_t n = readOwn(j);
+
+                if (n < 0) { job.read_error = true; fail("Read error on " + job.source + " at offset " + std::to_string(offset) + ": " + strerror(errno)); break; }
+                if (n == 0) break; // EOF
+
+                length = static_cast<size_t>(n);
+                ok = writeChunk(own_buf.data(), length, offset);
+            }
+
+            if (!ok) {
+                fail("Write error on " + w.target + " at offset " + std::to_string(offset) + ": " + strerror(errno));
+                break;
+            }
+
+            w.bytes_written += length;
+
+            {
+                std::lock_guard<std::mutex> lock(job.mtx);
+                w.next_chunk = j + 1;
+            }
+
+            job.space_cv.notify_all();
+
+            if (job.opts.checkpoint && std::chrono::steady_clock::now() - last_sync >= std::chrono::milliseconds(job.opts.checkpoint_interval_ms)) {
+                if (fdatasync(w.fd) != 0) { fail("fdatasync failed on " + w.target + ": " + strerror(errno)); break; }
+
+                last_sync = std::chrono::steady_clock::now();
+
+                {
+                    std::lock_guard<std::mutex> lock(job.mtx);
+                    w.synced_chunks = j + 1;
+                }
+
+                maybeCheckpoint(job);
+            }
+
+            if (length < job.opts.chunk_size) break; // last, short chunk
+        }
+
+        if (src_fd >= 0) close(src_fd);
+
+        // flush only this target instead of a global sync
+        if (!w.failed && fsync(w.fd) != 0) fail("fsync failed on " + w.target + ": " + strerror(errno));
+
+        if (!w.failed && w.is_regular && ftruncate(w.fd, static_cast<off_t>(job.opts.start_offset + w.bytes_written.load())) != 0) {
+            fail("Failed to truncate " + w.target + ": " + strerror(errno));
+        }
+
+        close(w.fd);
+        w.fd = -1;
+
+        {
+            std::lock_guard<std::mutex> lock(job.mtx);
+            w.finished = true;
+            if (!w.failed) w.synced_chunks = w.next_chunk;
+            job.writers_done++;
+        }
+
+        if (job.opts.checkpoint && !w.failed) maybeCheckpoint(job);
+
+        job.space_cv.notify_all();
+        job.done_cv.notify_all();
+    }
+
+    /**
+     * @brief Redraws one progress line per target (a single line for plain copies)
+     */
+    void printFanOutProgress(FanOutJob &job, bool first) {
+        const bool multi = job.writers.size() > 1;
+
+        if (!first && multi) std::cout << "\033[" << job.writers.size() << "A";
+
+        size_t name_width = 0;
+        for (const auto &w : job.writers) name_width = std::max(name_width, w->target.size());
+
+        for (const auto &w : job.writers) {
+            std::string state;
+
+            {
+                std::lock_guard<std::mutex> lock(job.mtx);
+                if (w->failed) state = RED + std::string(" FAILED") + RESET;
+                else if (w->finished) state = GREEN + std::string(" done") + RESET;
+                else if (w->detached()) state = YELLOW + std::string(" detached") + RESET;
+            }
+
+            w->rate.update(w->bytes_written);
+
+            std::cout << "\r\033[K";
+            if (multi) std::cout << "  " << std::left << std::setw(static_cast<int>(name_width + 2)) << w->target;
+            else std::cout << "Writing ";
+            if (w->failed) std::cout << humanBytes(w->bytes_written) << " written";
+            else std::cout << ProgressMeter::formatStats(job.total > job.opts.start_offset ? job.total - job.opts.start_offset : 0, w->rate);
+            if (job.opts.compare_before_write) std::cout << "  " << humanBytes(w->bytes_unchanged) << " unchanged";
+            std::cout << state;
+
+            if (multi) std::cout << "\n";
+        }
+
+        std::cout << std::flush;
+    }
+}
+
+BlockCopy::MultiCopyResult BlockCopy::copyMulti(const std::string &source, const std::vector<std::string> &targets, const Options &opts) {
+    MultiCopyResult res;
+
+    if (Globals::g_dry_run) {
+
+        for (const auto &target : targets) {
+            std::cout << YELLOW << "[DRY-RUN] Would copy: " << source << " -> " << target << RESET << "\n";
+            LOG_DRYRUN("copy " + source + " -> " + target);
+            res.targets.push_back({target, true, false, 0, 0, ""});
+        }
+
+        res.success = true;
+        return res;
+
+    }
+
+    FanOutJob job;
+    job.source = source;
+    job.opts = opts;
+    job.opts.ring_slots = std::max<size_t>(2, opts.ring_slots);
+
+    if (opts.start_offset % opts.chunk_size != 0) {
+
+        res.error = "Resume offset " + std::to_string(opts.start_offset) + " is not a multiple of the chunk size";
+        LOG_ERROR(res.error);
+        return res;
+
+    }
+
+    job.start_chunk = opts.start_offset / opts.chunk_size;
+    job.produced = job.start_chunk;
+    job.committed_chunks = job.start_chunk;
+
+    // clones copy raw bytes, a device that happens to start with a gzip magic stays as it is
+    const CompressedImage::Format format = opts.decompress ? CompressedImage::detect(source) : CompressedImage::Format::None;
+
+    if (format != CompressedImage::Format::None) {
+
+        job.streamed = true;
+        job.total = CompressedImage::decompressedSize(source, format);
+
+    } else {
+        const int probe_fd = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (probe_fd < 0) {
+
+            res.error = "Cannot open source " + source + ": " + strerror(errno);
+            LOG_ERROR(res.error);
+            return res;
+
+        }
+
+        job.total = sizeOfFd(probe_fd);
+        close(probe_fd);
+    }
+
+    for (const auto &target : targets) {
+        auto w = std::make_unique<WriterState>();
+        w->target = target;
+        w->next_chunk = job.start_chunk;
+        w->synced_chunks = job.start_chunk;
+        w->fd = open(target.c_str(), (opts.compare_before_write ? O_RDWR : O_WRONLY) | O_CREAT | O_CLOEXEC, 0644);
+
+        if (w->fd < 0) {
+
+            w->failed = true;
+            w->finished = true;
+            w->error = "Cannot open target " + target + ": " + strerror(errno);
+
+        } else {
+
+            struct stat st{};
+            fstat(w->fd, &st);
+            w->is_regular = S_ISREG(st.st_mode);
+
+            const uint64_t target_size = sizeOfFd(w->fd);
+
+            if (S_ISBLK(st.st_mode) && job.total > 0 && target_size > 0 && job.total > target_size) {
+                w->failed = true;
+                w->finished = true;
+                w->error = "Target " + target + " (" + humanBytes(target_size) + ") is smaller than source " + source + " (" + humanBytes(job.total) + ")";
+                close(w->fd);
+                w->fd = -1;
+            }
+
+        }
+
+        job.writers.push_back(std::move(w));
+    }
+
+    for (size_t i = 0; i < job.opts.ring_slots; ++i) {
+        job.slots.push_back(std::make_unique<RingSlot>(opts.chunk_size));
+
+        if (!job.slots.back()->buf.valid()) {
+
+            res.error = "Failed to allocate copy ring";
+            LOG_ERROR(res.error);
+            for (auto &w : job.writers) if (w->fd >= 0) close(w->fd);
+            return res;
+
+        }
+    }
+
+    if (job.total > 0) job.digests.reserve(static_cast<size_t>(job.total / opts.chunk_size + 1));
+
+    if (job.streamed) {
+        auto dec = CompressedImage::spawn(source, format, res.error);
+
+        if (!dec.has_value()) {
+
+            LOG_ERROR(res.error);
+            for (auto &w : job.writers) if (w->fd >= 0) close(w->fd);
+            return res;
+
+        }
+
+        job.dec = *dec;
+        LOG_INFO("Decompressing " + source + " with " + job.dec.tool + " while writing");
+    }
+
+    std::vector<std::thread> threads;
+    size_t started = 0;
+
+    for (auto &w : job.writers) {
+        if (w->finished) continue;
+        threads.emplace_back(writerLoop, std::ref(job), std::ref(*w));
+        ++started;
+    }
+
+    threads.emplace_back(readerLoop, std::ref(job));
+
+    bool first = true;
+
+    while (true) {
+        printFanOutProgress(job, first);
+        first = false;
+
+        std::unique_lock<std::mutex> lock(job.mtx);
+        if (job.done_cv.wait_for(lock, std::chrono::milliseconds(500), [&] { return job.reader_done && job.writers_done == started; })) break;
+    }
+
+    for (auto &t : threads) t.join();
+
+    printFanOutProgress(job, false);
+    if (job.writers.size() == 1) std::cout << "\n";
+
+    res.bytes_read = job.bytes_read;
+    res.digests = std::move(job.digests);
+    res.error = job.source_error;
+    res.read_error = job.read_error;
+    res.success = res.error.empty();
+
+    for (const auto &w : job.writers) {
+        TargetResult tr;
+        tr.target = w->target;
+        tr.detached = w->detached();
+        tr.bytes_written = w->bytes_written;
+        tr.bytes_unchanged = w->bytes_unchanged;
+        tr.error = w->error;
+        tr.success = res.error.empty() && !w->failed && tr.bytes_written == res.bytes_read;
+
+        if (tr.success == false && tr.error.empty()) tr.error = "Incomplete write to " + w->target;
+
+        if (!tr.success) {
+            res.success = false;
+            LOG_ERROR(tr.error);
+        }
+
+        res.targets.push_back(tr);
+    }
+
+    if (!res.error.empty()) LOG_ERROR(res.error);
+
+    return res;
+}
+
+BlockCopy::CopyResult BlockCopy::copy(const std::string &source, const std::string &target, const Options &opts) {
+    MultiCopyResult multi = copyMulti(source, {target}, opts);
+
+    CopyResult res;
+    res.digests = std::move(multi.digests);
+    res.success = multi.success;
+    res.bytes_copied = multi.targets.empty() ? 0 : multi.targets.front().bytes_written;
+    res.bytes_unchanged = multi.targets.empty() ? 0 : multi.targets.front().bytes_unchanged;
+    res.error = !multi.error.empty() ? multi.error : (multi.targets.empty() ? "" : multi.targets.front().error);
+    res.read_error = multi.read_error;
+
+    return res;
+}
+
+
+// ========== verify ==========
+
+namespace {
+    uint64_t digestBytes(const std::vector<BlockCopy::ChunkDigest> &digests) {
+        uint64_t total = 0;
+        for (const auto &d : digests) total += d.length;
+        return total;
+    }
+
+    /**
+     * @brief Compares a mismatching chunk sector by sector against the source and appends the differing ranges
+     * @returns false if the chunk couldnt be re-read, the caller then reports the whole chunk
+     */
+    bool narrowMismatch(int src_fd, int dst_fd, const BlockCopy::ChunkDigest &d, std::vector<BlockCopy::Range> &out) {
+        AlignedBuffer src_buf(d.length);
+        AlignedBuffer dst_buf(roundUp(d.length, DIRECT_ALIGN));
+
+        if (!src_buf.valid() || !dst_buf.valid()) return false;
+
+        const ssize_t s = preadFull(src_fd, src_buf.data(), d.length, d.offset);
+        const ssize_t t = preadFull(dst_fd, dst_buf.data(), roundUp(d.length, DIRECT_ALIGN), d.offset);
+
+        if (s != static_cast<ssize_t>(d.length) || t < 0) return false;
+
+        const size_t readable = std::min<size_t>(static_cast<size_t>(t), d.length);
+
+        for (size_t pos = 0; pos < d.length; pos += SECTOR_SIZE) {
+            const size_t len = std::min<size_t>(SECTOR_SIZE, d.length - pos);
+            const bool differs = pos + len > readable || std::memcmp(src_buf.data() + pos, dst_buf.data() + pos, len) != 0;
+
+            if (!differs) continue;
+
+            if (!out.empty() && out.back().offset + out.back().length == d.offset + pos) {
+                out.back().length += len;
+            } else {
+                out.push_back({d.offset + pos, len});
+            }
+        }
+
+        return true;
+    }
+}
+
+BlockCopy::VerifyResult BlockCopy::verify(const std::string &target, const std::vector<ChunkDigest> &digests, const std::string &source, const Options &opts) {
+    ProgressMeter meter("Verifying", digestBytes(digests));
+    if (!Globals::g_dry_run && !digests.empty()) meter.start();
+
+    VerifyResult res = verifyImpl(target, digests, source, opts, &meter);
+    meter.finish();
+
+    return res;
+}
+
+BlockCopy::VerifyResult BlockCopy::verifyImpl(const std::string &target, const std::vector<ChunkDigest> &digests, const std::string &source, const Options &opts, ProgressMeter *meter) {
+    VerifyResult res;
+
+    if (Globals::g_dry_run) {
+
+        std::cout << YELLOW << "[DRY-RUN] Would verify: " << target << RESET << "\n";
+        LOG_DRYRUN("verify " + target);
+        res.success = true;
+        return res;
+
+    }
+
+    if (digests.empty()) {
+        res.success = true;
+        return res;
+    }
+
+    size_t max_len = 0;
+    for (const auto &d : digests) max_len = std::max<size_t>(max_len, d.length);
+
+    const unsigned thread_count = std::max(1u, std::min<unsigned>(opts.verify_threads, static_cast<unsigned>(digests.size())));
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<uint64_t> verified{0};
+    std::mutex result_mtx;
+    std::vector<size_t> bad_chunks;
+
+    auto worker = [&]() {
+        IoQos::enterThread();
+        bool is_direct = false;
+        int fd = openDirectRead(target, is_direct);
+
+        if (fd < 0) {
+            std::lock_guard<std::mutex> lock(result_mtx);
+            if (res.error.empty()) res.error = "Cannot open " + target + " for verification: " + strerror(errno);
+            return;
+        }
+
+        AlignedBuffer buf(roundUp(max_len, DIRECT_ALIGN));
+        unsigned char sha[SHA256_DIGEST_LENGTH];
+
+        for (size_t i = next_chunk++; i < digests.size(); i = next_chunk++) {
+            const ChunkDigest &d = digests[i];
+
+            // O_DIRECT needs aligned lengths, the extra tail is simply ignored
+            ssize_t n = preadFull(fd, buf.data(), roundUp(d.length, DIRECT_ALIGN), d.offset);
+
+            if (n < 0 && errno == EINVAL && is_direct) {
+                // device with a logical block size above DIRECT_ALIGN, retry buffered
+                close(fd);
+                is_direct = false;
+                fd = open(target.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd >= 0) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                n = fd < 0 ? -1 : preadFull(fd, buf.data(), d.length, d.offset);
+            }
+
+            bool ok = n >= static_cast<ssize_t>(d.length);
+
+            if (ok) {
+                SHA256(buf.data(), d.length, sha);
+                ok = std::memcmp(sha, d.sha.data(), SHA256_DIGEST_LENGTH) == 0;
+            }
+
+            if (!ok) {
+                std::lock_guard<std::mutex> lock(result_mtx);
+                bad_chunks.push_back(i);
+            }
+
+            verified += d.length;
+            if (meter) meter->add(d.length);
+
+            if (fd < 0) break;
+        }
+
+        if (fd >= 0) close(fd);
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < thread_count; ++t) workers.emplace_back(worker);
+    for (auto &w : workers) w.join();
+
+    res.bytes_verified = verified;
+
+    if (!res.error.empty()) {
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    std::sort(bad_chunks.begin(), bad_chunks.end());
+
+    // a compressed source would have to be decompressed again up to every bad chunk, report those chunk exact
+    const bool seekable = !source.empty() && (!opts.decompress || CompressedImage::detect(source) == CompressedImage::Format::None);
+    int src_fd = seekable ? open(source.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+    bool dst_direct = false;
+    int dst_fd = bad_chunks.empty() ? -1 : openDirectRead(target, dst_direct);
+
+    for (size_t idx : bad_chunks) {
+        const ChunkDigest &d = digests[idx];
+
+        if (src_fd >= 0 && dst_fd >= 0 && narrowMismatch(src_fd, dst_fd, d, res.mismatches)) continue;
+
+        if (!res.mismatches.empty() && res.mismatches.back().offset + res.mismatches.back().length == d.offset) {
+            res.mismatches.back().length += d.length;
+        } else {
+            res.mismatches.push_back({d.offset, d.length});
+        }
+    }
+
+    if (src_fd >= 0) close(src_fd);
+    if (dst_fd >= 0) close(dst_fd);
+
+    res.success = bad_chunks.empty();
+
+    if (!res.success) {
+        LOG_ERROR("Verification of " + target + " failed: " + std::to_string(res.mismatches.size()) + " mismatching range(s)");
+
+        for (const auto &r : res.mismatches) {
+            LOG_ERROR("Mismatch on " + target + " bytes " + std::to_string(r.offset) + " - " + std::to_string(r.offset + r.length - 1));
+        }
+    }
+
+    return res;
+}
+
+std::vector<BlockCopy::VerifyResult> BlockCopy::verifyMulti(const std::vector<std::string> &targets, const std::vector<ChunkDigest> &digests, const std::string &source, const Options &opts) {
+    std::vector<VerifyResult> results(targets.size());
+    std::vector<std::thread> threads;
+
+    // the targets are independent devices, spread the readers over all of them
+    Options per_target = opts;
+    per_target.verify_threads = std::max(1u, opts.verify_threads / std::max<unsigned>(1, static_cast<unsigned>(targets.size())));
+
+    // one combined line, several meters would overwrite each other
+    ProgressMeter meter("Verifying " + std::to_string(targets.size()) + " target(s)", digestBytes(digests) * targets.size());
+    if (!Globals::g_dry_run && !digests.empty() && !targets.empty()) meter.start();
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        threads.emplace_back([&, i]() { results[i] = verifyImpl(targets[i], digests, source, per_target, &meter); });
+    }
+
+    for (auto &t : threads) t.join();
+    meter.finish();
+
+    return results;
+}
+
+void BlockCopy::printVerifyReport(const VerifyResult &res) {
+    if (!res.error.empty()) {
+        ERR(ErrorCode::IOError, res.error);
+        return;
+    }
+
+    if (res.success) {
+        std::cout << GREEN << "[VERIFIED] " << RESET << humanBytes(res.bytes_verified) << " read back, target matches the source\n";
+        return;
+    }
+
+    uint64_t bad_bytes = 0;
+    for (const auto &r : res.mismatches) bad_bytes += r.length;
+
+    std::cout << RED << "[VERIFY FAILED] " << RESET << res.mismatches.size() << " mismatching range(s), " << bad_bytes << " bytes total:\n";
+
+    constexpr size_t max_lines = 50;
+
+    for (size_t i = 0; i < res.mismatches.size() && i < max_lines; ++i) {
+        const auto &r = res.mismatches[i];
+        std::cout << "  bytes " << r.offset << " - " << (r.offset + r.length - 1)
+                  << " (sectors " << r.offset / SECTOR_SIZE << " - " << (r.offset + r.length - 1) / SECTOR_SIZE
+                  << ", " << humanBytes(r.length) << ")\n";
+    }
+
+    if (res.mismatches.size() > max_lines) {
+        std::cout << "  ... and " << (res.mismatches.size() - max_lines) << " more, see the log file\n";
+    }
+}
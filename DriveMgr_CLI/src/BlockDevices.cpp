@@ -0,0 +1,277 @@
+#include "../include/BlockDevices.hpp"
+#include "../include/DiskLister.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string trim(std::string s) {
+        const auto first = s.find_first_not_of(" \t\n\r");
+        if (first == std::string::npos) return "";
+        return s.substr(first, s.find_last_not_of(" \t\n\r") - first + 1);
+    }
+
+    std::string readSys(const fs::path &path) {
+        std::ifstream in(path);
+        if (!in.is_open()) return "";
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return trim(content);
+    }
+
+    uint64_t readSysU64(const fs::path &path) {
+        try {
+            const std::string value = readSys(path);
+            return value.empty() ? 0 : std::stoull(value);
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+
+    std::vector<std::string> listDir(const fs::path &dir) {
+        std::vector<std::string> names;
+        std::error_code ec;
+
+        for (const auto &entry : fs::directory_iterator(dir, ec)) names.push_back(entry.path().filename().string());
+
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    /**
+     * @brief udev escapes blanks and odd bytes in *_ENC values as \xNN
+     */
+    std::string unhexmangle(const std::string &s) {
+        std::string out;
+
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s[i] == '\\' && i + 3 < s.size() && s[i + 1] == 'x' && std::isxdigit(static_cast<unsigned char>(s[i + 2])) && std::isxdigit(static_cast<unsigned char>(s[i + 3]))) {
+                out += static_cast<char>(std::stoi(s.substr(i + 2, 2), nullptr, 16));
+                i += 3;
+            } else {
+                out += s[i];
+            }
+        }
+
+        return out;
+    }
+
+    /**
+     * @brief The E: properties udev stored for a device (/run/udev/data/b<major>:<minor>), empty without udev
+     */
+    std::map<std::string, std::string> udevProperties(unsigned major, unsigned minor) {
+        std::map<std::string, std::string> props;
+        std::ifstream in("/run/udev/data/b" + std::to_string(major) + ":" + std::to_string(minor));
+        std::string line;
+
+        while (std::getline(in, line)) {
+            if (line.compare(0, 2, "E:") != 0) continue;
+
+            const size_t eq = line.find('=');
+            if (eq != std::string::npos) props[line.substr(2, eq - 2)] = line.substr(eq + 1);
+        }
+
+        return props;
+    }
+
+    /**
+     * @brief The SCSI unit serial number page, for disks without a serial attribute
+     */
+    std::string vpdSerial(const fs::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        std::string page((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (page.size() < 4) return "";
+
+        const size_t len = static_cast<unsigned char>(page[3]);
+        return trim(page.substr(4, std::min(len, page.size() - 4)));
+    }
+
+    /**
+     * @brief Transport of a disk from its place in the device tree, in the order lsblk checks
+     */
+    std::string transportOf(const std::string &sys_path) {
+        if (sys_path.find("/usb") != std::string::npos) return "usb";
+        if (sys_path.find("/nvme") != std::string::npos) return "nvme";
+        if (sys_path.find("/ata") != std::string::npos) return "sata";
+        if (sys_path.find("/mmc") != std::string::npos) return "mmc";
+        if (sys_path.find("/virtio") != std::string::npos) return "virtio";
+        if (sys_path.find("/host") != std::string::npos) return "scsi";
+        return "";
+    }
+
+    std::string typeOf(const std::string &name, const fs::path &sys, bool partition) {
+        if (partition) return "part";
+        if (name.compare(0, 4, "loop") == 0) return "loop";
+        if (name.compare(0, 2, "sr") == 0) return "rom";
+
+        if (name.compare(0, 3, "dm-") == 0) {
+            const std::string uuid = readSys(sys / "dm" / "uuid");
+            if (uuid.compare(0, 4, "LVM-") == 0) return "lvm";
+            if (uuid.compare(0, 6, "CRYPT-") == 0) return "crypt";
+            if (uuid.compare(0, 4, "part") == 0) return "part";
+            return "dm";
+        }
+
+        if (name.compare(0, 2, "md") == 0) {
+            const std::string level = readSys(sys / "md" / "level");
+            return level.empty() ? "md" : level;
+        }
+
+        return "disk";
+    }
+
+    std::optional<BlockDevice> probeName(const std::string &name, const DiskLister::MountIndex &mounts) {
+        std::error_code ec;
+        const fs::path sys = fs::canonical("/sys/class/block/" + name, ec);
+        if (ec || !fs::exists(sys / "dev")) return std::nullopt;
+
+        BlockDevice dev;
+        dev.name = name;
+        dev.path = "/dev/" + name;
+
+        const std::string majmin = readSys(sys / "dev");
+        if (sscanf(majmin.c_str(), "%u:%u", &dev.major, &dev.minor) != 2) return std::nullopt;
+
+        const bool partition = fs::exists(sys / "partition");
+        const fs::path disk_sys = partition ? sys.parent_path() : sys;
+
+        dev.type = typeOf(name, sys, partition);
+        if (partition) dev.parent = disk_sys.filename().string();
+
+        dev.size = readSysU64(sys / "size") * 512;     // always 512 byte units, whatever the logical block size
+        dev.start = partition ? readSysU64(sys / "start") * 512 : 0;
+        dev.partition_number = partition ? static_cast<unsigned>(readSysU64(sys / "partition")) : 0;
+
+        dev.read_only = readSysU64(sys / "ro") != 0;
+        dev.removable = readSysU64(disk_sys / "removable") != 0;
+        dev.rotational = readSysU64(disk_sys / "queue" / "rotational") != 0;
+
+        const auto udev = udevProperties(dev.major, dev.minor);
+        auto prop = [&](const char* key) {
+            const auto it = udev.find(key);
+            return it == udev.end() ? std::string() : it->second;
+        };
+
+        // identity belongs to the whole disk, lsblk leaves it empty for partitions too
+        if (!partition) {
+            dev.model = trim(unhexmangle(prop("ID_MODEL_ENC")));
+            if (dev.model.empty()) dev.model = readSys(sys / "device" / "model");
+
+            dev.vendor = readSys(sys / "device" / "vendor");
+
+            dev.serial = prop("ID_SCSI_SERIAL");
+            if (dev.serial.empty()) dev.serial = prop("ID_SERIAL_SHORT");
+            if (dev.serial.empty()) dev.serial = readSys(sys / "device" / "serial");
+            if (dev.serial.empty()) dev.serial = vpdSerial(sys / "device" / "vpd_pg80");
+
+            dev.wwn = prop("ID_WWN");
+            if (dev.wwn.empty()) dev.wwn = readSys(sys / "wwid");
+            if (dev.wwn.empty()) dev.wwn = readSys(sys / "device" / "wwid");
+
+            if (dev.type == "disk") dev.transport = transportOf(sys.string());
+
+            for (const auto &child : listDir(sys)) {
+                if (fs::exists(sys / child / "partition")) dev.partitions.push_back(child);
+            }
+
+            std::sort(dev.partitions.begin(), dev.partitions.end(), [&](const std::string &a, const std::string &b) {
+                return readSysU64(sys / a / "partition") < readSysU64(sys / b / "partition");
+            });
+        }
+
+        dev.fstype = prop("ID_FS_TYPE");
+        dev.uuid = prop("ID_FS_UUID");
+        dev.label = unhexmangle(prop("ID_FS_LABEL_ENC"));
+
+        const auto mount = mounts.of(majmin, dev.path);
+
+        if (!mount.empty()) {
+            dev.mountpoint = mount.front().mountpoint;
+            if (dev.fstype.empty()) dev.fstype = mount.front().fstype;
+        }
+
+        dev.holders = listDir(sys / "holders");
+        dev.slaves = listDir(sys / "slaves");
+
+        return dev;
+    }
+
+    /**
+     * @brief Kernel name of a device node (or symlink to one) by its device number, so /dev/mapper and by-id paths work
+     */
+    std::string kernelName(const std::string &device) {
+        if (device.find('/') == std::string::npos) return device;
+
+        struct stat st{};
+        if (stat(device.c_str(), &st) != 0 || !S_ISBLK(st.st_mode)) return "";
+
+        std::error_code ec;
+        const fs::path sys = fs::canonical("/sys/dev/block/" + std::to_string(major(st.st_rdev)) + ":" + std::to_string(minor(st.st_rdev)), ec);
+        return ec ? "" : sys.filename().string();
+    }
+}
+
+std::optional<BlockDevice> BlockDevices::probe(const std::string &device) {
+    const std::string name = kernelName(device);
+    if (name.empty()) return std::nullopt;
+
+    return probeName(name, DiskLister::loadMountIndex());
+}
+
+std::vector<BlockDevice> BlockDevices::partitionsOf(const std::string &disk) {
+    std::vector<BlockDevice> parts;
+
+    const auto mounts = DiskLister::loadMountIndex();
+    const auto whole = probeName(kernelName(disk), mounts);
+    if (!whole) return parts;
+
+    for (const auto &name : whole->partitions) {
+        if (auto part = probeName(name, mounts)) parts.push_back(std::move(*part));
+    }
+
+    return parts;
+}
+
+std::vector<BlockDevice> BlockDevices::scan() {
+    std::vector<BlockDevice> devices;
+    const auto mounts = DiskLister::loadMountIndex();
+
+    for (const auto &name : listDir("/sys/class/block")) {
+        if (auto dev = probeName(name, mounts)) devices.push_back(std::move(*dev));
+    }
+
+    return devices;
+}
+
+std::string BlockDevices::lsblkSize(uint64_t bytes) {
+    // util-linux size_to_human_string() with a one letter suffix and one decimal
+    int exp = 0;
+    while (exp < 60 && bytes >= (1ULL << (exp + 10))) exp += 10;
+
+    uint64_t dec = exp ? bytes >> exp : bytes;
+    uint64_t frac = exp ? bytes & ((1ULL << exp) - 1) : 0;
+
+    if (frac) {
+        frac = frac >= UINT64_MAX / 1000 ? ((frac / 1024) * 1000) / (1ULL << (exp - 10)) : (frac * 1000) / (1ULL << exp);
+        frac = ((frac + 50) / 100) * 10;
+
+        if (frac == 100) {
+            ++dec;
+            frac = 0;
+        }
+    }
+
+    static const char suffixes[] = "BKMGTPE";
+    std::string out = std::to_string(dec);
+
+    if (frac) out += "." + std::to_string(frac / 10);
+
+    return out + suffixes[exp / 10];
+}
@@ -1,4 +1,77 @@
 #include "../include/DiskLister.hpp"
+#include "../include/BlockDevices.hpp"
+
+#include <atomic>
+#include <iterator>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    // sysfs reads are cheap, only hosts with hundreds of devices gain from more threads
+    constexpr size_t DISKS_PER_THREAD = 64;
+    constexpr size_t MAX_PROBE_THREADS = 16;
+
+    /**
+     * @brief Runs fn(i) for every i below n, on up to MAX_PROBE_THREADS threads
+     */
+    template <typename Fn>
+    void forEachParallel(size_t n, Fn fn) {
+        std::atomic<size_t> next{0};
+
+        auto worker = [&] {
+            for (size_t i = next++; i < n; i = next++) fn(i);
+        };
+
+        const size_t threads = std::min(MAX_PROBE_THREADS, n / DISKS_PER_THREAD);
+        std::vector<std::thread> pool;
+
+        for (size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+    }
+
+    std::vector<std::string> listedDisks(bool (*listed)(const std::string&)) {
+        std::vector<std::string> names;
+        std::error_code ec;
+
+        for (const auto& entry : fs::directory_iterator("/sys/block/", ec)) {
+            std::string dev = entry.path().filename().string();
+            if (listed(dev)) names.push_back(std::move(dev));
+        }
+
+        // sorted, so a drive plugged in later lands where a rescan would put it
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    /**
+     * @brief mountinfo octal escapes spaces, tabs, newlines and backslashes ("\040")
+     */
+    std::string unescapeMountField(const std::string& field) {
+        std::string out;
+        out.reserve(field.size());
+
+        for (size_t i = 0; i < field.size(); ++i) {
+            const bool octal = field[i] == '\\' && i + 3 < field.size()
+                               && std::all_of(field.begin() + i + 1, field.begin() + i + 4, [](char c) { return c >= '0' && c <= '7'; });
+
+            if (octal) {
+                out += static_cast<char>(std::stoi(field.substr(i + 1, 3), nullptr, 8));
+                i += 3;
+            } else {
+                out += field[i];
+            }
+        }
+
+        return out;
+    }
+}
+
+DiskLister::~DiskLister() {
+    if (revalidator.joinable()) revalidator.join();
+    if (revalidate_fd >= 0) close(revalidate_fd);
+}
 
 std::string DiskLister::readFile(const std::string& path) {
     std::ifstream file(path);
@@ -7,92 +80,339 @@ std::string DiskLister::readFile(const std::string& path) {
     return content;
 }
 
-std::string DiskLister::getMountPoint(const std::string& device) {
-    std::ifstream mtab("/etc/mtab");
-    if (!mtab.is_open()) return "";
+std::vector<DiskLister::MountEntry> DiskLister::MountIndex::of(const std::string& majmin, const std::string& path) const {
+    std::vector<MountEntry> mounts;
+
+    auto add = [&](const std::vector<MountEntry>& entries) {
+        for (const auto& m : entries) {
+            const bool seen = std::any_of(mounts.begin(), mounts.end(), [&](const MountEntry& o) { return o.mountpoint == m.mountpoint; });
+            if (!seen) mounts.push_back(m);
+        }
+    };
+
+    if (const auto it = by_devnum.find(majmin); it != by_devnum.end()) add(it->second);
+    if (const auto it = by_source.find(path); it != by_source.end()) add(it->second);
+
+    return mounts;
+}
+
+DiskLister::MountIndex DiskLister::loadMountIndex(const std::string& path) {
+    MountIndex index;
+    std::ifstream mountinfo(path);
     std::string line;
-    while (std::getline(mtab, line)) {
+
+    // mount ID, parent ID, major:minor, root, mount point, options, optional fields..., "-", fstype, source, super options
+    while (std::getline(mountinfo, line)) {
         std::istringstream iss(line);
-        std::string dev, mount, fstype;
-        if (std::getline(iss, dev, ' ') &&
-            std::getline(iss, mount, ' ') &&
-            std::getline(iss, fstype, ' ')) {
-            if (dev.find(device) != std::string::npos) {
-                return mount;
-            }
+        std::string id, parent, majmin, root, mountpoint, options, field;
+        if (!(iss >> id >> parent >> majmin >> root >> mountpoint >> options)) continue;
+
+        while (iss >> field && field != "-") {}
+
+        MountEntry entry;
+        std::string source;
+        if (!(iss >> entry.fstype >> source)) continue;
+
+        entry.mountpoint = unescapeMountField(mountpoint);
+        entry.source = unescapeMountField(source);
+
+        // /dev/mapper/x and /dev/disk/by-* sources are found under the node lsblk and sysfs name too
+        if (entry.source.compare(0, 5, "/dev/") == 0) {
+            std::error_code ec;
+            const std::string node = fs::canonical(entry.source, ec).string();
+            if (!ec && node != entry.source) index.by_source[node].push_back(entry);
         }
+
+        index.by_source[entry.source].push_back(entry);
+        index.by_devnum[majmin].push_back(std::move(entry));
     }
-    return "";
+
+    return index;
 }
 
-std::string DiskLister::getFsType(const std::string& device) {
-    std::ifstream mtab("/etc/mtab");
-    if (!mtab.is_open()) return "";
-    std::string line;
-    while (std::getline(mtab, line)) {
-        std::istringstream iss(line);
-        std::string dev, mount, fstype;
-        if (std::getline(iss, dev, ' ') &&
-            std::getline(iss, mount, ' ') &&
-            std::getline(iss, fstype, ' ')) {
-            if (dev.find(device) != std::string::npos) {
-                return fstype;
-            }
+std::optional<DiskLister::MountEntry> DiskLister::findMount(const std::string& majmin, const std::string& path) const {
+    auto mounts = mount_index.of(majmin, path);
+    if (mounts.empty()) return std::nullopt;
+    return std::move(mounts.front());
+}
+
+bool DiskLister::isListed(const std::string& dev) {
+    return dev.find("loop") == std::string::npos && dev.find("ram") == std::string::npos;
+}
+
+void DiskLister::resolveMount(DiskInfo& info, const std::string& dev) const {
+    auto trim = [](std::string s) {
+        s.erase(std::remove_if(s.begin(), s.end(), ::isspace), s.end());
+        return s;
+    };
+
+    info.mount.clear();
+    info.fstype.clear();
+
+    // by device number, so sda doesnt pick up the mounts of sdaa
+    auto mount = findMount(trim(readFile("/sys/block/" + dev + "/dev")), "/dev/" + dev);
+
+    if (!mount) {
+        std::vector<std::string> parts;
+        std::error_code ec;
+
+        for (const auto& sub : fs::directory_iterator("/sys/block/" + dev, ec)) {
+            if (fs::exists(sub.path() / "partition")) parts.push_back(sub.path().filename().string());
+        }
+
+        std::sort(parts.begin(), parts.end());
+
+        for (const auto& part : parts) {
+            mount = findMount(trim(readFile("/sys/block/" + dev + "/" + part + "/dev")), "/dev/" + part);
+            if (mount) break;
         }
     }
-    return "";
+
+    if (mount) {
+        info.mount = mount->mountpoint;
+        info.fstype = mount->fstype;
+    }
 }
 
-std::vector<DiskInfo> DiskLister::getPhysicalDisksInfo() {
+DiskInfo DiskLister::probeDisk(const std::string& dev) const {
+    DiskInfo info;
+    info.device = "/dev/" + dev;
+
+    // Size (in bytes, from /sys/block/<dev>/size)
+    std::string size = readFile("/sys/block/" + dev + "/size");
+    if (!size.empty()) {
+        size.erase(std::remove_if(size.begin(), size.end(), ::isspace), size.end());
+        // always 512 byte units, whatever the logical sector size
+        const uint64_t sectors = std::stoull(size);
+        info.bytes = sectors * 512;
+        info.size = BlockDevices::lsblkSize(info.bytes);
+    }
+
+    // Type (from /sys/block/<dev>/device/type)
+    info.type = readFile("/sys/block/" + dev + "/device/type");
+    info.type.erase(std::remove_if(info.type.begin(), info.type.end(), ::isspace), info.type.end());
+    if (info.type == "0") info.type = "disk";
+
+    // Mount point and filesystem type (from the mount index)
+    resolveMount(info, dev);
+
+    // Status (from /sys/block/<dev>/stat)
+    std::string stat = readFile("/sys/block/" + dev + "/stat");
+    info.status = stat.empty() ? "unknown" : "running";
+
+    return info;
+}
+
+void DiskLister::scan() {
+    mount_index = loadMountIndex();
+
+    const std::vector<std::string> names = listedDisks(isListed);
+    std::vector<DiskInfo> probed(names.size());
+    std::vector<std::optional<DriveStamp>> probed_stamps(names.size());
+
+    forEachParallel(names.size(), [&](size_t i) {
+        probed[i] = probeDisk(names[i]);
+        probed_stamps[i] = InventoryCache::stamp(names[i]);
+    });
+
     disks.clear();
-    
-    for (const auto& entry : fs::directory_iterator("/sys/block/")) {
-        std::string dev = entry.path().filename().string();
-        if (dev.find("loop") != std::string::npos || dev.find("ram") != std::string::npos) continue;
+    disks.reserve(probed.size());
+    stamps.clear();
 
-        DiskInfo info;
-        info.device = "/dev/" + dev;
-
-        // Size (in bytes, from /sys/block/<dev>/size)
-        std::string size = readFile("/sys/block/" + dev + "/size");
-        if (!size.empty()) {
-            size.erase(std::remove_if(size.begin(), size.end(), ::isspace), size.end());
-            unsigned long sectors = std::stoul(size);
-            info.size = std::to_string(sectors * 512 / 1024 / 1024 / 1024) + "G";
-        }
+    for (size_t i = 0; i < probed.size(); ++i) {
+        disks.append(probed[i]);
+        if (probed_stamps[i]) stamps[probed[i].device] = std::move(*probed_stamps[i]);
+    }
+
+    saveCache();
+}
+
+std::vector<DiskInfo> DiskLister::getPhysicalDisksInfo() {
+    scan();
+
+    std::vector<DiskInfo> out;
+    out.reserve(disks.size());
+    for (size_t i = 0; i < disks.size(); ++i) out.push_back(disks.info(i));
 
-        // Type (from /sys/block/<dev>/device/type)
-        info.type = readFile("/sys/block/" + dev + "/device/type");
-        info.type.erase(std::remove_if(info.type.begin(), info.type.end(), ::isspace), info.type.end());
-        if (info.type == "0") info.type = "disk";
+    return out;
+}
 
-        // Mount point and filesystem type (from /etc/mtab)
-        info.mount = getMountPoint(info.device);
-        info.fstype = getFsType(info.device);
+bool DiskLister::updateDisk(const std::string& dev) {
+    if (dev.empty() || !isListed(dev)) return false;
 
-        // Status (from /sys/block/<dev>/stat)
-        std::string stat = readFile("/sys/block/" + dev + "/stat");
-        info.status = stat.empty() ? "unknown" : "running";
+    const std::string device = "/dev/" + dev;
+    const size_t pos = disks.find(device);
+    const bool cached = pos < disks.size();
 
-        disks.push_back(info);
+    if (!fs::exists("/sys/block/" + dev)) {
+        if (!cached) return false;
+        disks.erase(pos);
+        stamps.erase(device);
+        return true;
     }
-    
-    return disks;
+
+    disks.put(probeDisk(dev));
+
+    if (auto stamp = InventoryCache::stamp(dev)) stamps[device] = std::move(*stamp);
+    else stamps.erase(device);
+
+    return true;
+}
+
+bool DiskLister::refreshMounts() {
+    mount_index = loadMountIndex();
+    bool changed = false;
+
+    for (size_t i = 0; i < disks.size(); ++i) {
+        DiskInfo info;
+        resolveMount(info, disks.text(DriveTable::Column::Device, i).substr(5));
+        changed |= disks.setMount(i, info.mount, info.fstype);
+    }
+
+    return changed;
 }
 
 std::vector<Row> DiskLister::getPhysicalDisksInfoAsRows() {
+    getPhysicalDisksInfo();
+    return getCachedDisksAsRows();
+}
+
+std::vector<Row> DiskLister::getCachedDisksAsRows() const {
     std::vector<Row> rows;
-    auto disk_list = getPhysicalDisksInfo();
-    for (const auto& disk : disk_list) {
-        rows.push_back({disk.device, disk.size, disk.type, disk.mount, disk.fstype, disk.status});
-    }
+    rows.reserve(disks.size());
+    for (size_t i = 0; i < disks.size(); ++i) rows.push_back(disks.row(i));
     return rows;
 }
 
-const std::vector<DiskInfo>& DiskLister::getCachedDisks() const {
+const DriveTable& DiskLister::getCachedDisks() const {
     return disks;
 }
 
 void DiskLister::refresh() {
-    getPhysicalDisksInfo();
+    // a full scan supersedes whatever the revalidation finds
+    if (revalidator.joinable()) {
+        revalidator.join();
+        close(revalidate_fd);
+        revalidate_fd = -1;
+        stale.clear();
+    }
+
+    scan();
+}
+
+bool DiskLister::loadCache() {
+    std::string err;
+    auto entries = InventoryCache::load(InventoryCache::defaultPath(), err);
+    if (!entries) return false;
+
+    disks.clear();
+    disks.reserve(entries->size());
+    stamps.clear();
+
+    for (auto& e : *entries) {
+        // written in table order, put() only sorts a cache somebody edited
+        if (disks.empty() || disks.text(DriveTable::Column::Device, disks.size() - 1) < e.info.device) disks.append(e.info);
+        else disks.put(e.info);
+        stamps[e.info.device] = std::move(e.stamp);
+    }
+
+    saved_cache = InventoryCache::serialize(*entries);
+    return true;
+}
+
+void DiskLister::saveCache() {
+    std::vector<InventoryCache::Entry> entries;
+    entries.reserve(disks.size());
+
+    for (size_t i = 0; i < disks.size(); ++i) {
+        InventoryCache::Entry e{disks.info(i), {}};
+        const auto it = stamps.find(e.info.device);
+        if (it != stamps.end()) e.stamp = it->second;
+        entries.push_back(std::move(e));
+    }
+
+    std::string data = InventoryCache::serialize(entries);
+    if (data == saved_cache) return;
+
+    // the cache only speeds up the next start, a read-only dmgr_root just means a full scan then
+    if (InventoryCache::save(InventoryCache::defaultPath(), data)) saved_cache = std::move(data);
+}
+
+std::vector<std::string> DiskLister::findStale(const std::vector<std::pair<std::string, DriveStamp>>& cached) {
+    const std::vector<std::string> names = listedDisks(isListed);
+    std::vector<char> is_stale(cached.size(), 0);
+
+    forEachParallel(cached.size(), [&](size_t i) {
+        const auto now = InventoryCache::stamp(cached[i].first);
+        is_stale[i] = !now || *now != cached[i].second;
+    });
+
+    std::vector<std::string> out;
+    for (size_t i = 0; i < cached.size(); ++i) {
+        if (is_stale[i]) out.push_back(cached[i].first);
+    }
+
+    // both sorted by name: disks that appeared since the cache was written
+    std::vector<std::string> known;
+    known.reserve(cached.size());
+    for (const auto& c : cached) known.push_back(c.first);
+
+    std::set_difference(names.begin(), names.end(), known.begin(), known.end(), std::back_inserter(out));
+    return out;
+}
+
+void DiskLister::startRevalidation() {
+    if (revalidator.joinable()) return;
+
+    revalidate_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (revalidate_fd < 0) {
+        // no way to notify anyone, the caller gets a fresh scan instead
+        scan();
+        return;
+    }
+
+    std::vector<std::pair<std::string, DriveStamp>> cached;
+    cached.reserve(disks.size());
+
+    for (size_t i = 0; i < disks.size(); ++i) {
+        const std::string& device = disks.text(DriveTable::Column::Device, i);
+        const auto it = stamps.find(device);
+        cached.emplace_back(device.substr(5), it == stamps.end() ? DriveStamp{} : it->second);
+    }
+
+    // only sysfs and a copy of the stamps are touched, the table stays with the caller's thread
+    revalidator = std::thread([this, cached = std::move(cached)] {
+        stale = findStale(cached);
+
+        const uint64_t one = 1;
+        if (write(revalidate_fd, &one, sizeof(one)) < 0) {}
+    });
+}
+
+bool DiskLister::finishRevalidation(bool wait) {
+    if (!revalidator.joinable()) return false;
+
+    if (!wait) {
+        pollfd pfd{revalidate_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 0) <= 0) return false;
+    }
+
+    revalidator.join();
+    close(revalidate_fd);
+    revalidate_fd = -1;
+
+    bool changed = !stale.empty();
+
+    if (stale.size() > disks.size() / 2) {
+        // after a reboot most names point elsewhere, the parallel scan beats probing one by one
+        scan();
+    } else {
+        // cached mount columns are as old as the cache, the mount table is one read
+        changed |= refreshMounts();
+        for (const auto& dev : stale) updateDisk(dev);
+        saveCache();
+    }
+
+    stale.clear();
+    return changed;
 }
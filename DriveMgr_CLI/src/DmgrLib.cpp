@@ -1,5 +1,7 @@
 #include "../include/DmgrLib.h"
 
+#include <mutex>
+
 // ========= Logger =========
 
 enum class LogType {
@@ -30,10 +32,16 @@ void Logger::log(LogType type, const std::string& operation, const char* func) {
             std::time_t currentTime = std::chrono::system_clock::to_time_t(now);
             char timeStr[100];
 
-            std::strftime(timeStr, sizeof(timeStr), "%d-%m-%Y %H:%M", std::localtime(&currentTime));
+            std::tm local_time{};
+            localtime_r(&currentTime, &local_time);
+            std::strftime(timeStr, sizeof(timeStr), "%d-%m-%Y %H:%M", &local_time);
 
             std::string log_msg = "[" + std::string(timeStr) + "] event: " + logMessage(type) + operation + " (location: " + std::string(func) + ")";
 
+            // engines log from worker threads (batch wipe), keep lines whole
+            static std::mutex log_mtx;
+            std::lock_guard<std::mutex> lock(log_mtx);
+
             std::ofstream log_file(Globals::log_path, std::ios::app);
 
             if (log_file) {
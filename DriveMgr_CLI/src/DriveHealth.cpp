@@ -0,0 +1,435 @@
+#include "../include/DriveHealth.hpp"
+#include "../include/utils/DevicePassthrough.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <thread>
+#include <unistd.h>
+
+using DevicePassthrough::Status;
+
+namespace {
+    constexpr uint8_t ATA_SMART = 0xB0;
+    constexpr uint16_t SMART_READ_DATA = 0xD0;
+    constexpr uint16_t SMART_READ_THRESHOLDS = 0xD1;
+    constexpr uint16_t SMART_RETURN_STATUS = 0xDA;
+    constexpr uint64_t SMART_LBA = 0xC24F00;           // LBA mid 4Fh, high C2h, the SMART signature
+    constexpr uint8_t NVME_LOG_HEALTH = 0x02;
+    constexpr size_t SMART_ENTRIES = 30;
+    constexpr size_t SMART_ENTRY_LEN = 12;
+
+    uint64_t le(const unsigned char* p, size_t bytes) {
+        uint64_t v = 0;
+        for (size_t i = bytes; i-- > 0; ) v = (v << 8) | p[i];
+        return v;
+    }
+
+    /** @brief 128 bit little endian counter, saturated */
+    uint64_t le128(const unsigned char* p) {
+        return le(p + 8, 8) != 0 ? UINT64_MAX : le(p, 8);
+    }
+
+    Status smartCommand(int fd, uint16_t feature, unsigned char* buf, DevicePassthrough::AtaRegisters &regs, std::string &err) {
+        regs.features = feature;
+        regs.count = buf ? 1 : 0;
+        regs.lba = SMART_LBA;
+        regs.command = ATA_SMART;
+        return DevicePassthrough::ataCommand(fd, regs, buf, buf ? 512 : 0, 15000, err);
+    }
+
+    void readAta(int fd, const std::array<uint16_t, 256> &ident, HealthReport &rep) {
+        rep.protocol = HealthReport::Protocol::Ata;
+
+        // words 82/85 bit 0: SMART feature set supported/enabled, 0000h and FFFFh mean the word isnt reported
+        const bool valid = ident[82] != 0 && ident[82] != 0xFFFF;
+        rep.smart_supported = valid && (ident[82] & 0x0001);
+        rep.smart_enabled = rep.smart_supported && (ident[85] & 0x0001);
+
+        if (!rep.smart_supported) {
+            rep.error = "The drive does not support SMART";
+            return;
+        }
+
+        if (!rep.smart_enabled) {
+            rep.error = "SMART is disabled on the drive";
+            return;
+        }
+
+        std::string err;
+        unsigned char data[512] = {};
+        unsigned char thresholds[512] = {};
+
+        DevicePassthrough::AtaRegisters regs;
+        if (smartCommand(fd, SMART_READ_DATA, data, regs, err) != Status::Ok) {
+            rep.error = err;
+            return;
+        }
+
+        DevicePassthrough::AtaRegisters tregs;
+        const bool have_thresholds = smartCommand(fd, SMART_READ_THRESHOLDS, thresholds, tregs, err) == Status::Ok;
+
+        unsigned char sum = 0;
+        for (unsigned char b : data) sum = static_cast<unsigned char>(sum + b);
+        if (sum != 0) rep.warnings.push_back("SMART data checksum mismatch, values may be garbage");
+
+        for (size_t i = 0; i < SMART_ENTRIES; ++i) {
+            const unsigned char* e = data + 2 + i * SMART_ENTRY_LEN;
+            if (e[0] == 0) continue;
+
+            SmartAttribute attr;
+            attr.id = e[0];
+            attr.name = DriveHealth::attributeName(attr.id);
+            attr.flags = static_cast<uint16_t>(le(e + 1, 2));
+            attr.value = e[3];
+            attr.worst = e[4];
+            attr.raw = le(e + 5, 6);
+
+            // the threshold table usually lists the ids in the same slots, but doesn't have to
+            if (have_thresholds) {
+                for (size_t j = 0; j < SMART_ENTRIES; ++j) {
+                    const unsigned char* t = thresholds + 2 + j * SMART_ENTRY_LEN;
+                    if (t[0] == attr.id) {
+                        attr.threshold = t[1];
+                        break;
+                    }
+                }
+            }
+
+            rep.attributes.push_back(attr);
+        }
+
+        bool attribute_failing = false;
+
+        for (const auto &attr : rep.attributes) {
+            if (attr.failingNow() && attr.prefailure()) {
+                attribute_failing = true;
+                rep.warnings.push_back(attr.name + " is below its threshold (" + std::to_string(attr.value) + " <= " + std::to_string(attr.threshold) + ")");
+            } else if (attr.failingNow()) {
+                rep.warnings.push_back(attr.name + " (old age) is below its threshold");
+            }
+
+            switch (attr.id) {
+                case 5: case 197: case 198:
+                    if (attr.raw & 0xFFFFFFFF) rep.warnings.push_back(attr.name + " = " + std::to_string(attr.raw & 0xFFFFFFFF));
+                    break;
+                case 9:
+                    rep.power_on_hours = attr.raw & 0xFFFFFFFF;
+                    break;
+                case 190: case 194:
+                    // low byte is the current temperature, the others hold min/max on most drives
+                    if (!rep.temperature || attr.id == 194) rep.temperature = static_cast<int>(attr.raw & 0xFF);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // the drive's own verdict; registers that didn't come back (status still 0) leave it to the attributes
+        DevicePassthrough::AtaRegisters sregs;
+        const Status st = smartCommand(fd, SMART_RETURN_STATUS, nullptr, sregs, err);
+        const unsigned mid = (sregs.lba >> 8) & 0xFF;
+        const unsigned high = (sregs.lba >> 16) & 0xFF;
+
+        if (st == Status::Ok && sregs.status != 0 && mid == 0xF4 && high == 0x2C) {
+            rep.verdict = HealthReport::Verdict::Failed;
+        } else if (st == Status::Ok && sregs.status != 0 && mid == 0x4F && high == 0xC2) {
+            rep.verdict = attribute_failing ? HealthReport::Verdict::Failed : HealthReport::Verdict::Passed;
+        } else {
+            rep.verdict = attribute_failing ? HealthReport::Verdict::Failed
+                        : have_thresholds ? HealthReport::Verdict::Passed : HealthReport::Verdict::Unknown;
+        }
+    }
+
+    void readNvme(int fd, HealthReport &rep) {
+        rep.protocol = HealthReport::Protocol::Nvme;
+        rep.smart_supported = true;
+        rep.smart_enabled = true;
+
+        unsigned char log[512] = {};
+        std::string err;
+
+        if (DevicePassthrough::nvmeLogPage(fd, NVME_LOG_HEALTH, 0xFFFFFFFF, log, sizeof(log), err) != Status::Ok) {
+            rep.error = err;
+            return;
+        }
+
+        NvmeHealthLog h;
+        h.critical_warning = log[0];
+        h.temperature = static_cast<int>(le(log + 1, 2)) - 273;
+        h.available_spare = log[3];
+        h.spare_threshold = log[4];
+        h.percentage_used = log[5];
+        h.data_units_read = le128(log + 32);
+        h.data_units_written = le128(log + 48);
+        h.host_reads = le128(log + 64);
+        h.host_writes = le128(log + 80);
+        h.power_cycles = le128(log + 112);
+        h.power_on_hours = le128(log + 128);
+        h.unsafe_shutdowns = le128(log + 144);
+        h.media_errors = le128(log + 160);
+        h.error_log_entries = le128(log + 176);
+        h.warning_temp_minutes = static_cast<uint32_t>(le(log + 192, 4));
+        h.critical_temp_minutes = static_cast<uint32_t>(le(log + 196, 4));
+
+        static const char* const critical[] = {
+            "available spare is below its threshold",
+            "temperature is outside its thresholds",
+            "NVM subsystem reliability is degraded",
+            "media has been placed in read only mode",
+            "volatile memory backup device has failed",
+            "persistent memory region is read only"
+        };
+
+        for (unsigned bit = 0; bit < 6; ++bit) {
+            if (h.critical_warning & (1u << bit)) rep.warnings.push_back(std::string("Critical warning: ") + critical[bit]);
+        }
+
+        if (h.percentage_used >= 100) rep.warnings.push_back("Rated endurance used up (" + std::to_string(h.percentage_used) + "%)");
+        if (h.media_errors > 0) rep.warnings.push_back("Media and data integrity errors = " + std::to_string(h.media_errors));
+
+        rep.temperature = h.temperature;
+        rep.power_on_hours = h.power_on_hours;
+        rep.verdict = h.critical_warning ? HealthReport::Verdict::Failed : HealthReport::Verdict::Passed;
+        rep.nvme = h;
+    }
+}
+
+std::string DriveHealth::attributeName(uint8_t id) {
+    switch (id) {
+        case 1: return "Raw_Read_Error_Rate";
+        case 2: return "Throughput_Performance";
+        case 3: return "Spin_Up_Time";
+        case 4: return "Start_Stop_Count";
+        case 5: return "Reallocated_Sector_Ct";
+        case 7: return "Seek_Error_Rate";
+        case 8: return "Seek_Time_Performance";
+        case 9: return "Power_On_Hours";
+        case 10: return "Spin_Retry_Count";
+        case 11: return "Calibration_Retry_Count";
+        case 12: return "Power_Cycle_Count";
+        case 170: return "Available_Reservd_Space";
+        case 171: return "Program_Fail_Count";
+        case 172: return "Erase_Fail_Count";
+        case 173: return "Wear_Leveling_Count";
+        case 174: return "Unexpect_Power_Loss_Ct";
+        case 177: return "Wear_Leveling_Count";
+        case 179: return "Used_Rsvd_Blk_Cnt_Tot";
+        case 181: return "Program_Fail_Cnt_Total";
+        case 182: return "Erase_Fail_Count_Total";
+        case 183: return "Runtime_Bad_Block";
+        case 184: return "End-to-End_Error";
+        case 187: return "Reported_Uncorrect";
+        case 188: return "Command_Timeout";
+        case 189: return "High_Fly_Writes";
+        case 190: return "Airflow_Temperature_Cel";
+        case 191: return "G-Sense_Error_Rate";
+        case 192: return "Power-Off_Retract_Count";
+        case 193: return "Load_Cycle_Count";
+        case 194: return "Temperature_Celsius";
+        case 195: return "Hardware_ECC_Recovered";
+        case 196: return "Reallocated_Event_Count";
+        case 197: return "Current_Pending_Sector";
+        case 198: return "Offline_Uncorrectable";
+        case 199: return "UDMA_CRC_Error_Count";
+        case 200: return "Multi_Zone_Error_Rate";
+        case 220: return "Disk_Shift";
+        case 222: return "Loaded_Hours";
+        case 223: return "Load_Retry_Count";
+        case 224: return "Load_Friction";
+        case 225: return "Load_Cycle_Count";
+        case 226: return "Load-in_Time";
+        case 231: return "SSD_Life_Left";
+        case 232: return "Available_Reservd_Space";
+        case 233: return "Media_Wearout_Indicator";
+        case 235: return "POR_Recovery_Count";
+        case 240: return "Head_Flying_Hours";
+        case 241: return "Total_LBAs_Written";
+        case 242: return "Total_LBAs_Read";
+        default: return "Unknown_Attribute";
+    }
+}
+
+std::string DriveHealth::verdictName(HealthReport::Verdict verdict) {
+    switch (verdict) {
+        case HealthReport::Verdict::Passed: return "PASSED";
+        case HealthReport::Verdict::Failed: return "FAILED";
+        default: return "UNKNOWN";
+    }
+}
+
+HealthReport DriveHealth::read(const std::string &device) {
+    HealthReport rep;
+    rep.device = device;
+
+    const int fd = open(device.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0) {
+        rep.error = "Cannot open " + device + ": " + strerror(errno);
+        return rep;
+    }
+
+    if (DevicePassthrough::nvmeNamespaceId(fd)) {
+        readNvme(fd, rep);
+    } else {
+        std::array<uint16_t, 256> ident{};
+        std::string err;
+        const Status st = DevicePassthrough::ataIdentify(fd, ident, err);
+
+        if (st == Status::Ok) readAta(fd, ident, rep);
+        else rep.error = st == Status::Unsupported ? "No ATA or NVMe command set reachable (" + err + ")" : err;
+    }
+
+    close(fd);
+    return rep;
+}
+
+std::vector<HealthReport> DriveHealth::readMany(const std::vector<std::string> &devices, unsigned threads) {
+    std::vector<HealthReport> reports(devices.size());
+    std::atomic<size_t> next{0};
+
+    // every drive is a handful of commands, the time goes to waiting on the devices
+    auto worker = [&] {
+        for (size_t i = next++; i < devices.size(); i = next++) reports[i] = read(devices[i]);
+    };
+
+    const size_t count = std::min<size_t>(std::max(1u, threads), devices.size());
+    std::vector<std::thread> pool;
+
+    for (size_t i = 0; i < count; ++i) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+
+    return reports;
+}
+
+void DriveHealth::printReport(const HealthReport &report) {
+    const auto verdict = report.verdict;
+
+    if (verdict == HealthReport::Verdict::Passed) std::cout << GREEN << "[PASSED] " << RESET;
+    else if (verdict == HealthReport::Verdict::Failed) std::cout << RED << "[FAILED] " << RESET;
+    else std::cout << YELLOW << "[UNKNOWN] " << RESET;
+
+    std::cout << report.device << " SMART overall-health self-assessment\n";
+
+    if (!report.error.empty()) std::cout << "  " << report.error << "\n";
+
+    for (const auto &w : report.warnings) std::cout << YELLOW << "  [Warning] " << RESET << w << "\n";
+
+    if (report.temperature) std::cout << "  Temperature:     " << *report.temperature << " C\n";
+    if (report.power_on_hours) std::cout << "  Power on hours:  " << *report.power_on_hours << "\n";
+
+    if (report.nvme) {
+        const auto &h = *report.nvme;
+        std::cout << "  Critical warning:   0x" << std::hex << static_cast<unsigned>(h.critical_warning) << std::dec << "\n"
+                  << "  Available spare:    " << static_cast<unsigned>(h.available_spare) << "% (threshold " << static_cast<unsigned>(h.spare_threshold) << "%)\n"
+                  << "  Percentage used:    " << static_cast<unsigned>(h.percentage_used) << "%\n"
+                  << "  Data read:          " << BlockIOUtils::humanBytes(h.data_units_read * 512000) << "\n"
+                  << "  Data written:       " << BlockIOUtils::humanBytes(h.data_units_written * 512000) << "\n"
+                  << "  Power cycles:       " << h.power_cycles << "\n"
+                  << "  Unsafe shutdowns:   " << h.unsafe_shutdowns << "\n"
+                  << "  Media errors:       " << h.media_errors << "\n"
+                  << "  Error log entries:  " << h.error_log_entries << "\n";
+        return;
+    }
+
+    if (report.attributes.empty()) return;
+
+    std::cout << "  ID# " << std::left << std::setw(24) << "ATTRIBUTE_NAME" << std::right
+              << "  FLAG  VALUE WORST THRESH TYPE      RAW\n";
+
+    for (const auto &a : report.attributes) {
+        std::cout << "  " << std::setw(3) << static_cast<unsigned>(a.id) << " " << std::left << std::setw(24) << a.name << std::right
+                  << "  0x" << std::hex << std::setw(4) << std::setfill('0') << a.flags << std::dec << std::setfill(' ')
+                  << "  " << std::setw(3) << std::setfill('0') << static_cast<unsigned>(a.value)
+                  << "   " << std::setw(3) << static_cast<unsigned>(a.worst)
+                  << "   " << std::setw(3) << static_cast<unsigned>(a.threshold) << std::setfill(' ')
+                  << "    " << std::left << std::setw(9) << (a.prefailure() ? "Pre-fail" : "Old_age") << std::right
+                  << " " << a.raw << (a.failingNow() ? "  FAILING_NOW" : a.failedInPast() ? "  In_the_past" : "") << "\n";
+    }
+}
+
+void DriveHealth::printSummary(const std::vector<HealthReport> &reports) {
+    std::cout << std::left << std::setw(16) << "DEVICE" << std::setw(6) << "TYPE" << std::setw(9) << "HEALTH"
+              << std::setw(7) << "TEMP" << std::setw(10) << "HOURS" << "NOTE\n" << std::right;
+
+    for (const auto &r : reports) {
+        const char* type = r.protocol == HealthReport::Protocol::Nvme ? "nvme" : r.protocol == HealthReport::Protocol::Ata ? "ata" : "-";
+        const std::string note = !r.warnings.empty() ? r.warnings.front() : r.error;
+
+        std::cout << std::left << std::setw(16) << r.device << std::setw(6) << type;
+
+        if (r.verdict == HealthReport::Verdict::Passed) std::cout << GREEN;
+        else if (r.verdict == HealthReport::Verdict::Failed) std::cout << RED;
+        else std::cout << YELLOW;
+
+        std::cout << std::setw(9) << verdictName(r.verdict) << RESET
+                  << std::setw(7) << (r.temperature ? std::to_string(*r.temperature) + "C" : "-")
+                  << std::setw(10) << (r.power_on_hours ? std::to_string(*r.power_on_hours) : "-")
+                  << note << "\n" << std::right;
+    }
+}
+
+void DriveHealth::writeJson(JsonWriter &out, const HealthReport &report) {
+    const char* protocol = report.protocol == HealthReport::Protocol::Nvme ? "nvme" : report.protocol == HealthReport::Protocol::Ata ? "ata" : "none";
+
+    out.beginObject()
+       .field("record", "health")
+       .field("device", report.device)
+       .field("protocol", protocol)
+       .field("verdict", report.verdict == HealthReport::Verdict::Passed ? "passed" : report.verdict == HealthReport::Verdict::Failed ? "failed" : "unknown")
+       .field("smart_supported", report.smart_supported)
+       .field("smart_enabled", report.smart_enabled)
+       .field("temperature", report.temperature)
+       .field("power_on_hours", report.power_on_hours)
+       .field("warnings", report.warnings);
+
+    if (!report.error.empty()) out.field("error", report.error);
+
+    if (report.protocol == HealthReport::Protocol::Ata) {
+        out.key("attributes").beginArray();
+
+        for (const auto &a : report.attributes) {
+            out.beginObject()
+               .field("id", a.id)
+               .field("name", a.name)
+               .field("value", a.value)
+               .field("worst", a.worst)
+               .field("threshold", a.threshold)
+               .field("raw", a.raw)
+               .field("prefailure", a.prefailure())
+               .field("failing_now", a.failingNow())
+               .field("failed_in_past", a.failedInPast())
+               .endObject();
+        }
+
+        out.endArray();
+    }
+
+    if (report.nvme) {
+        const NvmeHealthLog &n = *report.nvme;
+
+        out.key("nvme").beginObject()
+           .field("critical_warning", n.critical_warning)
+           .field("temperature", n.temperature)
+           .field("available_spare", n.available_spare)
+           .field("spare_threshold", n.spare_threshold)
+           .field("percentage_used", n.percentage_used)
+           .field("data_units_read", n.data_units_read)
+           .field("data_units_written", n.data_units_written)
+           .field("host_reads", n.host_reads)
+           .field("host_writes", n.host_writes)
+           .field("power_cycles", n.power_cycles)
+           .field("power_on_hours", n.power_on_hours)
+           .field("unsafe_shutdowns", n.unsafe_shutdowns)
+           .field("media_errors", n.media_errors)
+           .field("error_log_entries", n.error_log_entries)
+           .field("warning_temp_minutes", n.warning_temp_minutes)
+           .field("critical_temp_minutes", n.critical_temp_minutes)
+           .endObject();
+    }
+
+    out.endObject().endRecord();
+}
@@ -29,11 +29,32 @@
 
 // custom includes
 #include "../include/DmgrLib.h"
+#include "../include/BlockCopy.hpp"
+#include "../include/RescueImager.hpp"
+#include "../include/WipeEngine.hpp"
+#include "../include/OperationJournal.hpp"
+#include "../include/HardwareErase.hpp"
+#include "../include/BatchWipe.hpp"
+#include "../include/FreeSpaceWipe.hpp"
+#include "../include/BlockDevices.hpp"
+#include "../include/DriveProbe.hpp"
+#include "../include/DriveHealth.hpp"
+#include "../include/SpaceUsage.hpp"
+#include "../include/SpaceWalker.hpp"
+#include "../include/SpaceCache.hpp"
+#include "../include/ui/IoDashboard.hpp"
+#include "../include/utils/IoQos.hpp"
+#include "../include/utils/CompressedImage.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/utils/JsonWriter.hpp"
 #include "../include/LDM_updater.h"
 #include "../include/tests.hpp"
 #include "../include/ui/MenuIO.hpp"
 #include "../include/ui/Spinner.hpp"
+#include "../include/ui/ProgressMeter.hpp"
 #include "../include/ui/ListDrivesUtil.hpp"
+#include "../include/ui/SpaceBrowser.hpp"
+#include "../include/utils/SpaceMonitor.hpp"
 #include "../include/ui/TerminalSize.hpp"
 
 // ==== Version ====
@@ -289,21 +310,6 @@ void listpartisions() {
 
     std::cout << "\nPartitions of drive " << drive_name << ":\n";
 
-    const std::string cmd = "lsblk -o NAME,SIZE,TYPE,MOUNTPOINT,FSTYPE -n -p " + drive_name; 
-    const auto res = EXEC_QUIET(cmd); 
-
-    if (!res.success) {
-
-        ERR(ErrorCode::ProcessFailure, "lsblk failed");
-        LOG_ERROR("lsblk failed");
-
-    }
-
-    debug_msg("after EXEC(cmd) command", Globals::g_debug);
-
-    std::istringstream iss(res.output);
-    std::string line;
-
     std::cout << std::left 
               << std::setw(2)
               << std::setw(4) << "/"
@@ -317,35 +323,17 @@ void listpartisions() {
 
     std::vector<std::string> partitions;
 
-    while (std::getline(iss, line)) {
-
-        if (line.find("part") != std::string::npos) {
-
-            std::istringstream lss(line);
-            std::string part_name, part_size, part_type, part_mount, part_fstype;
-            
-            lss >> part_name >> part_size >> part_type;
-            
-            // Get rest of line for mountpoint and fstype
-            std::string rest;
-            std::getline(lss, rest);
-            std::istringstream rss(rest);
-            rss >> part_mount >> part_fstype;
-            
-            if (part_mount == "-") part_mount = "";
-            if (part_fstype == "-") part_fstype = "";
-            
-            // Print formatted row
-            std::cout << std::left
-                      << std::setw(18) << part_name
-                      << std::setw(10) << part_size
-                      << std::setw(10) << part_type
-                      << std::setw(15) << part_mount
-                      << std::setw(10) << part_fstype
-                      << "\n";
-            
-            partitions.push_back(part_name);
-        }
+    for (const auto &part : BlockDevices::partitionsOf(drive_name)) {
+        // Print formatted row
+        std::cout << std::left
+                  << std::setw(18) << part.path
+                  << std::setw(10) << BlockDevices::lsblkSize(part.size)
+                  << std::setw(10) << part.type
+                  << std::setw(15) << part.mountpoint
+                  << std::setw(10) << part.fstype
+                  << "\n";
+
+        partitions.push_back(part.path);
     }
 
     if (partitions.empty()) {
@@ -391,105 +379,198 @@ void listpartisions() {
 
 // ========== Disk Space Analysis ==========··−·
 
-void analyzeDiskSpace() {
-    std::cout << "[Analyze Disk Space]\n";
-    const std::string drive_name = ListDrivesUtil::listDrives(true); 
+/**
+ * @brief Where the space of a filesystem went (--du, and from Analyze Disk Space): a parallel walk, then the tree
+ * @param path a directory, or a block device whose mount point is walked
+ * @param top entries per directory when the tree is printed (not a terminal)
+ * @param depth levels printed below the root
+ * @param full ignore the cache of the last walk and list every directory
+ * @param live keep the browser up to date through fanotify
+ */
+int analyzeDirectoryUsage(const std::string &path, SpaceWalker::Options opts, size_t top, unsigned depth, bool full = false, bool live = false) {
+    std::string root = path;
+    struct stat st{};
 
-    std::cout  << (Globals::g_no_color ? BOLD : Globals::g_THEME_COLOR) << "\n┌────── Disk Information ──────\n" << RESET;
+    if (stat(path.c_str(), &st) == 0 && S_ISBLK(st.st_mode)) {
+        const auto dev = BlockDevices::probe(path);
+
+        if (!dev || dev->mountpoint.empty()) {
+            ERR(ErrorCode::InvalidDevice, path + " is not mounted, there is no tree to walk");
+            return 1;
+        }
 
-    std::string disk_cmd = "lsblk -b -o NAME,SIZE,TYPE,MOUNTPOINT -n -p " + drive_name;
-    const auto disk_cmd_res = EXEC_QUIET(disk_cmd); 
+        root = dev->mountpoint;
+    }
 
-    if (!disk_cmd_res.success || disk_cmd_res.output.empty()) {
+    std::error_code ec;
+    const auto canonical = std::filesystem::weakly_canonical(root, ec);
+    if (!ec) root = canonical.string();
 
-        ERR(ErrorCode::ProcessFailure, "lsblk failed");
-        return;
+    // the last walk of this root: directories that did not change are taken from it
+    const std::string cache_path = SpaceCache::defaultPath(root);
+    std::optional<SpaceTree> previous;
+    std::string err;
 
+    if (!full) {
+        previous = SpaceCache::load(cache_path, err);
+        if (previous) opts.previous = &*previous;
     }
 
-    {
-        std::istringstream iss(disk_cmd_res.output);
-        std::string line;
+    // the used bytes of the filesystem are what the walk will roughly add up to
+    FsUsage usage;
+    SpaceUsage::query(root, usage, err);
 
-        while (std::getline(iss, line)) {
-            std::cout << "│ " << line << "\n";
-        }
-        std::cout << "│\n";
+    ProgressMeter meter("Walking " + root, usage.used);
+    if (!Globals::g_json) {
+        opts.meter = &meter;
+        meter.start();
     }
 
-    std::istringstream iss(disk_cmd_res.output);
-    std::string line;
-    bool found = false;
-    std::string mount_point;
-    std::string size;
+    SpaceTree tree;
+    const bool ok = SpaceWalker::walk(root, opts, tree, err);
+    if (!Globals::g_json) meter.finish();
+    opts.meter = nullptr;
+    opts.previous = nullptr;
+    previous.reset();
+
+    if (!ok) {
+        ERR(ErrorCode::IOError, err);
+        LOG_ERROR(err);
+        return 1;
+    }
+
+    if (!SpaceCache::save(cache_path, tree)) LOG_WARNING("Cant write the directory usage cache " + cache_path);
 
-    while (std::getline(iss, line)) {
-        std::istringstream lss(line);
+    std::ostringstream stats;
+    stats << tree.dirs.size() << " directories and " << tree.dirs.front().files << " files in "
+          << std::fixed << std::setprecision(2) << tree.seconds << "s";
+    if (tree.reused) stats << ", " << tree.reused << " of them unchanged since the last walk";
+    if (tree.hardlinks) stats << ", " << tree.hardlinks << " extra hard links counted once";
+    if (tree.mountpoints) stats << ", " << tree.mountpoints << " other filesystems skipped";
+    if (tree.errors) stats << ", " << tree.errors << " entries unreadable";
 
-        std::string name, type;
+    LOG_INFO("Walked " + root + ": " + stats.str());
 
-        lss >> name >> size >> type;
+    if (Globals::g_json) {
+        JsonWriter out(std::cout);
+        SpaceBrowser::writeJson(out, tree, top, depth);
+        return 0;
+    }
 
-        std::getline(lss, mount_point);
+    std::cout << "[Info] Walked " << stats.str() << "\n";
 
-        if (!mount_point.empty() && mount_point[0] == ' ') mount_point = mount_point.substr(1);
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        SpaceBrowser::print(tree, top, depth);
+        return 0;
+    }
 
-        if (type == "disk") {
-            found = true;
-            std::cout << "│ Device:      " << name << "\n";
-            try {
+    SpaceMonitor monitor;
 
-                unsigned long long bytes = std::stoull(size);
-                const char* units[] = {"B", "KB", "MB", "GB", "TB"};
-                int unit = 0;
-                double human_size = bytes;
+    if (live && !monitor.start(root, err)) {
+        std::cout << YELLOW << "[Warning] No live updates: " << err << RESET << "\n";
+        LOG_WARNING("No live updates for " + root + ": " + err);
+        live = false;
+    }
 
-                while (human_size >= 1024 && unit < 4) {
-                    human_size /= 1024;
-                    ++unit;
-                }
+    SpaceBrowser::browse(tree, live ? &monitor : nullptr, opts);
 
-                std::cout << "│ Size:        " << human_size << " " << units[unit] << "\n";
+    // the live updates are worth keeping for the next run
+    if (live && !SpaceCache::save(cache_path, tree)) LOG_WARNING("Cant write the directory usage cache " + cache_path);
 
-            } catch (...) {
-                std::cout << "│ Size:        " << size << " bytes\n";
-            }
+    return 0;
+}
 
-            std::cout << "│ Type:        " << type << "\n";
-            std::cout << "│ Mountpoint:  " << (mount_point.empty() ? "-" : mount_point) << "\n";
-        }
-    }
+void analyzeDiskSpace() {
+    std::cout << "[Analyze Disk Space]\n";
+    const std::string drive_name = ListDrivesUtil::listDrives(true); 
+
+    std::cout  << (Globals::g_no_color ? BOLD : Globals::g_THEME_COLOR) << "\n┌────── Disk Information ──────\n" << RESET;
+
+    const auto disk = BlockDevices::probe(drive_name);
 
-    if (!found) {
+    if (!disk.has_value() || disk->type == "part") {
 
         ERR(ErrorCode::DeviceNotFound, "No Disk found");
         return;
 
-    } 
+    }
 
-    if (!mount_point.empty() && mount_point != "-") {
+    const auto parts = BlockDevices::partitionsOf(drive_name);
 
-        std::string df_cmd = "df -h '" + mount_point + "' | tail -1";
-        const auto df_res = EXEC_QUIET(df_cmd); 
-        std::string df_out = df_res.output;
+    {
+        std::cout << "│ " << disk->path << " " << disk->size << " " << disk->type << " " << disk->mountpoint << "\n";
 
-        std::istringstream dfiss(df_out);
+        for (const auto &part : parts) {
+            std::cout << "│ " << part.path << " " << part.size << " " << part.type << " " << part.mountpoint << "\n";
+        }
+        std::cout << "│\n";
+    }
 
-        std::string filesystem, df_size, used, avail, usep, mnt;
-        dfiss >> filesystem >> df_size >> used >> avail >> usep >> mnt;
+    const auto filesystems = SpaceUsage::ofDisk(*disk, parts);
 
-        std::cout << "│\n";
-        std::cout << "│ Used:        " << used << "\n";
-        std::cout << "│ Available:   " << avail << "\n";
-        std::cout << "│ Used %:      " << usep << "\n";
+    auto exact = [](uint64_t bytes) {
+        return BlockIOUtils::humanBytes(bytes) + " (" + std::to_string(bytes) + " bytes)";
+    };
 
-    } else {
+    std::cout << "│ Device:      " << disk->path << "\n";
+    std::cout << "│ Size:        " << exact(disk->size) << "\n";
+    std::cout << "│ Type:        " << disk->type << "\n";
+    std::cout << "│ Mountpoint:  " << (filesystems.empty() ? "-" : filesystems.front().mountpoints.front()) << "\n";
 
+    if (filesystems.empty()) {
         std::cout << "No mountpoint, cannot show used/free space.\n";
+    }
+
+    for (const auto &fs : filesystems) {
+        std::cout << "│\n";
+        std::cout << "│ " << fs.device << " (" << fs.fstype << (fs.read_only ? ", read-only" : "") << ") on ";
+        for (size_t i = 0; i < fs.mountpoints.size(); ++i) std::cout << (i ? ", " : "") << fs.mountpoints[i];
+        std::cout << "\n";
+
+        if (!fs.error.empty()) {
+            std::cout << "│   " << fs.error << "\n";
+            LOG_WARNING(fs.error);
+            continue;
+        }
+
+        std::cout << "│   Size:        " << exact(fs.total) << "\n";
+        std::cout << "│   Used:        " << exact(fs.used) << "\n";
+        std::cout << "│   Free:        " << exact(fs.free) << "\n";
+        std::cout << "│   Available:   " << exact(fs.available) << "\n";
+        std::cout << "│   Used %:      " << fs.usedPercent() << "%\n";
 
+        if (fs.inodes > 0) {
+            std::cout << "│   Inodes:      " << fs.inodes_used << " used, " << fs.inodes_free << " free of " << fs.inodes
+                      << " (" << fs.inodesUsedPercent() << "%)\n";
+        }
+
+        if (fs.usedPercent() >= SpaceUsage::WARN_PERCENT) {
+            std::cout << "│   " << YELLOW << "[Warning] " << RESET << "filesystem is " << fs.usedPercent() << "% full\n";
+        }
+
+        if (fs.inodes > 0 && fs.inodesUsedPercent() >= SpaceUsage::WARN_PERCENT) {
+            std::cout << "│   " << YELLOW << "[Warning] " << RESET << fs.inodesUsedPercent() << "% of the inodes are used\n";
+        }
     }
-    
+
     std::cout << (Globals::g_no_color ? BOLD : Globals::g_THEME_COLOR) << "└──────────────────────────────\n" << RESET;
+
+    if (filesystems.empty()) return;
+
+    size_t pick = 0;
+
+    if (filesystems.size() > 1) {
+        std::cout << "\nShow where the space went on which filesystem? (1-" << filesystems.size() << ", 0 to skip): ";
+        const auto choice = InputValidation::getInt(0, static_cast<int>(filesystems.size()));
+        if (!choice.has_value() || *choice == 0) return;
+        pick = static_cast<size_t>(*choice - 1);
+    } else {
+        std::cout << "\nShow where the space went on " << filesystems.front().mountpoints.front() << "? (y/n): ";
+        const auto confirm = InputValidation::getChar({'y', 'n'});
+        if (!confirm.has_value() || *confirm != 'y') return;
+    }
+
+    analyzeDirectoryUsage(filesystems[pick].mountpoints.front(), {}, 10, 2);
 }
 
 
@@ -644,24 +725,54 @@ int checkDriveHealth() {
     std::cout << "[Check Drive health]\n";
     const std::string driveHealth_name = ListDrivesUtil::listDrives(true);
 
-    try {
+    const HealthReport report = DriveHealth::read(driveHealth_name);
+    DriveHealth::printReport(report);
+
+    if (report.verdict == HealthReport::Verdict::Unknown) {
+
+        ERR(ErrorCode::DataUnavailable, "No SMART data for " + driveHealth_name + ": " + report.error);
+        LOG_ERROR("No SMART data for " + driveHealth_name + ": " + report.error);
 
-        const std::string health_cmd = "smartctl -H " + driveHealth_name;
-        const auto res = EXEC_QUIET_SUDO(health_cmd);
-        const std::string health_output = StrUtils::removeFirstLines(res.output, 3); 
-        std::cout << health_output;
+    } else if (report.verdict == HealthReport::Verdict::Failed) {
 
-    } catch(const std::exception& e) {
+        LOG_WARNING("SMART health check of " + driveHealth_name + " FAILED");
 
-        std::string error = e.what();
-        LOG_ERROR(error);
-        ERR(ErrorCode::ProcessFailure, e.what());
+    } else {
+
+        LOG_INFO("SMART health check of " + driveHealth_name + " passed");
 
     }
 
    return 0;
 }
 
+/**
+ * @brief Health of every listed disk at once (--check-health-all), one summary line per drive
+ */
+int checkAllDrivesHealth() {
+    std::cout << "[Check health of all drives]\n";
+
+    std::vector<std::string> devices;
+    DiskLister lister;
+    for (const auto& disk : lister.getPhysicalDisksInfo()) devices.push_back(disk.device);
+
+    if (devices.empty()) {
+        ERR(ErrorCode::DeviceNotFound, "No drives found");
+        return 1;
+    }
+
+    const auto reports = DriveHealth::readMany(devices);
+    DriveHealth::printSummary(reports);
+
+    size_t failed = 0;
+    for (const auto& r : reports) failed += r.verdict == HealthReport::Verdict::Failed;
+
+    if (failed > 0) LOG_WARNING(std::to_string(failed) + " of " + std::to_string(reports.size()) + " drives FAILED the SMART health check");
+    else LOG_INFO("SMART health of " + std::to_string(reports.size()) + " drives checked");
+
+    return failed > 0 ? 1 : 0;
+}
+
 
 // ========== Drive Resizing ==========
 
@@ -727,34 +838,22 @@ private:
     };
 
     static std::optional<std::string> isValidDrive(const std::string &drive_name) {
-        std::string cmd = "lsblk -o TYPE,VENDOR,TRAN -P -p " + drive_name; 
-        auto res = EXEC_QUIET(cmd);
+        const auto dev = BlockDevices::probe(drive_name);
 
-        if (!res.success || res.output.empty()) {
+        if (!dev.has_value()) {
 
-            ERR(ErrorCode::ProcessFailure, "lsblk failed to succed");
-            LOG_ERROR("lsblk failed to succed");
+            ERR(ErrorCode::DeviceNotFound, "Could not read the block device " + drive_name);
+            LOG_ERROR("Could not read the block device " + drive_name);
             return std::nullopt;
 
         }
 
         std::unordered_map<Metadata, std::string, MetadataHash> meta;
 
-        auto extract = [&](const std::string& key) -> std::string {
-            std::string search = key + "=\"";
-            size_t start = res.output.find(search);
-            if (start == std::string::npos) return "N/A";
-
-            start += search.length();
-            size_t end = res.output.find("\"", start);
-            if (end == std::string::npos) return "N/A";
-
-            return res.output.substr(start, end - start);
-        };
-
-        meta[Metadata::TYPE] = extract("TYPE");
-        meta[Metadata::VENDOR] = extract("VENDOR");
-        std::string tran = StrUtils::toLowerString(meta[Metadata::TRAN] = extract("TRAN"));
+        meta[Metadata::TYPE] = dev->type;
+        meta[Metadata::VENDOR] = dev->vendor.empty() ? "N/A" : dev->vendor;
+        meta[Metadata::TRAN] = dev->transport;
+        const std::string tran = dev->transport;
 
         if (meta[Metadata::TYPE] != "disk") {
 
@@ -1125,218 +1224,700 @@ public:
 };
 
 
-// ========== Drive Data Overwriting ==========
-// Tried my best to make this as safe and readable and maintainable as possible. v0.9.12.92
+// ========== Resumable Operations ==========
+// clone, burn, wipe and image keep an OperationJournal, --resume continues them after an interruption
 
-void overwriteDriveData() { 
-    std::cout << BOLD << "\n[Drive Data Overwriting]" << RESET << "\n";
-    const std::string drive_to_operate_on = ListDrivesUtil::listDrives(true);
+/**
+ * @brief Journal identity of a target, a missing file target is created first since files are identified by their inode
+ */
+static std::string targetIdentity(const std::string &target) {
+    if (!fileExists(target)) std::ofstream(target, std::ios::binary | std::ios::app);
+    return OperationJournal::identify(target, false);
+}
 
-    std::cout << YELLOW << "[WARNING]" << RESET << " Are you sure you want to overwrite all data on " << BOLD << drive_to_operate_on << RESET << "? This action cannot be undone! (y/n)\n";
-        
-    const auto confirm = InputValidation::getChar({'y', 'n'});
-    if (!confirm.has_value()) return;
+/**
+ * @brief Journal header of a fresh clone/burn, with the options it runs with
+ */
+static OperationJournal::State copyState(OperationJournal::Operation op, const std::string &source, const std::string &target, const BlockCopy::Options &opts) {
+    OperationJournal::State state;
+    state.op = op;
+    state.source = source;
+    state.source_id = OperationJournal::identify(source, true);
+    state.target = target;
+    state.target_id = targetIdentity(target);
+    state.block_size = opts.chunk_size;
+    state.compare_before_write = opts.compare_before_write;
+    state.decompress = opts.decompress;
+    state.validate_header = static_cast<bool>(opts.validate_header);
+
+    const auto format = opts.decompress ? CompressedImage::detect(source) : CompressedImage::Format::None;
+    state.total = format == CompressedImage::Format::None ? BlockIOUtils::sizeOfPath(source) : CompressedImage::decompressedSize(source, format);
+
+    return state;
+}
 
-    if (confirm != 'y') {
+/**
+ * @brief BlockCopy::copy() with an OperationJournal, so an interrupted clone/burn can be continued with --resume
+ * @param resume the validated journal state when continuing, nullptr for a fresh run
+ * @return the copy result covering the whole target, digests and byte count of earlier runs included
+ */
+static BlockCopy::CopyResult journaledCopy(OperationJournal::Operation op, const std::string &source, const std::string &target, BlockCopy::Options opts, const OperationJournal::State *resume = nullptr) {
+    if (Globals::g_dry_run) return BlockCopy::copy(source, target, opts);
 
-        std::cout << BOLD << "[Overwriting aborted]" << RESET << " The Overwriting process of " << drive_to_operate_on << " was interupted by user\n";
-        LOG_INFO("Overwriting process aborted by user for drive: " + drive_to_operate_on);
-        return;
+    OperationJournal journal(OperationJournal::defaultPath(op, source, target));
+    OperationJournal::State state;
 
-    }
+    if (resume) {
 
-    std::cout << "\nTo be sure you want to overwrite the data on " << BOLD << drive_to_operate_on << RESET << " you need to enter the following safety key\n";
+        state = *resume;
+        opts.chunk_size = state.block_size;
+        opts.start_offset = state.committed;
+        journal.resume(state);
 
-    const std::string conf_key = confirmationKeyGenerator();
-    LOG_INFO("Confirmation key generated for overwriting drive: " + drive_to_operate_on);
+    } else {
 
-    std::cout << "\n" << conf_key << "\n";
-    std::cout << "\nEnter the confirmation key:\n";
+        state = copyState(op, source, target, opts);
+        journal.begin(state);
 
-    auto user_input = InputValidation::getString();
-    if (!user_input.has_value()) return;
+    }
 
-    if (user_input != conf_key) {
+    opts.checkpoint = [&journal](uint64_t committed, const std::vector<BlockCopy::ChunkDigest> &digests, const std::vector<size_t>&) { journal.commit(committed, 0, digests); };
 
-        std::cout << BOLD << "[INFO]" << RESET << " The confirmationkey was incorrect, the overwriting process has been interupted\n";
-        LOG_INFO("Incorrect confirmation key entered, overwriting process aborted for drive: " + drive_to_operate_on);
-        return;
+    auto res = BlockCopy::copy(source, target, opts);
 
+    if (resume) {
+        res.digests.insert(res.digests.begin(), state.digests.begin(), state.digests.end());
+        res.bytes_copied += state.committed;
     }
 
-    std::cout << YELLOW << "\n[Process]" << RESET << " Proceeding with overwriting all data on: " << drive_to_operate_on << "\n";
-    std::cout << " \n";
-
-    try {
-        const auto res_urandom = EXEC_SUDO_SPINNER("dd if=/dev/urandom of=" + drive_to_operate_on + " bs=16M >/dev/null 2>&1 && sync"); 
-        const auto res_zero = EXEC_SUDO_SPINNER("dd if=/dev/zero of=" + drive_to_operate_on + " bs=16M >/dev/null 2>&1 && sync"); 
-            
-        if (!res_urandom.success && !res_zero.success) {
+    if (res.success) {
+        journal.remove();
+    } else {
+        std::cout << YELLOW << "[Info] " << RESET << "Progress is kept in " << journal.path() << ", continue with --resume\n";
+    }
 
-            ERR(ErrorCode::ProcessFailure, "Failed to overwrite the drive: " + drive_to_operate_on);
-            LOG_ERROR("Overwriting failed to complete for drive: " + drive_to_operate_on);
-            return;
+    return res;
+}
 
-        } else if (!res_urandom.success || !res_zero.success) {
+/**
+ * @brief BlockCopy::copyMulti() with one OperationJournal per target. Each one is a plain clone/burn journal,
+ * so --resume continues an interrupted target on its own from the last offset all live targets had flushed.
+ */
+static BlockCopy::MultiCopyResult journaledCopyMulti(OperationJournal::Operation op, const std::string &source, const std::vector<std::string> &targets, BlockCopy::Options opts) {
+    if (Globals::g_dry_run) return BlockCopy::copyMulti(source, targets, opts);
 
-            std::cout << YELLOW << "[Warning]" << RESET << " One of the overwriting operations failed, but the drive may have been partially overwritten. Please check the output and try again if necessary.\n";
-            LOG_WARNING("One of the overwriting operations failed for drive: " + drive_to_operate_on);
-            return;
-        } 
+    std::vector<std::unique_ptr<OperationJournal>> journals;
 
-        std::cout << GREEN << "[Success]" << RESET << " Overwriting completed successfully for drive: " << drive_to_operate_on << "\n";
-        LOG_SUCCESS("Overwriting completed successfully for drive: " + drive_to_operate_on);
-        return;
+    for (const auto &target : targets) {
+        journals.push_back(std::make_unique<OperationJournal>(OperationJournal::defaultPath(op, source, target)));
+        journals.back()->begin(copyState(op, source, target, opts));
+    }
 
-    } catch (const std::exception& e) {
+    opts.checkpoint = [&journals](uint64_t committed, const std::vector<BlockCopy::ChunkDigest> &digests, const std::vector<size_t> &live) {
+        for (const size_t i : live) journals[i]->commit(committed, 0, digests);
+    };
 
-        LOG_ERROR("Failed during overwriting process for drive: " + drive_to_operate_on + " Reason: " + e.what());
-        ERR(ErrorCode::ProcessFailure, "Exception during overwriting process: " + std::string(e.what()));
-        return;
+    auto res = BlockCopy::copyMulti(source, targets, opts);
 
+    for (size_t i = 0; i < res.targets.size(); ++i) {
+        if (res.targets[i].success) {
+            journals[i]->remove();
+        } else {
+            std::cout << YELLOW << "[Info] " << RESET << "Progress of " << targets[i] << " is kept in " << journals[i]->path() << ", continue with --resume\n";
+        }
     }
+
+    return res;
 }
 
+/**
+ * @brief The overwrite passes of a wipe scheme, journaled per pass
+ * The seed of the random pass is journaled too, so a resumed pass continues the same stream and can still be verified.
+ * @param resume the validated journal state when continuing, nullptr for a fresh run
+ * @return the result of every pass that ran, a failed read-back of RandomVerify is reported as a failed result
+ */
+static std::vector<WipeEngine::Result> journaledWipe(const std::string &target, WipeEngine::Scheme scheme, const OperationJournal::State *resume = nullptr) {
+    const auto passes = WipeEngine::passes(scheme);
+    std::vector<WipeEngine::Result> results;
+    WipeEngine::Options opts;
+
+    if (Globals::g_dry_run) {
+        for (auto pattern : passes) results.push_back(WipeEngine::fill(target, pattern));
+        return results;
+    }
 
-// ========== Drive Metadata Reader ==========
-// getMetadata refactor
+    OperationJournal journal(OperationJournal::defaultPath(OperationJournal::Operation::Wipe, "", target));
+    OperationJournal::State state;
 
-class MetadataReader {
-private:
-    static std::optional<DriveMetadataStruct::DriveMetadata> getMetadata(const std::string& drive) {
-        DriveMetadataStruct::DriveMetadata metadata;
-        // -P (Pairs) is the key here. It output KEY="VALUE"
-        const std::string cmd = "lsblk -o NAME,SIZE,MODEL,SERIAL,TYPE,MOUNTPOINT,VENDOR,FSTYPE,UUID -P -p " + drive; 
+    if (resume) {
 
-        const auto res = EXEC_QUIET(cmd);
+        state = *resume;
+        opts.chunk_size = state.block_size;
+        journal.resume(state);
 
-        if (!res.success || res.output.empty()) { 
+    } else {
 
-            ERR(ErrorCode::ProcessFailure, "The lsblk failed to deliver data");
-            LOG_ERROR("lsblk failed to deliver data");
-            return std::nullopt; 
-            
-        }
+        state.op = OperationJournal::Operation::Wipe;
+        state.target = target;
+        state.target_id = OperationJournal::identify(target, false);
+        state.block_size = opts.chunk_size;
+        state.total = BlockIOUtils::sizeOfPath(target);
+        state.scheme = WipeEngine::schemeName(scheme);
+        state.seed = WipeEngine::seedToHex(WipeEngine::newSeed());
+        journal.begin(state);
 
-        auto extract = [&](const std::string& key) -> std::string {
-            std::string search = key + "=\"";
-            size_t start = res.output.find(search);
+    }
 
-            if (start == std::string::npos) return "N/A";
-            
-            start += search.length();
-            size_t end = res.output.find("\"", start);
+    opts.seed = WipeEngine::seedFromHex(state.seed);
 
-            if (end == std::string::npos) return "N/A";
-            
-            std::string val = res.output.substr(start, end - start);
-            return val.empty() ? "N/A" : val;
-        };
+    for (unsigned pass = state.pass; pass < passes.size(); ++pass) {
+        opts.start_offset = pass == state.pass ? state.committed : 0;
+        opts.checkpoint = [&journal, pass](uint64_t committed) { journal.commit(committed, pass); };
 
-        metadata.name       = extract("NAME");
-        metadata.size       = extract("SIZE");
-        metadata.model      = extract("MODEL");
-        metadata.serial     = extract("SERIAL");
-        metadata.type       = extract("TYPE");
-        metadata.mountpoint = extract("MOUNTPOINT");
-        metadata.vendor     = extract("VENDOR");
-        metadata.fstype     = extract("FSTYPE");
-        metadata.uuid       = extract("UUID");
+        if (pass > 0) journal.commit(opts.start_offset, pass);
 
-        return metadata;
+        results.push_back(WipeEngine::fill(target, passes[pass], opts));
     }
 
-    static void displayMetadata(const DriveMetadataStruct::DriveMetadata& metadata) {
-        std::cout << "\n-------- Drive Metadata --------\n";
+    if (scheme == WipeEngine::Scheme::RandomVerify && !results.empty() && results.back().success) {
+        std::cout << "[Info] Reading " << target << " back to verify the random pass...\n";
+        const auto verify_res = WipeEngine::verify(target, results.back().seed, opts);
+        WipeEngine::printVerifyReport(verify_res);
 
-        auto printAttr = [&](const std::string& attr, const std::string& value) {
-            std::cout << "| " << attr << ": " << (value.empty() ? "N/A" : value) << "\n";
-        };
+        if (!verify_res.success) {
+            WipeEngine::Result failed;
+            failed.error = verify_res.error.empty() ? std::to_string(verify_res.mismatches.size()) + " range(s) of " + target + " dont hold the written data" : verify_res.error;
+            results.push_back(failed);
+        }
 
-        printAttr("Name", metadata.name.value_or("[ERROR] No Data available"));
-        printAttr("Size", metadata.size.value_or("[ERROR] No Data available"));
-        printAttr("Model", metadata.model.value_or("[ERROR] No Data available"));
-        printAttr("Serial", metadata.serial.value_or("[ERROR] No Data available"));
-        printAttr("Type", metadata.type.value_or("N/A"));
-        printAttr("Mountpoint", metadata.mountpoint.value_or("Not mounted"));
-        printAttr("Vendor", metadata.vendor.value_or("N/A"));
-        printAttr("Filesystem", metadata.fstype.value_or("N/A"));
-        printAttr("UUID", metadata.uuid.value_or("N/A"));
+    } else if (!Globals::g_dry_run && !results.empty() && results.back().success) {
+        // no full read back for the other schemes, a statistical check takes seconds
+        const bool last_random = passes.back() == WipeEngine::Pattern::Random;
+        std::cout << "[Info] Sampling " << target << " to check the wipe...\n";
 
-        if (metadata.type == "disk") {
+        const auto sample_res = WipeEngine::sampleVerify(target, last_random ? opts.seed : std::nullopt);
+        WipeEngine::printSampleReport(sample_res);
 
-            std::cout << "\n┌-─-─-─- SMART Data -─-─-─-─\n";
-            
-            const std::string smartCmd = "smartctl -i " + *metadata.name;
-            const auto res = EXEC_QUIET_SUDO(smartCmd); 
+        if (!sample_res.success) {
+            WipeEngine::Result failed;
+            failed.error = sample_res.error.empty() ? std::to_string(sample_res.blocks_bad) + " sampled block(s) of " + target + " dont hold the wipe pattern" : sample_res.error;
+            results.push_back(failed);
+        }
+    }
 
-            if (!res.success) {
+    bool all_ok = true;
+    for (const auto &r : results) all_ok = all_ok && r.success;
 
-                ERR(ErrorCode::ProcessFailure, "Failed to retrieve SMART data for " + *metadata.name);
-                LOG_ERROR("Failed to retrieve SMART data for " + *metadata.name);
-                return;
+    if (all_ok) {
+        journal.remove();
+    } else {
+        std::cout << YELLOW << "[Info] " << RESET << "Progress is kept in " << journal.path() << ", continue with --resume\n";
+    }
 
-            }
+    return results;
+}
 
-            const std::string smartOutput = StrUtils::removeFirstLines(res.output, 4);
+/**
+ * @brief Images source with the RescueImager, the rescue map holds the completed ranges and the journal records the devices
+ * @param resume the validated journal state when continuing, nullptr for a fresh run
+ */
+static void journaledDiskImage(const std::string &source, const std::string &target, const std::string &map_path, const OperationJournal::State *resume = nullptr) {
+    OperationJournal journal(OperationJournal::defaultPath(OperationJournal::Operation::Image, source, target));
+
+    if (!Globals::g_dry_run && !resume) {
+        OperationJournal::State state;
+        state.op = OperationJournal::Operation::Image;
+        state.source = source;
+        state.source_id = OperationJournal::identify(source, false); // a failing source may not be readable for sampling
+        state.target = target;
+        state.target_id = targetIdentity(target);
+        state.map_path = map_path;
+        journal.begin(state);
+    }
 
-            if (!smartOutput.empty()) {
+    if (fileExists(map_path)) std::cout << "[Info] Resuming from rescue map " << map_path << "\n";
 
-                std::cout << smartOutput;
+    IoQos::Scope qos(IoQos::Operation::Image, {source, target});
+    const auto res = RescueImager::rescue(source, target, map_path);
+    RescueImager::printReport(res);
 
-            } else {
+    if (!res.completed) {
+        ERR(ErrorCode::ProcessFailure, "Failed to create disk image: " + res.error);
+        LOG_ERROR("Failed to create disk image for drive: " + source + " " + res.error);
+        if (!Globals::g_dry_run) std::cout << YELLOW << "[Info] " << RESET << "Continue later with --resume\n";
+        return;
+    }
 
-                ERR(ErrorCode::CorruptedData, "Failed to retrieve SMART data for " + *metadata.name);
-                LOG_ERROR("Failed to retrieve SMART data for " + *metadata.name);
+    if (!Globals::g_dry_run) journal.remove();
 
-            }
-        }   
-        std::cout << "└─  - -─ --- ─ - -─-  - ──- ──- ───────────────────\n";         
-    } 
-    
-public:
-    static void mainReader() {
-        std::cout << "\n[Drive Metadata]\n";
-        const std::string driveName = ListDrivesUtil::listDrives(true);
-        auto metadata = getMetadata(driveName);
+    if (!res.success) {
+        std::cout << YELLOW << "[Warning] Disk image created at " << target << " with unreadable areas left empty\n" << RESET;
+        LOG_WARNING("Disk image for drive " + source + " has " + std::to_string(res.bytes_bad) + " unreadable bytes");
+        return;
+    }
 
-        try {
+    std::cout << GREEN << "[Success] Disk image created at " << target << "\n" << RESET;
+    LOG_SUCCESS("Disk image created successfully for drive: " + source);
+}
 
-            if (!metadata.has_value()) {
 
-                ERR(ErrorCode::ProcessFailure, "Failed to read metadata for drive: " + driveName);
-                LOG_ERROR("Failed to read metadata for drive: " + driveName);
-                return;
-                
-            }
+// ========== Drive Data Overwriting ==========
+// Tried my best to make this as safe and readable and maintainable as possible. v0.9.12.92
 
-            displayMetadata(*metadata);
+/**
+ * @brief Runs the passes of scheme on drive and reports the outcome
+ * @param resume the validated journal state when continuing an interrupted wipe, nullptr for a fresh one
+ */
+static void runOverwrite(const std::string &drive_to_operate_on, WipeEngine::Scheme scheme, const OperationJournal::State *resume = nullptr) {
+    try {
+        IoQos::Scope qos(IoQos::Operation::Wipe, {drive_to_operate_on});
 
-            LOG_SUCCESS("Successfully read metadata for drive: " + driveName);
+        const auto results = journaledWipe(drive_to_operate_on, scheme, resume);
 
-        } catch (const std::exception& e) {
+        size_t failed = 0;
+        std::string first_error;
 
-            ERR(ErrorCode::ProcessFailure, "Failed to read drive metadata: " + std::string(e.what()));
-            LOG_ERROR("Failed to read drive metadata: " + std::string(e.what()));
+        for (const auto &r : results) {
+            if (r.success) continue;
+            if (failed++ == 0) first_error = r.error;
+        }
+            
+        if (failed > 0 && failed == results.size()) {
+
+            ERR(ErrorCode::ProcessFailure, "Failed to overwrite the drive: " + drive_to_operate_on + ": " + first_error);
+            LOG_ERROR("Overwriting failed to complete for drive: " + drive_to_operate_on);
             return;
 
-        }
+        } else if (failed > 0) {
 
-        DriveMetadataStruct::clearMetadata(*metadata);
-    } 
-};
+            std::cout << YELLOW << "[Warning]" << RESET << " One of the overwriting operations failed, but the drive may have been partially overwritten. Please check the output and try again if necessary.\n";
+            LOG_WARNING("One of the overwriting operations failed for drive: " + drive_to_operate_on);
+            return;
+        } 
 
+        std::cout << GREEN << "[Success]" << RESET << " Overwriting completed successfully for drive: " << drive_to_operate_on << "\n";
+        LOG_SUCCESS("Overwriting completed successfully for drive: " + drive_to_operate_on);
+        return;
 
-// ========== Mounting and Burning Utilities ==========
-// IsoFileMetadataChecker and IsoBurner refactored; v0.9.13.93
+    } catch (const std::exception& e) {
 
-class MountUtility {
-private:
-    /**
-     * @brief Checks if the provided ISO file has valid metadata by verifying the ISO9660 signature at the expected offset. This helps ensure that the file is a valid ISO image before attempting to burn it to a storage device.
-     * @param iso_path The file path to the ISO image to be checked.
-     * @return true if the ISO file is valid and contains the correct metadata; false otherwise.
-     */
+        LOG_ERROR("Failed during overwriting process for drive: " + drive_to_operate_on + " Reason: " + e.what());
+        ERR(ErrorCode::ProcessFailure, "Exception during overwriting process: " + std::string(e.what()));
+        return;
+
+    }
+}
+
+/**
+ * @brief Erases drive with the strongest command the device offers (sanitize, format, discard, ...), see HardwareErase
+ */
+static void runHardwareErase(const std::string &drive_to_operate_on) {
+    const auto caps = HardwareErase::probe(drive_to_operate_on);
+    HardwareErase::printCapabilities(drive_to_operate_on, caps);
+
+    if (caps.methods.empty()) {
+
+        std::cout << YELLOW << "[Info]" << RESET << " " << drive_to_operate_on << " cannot erase itself, choose one of the overwrite schemes instead\n";
+        LOG_INFO("No hardware erase method available for drive: " + drive_to_operate_on);
+        return;
+
+    }
+
+    const auto strongest = caps.methods.front();
+
+    if (strongest == HardwareErase::Method::NvmeSanitizeCrypto || strongest == HardwareErase::Method::NvmeSanitizeBlock
+        || strongest == HardwareErase::Method::AtaSanitizeCrypto || strongest == HardwareErase::Method::AtaSanitizeBlock) {
+        std::cout << YELLOW << "[Info]" << RESET << " A sanitize keeps running inside the drive, it stays unusable until it finished (even after a power cycle)\n";
+    } else if (!HardwareErase::destroysMedia(strongest)) {
+        std::cout << YELLOW << "[Info]" << RESET << " " << HardwareErase::methodName(strongest) << " does not erase the flash itself, the read back check shows if the old data is still returned\n";
+    }
+
+    const auto res = HardwareErase::run(drive_to_operate_on);
+    HardwareErase::printReport(res);
+
+    if (!res.success) {
+        LOG_ERROR("Hardware erase failed for drive: " + drive_to_operate_on + " " + res.error);
+        return;
+    }
+
+    LOG_SUCCESS("Hardware erase (" + HardwareErase::methodName(res.method) + ") completed for drive: " + drive_to_operate_on);
+}
+
+void overwriteDriveData() { 
+    std::cout << BOLD << "\n[Drive Data Overwriting]" << RESET << "\n";
+    const std::string drive_to_operate_on = ListDrivesUtil::listDrives(true);
+
+    std::cout << YELLOW << "[WARNING]" << RESET << " Are you sure you want to overwrite all data on " << BOLD << drive_to_operate_on << RESET << "? This action cannot be undone! (y/n)\n";
+        
+    const auto confirm = InputValidation::getChar({'y', 'n'});
+    if (!confirm.has_value()) return;
+
+    if (confirm != 'y') {
+
+        std::cout << BOLD << "[Overwriting aborted]" << RESET << " The Overwriting process of " << drive_to_operate_on << " was interupted by user\n";
+        LOG_INFO("Overwriting process aborted by user for drive: " + drive_to_operate_on);
+        return;
+
+    }
+
+    std::cout << "\nTo be sure you want to overwrite the data on " << BOLD << drive_to_operate_on << RESET << " you need to enter the following safety key\n";
+
+    const std::string conf_key = confirmationKeyGenerator();
+    LOG_INFO("Confirmation key generated for overwriting drive: " + drive_to_operate_on);
+
+    std::cout << "\n" << conf_key << "\n";
+    std::cout << "\nEnter the confirmation key:\n";
+
+    auto user_input = InputValidation::getString();
+    if (!user_input.has_value()) return;
+
+    if (user_input != conf_key) {
+
+        std::cout << BOLD << "[INFO]" << RESET << " The confirmationkey was incorrect, the overwriting process has been interupted\n";
+        LOG_INFO("Incorrect confirmation key entered, overwriting process aborted for drive: " + drive_to_operate_on);
+        return;
+
+    }
+
+    std::cout << "\nChoose the overwrite scheme:\n"
+              << "  1) Random data, one pass\n"
+              << "  2) Zeros, one pass\n"
+              << "  3) Random data, then read back and verified\n"
+              << "  4) Random data, then zeros\n"
+              << "  5) Hardware erase (sanitize, secure format or discard, whatever the drive supports)\n";
+
+    static const WipeEngine::Scheme schemes[] = {WipeEngine::Scheme::Random, WipeEngine::Scheme::Zero, WipeEngine::Scheme::RandomVerify, WipeEngine::Scheme::RandomZero};
+
+    const auto scheme_choice = InputValidation::getInt(1, 5);
+    if (!scheme_choice.has_value()) return;
+
+    if (*scheme_choice == 5) {
+        std::cout << YELLOW << "\n[Process]" << RESET << " Erasing all data on: " << drive_to_operate_on << " with the drive's own commands\n";
+        runHardwareErase(drive_to_operate_on);
+        return;
+    }
+
+    const WipeEngine::Scheme scheme = schemes[*scheme_choice - 1];
+
+    std::cout << YELLOW << "\n[Process]" << RESET << " Proceeding with overwriting all data on: " << drive_to_operate_on << " (" << WipeEngine::schemeName(scheme) << ")\n";
+    std::cout << " \n";
+
+    runOverwrite(drive_to_operate_on, scheme);
+}
+
+
+// ========== Batch Wipe ==========
+
+/**
+ * @brief Wipes several drives at once (--wipe-batch), after the same two confirmations as overwriteDriveData
+ * @param per_bus concurrent wipes per controller or USB hub, 0 for the defaults
+ */
+void batchWipe(std::vector<std::string> drives, WipeEngine::Scheme scheme, unsigned per_bus) {
+    std::cout << BOLD << "\n[Batch Wipe]" << RESET << "\n";
+
+    std::sort(drives.begin(), drives.end());
+    drives.erase(std::unique(drives.begin(), drives.end()), drives.end());
+
+    for (const auto &drive : drives) {
+        if (fileExists(drive)) continue;
+
+        ERR(ErrorCode::DeviceNotFound, "The device '" + drive + "' could not be found");
+        LOG_ERROR("Batch wipe: the device '" + drive + "' could not be found");
+        return;
+    }
+
+    if (drives.empty()) {
+
+        ERR(ErrorCode::InvalidInput, "No drives given for the batch wipe");
+        return;
+
+    }
+
+    std::cout << "Scheme: " << BOLD << WipeEngine::schemeName(scheme) << RESET << "\n";
+
+    for (const auto &drive : drives) {
+        std::cout << "  " << drive << "  (" << BlockIOUtils::humanBytes(BlockIOUtils::sizeOfPath(drive)) << ", bus " << BatchWipe::busLabel(BatchWipe::busOf(drive)) << ")\n";
+    }
+
+    std::cout << YELLOW << "[WARNING]" << RESET << " Are you sure you want to overwrite all data on these " << drives.size() << " drive(s)? This action cannot be undone! (y/n)\n";
+
+    const auto confirm = InputValidation::getChar({'y', 'n'});
+    if (!confirm.has_value()) return;
+
+    if (confirm != 'y') {
+
+        std::cout << BOLD << "[Batch wipe aborted]" << RESET << "\n";
+        LOG_INFO("Batch wipe aborted by user");
+        return;
+
+    }
+
+    const std::string conf_key = confirmationKeyGenerator();
+    LOG_INFO("Confirmation key generated for batch wipe of " + std::to_string(drives.size()) + " drive(s)");
+
+    std::cout << "\nTo be sure, enter the following safety key\n\n" << conf_key << "\n\nEnter the confirmation key:\n";
+
+    const auto user_input = InputValidation::getString();
+    if (!user_input.has_value()) return;
+
+    if (user_input != conf_key) {
+
+        std::cout << BOLD << "[INFO]" << RESET << " The confirmationkey was incorrect, the batch wipe has been interupted\n";
+        LOG_INFO("Incorrect confirmation key entered, batch wipe aborted");
+        return;
+
+    }
+
+    BatchWipe::Options opts;
+    opts.scheme = scheme;
+    opts.per_bus = per_bus;
+
+    LOG_INFO("Batch wipe (" + WipeEngine::schemeName(scheme) + ") of " + std::to_string(drives.size()) + " drive(s) started");
+
+    std::cout << "\n";
+    const auto results = BatchWipe::run(drives, opts);
+    BatchWipe::printSummary(results);
+}
+
+
+// ========== Wipe Verification ==========
+
+/**
+ * @brief Statistical check of an earlier wipe (--verify-wipe), reads random blocks and compares them with zeros or the stream of seed_hex
+ * @param seed_hex seed of a last random pass (from the wipe journal or certificate), empty to expect zeros
+ */
+void verifyWipe(const std::string &drive, const std::string &seed_hex, size_t samples, uint64_t stride) {
+    std::cout << BOLD << "\n[Wipe Verification]" << RESET << "\n";
+
+    if (!fileExists(drive)) {
+
+        ERR(ErrorCode::DeviceNotFound, "The device '" + drive + "' could not be found");
+        LOG_ERROR("Wipe verification: the device '" + drive + "' could not be found");
+        return;
+
+    }
+
+    std::optional<WipeEngine::Seed> seed;
+
+    if (!seed_hex.empty()) {
+        seed = WipeEngine::seedFromHex(seed_hex);
+
+        if (!seed.has_value()) {
+
+            ERR(ErrorCode::InvalidInput, "The seed has to be 48 hex digits");
+            return;
+
+        }
+    }
+
+    WipeEngine::SampleOptions sopts;
+    sopts.count = samples;
+    sopts.stride = stride;
+
+    std::cout << "Checking " << drive << " for " << (seed ? "the random stream of the seed" : "zeros") << " (" << samples << " random blocks"
+              << (stride > 0 ? ", every " + std::to_string(stride) + ". block" : "") << ")\n";
+
+    const auto res = WipeEngine::sampleVerify(drive, seed, sopts);
+    WipeEngine::printSampleReport(res);
+
+    if (res.success) LOG_SUCCESS("Wipe of " + drive + " verified by sampling");
+}
+
+
+// ========== Free Space Wipe ==========
+
+/**
+ * @brief Wipes only the free space of a filesystem (--wipe-free), the files on it stay
+ * @param target unmounted partition or image (allocation bitmap), mounted partition or directory (filler files)
+ */
+void freeSpaceWipe(const std::string &target, WipeEngine::Pattern pattern, bool discard) {
+    std::cout << BOLD << "\n[Free Space Wipe]" << RESET << "\n";
+
+    if (!fileExists(target)) {
+
+        ERR(ErrorCode::DeviceNotFound, "'" + target + "' could not be found");
+        LOG_ERROR("Free space wipe: '" + target + "' could not be found");
+        return;
+
+    }
+
+    const std::string mountpoint = FreeSpaceWipe::mountPointOf(target);
+
+    if (!mountpoint.empty()) {
+        std::cout << target << " is mounted on " << mountpoint << ", its free space is filled with files that are removed afterwards\n";
+        std::cout << YELLOW << "[Info]" << RESET << " Programs writing to " << mountpoint << " meanwhile can run out of space\n";
+    }
+
+    std::cout << YELLOW << "[WARNING]" << RESET << " Deleted data on " << BOLD << target << RESET << " can not be recovered afterwards, files in use are kept. Continue? (y/n)\n";
+
+    const auto confirm = InputValidation::getChar({'y', 'n'});
+    if (!confirm.has_value()) return;
+
+    if (confirm != 'y') {
+
+        std::cout << BOLD << "[Free space wipe aborted]" << RESET << "\n";
+        LOG_INFO("Free space wipe aborted by user for: " + target);
+        return;
+
+    }
+
+    FreeSpaceWipe::Options opts;
+    opts.pattern = pattern;
+    opts.discard = discard;
+
+    IoQos::Scope qos(IoQos::Operation::Wipe, {target});
+
+    const auto res = FreeSpaceWipe::run(target, opts);
+    if (!Globals::g_dry_run) FreeSpaceWipe::printReport(res);
+
+    if (res.success) LOG_SUCCESS("Free space of " + target + " wiped");
+}
+
+
+// ========== Drive Metadata Reader ==========
+// getMetadata refactor
+
+class MetadataReader {
+private:
+    static std::optional<DriveMetadataStruct::DriveMetadata> getMetadata(const std::string& drive) {
+        DriveMetadataStruct::DriveMetadata metadata;
+        std::string err;
+
+        if (!DriveProbe::fillMetadata(drive, metadata, err)) { 
+
+            ERR(ErrorCode::DeviceNotFound, err);
+            LOG_ERROR(err);
+            return std::nullopt; 
+            
+        }
+
+        return metadata;
+    }
+
+    static void displayMetadata(const DriveMetadataStruct::DriveMetadata& metadata) {
+        std::cout << "\n-------- Drive Metadata --------\n";
+
+        auto printAttr = [&](const std::string& attr, const std::string& value) {
+            std::cout << "| " << attr << ": " << (value.empty() ? "N/A" : value) << "\n";
+        };
+
+        printAttr("Name", metadata.name.value_or("[ERROR] No Data available"));
+        printAttr("Size", metadata.size.value_or("[ERROR] No Data available")
+            + (metadata.size_bytes ? " (" + std::to_string(*metadata.size_bytes) + " bytes)" : ""));
+
+        if (metadata.logical_sector_size) {
+            printAttr("Sector size", std::to_string(*metadata.logical_sector_size) + " logical / "
+                + std::to_string(metadata.physical_sector_size.value_or(*metadata.logical_sector_size)) + " physical");
+        }
+
+        printAttr("Model", metadata.model.value_or("[ERROR] No Data available"));
+        printAttr("Serial", metadata.serial.value_or("[ERROR] No Data available"));
+        printAttr("Firmware", metadata.firmware.value_or("N/A"));
+        printAttr("WWN", metadata.wwn.value_or("N/A"));
+        printAttr("Type", metadata.type.value_or("N/A"));
+        printAttr("Mountpoint", metadata.mountpoint.value_or("Not mounted"));
+        printAttr("Vendor", metadata.vendor.value_or("N/A"));
+        printAttr("Filesystem", metadata.fstype.value_or("N/A"));
+        printAttr("UUID", metadata.uuid.value_or("N/A"));
+
+        if (metadata.type == "disk") {
+
+            std::cout << "\n┌-─-─-─- SMART Data -─-─-─-─\n";
+
+            const HealthReport health = DriveHealth::read(*metadata.name);
+
+            if (health.protocol == HealthReport::Protocol::None) {
+
+                ERR(ErrorCode::DataUnavailable, "Failed to retrieve SMART data for " + *metadata.name + ": " + health.error);
+                LOG_ERROR("Failed to retrieve SMART data for " + *metadata.name + ": " + health.error);
+                return;
+
+            }
+
+            printAttr("SMART support", !health.smart_supported ? "Unavailable" : health.smart_enabled ? "Available - enabled" : "Available - disabled");
+            printAttr("Overall health", DriveHealth::verdictName(health.verdict));
+            if (health.temperature) printAttr("Temperature", std::to_string(*health.temperature) + " C");
+            if (health.power_on_hours) printAttr("Power on hours", std::to_string(*health.power_on_hours));
+            for (const auto& w : health.warnings) printAttr("Warning", w);
+        }   
+        std::cout << "└─  - -─ --- ─ - -─-  - ──- ──- ───────────────────\n";         
+    } 
+    
+public:
+    static void mainReader() {
+        std::cout << "\n[Drive Metadata]\n";
+        const std::string driveName = ListDrivesUtil::listDrives(true);
+        auto metadata = getMetadata(driveName);
+
+        try {
+
+            if (!metadata.has_value()) {
+
+                ERR(ErrorCode::ProcessFailure, "Failed to read metadata for drive: " + driveName);
+                LOG_ERROR("Failed to read metadata for drive: " + driveName);
+                return;
+                
+            }
+
+            displayMetadata(*metadata);
+
+            LOG_SUCCESS("Successfully read metadata for drive: " + driveName);
+
+        } catch (const std::exception& e) {
+
+            ERR(ErrorCode::ProcessFailure, "Failed to read drive metadata: " + std::string(e.what()));
+            LOG_ERROR("Failed to read drive metadata: " + std::string(e.what()));
+            return;
+
+        }
+
+        DriveMetadataStruct::clearMetadata(*metadata);
+    } 
+};
+
+
+// ========== Mounting and Burning Utilities ==========
+// IsoFileMetadataChecker and IsoBurner refactored; v0.9.13.93
+
+class MountUtility {
+private:
+    /**
+     * @brief Recognizes a burnable image by its first bytes: the ISO9660 volume descriptor ("CD001" at 32769),
+     * or the GPT header / MBR partition table of a raw disk image (.img)
+     * @return the kind of image, empty if nothing matched
+     */
+    static std::string imageSignature(const unsigned char* data, size_t length) {
+        constexpr size_t iso_magic_offset = 32769; // 16 * 2048 + 1
+
+        if (length >= iso_magic_offset + 5 && std::memcmp(data + iso_magic_offset, "CD001", 5) == 0) return "ISO9660";
+        if (length >= 520 && std::memcmp(data + 512, "EFI PART", 8) == 0) return "GPT disk image";
+        if (length >= 512 && data[510] == 0x55 && data[511] == 0xAA && isMbrPartitionTable(data)) return "MBR disk image";
+
+        return "";
+    }
+
+    /**
+     * @brief 0x55AA alone also ends FAT/NTFS boot sectors and random data, so the four partition entries
+     * (at 446) must look like a table too: status 0x00 or 0x80 each, and at least one used entry
+     */
+    static bool isMbrPartitionTable(const unsigned char* sector) {
+        bool used = false;
+
+        for (size_t i = 0; i < 4; ++i) {
+            const unsigned char* entry = sector + 446 + 16 * i;
+            if (entry[0] != 0x00 && entry[0] != 0x80) return false;
+            if (entry[4] != 0x00) used = true;
+        }
+
+        return used;
+    }
+
+    /**
+     * @brief Checks if the provided ISO/IMG file has valid metadata by verifying the ISO9660 signature at the expected offset (or the partition table of a raw disk image). This helps ensure that the file is a valid image before attempting to burn it to a storage device.
+     * Compressed images (.xz, .gz, .zst) cant be checked without decompressing them, their signature is checked on the fly by validateImageHeader() before the first write.
+     * @param iso_path The file path to the ISO image to be checked.
+     * @return true if the ISO file is valid and contains the correct metadata; false otherwise.
+     */
     static bool IsoFileMetadataChecker(const std::string& iso_path) {
         namespace fs = std::filesystem;
 
@@ -1348,52 +1929,260 @@ private:
 
         }
 
-        constexpr std::streamoff iso_magic_offset = 32769; // 16 * 2048 + 1
+        const auto format = CompressedImage::detect(iso_path);
+
+        if (format != CompressedImage::Format::None) {
+
+            if (!CompressedImage::toolAvailable(format)) {
+
+                ERR(ErrorCode::ProcessFailure, "No " + CompressedImage::formatName(format) + " decompressor installed for: " + iso_path);
+                LOG_ERROR("No " + CompressedImage::formatName(format) + " decompressor installed for: " + iso_path);
+                return false;
+
+            }
+
+            std::cout << "[Info] " << CompressedImage::formatName(format) << " compressed image, it is decompressed while burning and checked before the first write\n";
+            return true;
+
+        }
+
+        constexpr size_t header_size = 32769 + 5; // up to the end of the ISO9660 magic
+
+        if (fs::file_size(iso_path) < 512) {
+
+            ERR(ErrorCode::InvalidInput, "ISO file too small to contain valid metadata: " + iso_path);
+            LOG_ERROR("ISO file too small to contain valid metadata: " + iso_path);
+            return false;
+
+        }
+
+        std::ifstream iso_file(iso_path, std::ios::binary);
+
+        if (!iso_file) {
+
+            ERR(ErrorCode::IOError, "Cannot open ISO file: " + iso_path);
+            LOG_ERROR("Cannot open ISO file: " + iso_path);
+            iso_file.close();
+            return false;
+
+        }
+
+        std::vector<unsigned char> header(header_size);
+        iso_file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+        if (iso_file.gcount() < 512) {
+
+            ERR(ErrorCode::IOError, "Failed to read ISO metadata from file: " + iso_path);
+            LOG_ERROR(" Failed to read ISO metadata: " + iso_path);
+            iso_file.close();
+            return false;
+
+        }
+
+        if (imageSignature(header.data(), static_cast<size_t>(iso_file.gcount())).empty()) {
+
+            ERR(ErrorCode::InvalidInput, "Invalid ISO signature in file: " + iso_path);
+            LOG_ERROR("Invalid ISO signature in file: " + iso_path);
+            iso_file.close();
+            return false;
+
+        }
+
+        iso_file.close();
+        return true;
+    }
+
+    /**
+     * @brief Asks for the optional burn modes
+     * @returns the BlockCopy options to burn with, std::nullopt if the input was invalid
+     */
+    static std::optional<BlockCopy::Options> askBurnOptions() {
+        BlockCopy::Options opts;
+
+        std::cout << "Only write the blocks that differ from what is on the device? Faster when re-flashing an older build of the same image, and less flash wear (y/n)\n";
+
+        const auto compare = InputValidation::getChar({'y', 'n'});
+        if (!compare.has_value()) return std::nullopt;
+
+        opts.compare_before_write = (*compare == 'y');
+        opts.validate_header = validateImageHeader;
+        opts.decompress = true;
+        return opts;
+    }
+
+    /**
+     * @brief Asks for the image to burn and checks it
+     * @returns the image path, std::nullopt if it was rejected
+     */
+    static std::optional<std::string> askImagePath(const std::string &where) {
+        std::cout << "Enter the path to the ISO/IMG file you want to burn on " << where << ":\n";
+
+        std::string iso_path;
+        std::getline(std::cin >> std::ws, iso_path);
+
+        if (size_t pos = iso_path.find_first_of("-'&|<>;\""); pos != std::string::npos) {
+
+            ERR(ErrorCode::InvalidInput, "Invalid characters in ISO path: " + iso_path);
+            LOG_ERROR("Invalid characters in ISO path\n");
+            return std::nullopt;
+
+        }
+
+        if (!IsoFileMetadataChecker(iso_path)) {
+
+            ERR(ErrorCode::InvalidInput, "Invalid ISO file: " + iso_path);
+            LOG_ERROR("Invalid ISO file: " + iso_path);
+            return std::nullopt;
+
+        }
+
+        return iso_path;
+    }
+
+    /**
+     * @brief The burn flow shared by the single and multi device menus: confirmation, unmount, write, verify.
+     * One device goes through the journal so it can be resumed, several are written by one fan-out copy
+     */
+    static void burnImage(const std::string &iso_path, const std::vector<std::string> &devices) {
+        if (devices.size() == 1) {
+            std::cout << "Are you sure you want to burn " << iso_path << " to " << devices[0] << "? (y/n)\n";
+        } else {
+            std::cout << "Are you sure you want to burn " << iso_path << " to:\n";
+            for (const auto &dev : devices) std::cout << "  " << BOLD << dev << RESET << "\n";
+            std::cout << "All data on these devices will be lost! (y/n)\n";
+        }
+
+        const auto confirmation = InputValidation::getChar({'y', 'n'});
+        if (!confirmation.has_value()) return;
+
+        if (confirmation != 'y') {
+
+            std::cout << YELLOW << "[INFO] Operation cancelled\n" << RESET;
+            LOG_INFO("Burn operation cancelled by user");
+            return;
+
+        }
+
+        const std::string confirmation_key = confirmationKeyGenerator();
+        std::cout << "\nEnter the confirmation key to proceed:\n";
+        std::cout << confirmation_key << "\n";
+
+        std::string user_key_input;
+        std::getline(std::cin, user_key_input);
+
+        if (user_key_input != confirmation_key) {
+
+            ERR(ErrorCode::InvalidInput, "Incorrect confirmation key.");
+            LOG_ERROR("Incorrect confirmation key ");
+            return;
+
+        }
+
+        const auto burn_opts = askBurnOptions();
+        if (!burn_opts.has_value()) return;
+
+        std::cout << "\n" << YELLOW << "[PROCESS]" << RESET << " Burning ISO to " << (devices.size() == 1 ? "device" : std::to_string(devices.size()) + " device(s)") << "...\n";
+
+        std::cout << CYAN << "[Phase 1]:\n" << RESET;
+        for (const auto &dev : devices) {
+            const auto unmount_res = EXEC_SUDO("umount " + dev + "* 2>/dev/null || true");
+
+            if (!unmount_res.success) {
+
+                ERR(ErrorCode::ProcessFailure, "Failed to unmount drive: " + dev);
+                LOG_ERROR("Failed to unmount drive before burn: " + dev);
+                return;
+
+            }
+        }
+
+        std::cout << CYAN << "\n[Phase 2]:\n" << RESET;
+        std::vector<std::string> qos_paths = devices;
+        qos_paths.push_back(iso_path);
+        IoQos::Scope qos(IoQos::Operation::Burn, qos_paths);
+
+        // per target: what was written, how the verification went
+        std::vector<BlockCopy::TargetResult> targets;
+        std::vector<BlockCopy::ChunkDigest> digests;
+
+        if (devices.size() == 1) {
+            const auto res = journaledCopy(OperationJournal::Operation::Burn, iso_path, devices[0], *burn_opts);
+
+            BlockCopy::TargetResult t;
+            t.target = devices[0];
+            t.success = res.success;
+            t.error = res.error;
+            t.bytes_written = res.bytes_copied;
+            t.bytes_unchanged = res.bytes_unchanged;
+            targets.push_back(t);
+            digests = res.digests;
+        } else {
+            auto res = journaledCopyMulti(OperationJournal::Operation::Burn, iso_path, devices, *burn_opts);
 
-        if (fs::file_size(iso_path) < iso_magic_offset + 5) {
+            if (!res.error.empty()) {
 
-            ERR(ErrorCode::InvalidInput, "ISO file too small to contain valid metadata: " + iso_path);
-            LOG_ERROR("ISO file too small to contain valid metadata: " + iso_path);
-            return false;
+                ERR(ErrorCode::IOError, "Failed to read " + iso_path + ": " + res.error);
+                LOG_ERROR("Multi burn failed reading: " + iso_path);
+                return;
+
+            }
 
+            targets = std::move(res.targets);
+            digests = std::move(res.digests);
         }
 
-        std::ifstream iso_file(iso_path, std::ios::binary);
+        std::vector<std::string> written;
+        for (const auto &t : targets) if (t.success) written.push_back(t.target);
 
-        if (!iso_file) {
+        if (written.empty()) {
 
-            ERR(ErrorCode::IOError, "Cannot open ISO file: " + iso_path);
-            LOG_ERROR("Cannot open ISO file: " + iso_path);
-            iso_file.close();
-            return false;
+            for (const auto &t : targets) {
+                ERR(ErrorCode::ProcessFailure, "Failed to burn ISO to " + t.target + ": " + t.error);
+                LOG_ERROR("burn failed for drive: " + t.target);
+            }
+            return;
 
         }
 
-        iso_file.seekg(iso_magic_offset);
+        std::cout << CYAN << "\n[Phase 3]: Verifying\n" << RESET;
+        const auto verify_results = BlockCopy::verifyMulti(written, digests, iso_path, *burn_opts);
 
-        char buffer[6] = {};
-         
-        if (!iso_file.read(buffer, 5)) {
+        size_t ok_count = 0;
+        size_t verify_idx = 0;
 
-            ERR(ErrorCode::IOError, "Failed to read ISO metadata from file: " + iso_path);
-            LOG_ERROR(" Failed to read ISO metadata: " + iso_path);
-            iso_file.close();
-            return false;
+        for (const auto &t : targets) {
+            std::cout << BOLD << t.target << RESET << (t.detached ? " (read source on its own after falling behind)" : "") << ": ";
 
-        }
+            if (!t.success) {
 
-        // ISO9660 magic signature
-        if (std::strncmp(buffer, "CD001", 5) != 0) {
+                std::cout << RED << "[FAILED] " << RESET << t.error << "\n";
+                LOG_ERROR("burn failed for drive: " + t.target + " " + t.error);
+                continue;
 
-            ERR(ErrorCode::InvalidInput, "Invalid ISO signature in file: " + iso_path);
-            LOG_ERROR("Invalid ISO signature in file: " + iso_path);
-            iso_file.close();
-            return false;
+            }
+
+            if (burn_opts->compare_before_write) {
+                std::cout << BlockIOUtils::humanBytes(t.bytes_unchanged) << " of " << BlockIOUtils::humanBytes(t.bytes_written) << " already matched and were not rewritten, ";
+            }
 
+            const auto &v = verify_results[verify_idx++];
+            BlockCopy::printVerifyReport(v);
+
+            if (v.success) {
+                ++ok_count;
+                LOG_SUCCESS("Successfully burned ISO to drive: " + t.target);
+            } else {
+                LOG_ERROR("Verification after burn failed for drive: " + t.target);
+            }
         }
 
-        iso_file.close();
-        return true;
+        if (ok_count == targets.size()) {
+            std::cout << GREEN << "[SUCCESS] Successfully burned " << iso_path << " to " << (ok_count == 1 ? targets[0].target : "all " + std::to_string(ok_count) + " device(s)") << "\n" << RESET;
+        } else if (targets.size() == 1) {
+            ERR(ErrorCode::CorruptedData, "Written data on " + targets[0].target + " doesnt match " + iso_path);
+        } else {
+            std::cout << YELLOW << "[WARNING] " << RESET << ok_count << " of " << targets.size() << " device(s) were burned and verified\n";
+        }
     }
 
     static void BurnISOToStorageDevice() {
@@ -1401,87 +2190,81 @@ private:
         try {
             const std::string drive_name = ListDrivesUtil::listDrives(true);
 
-            std::cout << "Enter the path to the ISO/IMG file you want to burn on " << drive_name << ":\n";
-
-            std::string iso_path;
-            std::getline(std::cin >> std::ws, iso_path);
-
-            if (size_t pos = iso_path.find_first_of("-'&|<>;\""); pos != std::string::npos) {
-
-                ERR(ErrorCode::InvalidInput, "Invalid characters in ISO path: " + iso_path);
-                LOG_ERROR("Invalid characters in ISO path\n");
-                return;
-
-            }
-
-            if (!IsoFileMetadataChecker(iso_path)) {
+            const auto iso_path = askImagePath(drive_name);
+            if (!iso_path.has_value()) return;
 
-                ERR(ErrorCode::InvalidInput, "Invalid ISO file: " + iso_path);
-                LOG_ERROR("Invalid ISO file: " + iso_path);
-                return;
+            burnImage(*iso_path, {drive_name});
 
-            }
+        } catch (const std::exception& e) {
 
-            std::cout << "Are you sure you want to burn " << iso_path << " to " << drive_name << "? (y/n)\n";
+            ERR(ErrorCode::ProcessFailure, "Burn operation failed: " + std::string(e.what()));
+            LOG_ERROR("BurnISOToStorageDevice() exception: " + std::string(e.what()));
+            return;
 
-            const auto confirmation = InputValidation::getChar({'y', 'n'});
-            if (!confirmation.has_value()) return;
+        }
+    }
 
-            if (confirmation != 'y') {
+    /**
+     * @brief Splits a user entered device list ("/dev/sdb /dev/sdc,/dev/sdd") into validated, unique device paths
+     * @returns the devices, or std::nullopt if one of them is invalid
+     */
+    static std::optional<std::vector<std::string>> parseDeviceList(const std::string &input) {
+        std::vector<std::string> devices;
+        std::string token;
+        std::istringstream iss(input);
 
-                std::cout << YELLOW << "[INFO] Operation cancelled\n" << RESET;
-                LOG_INFO("Burn operation cancelled by user");
-                return;
+        while (iss >> token) {
+            std::istringstream tss(token);
+            std::string dev;
 
-            }
+            while (std::getline(tss, dev, ',')) {
+                if (dev.empty()) continue;
 
-            const std::string confirmation_key = confirmationKeyGenerator();
-            std::cout << "\nEnter the confirmation key to proceed:\n";
-            std::cout << confirmation_key << "\n";
-                        
-            std::string user_key_input;
-            std::getline(std::cin, user_key_input);
+                if (dev.rfind("/dev/", 0) != 0 || dev.find_first_of("'&|<>;\"") != std::string::npos || !fileExists(dev)) {
 
-            if (user_key_input != confirmation_key) {
+                    ERR(ErrorCode::InvalidDevice, "Invalid device in list: " + dev);
+                    LOG_ERROR("Invalid device in list: " + dev);
+                    return std::nullopt;
 
-                ERR(ErrorCode::InvalidInput, "Incorrect confirmation key.");
-                LOG_ERROR("Incorrect confirmation key ");
-                return;
+                }
 
+                if (std::find(devices.begin(), devices.end(), dev) == devices.end()) devices.push_back(dev);
             }
+        }
 
-            std::cout << "\n" << YELLOW << "[PROCESS]" << RESET << " Burning ISO to device...\n";
-
-            std::cout << CYAN << "[Phase 1]:\n";
-            const auto unmount_res = EXEC_SUDO("umount " + drive_name + "* 2>/dev/null || true");
-            
-            if (!unmount_res.success) {
+        if (devices.empty()) {
 
-                ERR(ErrorCode::ProcessFailure, "Failed to unmount drive: " + drive_name);
-                LOG_ERROR("dd burn failed for drive: " + drive_name);
-                return;  
+            ERR(ErrorCode::InvalidInput, "No devices entered");
+            return std::nullopt;
 
-            }
+        }
 
-            std::cout << CYAN << "\n[Phase 2]:\n";
-            const auto res = EXEC_SUDO("dd if=" + iso_path + " of=" + drive_name + " bs=4M status=progress && sync"); 
+        return devices;
+    }
 
-            if (!res.success) {
+    /**
+     * @brief Writes one image to several devices at once, the image is read only once (fan-out)
+     */
+    static void BurnISOToMultipleDevices() {
+        try {
+            std::cout << "\nAvailable drives:\n";
+            ListDrivesUtil::listDrives(false);
 
-                ERR(ErrorCode::ProcessFailure, "Failed to burn ISO: " + res.output);
-                LOG_ERROR("dd burn failed for drive: " + drive_name);
-                return;
+            std::cout << "\nEnter all target devices separated by spaces or commas (e.g. /dev/sdb /dev/sdc):\n";
+            const std::string device_input = readLine();
 
-            }
+            const auto devices = parseDeviceList(device_input);
+            if (!devices.has_value()) return;
 
-            std::cout << GREEN << "[SUCCESS] Successfully burned " << iso_path << " to " << drive_name << "\n" << RESET;
+            const auto iso_path = askImagePath(std::to_string(devices->size()) + " device(s)");
+            if (!iso_path.has_value()) return;
 
-            LOG_SUCCESS("Successfully burned ISO to drive: " + drive_name);
+            burnImage(*iso_path, *devices);
 
         } catch (const std::exception& e) {
 
-            ERR(ErrorCode::ProcessFailure, "Burn operation failed: " + std::string(e.what()));
-            LOG_ERROR("BurnISOToStorageDevice() exception: " + std::string(e.what()));
+            ERR(ErrorCode::ProcessFailure, "Multi burn operation failed: " + std::string(e.what()));
+            LOG_ERROR("BurnISOToMultipleDevices() exception: " + std::string(e.what()));
             return;
 
         }
@@ -1685,12 +2468,13 @@ private:
 
     // ========== Menu that took that i made in 1:51 am in the morning ===========
     enum MenuOptions {
-        Burniso = 1, MountDrive = 2, UnmountDrive = 3, RESTOREUSB = 4, Exit = 0
+        Burniso = 1, MountDrive = 2, UnmountDrive = 3, RESTOREUSB = 4, BurnisoMulti = 5, Exit = 0
     };
 
     static std::vector<std::pair<int, std::string>> getMenuItems() {
         return {
             {Burniso, "Burn iso/img to storage device"},
+            {BurnisoMulti, "Burn iso/img to multiple devices"},
             {MountDrive, "Mount storage device"},
             {UnmountDrive, "Unmount storage device"},
             {RESTOREUSB, "Restore usb from iso"},
@@ -1699,6 +2483,16 @@ private:
     }
 
 public:
+    /**
+     * @brief BlockCopy header check, runs on the first decompressed chunk of compressed images
+     */
+    static bool validateImageHeader(const unsigned char* data, size_t length, std::string &why) {
+        if (!imageSignature(data, length).empty()) return true;
+
+        why = "Image has no ISO9660, GPT or MBR signature, nothing was written";
+        return false;
+    }
+
     static void mainMountUtil() {
         const int menu_input = GenericMenuIO::noColorTuiMenu("Mount/Unmount", getMenuItems()); 
         
@@ -1708,6 +2502,11 @@ public:
                 break;  
             }
 
+            case BurnisoMulti: {
+                BurnISOToMultipleDevices();
+                break;
+            }
+
             case MountDrive: {
                 choose_mount_unmount("mount");
                 break;
@@ -1759,15 +2558,8 @@ private:
                 return;
             }
 
-            auto res = EXEC_SUDO("dd if=" + driveName + " of=" + imagePath + " bs=4M status=progress && sync");
-            if (!res.success) {
-                ERR(ErrorCode::ProcessFailure, "Failed to create disk image");
-                LOG_ERROR("Failed to create disk image for drive: " + driveName);
-                return;
-            }
-
-            std::cout << GREEN << "[Success] Disk image created at " << imagePath << "\n" << RESET;
-            LOG_SUCCESS("Disk image created successfully for drive: " + driveName);
+            // the map next to the image makes an interrupted run resumable
+            journaledDiskImage(driveName, imagePath, imagePath + ".map");
        
         } catch (const std::exception& e) {
             ERR(ErrorCode::ProcessFailure, "Failed to create Disk image: " + std::string(e.what()));
@@ -1951,6 +2743,13 @@ private:
                 return;
             }
 
+            disk.seekg(0, std::ios::end);
+            const std::streamoff disk_size = disk.tellg();
+            disk.seekg(0, std::ios::beg);
+
+            ProgressMeter meter("Scanning for ." + sig.extension, disk_size > 0 ? static_cast<uint64_t>(disk_size) : 0);
+            meter.start();
+
             std::vector<uint8_t> prev_tail;
             size_t offset = 0;
             const size_t header_len = sig.header.size();
@@ -1969,7 +2768,7 @@ private:
                 for (size_t i = 0; i + header_len <= window.size(); ++i) {
                     if (std::memcmp(window.data() + i, sig.header.data(), header_len) == 0) {
                         size_t found_offset = offset + i - prev_tail.size();
-                        std::cout << "[FOUND] ." << sig.extension << " signature at offset: " << found_offset << "\n";
+                        meter.print("[FOUND] ." + sig.extension + " signature at offset: " + std::to_string(found_offset));
                     }
                 }
 
@@ -1981,8 +2780,10 @@ private:
                 }
 
                 offset += static_cast<size_t>(n);
+                meter.add(static_cast<uint64_t>(n));
             }
 
+            meter.finish();
             disk.close();
         };
 
@@ -2191,96 +2992,390 @@ class Clone {
             } else if (confirmation == 'y') {
                 try {
 
-                    const auto res = EXEC_SUDO("dd if=" + source + " of=" + target + " bs=5M status=progress && sync");
+                    IoQos::Scope qos(IoQos::Operation::Clone, {source, target});
+                    const auto res = journaledCopy(OperationJournal::Operation::Clone, source, target, {});
 
                     if (!res.success) {
 
                         LOG_ERROR("Failed to clone drive from " + source + " to " + target);
-                        ERR(ErrorCode::ProcessFailure, "Failed to clone data from " + source + " to " + target);
+                        ERR(ErrorCode::ProcessFailure, "Failed to clone data from " + source + " to " + target + ": " + res.error);
+
+                        // the rescue mode only helps with a source that has unreadable sectors, not with a failing target
+                        if (!res.read_error) return;
+
+                        std::cout << "[CloneDrive] Retry in rescue mode? Unreadable sectors are skipped and the run can be resumed (y/n): ";
+                        const auto rescue_confirm = InputValidation::getChar({'y', 'n'});
+
+                        if (rescue_confirm.has_value() && *rescue_confirm == 'y') rescueClone(source, target);
+                        return;
+
+                    }
+
+                    std::cout << "[Info] Verifying clone...\n";
+                    const auto verify_res = BlockCopy::verify(target, res.digests, source);
+                    BlockCopy::printVerifyReport(verify_res);
+
+                    if (!verify_res.success) {
+
+                        LOG_ERROR("Verification of clone failed from " + source + " to " + target);
+                        ERR(ErrorCode::CorruptedData, "Cloned data on " + target + " doesnt match " + source);
                         return;
 
-                    }
+                    }
+
+                    std::cout << GREEN << "[Success] Drive cloned from " << source << " to " << target << "\n" << RESET;
+                    LOG_SUCCESS("Drive cloned successfully from " + source + " to " + target);
+                
+                } catch (const std::exception& e) {
+
+                    ERR(ErrorCode::ProcessFailure, "Failed to clone drive: " + std::string(e.what()));
+                    LOG_ERROR(std::string("Failed to clone drive from ") + source + " to " + target + e.what());
+                    return;
+
+                }
+            }
+
+        }
+
+        /**
+         * @brief Clones with the RescueImager, used when the source has unreadable sectors
+         */
+        static void rescueClone(const std::string &source, const std::string &target) {
+            const std::string map_path = RescueImager::defaultMapPath(source, target);
+            if (fileExists(map_path)) std::cout << "[Info] Resuming from rescue map " << map_path << "\n";
+
+            IoQos::Scope qos(IoQos::Operation::Clone, {source, target});
+            const auto res = RescueImager::rescue(source, target, map_path);
+            RescueImager::printReport(res);
+
+            if (!res.completed) {
+
+                LOG_ERROR("Rescue clone from " + source + " to " + target + " stopped: " + res.error);
+                ERR(ErrorCode::ProcessFailure, "Rescue clone stopped: " + res.error);
+                return;
+
+            }
+
+            if (res.success) {
+                std::cout << GREEN << "[Success] Drive cloned from " << source << " to " << target << "\n" << RESET;
+                LOG_SUCCESS("Drive cloned in rescue mode from " + source + " to " + target);
+            } else {
+                std::cout << YELLOW << "[Warning] Drive cloned with " << res.bad_areas.size() << " unreadable area(s) left as they were on " << target << "\n" << RESET;
+                LOG_WARNING("Drive cloned from " + source + " to " + target + " with " + std::to_string(res.bytes_bad) + " unreadable bytes");
+            }
+        }
+
+        /**
+         * @brief Clones source to several targets at once, the source is read only once
+         */
+        static void CloneDriveMulti(const std::string &source, const std::vector<std::string> &targets) {
+            std::cout << "\n[CloneDrive] Do you want to clone data from " << source << " to:\n";
+            for (const auto &t : targets) std::cout << "  " << BOLD << t << RESET << "\n";
+            std::cout << "This will overwrite all data on the target drives (y/n): ";
+
+            const auto confirmation = InputValidation::getChar({'y', 'n'});
+            if (!confirmation.has_value()) return;
+
+            if (confirmation != 'y') {
+
+                std::cout << "[Info] Operation cancelled\n";
+                LOG_INFO("Operation cancelled");
+                return;
+
+            }
+
+            try {
+                std::vector<std::string> qos_paths = targets;
+                qos_paths.push_back(source);
+                IoQos::Scope qos(IoQos::Operation::Clone, qos_paths);
+
+                const auto res = journaledCopyMulti(OperationJournal::Operation::Clone, source, targets, {});
+
+                if (!res.error.empty()) {
+
+                    LOG_ERROR("Failed to read clone source " + source);
+                    ERR(ErrorCode::ProcessFailure, "Failed to clone data from " + source + ": " + res.error);
+                    return;
+
+                }
+
+                std::vector<std::string> written;
+                for (const auto &t : res.targets) if (t.success) written.push_back(t.target);
+
+                std::cout << "[Info] Verifying clones...\n";
+                const auto verify_results = BlockCopy::verifyMulti(written, res.digests, source);
+
+                size_t verify_idx = 0;
+                for (const auto &t : res.targets) {
+                    std::cout << BOLD << t.target << RESET << ": ";
+
+                    if (!t.success) {
+
+                        std::cout << RED << "[FAILED] " << RESET << t.error << "\n";
+                        LOG_ERROR("Failed to clone drive from " + source + " to " + t.target + ": " + t.error);
+                        continue;
+
+                    }
+
+                    const auto &v = verify_results[verify_idx++];
+                    BlockCopy::printVerifyReport(v);
+
+                    if (v.success) {
+                        LOG_SUCCESS("Drive cloned successfully from " + source + " to " + t.target);
+                    } else {
+                        LOG_ERROR("Verification of clone failed from " + source + " to " + t.target);
+                    }
+                }
+
+            } catch (const std::exception& e) {
+
+                ERR(ErrorCode::ProcessFailure, "Failed to clone drive: " + std::string(e.what()));
+                LOG_ERROR(std::string("Failed to clone drive from ") + source + ": " + e.what());
+                return;
+
+            }
+        }
+
+        static std::optional<std::string> validateTargetDriveName(const std::string& target_drive) {
+            static const std::array<std::string, 3> valid_paths_contains {
+                "/mnt/", "/dev/", "/media/"
+            };
+
+            if (target_drive.empty()) {
+
+                ERR(ErrorCode::DataUnavailable, "Target drive cannot be empty string");
+                LOG_ERROR("Target drive cannot be empty string");
+                return std::nullopt;
+
+            }
+
+            for (const auto& path : valid_paths_contains) {
+
+                if (target_drive.find(path) != std::string::npos) {
+
+                    return target_drive;
+
+                }
+
+            }
+
+            ERR(ErrorCode::InvalidInput, "Target drive string doesn't contain a valid drive path prefix");
+            return std::nullopt;
+        }
+
+        
+    public:
+        static void mainClone() {
+            try {
+                std::cout << "\nChoose a Source drive to clone the data from it:\n";
+                const std::string source_drive = ListDrivesUtil::listDrives(true);
+
+                std::cout << "\nEnter a Target drive/device to clone the data on to it (dont choose the same drive):\n";
+                std::cout << "Several targets can be entered separated by spaces or commas, the source is then read only once\n";
+                std::cout << YELLOW << "[WARNING]" << RESET << " Make sure to choose the mount path of the target" << BOLD << " (e.g., /media/target_drive)\n" << RESET;
+                
+                auto target_drive = InputValidation::getString();
+                if (!target_drive.has_value()) return;
+
+                std::vector<std::string> targets;
+                std::string token;
+                std::istringstream iss(*target_drive);
+
+                while (iss >> token) {
+                    std::istringstream tss(token);
+                    std::string target;
+
+                    while (std::getline(tss, target, ',')) {
+                        if (target.empty()) continue;
+
+                        const auto validated = validateTargetDriveName(target);
+                        if (!validated) { return; }
+
+                        if (source_drive == *validated) {
+
+                            LOG_ERROR("Source and target drives are the same");
+                            dmgr_runtime_error("[ERROR] Source and target drives cannot be the same!");
+                            return;
+
+                        }
+
+                        if (std::find(targets.begin(), targets.end(), *validated) == targets.end()) targets.push_back(*validated);
+                    }
+                }
+
+                if (targets.empty()) {
+
+                    ERR(ErrorCode::DataUnavailable, "Target drive cannot be empty string");
+                    LOG_ERROR("Target drive cannot be empty string");
+                    return;
+
+                }
+
+                if (targets.size() == 1) {
+                    CloneDrive(source_drive, targets.front());
+                } else {
+                    CloneDriveMulti(source_drive, targets);
+                }
+                return;
+
+            } catch (std::exception& e) {
+
+                ERR(ErrorCode::ProcessFailure, "An error occurred during the clone initializing process: " + std::string(e.what()));
+                LOG_ERROR(std::string(e.what()));
+                return; 
+
+            }
+        }
+};
+
+
+// ========== Resume Utility ==========
+
+/**
+ * @brief Lists the journals of interrupted operations and continues the chosen one once its devices are verified unchanged
+ */
+void resumeOperation() {
+    const auto journals = OperationJournal::pending();
+
+    if (journals.empty()) {
+
+        std::cout << "[Info] No interrupted operations to resume\n";
+        return;
+
+    }
+
+    std::vector<std::pair<std::string, OperationJournal::State>> resumable;
+    std::cout << BOLD << "\n[Interrupted operations]" << RESET << "\n";
+
+    for (const auto &path : journals) {
+        std::string err;
+        const auto state = OperationJournal::load(path, err);
+
+        if (!state.has_value()) {
+
+            std::cout << "  " << RED << "[Unreadable] " << RESET << err << "\n";
+            LOG_WARNING(err);
+            continue;
+
+        }
+
+        // the checkpoints and the seed belong to the pass layout of that scheme, no other one may continue them
+        if (state->op == OperationJournal::Operation::Wipe && !WipeEngine::parseScheme(state->scheme).has_value()) {
+
+            const std::string damaged = path + " is damaged: unknown wipe scheme \"" + state->scheme + "\"";
+            std::cout << "  " << RED << "[Damaged] " << RESET << damaged << "\n";
+            LOG_WARNING(damaged);
+            continue;
+
+        }
+
+        std::string progress;
+
+        if (state->op == OperationJournal::Operation::Image) {
+            progress = "ranges in " + state->map_path;
+        } else {
+            progress = BlockIOUtils::humanBytes(state->committed) + (state->total > 0 ? " of " + BlockIOUtils::humanBytes(state->total) : "") + " done";
+            if (state->op == OperationJournal::Operation::Wipe) progress = "pass " + std::to_string(state->pass + 1) + ", " + progress;
+        }
 
-                    std::cout << GREEN << "[Success] Drive cloned from " << source << " to " << target << "\n" << RESET;
-                    LOG_SUCCESS("Drive cloned successfully from " + source + " to " + target);
-                
-                } catch (const std::exception& e) {
+        resumable.emplace_back(path, *state);
+        std::cout << "  " << resumable.size() << ") " << BOLD << OperationJournal::operationName(state->op) << RESET << " "
+                  << (state->source.empty() ? "" : state->source + " -> ") << state->target << "  (" << progress << ")\n";
+    }
 
-                    ERR(ErrorCode::ProcessFailure, "Failed to clone drive: " + std::string(e.what()));
-                    LOG_ERROR(std::string("Failed to clone drive from ") + source + " to " + target + e.what());
-                    return;
+    if (resumable.empty()) return;
 
-                }
-            }
+    std::cout << "\nChoose the operation to resume (0 to cancel):\n";
+    const auto choice = InputValidation::getInt(0, static_cast<int>(resumable.size()));
+    if (!choice.has_value() || *choice == 0) return;
 
-        }
+    const auto &[journal_path, state] = resumable[static_cast<size_t>(*choice - 1)];
+    const std::string op_name = OperationJournal::operationName(state.op);
 
-        static std::optional<std::string> validateTargetDriveName(const std::string& target_drive) {
-            static const std::array<std::string, 3> valid_paths_contains {
-                "/mnt/", "/dev/", "/media/"
-            };
+    std::string why;
 
-            if (target_drive.empty()) {
+    if (!OperationJournal::validate(state, why)) {
 
-                ERR(ErrorCode::DataUnavailable, "Target drive cannot be empty string");
-                LOG_ERROR("Target drive cannot be empty string");
-                return std::nullopt;
+        ERR(ErrorCode::InvalidDevice, "Cannot resume the " + op_name + ": " + why);
+        LOG_ERROR("Resume of " + journal_path + " refused: " + why);
 
-            }
+        std::cout << "Discard this journal? The operation then has to start from the beginning (y/n)\n";
+        const auto discard = InputValidation::getChar({'y', 'n'});
+        if (discard.has_value() && *discard == 'y') OperationJournal(journal_path).remove();
+        return;
 
-            for (const auto& path : valid_paths_contains) {
+    }
 
-                if (target_drive.find(path) != std::string::npos) {
+    std::cout << "Continue the " << op_name << " of " << BOLD << state.target << RESET << "? The rest of it will be overwritten (y/n)\n";
 
-                    return target_drive;
+    const auto confirmation = InputValidation::getChar({'y', 'n'});
+    if (!confirmation.has_value()) return;
 
-                }
+    if (confirmation != 'y') {
 
-            }
+        std::cout << "[Info] Operation cancelled\n";
+        LOG_INFO("Resume cancelled by user");
+        return;
 
-            ERR(ErrorCode::InvalidInput, "Target drive string doesn't contain a valid drive path prefix");
-            return std::nullopt;
-        }
+    }
 
-        
-    public:
-        static void mainClone() {
-            try {
-                std::cout << "\nChoose a Source drive to clone the data from it:\n";
-                const std::string source_drive = ListDrivesUtil::listDrives(true);
+    LOG_INFO("Resuming " + op_name + " of " + state.target + " from " + journal_path);
 
-                std::cout << "\nEnter a Target drive/device to clone the data on to it (dont choose the same drive):\n";
-                std::cout << YELLOW << "[WARNING]" << RESET << " Make sure to choose the mount path of the target" << BOLD << " (e.g., /media/target_drive)\n" << RESET;
-                
-                auto target_drive = InputValidation::getString();
-                if (!target_drive.has_value()) return;
+    try {
+        switch (state.op) {
+            case OperationJournal::Operation::Clone:
+            case OperationJournal::Operation::Burn: {
+                IoQos::Scope qos(state.op == OperationJournal::Operation::Clone ? IoQos::Operation::Clone : IoQos::Operation::Burn, {state.source, state.target});
 
-                const auto validated = validateTargetDriveName(*target_drive);
-                if (!validated) { return; }
+                // the run continues with the options it was started with
+                BlockCopy::Options opts;
+                opts.compare_before_write = state.compare_before_write;
+                opts.decompress = state.decompress;
+                if (state.validate_header) opts.validate_header = MountUtility::validateImageHeader;
 
-                const std::string val_target = *validated;
+                const auto res = journaledCopy(state.op, state.source, state.target, opts, &state);
 
-                if (source_drive == val_target) {
+                if (!res.success) {
 
-                    LOG_ERROR("Source and target drives are the same");
-                    dmgr_runtime_error("[ERROR] Source and target drives cannot be the same!");
+                    ERR(ErrorCode::ProcessFailure, "Failed to resume the " + op_name + ": " + res.error);
+                    LOG_ERROR("Resumed " + op_name + " of " + state.target + " failed: " + res.error);
                     return;
 
-                } else {
+                }
+
+                std::cout << "[Info] Verifying " << state.target << "...\n";
+                const auto verify_res = BlockCopy::verify(state.target, res.digests, state.source, opts);
+                BlockCopy::printVerifyReport(verify_res);
 
-                    CloneDrive(source_drive, val_target);
+                if (!verify_res.success) {
+
+                    ERR(ErrorCode::CorruptedData, "Written data on " + state.target + " doesnt match " + state.source);
+                    LOG_ERROR("Verification after resumed " + op_name + " failed for: " + state.target);
                     return;
+
                 }
 
-            } catch (std::exception& e) {
+                std::cout << GREEN << "[Success] Resumed " << op_name << " of " << state.source << " to " << state.target << " completed\n" << RESET;
+                LOG_SUCCESS("Resumed " + op_name + " completed from " + state.source + " to " + state.target);
+                break;
+            }
 
-                ERR(ErrorCode::ProcessFailure, "An error occurred during the clone initializing process: " + std::string(e.what()));
-                LOG_ERROR(std::string(e.what()));
-                return; 
+            case OperationJournal::Operation::Wipe:
+                runOverwrite(state.target, *WipeEngine::parseScheme(state.scheme), &state);
+                break;
 
-            }
+            case OperationJournal::Operation::Image:
+                journaledDiskImage(state.source, state.target, state.map_path, &state);
+                break;
         }
-};
+
+    } catch (const std::exception& e) {
+
+        ERR(ErrorCode::ProcessFailure, "Failed to resume the " + op_name + ": " + std::string(e.what()));
+        LOG_ERROR("resumeOperation() exception: " + std::string(e.what()));
+
+    }
+}
 
 
 // ========== Log Viewer Utility ==========
@@ -2357,6 +3452,11 @@ class ConfigValueHandeling {
             std::string SELECTION_COLOR_MODE = "RESET";
             bool DRY_RUN_MODE = false;
             bool ROOT_MODE = false;
+            std::string IO_QOS = "normal";
+            std::string IO_QOS_CLONE = "";
+            std::string IO_QOS_BURN = "";
+            std::string IO_QOS_WIPE = "";
+            std::string IO_QOS_IMAGE = "";
         };
 
         static CONFIG_VALUES configHandler() {
@@ -2420,7 +3520,12 @@ class ConfigValueHandeling {
                 else if (key == "ROOT_MODE") {
                     std::string v = StrUtils::toLowerString(value);
                     cfg.ROOT_MODE = (v == "true");
-                };
+                }
+                else if (key == "IO_QOS") cfg.IO_QOS = value;
+                else if (key == "IO_QOS_CLONE") cfg.IO_QOS_CLONE = value;
+                else if (key == "IO_QOS_BURN") cfg.IO_QOS_BURN = value;
+                else if (key == "IO_QOS_WIPE") cfg.IO_QOS_WIPE = value;
+                else if (key == "IO_QOS_IMAGE") cfg.IO_QOS_IMAGE = value;
             }
             return cfg;
         }
@@ -2435,6 +3540,7 @@ class ConfigValueHandeling {
             std::cout << "│ Root mode: "        << cfg.ROOT_MODE             << "\n";
             std::cout << "│ Theme Color: "      << cfg.THEME_COLOR_MODE      << "\n";
             std::cout << "│ Selection Color: "  << cfg.SELECTION_COLOR_MODE  << "\n";
+            std::cout << "│ I/O QoS: "          << cfg.IO_QOS                << "\n";
             std::cout << "└─────────────────────────┘\n";   
             std::cout << "\nDo you want to edit the config file? (y/n)\n";
             
@@ -2472,6 +3578,37 @@ class ConfigValueHandeling {
             return;      
         }
 
+        /**
+         * @brief Sets the I/O QoS policy of every operation from --io-qos, IO_QOS_<OPERATION> or IO_QOS (first one set wins)
+         */
+        static void ioQosHandler() {
+            CONFIG_VALUES cfg = configHandler();
+
+            const std::vector<std::pair<IoQos::Operation, std::string>> per_operation = {
+                {IoQos::Operation::Clone, cfg.IO_QOS_CLONE},
+                {IoQos::Operation::Burn, cfg.IO_QOS_BURN},
+                {IoQos::Operation::Wipe, cfg.IO_QOS_WIPE},
+                {IoQos::Operation::Image, cfg.IO_QOS_IMAGE}
+            };
+
+            for (const auto &[op, op_spec] : per_operation) {
+                const std::string spec = !Globals::g_io_qos_spec.empty() ? Globals::g_io_qos_spec : !op_spec.empty() ? op_spec : cfg.IO_QOS;
+
+                std::string err;
+                const auto policy = IoQos::parse(spec, err);
+
+                if (!policy.has_value()) {
+
+                    ERR(ErrorCode::InvalidInput, "Invalid I/O QoS setting '" + spec + "': " + err);
+                    LOG_ERROR("Invalid I/O QoS setting '" + spec + "': " + err);
+                    continue;
+
+                }
+
+                IoQos::setPolicy(op, *policy);
+            }
+        }
+
         static void colorThemeHandler() {
             CONFIG_VALUES cfg = configHandler();
 
@@ -2504,38 +3641,26 @@ class DriveFingerprinting {
 private:
     static DriveMetadataStruct::DriveMetadata getMetadata(const std::string& drive) {
         DriveMetadataStruct::DriveMetadata metadata;
-        const std::string cmd = "lsblk -o NAME,SIZE,MODEL,SERIAL,UUID -P -p " + drive; 
+        const auto dev = BlockDevices::probe(drive);
 
-        const auto res = EXEC_QUIET(cmd);
+        if (!dev.has_value()) { 
 
-        if (!res.success || res.output.empty()) { 
-
-            ERR(ErrorCode::ProcessFailure, "The lsblk failed to deliver data");
-            LOG_ERROR("lsblk failed to deliver data");
+            ERR(ErrorCode::DeviceNotFound, "Could not read the block device " + drive);
+            LOG_ERROR("Could not read the block device " + drive);
             return metadata; 
 
         }
 
-        auto extract = [&](const std::string& key) -> std::string {
-            std::string search = key + "=\"";
-            size_t start = res.output.find(search);
-
-            if (start == std::string::npos) return "N/A";
-            
-            start += search.length();
-            size_t end = res.output.find("\"", start);
-
-            if (end == std::string::npos) return "N/A";
-            
-            std::string val = res.output.substr(start, end - start);
+        // same fields and formats lsblk delivered, fingerprints taken before stay comparable
+        auto value = [](const std::string& val) -> std::string {
             return val.empty() ? "N/A" : val;
         };
 
-        metadata.name       = extract("NAME");
-        metadata.size       = extract("SIZE");
-        metadata.model      = extract("MODEL");
-        metadata.serial     = extract("SERIAL");
-        metadata.uuid       = extract("UUID");
+        metadata.name       = dev->path;
+        metadata.size       = BlockDevices::lsblkSize(dev->size);
+        metadata.model      = value(dev->model);
+        metadata.serial     = value(dev->serial);
+        metadata.uuid       = value(dev->uuid);
 
         return metadata;
     }
@@ -2572,6 +3697,30 @@ private:
 
 
 public:
+    /**
+     * @brief One "fingerprint" record (--json) with the fields the hash is taken over
+     * @returns false if the drive couldnt be read, nothing is written then
+     */
+    static bool writeJson(JsonWriter& out, const std::string& drive) {
+        DriveMetadataStruct::DriveMetadata metadata = getMetadata(drive);
+        if (!metadata.name.has_value()) return false;
+
+        const std::string fingerprint = fingerprinting(*metadata.name + "|" + *metadata.size + "|" + *metadata.model + "|" + *metadata.serial + "|" + *metadata.uuid);
+
+        out.beginObject()
+           .field("record", "fingerprint")
+           .field("device", *metadata.name)
+           .field("fingerprint", fingerprint)
+           .field("size", *metadata.size)
+           .field("model", *metadata.model)
+           .field("serial", *metadata.serial)
+           .field("uuid", *metadata.uuid)
+           .endObject().endRecord();
+
+        DriveMetadataStruct::clearMetadata(metadata);
+        return true;
+    }
+
     static void fingerprinting_main() {
         std::cout << "\n[Drive Fingerprinting]\n";
         const std::string drive_name_fingerprinting = ListDrivesUtil::listDrives(true);
@@ -2600,6 +3749,86 @@ public:
 };
 
 
+// ========== NDJSON output ==========
+
+/**
+ * @brief A read-only operation with --json: one record per line on stdout, errors only on stderr and as
+ * "error" records, so a script can tell which drive failed without parsing messages
+ * @param operation the operation flag, e.g. "--check-health-all"
+ * @param devices the drives to report on, every listed disk if empty (--list-drives ignores them)
+ * @returns 0, or 1 if any drive couldnt be reported on
+ */
+int writeJsonOperation(const std::string &operation, std::vector<std::string> devices) {
+    JsonWriter out(std::cout);
+
+    if (operation == "--list-drives") {
+        if (ListDrivesUtil::writeDrivesJson(out) > 0) return 0;
+
+        ERR(ErrorCode::DeviceNotFound, "No drives found");
+        return 1;
+    }
+
+    const bool health = operation == "--check-drive-health" || operation == "--check-health-all";
+
+    if (health ? !checkRoot() : !checkRootMetadata()) return 1;
+
+    if (devices.empty()) {
+        DiskLister lister;
+        for (const auto &disk : lister.getPhysicalDisksInfo()) devices.push_back(disk.device);
+    }
+
+    int failed = 0;
+
+    auto fail = [&](const std::string &device, const std::string &err) {
+        out.beginObject().field("record", "error").field("device", device).field("error", err).endObject().endRecord();
+        LOG_ERROR(operation + " " + device + ": " + err);
+        failed = 1;
+    };
+
+    if (health) {
+        // the drives are asked in parallel, the records still come in device order
+        for (const auto &report : DriveHealth::readMany(devices)) {
+            if (!report.error.empty()) fail(report.device, report.error);
+            else DriveHealth::writeJson(out, report);
+        }
+
+        return failed;
+    }
+
+    for (const auto &device : devices) {
+        if (operation == "--view-metadata") {
+            std::string err;
+            const auto id = DriveProbe::probe(device, err);
+
+            if (!id) {
+                fail(device, err);
+                continue;
+            }
+
+            const auto dev = BlockDevices::probe(device);
+            DriveProbe::writeJson(out, *id, dev ? &*dev : nullptr);
+
+        } else if (operation == "--analyze-disk-space") {
+            const auto dev = BlockDevices::probe(device);
+
+            if (!dev) {
+                fail(device, "not a block device");
+                continue;
+            }
+
+            // a partition counts as a disk without partitions, only its own filesystem is reported
+            const auto parts = dev->type == "part" ? std::vector<BlockDevice>{} : BlockDevices::partitionsOf(device);
+            for (const auto &usage : SpaceUsage::ofDisk(*dev, parts)) SpaceUsage::writeJson(out, usage);
+
+        } else if (operation == "--fingerprint") {
+            if (!DriveFingerprinting::writeJson(out, device)) fail(device, "Could not read the block device");
+        }
+    }
+
+    return failed;
+}
+
+
 // ========== Main Menu and Utilities ==========
 
 static void Info() {
@@ -2629,6 +3858,26 @@ static void printUsage(const char* progname) {
               << "  --logs, -l          Show log file content\n"
               << "  --select <device>, -sd <device>         Pre select a drive you want to use\n"
               << "  --config-src <path>, -cfg-src <path>    Use a diffrent config source temporalily\n"
+              << "  --io-qos <spec>, -qos <spec>            I/O priority and limits for clone/burn/wipe/image,\n"
+              << "                                          e.g. idle or best-effort:6,wbps=50M,wiops=2000\n"
+              << "  --wipe-batch <scheme> [--per-bus <n>] <device>..., -wb ...\n"
+              << "                                          Wipe several drives at once (random, zero, random-verify\n"
+              << "                                          or random-zero), n wipes per controller or USB hub\n"
+              << "  --verify-wipe <device> [--samples <n>] [--stride <k>] [--seed <hex>], -vw ...\n"
+              << "                                          Check a wipe by reading n random blocks (and every k-th),\n"
+              << "                                          expecting zeros or the random stream of the seed\n"
+              << "  --wipe-free <partition|dir> [--random] [--discard], -wf ...\n"
+              << "                                          Wipe only the free space of a filesystem, mounted or not\n"
+              << "  --iostat [--interval <ms>] [--count <n>] [--partitions] [--hide-idle] [device...], -io ...\n"
+              << "                                          Live IOPS, throughput, latency, queue depth and utilization\n"
+              << "  --du <dir|partition> [--top <n>] [--depth <n>] [--threads <n>] [--full] [--live]\n"
+              << "                                          Largest directories and files of one filesystem, browsable\n"
+              << "                                          on a terminal, else the top n per directory, depth levels deep;\n"
+              << "                                          unchanged directories come from the last walk unless --full,\n"
+              << "                                          --live follows changes while browsing\n"
+              << "  --json, -j <operation> [device...]      NDJSON records instead of text for --list-drives, --view-metadata,\n"
+              << "                                          --check-drive-health, --check-health-all, --analyze-disk-space,\n"
+              << "                                          --fingerprint (every disk if no device is given) and --du\n"
               << "  --operation-name    Goes directly to a specific operation without menu\n"
               << "                      Available operations:\n"
               << "                        --list-drives\n"
@@ -2636,19 +3885,26 @@ static void printUsage(const char* progname) {
               << "                        --encrypt-decrypt\n"
               << "                        --resize-drive\n"
               << "                        --check-drive-health\n"
+              << "                        --check-health-all  SMART health of every drive at once\n"
               << "                        --analyze-disk-space\n"
               << "                        --overwrite-drive-data\n"
               << "                        --view-metadata\n"
               << "                        --info\n"
               << "                        --forensics\n"
-              << "                        --clone-drive\n";
+              << "                        --clone-drive\n"
+              << "                        --resume          Continue an interrupted clone, burn, wipe or image\n";
 }
 
 
 // ==================== Main Function ====================
 
 int main(int argc, char* argv[]) {
-    std::cout << NEWTERMINALSCREEN;
+    // with --json stdout carries the records and nothing else, not even the alternate screen
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--json" || std::string(argv[i]) == "-j") Globals::g_json = true;
+    }
+
+    if (!Globals::g_json) std::cout << NEWTERMINALSCREEN;
 
     const std::map<std::string, std::function<void()>> cli_commands = {
         {"--list-drives", []()          { std::cout << LEAVETERMINALSCREEN; ListDrivesUtil::listDrives(false); }},
@@ -2656,11 +3912,13 @@ int main(int argc, char* argv[]) {
         {"--encrypt-decrypt", []()      { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; USBEnDeCryptionUtils::mainUsbEnDecryption(); }}, 
         {"--resize-drive", []()         { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; resizeDrive(); }},
         {"--check-drive-health", []()   { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; checkDriveHealth(); }},
+        {"--check-health-all", []()     { std::cout << LEAVETERMINALSCREEN; if (!checkRoot()) return; checkAllDrivesHealth(); }},
         {"--analyze-disk-space", []()   { term.enableTerminosInput_diableAltTerminal(); analyzeDiskSpace(); }},
         {"--overwrite-drive-data", []() { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; overwriteDriveData(); }},
         {"--view-metadata", []()        { term.enableTerminosInput_diableAltTerminal(); if (!checkRootMetadata()) return; MetadataReader::mainReader(); }},
         {"--forensics", []()            { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; ForensicAnalysis::mainForensic(); }},
         {"--clone-drive", []()          { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; Clone::mainClone(); }},
+        {"--resume", []()               { term.enableTerminosInput_diableAltTerminal(); if (!checkRoot()) return; resumeOperation(); }},
         {"--fingerprint", []()          { term.enableTerminosInput_diableAltTerminal(); if (!checkRootMetadata()) return;  DriveFingerprinting::fingerprinting_main();  }}
     };
 
@@ -2677,6 +3935,21 @@ int main(int argc, char* argv[]) {
         
         if (a == "--debug" || a == "-d")                           { Globals::g_debug = true; continue; }
 
+        if (a == "--json" || a == "-j")                            { continue; }
+
+        if (Globals::g_json)                                       {
+
+            // operations that are dispatched before the cli_commands table below, none of them has a JSON report
+            const std::vector<std::string> no_json = {
+                "--logs", "-l", "--wipe-batch", "-wb", "--verify-wipe", "-vw", "--iostat", "-io", "--wipe-free", "-wf"
+            };
+
+            if (std::find(no_json.begin(), no_json.end(), a) != no_json.end()) {
+                ERR(ErrorCode::InvalidInput, "--json only works with the read-only operations and --du, not " + a);
+                return 1;
+            }
+        }
+
         if (a == "--logs" || a == "-l")                            { logViewer(); std::cout << LEAVETERMINALSCREEN; return 0; }
 
         if (a == "--dry-run" || a == "-n")                         { Globals::g_dry_run = true; continue; }
@@ -2701,6 +3974,253 @@ int main(int argc, char* argv[]) {
             continue; 
         }
 
+        if (a == "--io-qos" || a == "-qos")                        {
+
+            if (i + 1 >= argc) {
+
+                ERR(ErrorCode::InvalidInput, "--io-qos needs a value, e.g. idle or best-effort:6,wbps=50M");
+                return 1;
+
+            }
+
+            Globals::g_io_qos_spec = argv[++i];
+            continue;
+        }
+
+        if (a == "--wipe-batch" || a == "-wb")                     {
+
+            // --wipe-batch <scheme> [--per-bus <n>] <device>...
+            if (i + 2 >= argc) {
+
+                ERR(ErrorCode::InvalidInput, "--wipe-batch needs a scheme and the drives, e.g. --wipe-batch random-zero /dev/sdb /dev/sdc");
+                return 1;
+
+            }
+
+            const auto scheme = WipeEngine::parseScheme(argv[++i]);
+
+            if (!scheme.has_value()) {
+
+                ERR(ErrorCode::InvalidInput, "Unknown wipe scheme '" + std::string(argv[i]) + "', use random, zero, random-verify or random-zero");
+                return 1;
+
+            }
+
+            unsigned per_bus = 0;
+            std::vector<std::string> drives;
+
+            while (++i < argc) {
+                const std::string arg(argv[i]);
+
+                if (arg != "--per-bus") {
+                    drives.push_back(arg);
+                    continue;
+                }
+
+                try {
+                    per_bus = i + 1 < argc ? static_cast<unsigned>(std::stoul(argv[++i])) : 0;
+                } catch (const std::exception&) {
+                    per_bus = 0;
+                }
+
+                if (per_bus == 0) {
+
+                    ERR(ErrorCode::InvalidInput, "--per-bus needs a number above 0");
+                    return 1;
+
+                }
+            }
+
+            ConfigValueHandeling::ioQosHandler();
+            term.enableTerminosInput_diableAltTerminal();
+            if (!checkRoot()) return 1;
+
+            batchWipe(drives, *scheme, per_bus);
+            return 0;
+        }
+
+        if (a == "--verify-wipe" || a == "-vw")                    {
+
+            // --verify-wipe <device> [--samples <n>] [--stride <k>] [--seed <hex>]
+            if (i + 1 >= argc) {
+
+                ERR(ErrorCode::InvalidInput, "--verify-wipe needs a device, e.g. --verify-wipe /dev/sdb --stride 4096");
+                return 1;
+
+            }
+
+            const std::string drive(argv[++i]);
+            std::string seed_hex;
+            size_t samples = 4096;
+            uint64_t stride = 0;
+
+            while (i + 1 < argc) {
+                const std::string opt(argv[i + 1]);
+                if (opt != "--samples" && opt != "--stride" && opt != "--seed") break;
+
+                if (i + 2 >= argc) {
+
+                    ERR(ErrorCode::InvalidInput, opt + " needs a value");
+                    return 1;
+
+                }
+
+                const std::string value(argv[i + 2]);
+                i += 2;
+
+                if (opt == "--seed") {
+                    seed_hex = value;
+                    continue;
+                }
+
+                try {
+                    (opt == "--samples" ? samples : stride) = std::stoull(value);
+                } catch (const std::exception&) {
+
+                    ERR(ErrorCode::InvalidInput, opt + " needs a number");
+                    return 1;
+
+                }
+            }
+
+            term.enableTerminosInput_diableAltTerminal();
+            if (!checkRoot()) return 1;
+
+            verifyWipe(drive, seed_hex, samples, stride);
+            return 0;
+        }
+
+        if (a == "--iostat" || a == "-io")                         {
+
+            // --iostat [--interval <ms>] [--count <n>] [--partitions] [--hide-idle] [device...]
+            IoDashboard::Options opts;
+
+            while (i + 1 < argc) {
+                const std::string opt(argv[i + 1]);
+
+                if ((opt == "--interval" || opt == "--count") && i + 2 < argc) {
+                    try {
+
+                        const unsigned long value = std::stoul(argv[i + 2]);
+                        (opt == "--interval" ? opts.interval_ms : opts.count) = static_cast<unsigned>(value);
+
+                    } catch (const std::exception&) {
+
+                        ERR(ErrorCode::InvalidInput, opt + " needs a number, got " + std::string(argv[i + 2]));
+                        return 1;
+
+                    }
+
+                    i += 2;
+                    continue;
+                }
+
+                if (opt == "--partitions") opts.partitions = true;
+                else if (opt == "--hide-idle") opts.hide_idle = true;
+                else if (opt.rfind("-", 0) == 0) break;
+                else {
+                    // /dev/sdb, /dev/mapper/... or a kernel name
+                    const auto dev = BlockDevices::probe(opt);
+
+                    if (!dev) {
+                        ERR(ErrorCode::DeviceNotFound, opt + " is not a block device");
+                        return 1;
+                    }
+
+                    opts.devices.push_back(dev->name);
+                }
+
+                ++i;
+            }
+
+            term.enableTerminosInput_diableAltTerminal();
+
+            std::string err;
+            if (!IoDashboard::run(opts, err)) {
+                ERR(ErrorCode::IOError, err);
+                return 1;
+            }
+
+            return 0;
+        }
+
+        if (a == "--du")                                           {
+
+            // --du <dir|partition> [--top <n>] [--depth <n>] [--threads <n>] [--full] [--live]
+            if (i + 1 >= argc) {
+                ERR(ErrorCode::InvalidInput, "--du needs a directory or a mounted partition");
+                return 1;
+            }
+
+            const std::string path(argv[++i]);
+            SpaceWalker::Options opts;
+            unsigned long top = 10, depth = 2;
+            bool full = false, live = false;
+
+            while (i + 1 < argc) {
+                const std::string opt(argv[i + 1]);
+
+                if (opt == "--full" || opt == "--live") {
+                    (opt == "--full" ? full : live) = true;
+                    ++i;
+                    continue;
+                }
+
+                if ((opt != "--top" && opt != "--depth" && opt != "--threads") || i + 2 >= argc) break;
+
+                try {
+
+                    const unsigned long value = std::stoul(argv[i + 2]);
+                    if (opt == "--top") top = value;
+                    else if (opt == "--depth") depth = value;
+                    else opts.threads = static_cast<unsigned>(value);
+
+                } catch (const std::exception&) {
+
+                    ERR(ErrorCode::InvalidInput, opt + " needs a number, got " + std::string(argv[i + 2]));
+                    return 1;
+
+                }
+
+                i += 2;
+            }
+
+            if (!Globals::g_json) term.enableTerminosInput_diableAltTerminal();
+            return analyzeDirectoryUsage(path, opts, top, static_cast<unsigned>(depth), full, live);
+        }
+
+        if (a == "--wipe-free" || a == "-wf")                      {
+
+            // --wipe-free <partition|directory> [--random] [--discard]
+            if (i + 1 >= argc) {
+
+                ERR(ErrorCode::InvalidInput, "--wipe-free needs a partition or mount point, e.g. --wipe-free /dev/sdb1");
+                return 1;
+
+            }
+
+            const std::string target(argv[++i]);
+            auto pattern = WipeEngine::Pattern::Zero;
+            bool discard = false;
+
+            while (i + 1 < argc) {
+                const std::string opt(argv[i + 1]);
+
+                if (opt == "--random") pattern = WipeEngine::Pattern::Random;
+                else if (opt == "--discard") discard = true;
+                else break;
+
+                ++i;
+            }
+
+            ConfigValueHandeling::ioQosHandler();
+            term.enableTerminosInput_diableAltTerminal();
+            if (!checkRoot()) return 1;
+
+            freeSpaceWipe(target, pattern, discard);
+            return 0;
+        }
+
         if (a == "--config-src" || a == "-cfg-src")                {
 
             Globals::g_config_src_flag = true;
@@ -2723,16 +4243,39 @@ int main(int argc, char* argv[]) {
             continue;
         }
 
+        if (Globals::g_json && cli_commands.count(a))             {
+
+            // --json <operation> [device...]
+            const std::vector<std::string> read_only = {
+                "--list-drives", "--view-metadata", "--check-drive-health", "--check-health-all", "--analyze-disk-space", "--fingerprint"
+            };
+
+            if (std::find(read_only.begin(), read_only.end(), a) == read_only.end()) {
+                ERR(ErrorCode::InvalidInput, "--json only works with the read-only operations and --du, not " + a);
+                return 1;
+            }
+
+            std::vector<std::string> devices;
+            while (i + 1 < argc && argv[i + 1][0] != '-') devices.emplace_back(argv[++i]);
+
+            return writeJsonOperation(a, devices);
+        }
+
         else {
             auto cmd = cli_commands.find(argv[i]);
             
             if (cmd != cli_commands.end()) {
+                ConfigValueHandeling::ioQosHandler();
                 cmd->second();
                 return 0;
             }
         }
     }
 
+    if (Globals::g_json) {
+        ERR(ErrorCode::InvalidInput, "--json needs an operation: --list-drives, --view-metadata, --check-drive-health, --check-health-all, --analyze-disk-space, --fingerprint or --du");
+        return 1;
+    }
 
     ConfigValueHandeling::colorThemeHandler();
 
@@ -2743,6 +4286,8 @@ int main(int argc, char* argv[]) {
         Globals::g_dry_run = true;
     }
 
+    ConfigValueHandeling::ioQosHandler();
+
 
     // ===== Menu Renderer =====
 
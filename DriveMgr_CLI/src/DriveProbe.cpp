@@ -0,0 +1,294 @@
+#include "../include/DriveProbe.hpp"
+#include "../include/BlockDevices.hpp"
+#include "../include/utils/DevicePassthrough.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using DevicePassthrough::Status;
+
+namespace {
+    constexpr uint16_t INQUIRY_LEN = 96;
+    constexpr uint16_t VPD_LEN = 255;
+    constexpr uint8_t VPD_UNIT_SERIAL = 0x80;
+    constexpr uint8_t VPD_DEVICE_ID = 0x83;
+
+    uint64_t readSysU64(const std::string &path) {
+        std::ifstream in(path);
+        uint64_t value = 0;
+        in >> value;
+        return in ? value : 0;
+    }
+
+    /**
+     * @brief Fixed width ASCII field as found in INQUIRY and identify data, blank and NUL padding removed
+     */
+    std::string ascii(const unsigned char* p, size_t len) {
+        std::string s;
+        for (size_t i = 0; i < len && p[i] != '\0'; ++i) s += (p[i] >= 0x20 && p[i] < 0x7F) ? static_cast<char>(p[i]) : ' ';
+
+        const auto first = s.find_first_not_of(' ');
+        if (first == std::string::npos) return "";
+        return s.substr(first, s.find_last_not_of(' ') - first + 1);
+    }
+
+    /**
+     * @brief ATA strings hold two characters per word, the first one in the high byte
+     */
+    std::string ataString(const std::array<uint16_t, 256> &words, size_t first, size_t count) {
+        unsigned char raw[80] = {};
+
+        for (size_t i = 0; i < count; ++i) {
+            raw[2 * i] = static_cast<unsigned char>(words[first + i] >> 8);
+            raw[2 * i + 1] = static_cast<unsigned char>(words[first + i]);
+        }
+
+        return ascii(raw, 2 * count);
+    }
+
+    std::string hexBytes(const unsigned char* p, size_t len) {
+        std::string out;
+        char buf[3];
+
+        for (size_t i = 0; i < len; ++i) {
+            snprintf(buf, sizeof(buf), "%02x", p[i]);
+            out += buf;
+        }
+
+        return out;
+    }
+
+    bool allZero(const unsigned char* p, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            if (p[i]) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief NAA designator of the logical unit from the device identification page, like udev's ID_WWN_WITH_EXTENSION
+     */
+    std::string naaOf(const unsigned char* page, size_t len) {
+        const size_t end = std::min<size_t>(len, 4 + ((page[2] << 8) | page[3]));
+
+        for (size_t i = 4; i + 4 <= end; i += 4 + page[i + 3]) {
+            const unsigned char* d = page + i;
+            const size_t dlen = d[3];
+
+            const unsigned code_set = d[0] & 0x0F;
+            const unsigned association = (d[1] >> 4) & 0x03;
+            const unsigned type = d[1] & 0x0F;
+
+            // binary NAA designator of the logical unit (not of a port or target)
+            if (code_set == 1 && association == 0 && type == 3 && i + 4 + dlen <= end) return "0x" + hexBytes(d + 4, dlen);
+        }
+
+        return "";
+    }
+
+    bool identifyNvme(int fd, DriveIdentity &id) {
+        const auto nsid = DevicePassthrough::nvmeNamespaceId(fd);
+        if (!nsid) return false;
+
+        std::array<unsigned char, 4096> ctrl{};
+        std::string err;
+        if (DevicePassthrough::nvmeIdentify(fd, 1, 0, ctrl, err) != Status::Ok) return false;
+
+        id.source = "nvme";
+        id.serial = ascii(ctrl.data() + 4, 20);
+        id.model = ascii(ctrl.data() + 24, 40);
+        id.firmware = ascii(ctrl.data() + 64, 8);
+
+        // same precedence as the kernel's wwid attribute: NGUID, then EUI-64
+        std::array<unsigned char, 4096> ns{};
+        if (DevicePassthrough::nvmeIdentify(fd, 0, *nsid, ns, err) == Status::Ok) {
+            if (!allZero(ns.data() + 104, 16)) id.wwn = "eui." + hexBytes(ns.data() + 104, 16);
+            else if (!allZero(ns.data() + 120, 8)) id.wwn = "eui." + hexBytes(ns.data() + 120, 8);
+        }
+
+        return true;
+    }
+
+    void identifyAta(int fd, DriveIdentity &id) {
+        std::array<uint16_t, 256> words{};
+        std::string err;
+        if (DevicePassthrough::ataIdentify(fd, words, err) != Status::Ok) return;
+
+        // INQUIRY of a libata disk has the model cut to 16 characters and serial/firmware from the SAT layer
+        id.source = "ata";
+        id.serial = ataString(words, 10, 10);
+        id.firmware = ataString(words, 23, 4);
+        id.model = ataString(words, 27, 20);
+
+        // word 87 bit 8: the world wide name in words 108-111 is valid
+        if ((words[87] & 0xC000) == 0x4000 && (words[87] & 0x0100)) {
+            char wwn[24];
+            snprintf(wwn, sizeof(wwn), "0x%04x%04x%04x%04x", words[108], words[109], words[110], words[111]);
+            id.wwn = wwn;
+        }
+    }
+
+    bool identifyScsi(int fd, DriveIdentity &id) {
+        unsigned char inq[INQUIRY_LEN] = {};
+        std::string err;
+        if (DevicePassthrough::scsiInquiry(fd, false, 0, inq, sizeof(inq), err) != Status::Ok) return false;
+
+        id.source = "scsi";
+        id.vendor = ascii(inq + 8, 8);
+        id.model = ascii(inq + 16, 16);
+        id.firmware = ascii(inq + 32, 4);
+
+        unsigned char vpd[VPD_LEN] = {};
+
+        if (DevicePassthrough::scsiInquiry(fd, true, VPD_UNIT_SERIAL, vpd, sizeof(vpd), err) == Status::Ok && vpd[1] == VPD_UNIT_SERIAL) {
+            const size_t len = std::min<size_t>((vpd[2] << 8) | vpd[3], sizeof(vpd) - 4);
+            id.serial = ascii(vpd + 4, len);
+        }
+
+        std::memset(vpd, 0, sizeof(vpd));
+
+        if (DevicePassthrough::scsiInquiry(fd, true, VPD_DEVICE_ID, vpd, sizeof(vpd), err) == Status::Ok && vpd[1] == VPD_DEVICE_ID) {
+            id.wwn = naaOf(vpd, sizeof(vpd));
+        }
+
+        if (id.vendor == "ATA") identifyAta(fd, id);
+
+        return true;
+    }
+}
+
+std::optional<DriveIdentity> DriveProbe::probe(const std::string &device, std::string &err) {
+    auto dev = BlockDevices::probe(device);
+
+    DriveIdentity id;
+    id.device = device;
+    id.disk = dev && !dev->parent.empty() ? "/dev/" + dev->parent : device;
+
+    const int fd = open(device.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0) {
+        err = "Cannot open " + device + ": " + strerror(errno);
+        if (!dev) return std::nullopt;
+
+        // no access to the node (no root, a sandbox): the geometry sysfs reports, the queue belongs to the whole disk
+        const std::string queue = "/sys/class/block/" + (dev->parent.empty() ? dev->name : dev->parent) + "/queue/";
+        id.size = dev->size;
+        id.logical_sector = static_cast<uint32_t>(readSysU64(queue + "logical_block_size"));
+        id.physical_sector = static_cast<uint32_t>(readSysU64(queue + "physical_block_size"));
+    } else {
+        struct stat st{};
+        int logical = 0;
+        unsigned int physical = 0;
+
+        if (fstat(fd, &st) != 0 || !S_ISBLK(st.st_mode)) {
+            err = device + " is not a block device";
+            close(fd);
+            return std::nullopt;
+        }
+
+        if (ioctl(fd, BLKGETSIZE64, &id.size) != 0 || ioctl(fd, BLKSSZGET, &logical) != 0) {
+            err = "Cannot read the geometry of " + device + ": " + strerror(errno);
+            close(fd);
+            return std::nullopt;
+        }
+
+        id.logical_sector = static_cast<uint32_t>(logical);
+        id.physical_sector = ioctl(fd, BLKPBSZGET, &physical) == 0 ? physical : id.logical_sector;
+
+        // the kernel refuses SG_IO on partitions, ask the whole disk
+        const int disk_fd = id.disk == device ? fd : open(id.disk.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+        if (disk_fd >= 0 && !identifyNvme(disk_fd, id)) identifyScsi(disk_fd, id);
+
+        if (disk_fd >= 0 && disk_fd != fd) close(disk_fd);
+        close(fd);
+    }
+
+    // virtio, loop, dm and mmc (or no permission for the commands): what sysfs and udev know
+    if (id.source.empty()) id.source = "sysfs";
+
+    if (dev && !dev->parent.empty()) dev = BlockDevices::probe(dev->parent);
+
+    if (dev) {
+        if (id.vendor.empty()) id.vendor = dev->vendor;
+        if (id.model.empty()) id.model = dev->model;
+        if (id.serial.empty()) id.serial = dev->serial;
+        if (id.wwn.empty()) id.wwn = dev->wwn;
+    }
+
+    return id;
+}
+
+bool DriveProbe::fillMetadata(const std::string &device, DriveMetadataStruct::DriveMetadata &metadata, std::string &err) {
+    const auto id = probe(device, err);
+    if (!id) return false;
+
+    const auto dev = BlockDevices::probe(device);
+
+    auto value = [](const std::string& val) -> std::string {
+        return val.empty() ? "N/A" : val;
+    };
+
+    metadata.name                 = device;
+    metadata.size                 = BlockDevices::lsblkSize(id->size);
+    metadata.size_bytes           = id->size;
+    metadata.logical_sector_size  = id->logical_sector;
+    metadata.physical_sector_size = id->physical_sector;
+    metadata.model                = value(id->model);
+    metadata.serial               = value(id->serial);
+    metadata.vendor               = value(id->vendor);
+    metadata.firmware             = value(id->firmware);
+    metadata.wwn                  = value(id->wwn);
+
+    metadata.type       = dev ? dev->type : "N/A";
+    metadata.mountpoint = value(dev ? dev->mountpoint : "");
+    metadata.fstype     = value(dev ? dev->fstype : "");
+    metadata.uuid       = value(dev ? dev->uuid : "");
+
+    return true;
+}
+
+void DriveProbe::writeJson(JsonWriter &out, const DriveIdentity &id, const BlockDevice* dev) {
+    auto text = [&](const char* name, const std::string &val) {
+        if (val.empty()) out.key(name).null();
+        else out.field(name, val);
+    };
+
+    out.beginObject()
+       .field("record", "metadata")
+       .field("device", id.device)
+       .field("disk", id.disk)
+       .field("bytes", id.size)
+       .field("logical_sector", id.logical_sector)
+       .field("physical_sector", id.physical_sector)
+       .field("source", id.source);
+
+    text("vendor", id.vendor);
+    text("model", id.model);
+    text("serial", id.serial);
+    text("firmware", id.firmware);
+    text("wwn", id.wwn);
+
+    if (dev) {
+        text("type", dev->type);
+        text("transport", dev->transport);
+        out.field("rotational", dev->rotational)
+           .field("removable", dev->removable)
+           .field("read_only", dev->read_only);
+        text("fstype", dev->fstype);
+        text("uuid", dev->uuid);
+        text("label", dev->label);
+        text("mountpoint", dev->mountpoint);
+        out.field("partitions", dev->partitions);
+    }
+
+    out.endObject().endRecord();
+}
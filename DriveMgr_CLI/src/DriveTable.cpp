@@ -0,0 +1,160 @@
+#include "../include/DriveTable.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+namespace {
+    std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+}
+
+const char* DriveTable::columnName(Column column) {
+    switch (column) {
+        case Column::Device: return "device";
+        case Column::Size: return "size";
+        case Column::Type: return "type";
+        case Column::Mount: return "mountpoint";
+        case Column::FsType: return "fstype";
+        default: return "status";
+    }
+}
+
+void DriveTable::clear() {
+    pool.clear();
+
+    for (auto *col : {&devices, &sizes, &types, &mounts, &fstypes, &statuses}) col->clear();
+    byte_sizes.clear();
+}
+
+void DriveTable::reserve(size_t n) {
+    for (auto *col : {&devices, &sizes, &types, &mounts, &fstypes, &statuses}) col->reserve(n);
+    byte_sizes.reserve(n);
+}
+
+size_t DriveTable::lowerBound(const std::string &device) const {
+    const auto it = std::lower_bound(devices.begin(), devices.end(), device, [&](StringPool::Id id, const std::string &name) {
+        return pool.str(id) < name;
+    });
+
+    return static_cast<size_t>(it - devices.begin());
+}
+
+size_t DriveTable::find(const std::string &device) const {
+    const size_t pos = lowerBound(device);
+    return pos < size() && pool.str(devices[pos]) == device ? pos : size();
+}
+
+void DriveTable::assign(size_t pos, const DiskInfo &info) {
+    devices[pos] = pool.intern(info.device);
+    sizes[pos] = pool.intern(info.size);
+    types[pos] = pool.intern(info.type);
+    mounts[pos] = pool.intern(info.mount);
+    fstypes[pos] = pool.intern(info.fstype);
+    statuses[pos] = pool.intern(info.status);
+    byte_sizes[pos] = info.bytes;
+}
+
+void DriveTable::put(const DiskInfo &info) {
+    const size_t pos = lowerBound(info.device);
+
+    if (pos == size() || pool.str(devices[pos]) != info.device) {
+        for (auto *col : {&devices, &sizes, &types, &mounts, &fstypes, &statuses}) col->insert(col->begin() + pos, StringPool::EMPTY);
+        byte_sizes.insert(byte_sizes.begin() + pos, 0);
+    }
+
+    assign(pos, info);
+}
+
+void DriveTable::append(const DiskInfo &info) {
+    for (auto *col : {&devices, &sizes, &types, &mounts, &fstypes, &statuses}) col->push_back(StringPool::EMPTY);
+    byte_sizes.push_back(0);
+
+    assign(size() - 1, info);
+}
+
+void DriveTable::erase(size_t pos) {
+    for (auto *col : {&devices, &sizes, &types, &mounts, &fstypes, &statuses}) col->erase(col->begin() + pos);
+    byte_sizes.erase(byte_sizes.begin() + pos);
+}
+
+bool DriveTable::setMount(size_t pos, const std::string &mount, const std::string &fstype) {
+    const StringPool::Id m = pool.intern(mount);
+    const StringPool::Id f = pool.intern(fstype);
+    const bool changed = mounts[pos] != m || fstypes[pos] != f;
+
+    mounts[pos] = m;
+    fstypes[pos] = f;
+    return changed;
+}
+
+const std::vector<StringPool::Id>& DriveTable::column(Column column) const {
+    switch (column) {
+        case Column::Device: return devices;
+        case Column::Size: return sizes;
+        case Column::Type: return types;
+        case Column::Mount: return mounts;
+        case Column::FsType: return fstypes;
+        default: return statuses;
+    }
+}
+
+const std::string& DriveTable::text(Column col, size_t pos) const {
+    return pool.str(column(col)[pos]);
+}
+
+DiskInfo DriveTable::info(size_t pos) const {
+    return {pool.str(devices[pos]), pool.str(sizes[pos]), pool.str(types[pos]), pool.str(mounts[pos]),
+            pool.str(fstypes[pos]), pool.str(statuses[pos]), byte_sizes[pos]};
+}
+
+Row DriveTable::row(size_t pos) const {
+    return {pool.str(devices[pos]), pool.str(sizes[pos]), pool.str(types[pos]), pool.str(mounts[pos]),
+            pool.str(fstypes[pos]), pool.str(statuses[pos])};
+}
+
+std::vector<uint32_t> DriveTable::view(const std::string &filter, Column key, bool descending) const {
+    std::vector<uint32_t> out;
+    out.reserve(size());
+
+    if (filter.empty()) {
+        out.resize(size());
+        std::iota(out.begin(), out.end(), 0);
+    } else {
+        // every distinct string is matched once, rows only look up their ids
+        const std::string needle = lower(filter);
+        std::vector<char> hit(pool.size());
+
+        for (size_t id = 0; id < pool.size(); ++id) hit[id] = lower(pool.str(static_cast<StringPool::Id>(id))).find(needle) != std::string::npos;
+
+        for (size_t i = 0; i < size(); ++i) {
+            if (hit[devices[i]] || hit[sizes[i]] || hit[types[i]] || hit[mounts[i]] || hit[fstypes[i]] || hit[statuses[i]]) {
+                out.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    if (key == Column::Device) {
+        // the table is in device order already
+        if (descending) std::reverse(out.begin(), out.end());
+        return out;
+    }
+
+    if (key == Column::Size) {
+        std::stable_sort(out.begin(), out.end(), [&](uint32_t a, uint32_t b) {
+            return descending ? byte_sizes[b] < byte_sizes[a] : byte_sizes[a] < byte_sizes[b];
+        });
+        return out;
+    }
+
+    const auto &col = column(key);
+
+    std::stable_sort(out.begin(), out.end(), [&](uint32_t a, uint32_t b) {
+        if (col[a] == col[b]) return false;
+        return descending ? pool.str(col[b]) < pool.str(col[a]) : pool.str(col[a]) < pool.str(col[b]);
+    });
+
+    return out;
+}
@@ -0,0 +1,629 @@
+#include "../include/FreeSpaceWipe.hpp"
+#include "../include/DiskLister.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+using namespace BlockIOUtils;
+
+namespace {
+    constexpr uint16_t EXT_MAGIC = 0xEF53;
+    constexpr uint32_t EXT_INCOMPAT_RECOVER = 0x0004;
+    constexpr uint32_t EXT_INCOMPAT_META_BG = 0x0010;
+    constexpr uint32_t EXT_INCOMPAT_64BIT = 0x0080;
+    constexpr uint32_t EXT_RO_COMPAT_GDT_CSUM = 0x0010;
+    constexpr uint32_t EXT_RO_COMPAT_BIGALLOC = 0x0200;
+    constexpr uint32_t EXT_RO_COMPAT_METADATA_CSUM = 0x0400;
+    constexpr uint16_t EXT_BG_BLOCK_UNINIT = 0x0002;
+
+    uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+    uint32_t le32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    void appendFree(std::vector<FreeSpaceWipe::Range> &ranges, uint64_t offset, uint64_t length) {
+        if (!ranges.empty() && ranges.back().offset + ranges.back().length == offset) {
+            ranges.back().length += length;
+        } else {
+            ranges.push_back({offset, length});
+        }
+    }
+
+    bool readAt(int fd, std::vector<unsigned char> &buf, uint64_t offset) {
+        return preadFull(fd, buf.data(), buf.size(), offset) == static_cast<ssize_t>(buf.size());
+    }
+
+    struct BlockExtent {
+        uint64_t start = 0;
+        uint64_t count = 0;
+    };
+
+    bool isPowerOf(uint64_t n, uint64_t base) {
+        while (n > 1 && n % base == 0) n /= base;
+        return n == 1;
+    }
+
+    /**
+     * @brief Walks the block bitmaps of an ext2/3/4 filesystem, a set bit is a used block
+     * Groups flagged BLOCK_UNINIT have no bitmap on disk, it is rebuilt like the kernel does
+     * (ext4_init_block_bitmap): superblock backup, descriptors and the flex_bg metadata placed in the group.
+     */
+    void readExtMap(int fd, const unsigned char* sb, FreeSpaceWipe::FreeMap &map) {
+        const uint32_t log_block = le32(sb + 0x18);
+        const uint32_t compat = le32(sb + 0x5C);
+        const uint32_t incompat = le32(sb + 0x60);
+        const uint32_t ro_compat = le32(sb + 0x64);
+
+        if (log_block > 6) {
+            map.error = "ext superblock has an invalid block size";
+            return;
+        }
+
+        if (incompat & EXT_INCOMPAT_RECOVER) {
+            map.error = "the ext journal needs recovery, mount the filesystem once or run e2fsck first";
+            return;
+        }
+
+        if (!(le16(sb + 0x3A) & 1)) {
+            map.error = "the filesystem was not cleanly unmounted, run e2fsck first";
+            return;
+        }
+
+        if (incompat & EXT_INCOMPAT_META_BG) {
+            map.error = "ext filesystems with meta_bg are not supported";
+            return;
+        }
+
+        // a bitmap bit is a cluster of several blocks there, read as blocks used clusters would look free
+        if (ro_compat & EXT_RO_COMPAT_BIGALLOC) {
+            map.error = "ext filesystems with bigalloc are not supported";
+            return;
+        }
+
+        const bool is64 = incompat & EXT_INCOMPAT_64BIT;
+        const uint64_t bs = 1024ull << log_block;
+        const uint64_t blocks = le32(sb + 0x04) | (is64 ? static_cast<uint64_t>(le32(sb + 0x150)) << 32 : 0);
+        const uint64_t first = le32(sb + 0x14);
+        const uint64_t per_group = le32(sb + 0x20);
+        const uint64_t inodes_per_group = le32(sb + 0x28);
+        const uint64_t inode_size = le32(sb + 0x4C) >= 1 ? le16(sb + 0x58) : 128;
+        const uint64_t reserved_gdt = le16(sb + 0xCE);
+        const size_t desc_size = is64 ? le16(sb + 0xFE) : 32;
+
+        if (per_group == 0 || per_group > 8 * bs || blocks <= first || desc_size < 32 || (is64 && desc_size < 64) || inode_size == 0) {
+            map.error = "ext superblock is inconsistent";
+            return;
+        }
+
+        // the kernel only trusts BLOCK_UNINIT when the descriptors are checksummed
+        const bool uninit_valid = ro_compat & (EXT_RO_COMPAT_GDT_CSUM | EXT_RO_COMPAT_METADATA_CSUM);
+        const uint64_t groups = (blocks - first + per_group - 1) / per_group;
+        const uint64_t gdt_blocks = (groups * desc_size + bs - 1) / bs;
+        const uint64_t itable_blocks = (inodes_per_group * inode_size + bs - 1) / bs;
+
+        std::vector<unsigned char> gdt(gdt_blocks * bs);
+        std::vector<unsigned char> bitmap(bs);
+
+        if (!readAt(fd, gdt, (first + 1) * bs)) {
+            map.error = std::string("Cannot read the ext group descriptors: ") + strerror(errno);
+            return;
+        }
+
+        auto descField = [&](const unsigned char* d, size_t lo, size_t hi) {
+            return le32(d + lo) | (desc_size >= 64 ? static_cast<uint64_t>(le32(d + hi)) << 32 : 0);
+        };
+
+        // with flex_bg a group's bitmaps and inode table can sit in any other group
+        std::vector<BlockExtent> metadata;
+
+        for (uint64_t g = 0; g < groups; ++g) {
+            const unsigned char* d = gdt.data() + g * desc_size;
+            metadata.push_back({descField(d, 0x00, 0x20), 1});
+            metadata.push_back({descField(d, 0x04, 0x24), 1});
+            metadata.push_back({descField(d, 0x08, 0x28), itable_blocks});
+        }
+
+        std::sort(metadata.begin(), metadata.end(), [](const BlockExtent &a, const BlockExtent &b) { return a.start < b.start; });
+
+        const bool sparse = ro_compat & 0x0001;
+        const bool sparse2 = compat & 0x0200;
+
+        auto hasBackup = [&](uint64_t g) {
+            if (g == 0) return true;
+            if (sparse2) return g == le32(sb + 0x24C) || g == le32(sb + 0x250);
+            if (!sparse) return true;
+            return g == 1 || isPowerOf(g, 3) || isPowerOf(g, 5) || isPowerOf(g, 7);
+        };
+
+        map.type = FreeSpaceWipe::FsType::Ext;
+        map.block_size = bs;
+        map.total_bytes = blocks * bs;
+
+        for (uint64_t g = 0; g < groups; ++g) {
+            const unsigned char* d = gdt.data() + g * desc_size;
+            const uint64_t base = first + g * per_group;
+            const uint64_t in_group = std::min(per_group, blocks - base);
+
+            if (uninit_valid && (le16(d + 0x12) & EXT_BG_BLOCK_UNINIT)) {
+
+                std::fill(bitmap.begin(), bitmap.end(), 0);
+
+                auto markUsed = [&](uint64_t start, uint64_t count) {
+                    const uint64_t from = std::max(start, base);
+                    const uint64_t to = std::min(start + count, base + in_group);
+                    for (uint64_t b = from; b < to; ++b) bitmap[(b - base) >> 3] |= static_cast<unsigned char>(1u << ((b - base) & 7));
+                };
+
+                if (hasBackup(g)) markUsed(base, 1 + gdt_blocks + reserved_gdt);
+
+                auto it = std::lower_bound(metadata.begin(), metadata.end(), base > itable_blocks ? base - itable_blocks : 0,
+                                           [](const BlockExtent &e, uint64_t v) { return e.start < v; });
+                for (; it != metadata.end() && it->start < base + in_group; ++it) markUsed(it->start, it->count);
+
+            } else {
+
+                const uint64_t bitmap_block = descField(d, 0x00, 0x20);
+
+                if (bitmap_block == 0 || bitmap_block >= blocks || !readAt(fd, bitmap, bitmap_block * bs)) {
+                    map.error = "Cannot read the block bitmap of group " + std::to_string(g);
+                    return;
+                }
+
+            }
+
+            for (uint64_t i = 0; i < in_group; ) {
+                const unsigned char byte = bitmap[i >> 3];
+
+                // whole bytes first, most of a bitmap is all used or all free
+                if ((i & 7) == 0 && i + 8 <= in_group && (byte == 0x00 || byte == 0xFF)) {
+                    if (byte == 0x00) appendFree(map.free, (base + i) * bs, 8 * bs);
+                    i += 8;
+                    continue;
+                }
+
+                if (!(byte & (1u << (i & 7)))) appendFree(map.free, (base + i) * bs, bs);
+                ++i;
+            }
+        }
+    }
+
+    /**
+     * @brief Reads the first FAT, a zero entry is a free cluster
+     * @returns false if the boot sector doesnt carry a FAT BPB
+     */
+    bool readFatMap(int fd, const unsigned char* boot, FreeSpaceWipe::FreeMap &map) {
+        if (le16(boot + 510) != 0xAA55) return false;
+        if (std::memcmp(boot + 3, "EXFAT   ", 8) == 0 || std::memcmp(boot + 3, "NTFS    ", 8) == 0) return false;
+
+        const uint64_t bps = le16(boot + 11);
+        const uint64_t spc = boot[13];
+        const uint64_t reserved = le16(boot + 14);
+        const uint64_t fats = boot[16];
+        const uint64_t root_entries = le16(boot + 17);
+        const uint64_t total = le16(boot + 19) ? le16(boot + 19) : le32(boot + 32);
+        const uint64_t fat_size = le16(boot + 22) ? le16(boot + 22) : le32(boot + 36);
+
+        const bool bps_ok = bps == 512 || bps == 1024 || bps == 2048 || bps == 4096;
+        const bool spc_ok = spc != 0 && (spc & (spc - 1)) == 0;
+        if (!bps_ok || !spc_ok || reserved == 0 || fats == 0 || total == 0 || fat_size == 0) return false;
+
+        const uint64_t root_sectors = (root_entries * 32 + bps - 1) / bps;
+        const uint64_t data_start = reserved + fats * fat_size + root_sectors;
+        if (data_start >= total) return false;
+
+        const uint64_t clusters = (total - data_start) / spc;
+        const FreeSpaceWipe::FsType type = clusters < 4085 ? FreeSpaceWipe::FsType::Fat12
+                                         : clusters < 65525 ? FreeSpaceWipe::FsType::Fat16 : FreeSpaceWipe::FsType::Fat32;
+
+        const uint64_t entry_bits = type == FreeSpaceWipe::FsType::Fat12 ? 12 : type == FreeSpaceWipe::FsType::Fat16 ? 16 : 32;
+
+        if ((clusters + 2) * entry_bits > fat_size * bps * 8) {
+            map.error = "the FAT is smaller than the data area";
+            return true;
+        }
+
+        std::vector<unsigned char> fat(fat_size * bps);
+
+        if (!readAt(fd, fat, reserved * bps)) {
+            map.error = std::string("Cannot read the FAT: ") + strerror(errno);
+            return true;
+        }
+
+        fat.push_back(0);   // a FAT12 entry at the very end is read as 16 bits
+
+        map.type = type;
+        map.block_size = spc * bps;
+        map.total_bytes = clusters * spc * bps;
+
+        for (uint64_t n = 2; n < clusters + 2; ++n) {
+            uint32_t entry;
+
+            if (type == FreeSpaceWipe::FsType::Fat12) {
+                const uint16_t v = le16(fat.data() + n + n / 2);
+                entry = (n & 1) ? v >> 4 : v & 0x0FFF;
+            } else if (type == FreeSpaceWipe::FsType::Fat16) {
+                entry = le16(fat.data() + 2 * n);
+            } else {
+                entry = le32(fat.data() + 4 * n) & 0x0FFFFFFF;
+            }
+
+            if (entry == 0) appendFree(map.free, (data_start + (n - 2) * spc) * bps, spc * bps);
+        }
+
+        return true;
+    }
+
+    FreeSpaceWipe::FreeMap readFreeMapFd(int fd, const std::string &device) {
+        FreeSpaceWipe::FreeMap map;
+        std::vector<unsigned char> head(4096);
+
+        if (!readAt(fd, head, 0)) {
+            map.error = "Cannot read the start of " + device;
+            return map;
+        }
+
+        if (le16(head.data() + 1024 + 0x38) == EXT_MAGIC) {
+            readExtMap(fd, head.data() + 1024, map);
+        } else if (!readFatMap(fd, head.data(), map)) {
+            map.error = "No ext2/3/4 or FAT filesystem found on " + device;
+        }
+
+        if (!map.error.empty()) return map;
+
+        for (const auto &r : map.free) map.free_bytes += r.length;
+        return map;
+    }
+
+    /**
+     * @brief Overwrites (or discards) the free ranges of an unmounted filesystem
+     */
+    void wipeUnmounted(const std::string &target, const FreeSpaceWipe::Options &opts, FreeSpaceWipe::Result &res) {
+        // O_EXCL on a block device keeps it from being mounted while the bitmap is used
+        const int fd = open(target.c_str(), O_RDWR | O_EXCL | O_CLOEXEC);
+
+        if (fd < 0) {
+            const int e = errno;
+            res.error = e == EBUSY ? target + " is in use (mounted or opened by another program)" : "Cannot open " + target + ": " + strerror(e);
+            return;
+        }
+
+        const auto map = readFreeMapFd(fd, target);
+        res.type = map.type;
+
+        if (!map.error.empty()) {
+            close(fd);
+            res.error = map.error;
+            return;
+        }
+
+        struct stat st{};
+        fstat(fd, &st);
+
+        ProgressMeter meter(opts.discard ? "Discarding free space" : "Wiping free space", map.free_bytes);
+        meter.start();
+
+        if (opts.discard) {
+
+            for (const auto &r : map.free) {
+                uint64_t range[2] = {r.offset, r.length};
+
+                // images stand in for devices, punching holes is their discard
+                const int rc = S_ISBLK(st.st_mode) ? ioctl(fd, BLKDISCARD, range)
+                                                   : fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(r.offset), static_cast<off_t>(r.length));
+
+                if (rc != 0) {
+                    res.error = std::string("Discard failed: ") + strerror(errno);
+                    break;
+                }
+
+                meter.add(r.length);
+                res.bytes += r.length;
+            }
+
+            res.discarded = true;
+
+        } else {
+
+            // block aligned ranges go through O_DIRECT, the page cache would only hold data nobody reads again
+            const int direct_fd = open(target.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+            const WipeSeed seed = opts.seed.value_or(WipeEngine::newSeed());
+
+            AlignedBuffer buf(opts.chunk_size);
+            if (buf.valid() && opts.pattern == WipeEngine::Pattern::Zero) std::memset(buf.data(), 0, buf.size());
+
+            if (!buf.valid()) res.error = "Failed to allocate the wipe buffer";
+
+            for (size_t i = 0; res.error.empty() && i < map.free.size(); ++i) {
+                const auto &r = map.free[i];
+
+                for (uint64_t pos = r.offset; pos < r.offset + r.length; ) {
+                    const size_t len = static_cast<size_t>(std::min<uint64_t>(opts.chunk_size, r.offset + r.length - pos));
+                    const bool aligned = pos % DIRECT_ALIGN == 0 && len % DIRECT_ALIGN == 0;
+
+                    if (opts.pattern == WipeEngine::Pattern::Random && !WipeEngine::generate(seed, pos, buf.data(), len)) {
+                        res.error = "AES-CTR generation failed";
+                        break;
+                    }
+
+                    if (!pwriteFull(aligned && direct_fd >= 0 ? direct_fd : fd, buf.data(), len, pos)) {
+                        res.error = "Write failed at offset " + std::to_string(pos) + ": " + strerror(errno);
+                        break;
+                    }
+
+                    pos += len;
+                    res.bytes += len;
+                    meter.add(len);
+                }
+            }
+
+            if (direct_fd >= 0) {
+                if (res.error.empty() && fsync(direct_fd) != 0) res.error = std::string("fsync failed: ") + strerror(errno);
+                close(direct_fd);
+            }
+        }
+
+        if (res.error.empty() && fsync(fd) != 0) res.error = std::string("fsync failed: ") + strerror(errno);
+
+        meter.finish();
+        close(fd);
+    }
+
+    /**
+     * @brief Fills the filesystem holding dir with filler files until it is full, then removes them
+     */
+    void wipeMounted(const std::string &dir, const FreeSpaceWipe::Options &opts, FreeSpaceWipe::Result &res) {
+        struct statvfs vfs{};
+
+        if (statvfs(dir.c_str(), &vfs) != 0) {
+            res.error = "Cannot stat the filesystem of " + dir + ": " + strerror(errno);
+            return;
+        }
+
+        if (opts.discard) {
+            const int dfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            fstrim_range range{0, UINT64_MAX, 0};
+
+            if (dfd < 0 || ioctl(dfd, FITRIM, &range) != 0) {
+                res.error = "FITRIM on " + dir + " failed: " + strerror(errno);
+            } else {
+                res.bytes = range.len;  // the kernel reports the bytes it trimmed
+                res.discarded = true;
+            }
+
+            if (dfd >= 0) close(dfd);
+            return;
+        }
+
+        const std::string work = dir + "/.dmgr-freespace-" + std::to_string(getpid());
+
+        if (mkdir(work.c_str(), 0700) != 0) {
+            res.error = "Cannot create " + work + ": " + strerror(errno);
+            return;
+        }
+
+        const uint64_t min_len = std::max<uint64_t>(vfs.f_bsize, DIRECT_ALIGN);
+        const WipeSeed seed = opts.seed.value_or(WipeEngine::newSeed());
+        std::vector<std::string> files;
+
+        AlignedBuffer buf(opts.chunk_size);
+        if (buf.valid() && opts.pattern == WipeEngine::Pattern::Zero) std::memset(buf.data(), 0, buf.size());
+        if (!buf.valid()) res.error = "Failed to allocate the wipe buffer";
+
+        ProgressMeter meter("Filling free space", static_cast<uint64_t>(vfs.f_bfree) * vfs.f_frsize);
+        meter.start();
+
+        uint64_t stream = 0;
+        bool full = false;
+
+        while (res.error.empty() && !full) {
+            char name[32];
+            snprintf(name, sizeof(name), "/fill_%05zu", files.size());
+            const std::string path = work + name;
+
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_DIRECT | O_CLOEXEC, 0600);
+            if (fd < 0 && errno == EINVAL) fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+
+            if (fd < 0) {
+                if (errno == ENOSPC || errno == EDQUOT) break;
+                res.error = "Cannot create " + path + ": " + strerror(errno);
+                break;
+            }
+
+            files.push_back(path);
+
+            // preallocating keeps every filler file in a few large extents, a full filesystem shrinks the request
+            for (uint64_t want = opts.fill_file_size; want >= opts.chunk_size; want /= 2) {
+                if (fallocate(fd, 0, 0, static_cast<off_t>(want)) == 0 || errno != ENOSPC) break;
+            }
+
+            uint64_t off = 0;
+            size_t len = opts.chunk_size;
+
+            while (off < opts.fill_file_size) {
+                const size_t n = static_cast<size_t>(std::min<uint64_t>(len, opts.fill_file_size - off));
+
+                if (opts.pattern == WipeEngine::Pattern::Random && !WipeEngine::generate(seed, stream, buf.data(), n)) {
+                    res.error = "AES-CTR generation failed";
+                    break;
+                }
+
+                const ssize_t w = pwrite(fd, buf.data(), n, static_cast<off_t>(off));
+
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+
+                    if (errno == ENOSPC || errno == EDQUOT || errno == EFBIG) {
+                        // squeeze the last blocks out with smaller writes before calling it full
+                        if (len > min_len) {
+                            len /= 2;
+                            continue;
+                        }
+                        full = true;
+                        break;
+                    }
+
+                    res.error = "Write to " + path + " failed: " + strerror(errno);
+                    break;
+                }
+
+                if (w == 0) {
+                    full = true;
+                    break;
+                }
+
+                off += static_cast<uint64_t>(w);
+                stream += roundUp(static_cast<uint64_t>(w), 16);
+                res.bytes += static_cast<uint64_t>(w);
+                meter.set(res.bytes);
+            }
+
+            if (fdatasync(fd) != 0 && res.error.empty()) res.error = "fdatasync of " + path + " failed: " + strerror(errno);
+            close(fd);
+        }
+
+        meter.finish();
+
+        const int dfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dfd >= 0) syncfs(dfd);
+
+        // the filler files go in every case, a full filesystem breaks whatever else is running on it
+        for (const auto &f : files) unlink(f.c_str());
+        rmdir(work.c_str());
+
+        if (dfd >= 0) {
+            syncfs(dfd);
+            close(dfd);
+        }
+
+        res.files = files.size();
+    }
+}
+
+std::string FreeSpaceWipe::fsTypeName(FsType type) {
+    switch (type) {
+        case FsType::Ext: return "ext2/3/4";
+        case FsType::Fat12: return "FAT12";
+        case FsType::Fat16: return "FAT16";
+        case FsType::Fat32: return "FAT32";
+        default: return "unknown";
+    }
+}
+
+std::string FreeSpaceWipe::mountPointOf(const std::string &device) {
+    struct stat st{};
+    if (stat(device.c_str(), &st) != 0 || !S_ISBLK(st.st_mode)) return "";
+
+    // btrfs mounts carry an anonymous device number, their source names the node the symlinks resolve to
+    std::error_code ec;
+    const std::string node = std::filesystem::canonical(device, ec).string();
+
+    const auto mounts = DiskLister::loadMountIndex().of(std::to_string(major(st.st_rdev)) + ":" + std::to_string(minor(st.st_rdev)), ec ? device : node);
+    return mounts.empty() ? "" : mounts.front().mountpoint;
+}
+
+FreeSpaceWipe::FreeMap FreeSpaceWipe::readFreeMap(const std::string &device) {
+    const int fd = open(device.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        FreeMap map;
+        map.error = "Cannot open " + device + ": " + strerror(errno);
+        return map;
+    }
+
+    auto map = readFreeMapFd(fd, device);
+    close(fd);
+    return map;
+}
+
+FreeSpaceWipe::Result FreeSpaceWipe::run(const std::string &target, const Options &opts) {
+    Result res;
+    struct stat st{};
+
+    if (stat(target.c_str(), &st) != 0) {
+        res.error = "Cannot access " + target + ": " + strerror(errno);
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        res.mounted = true;
+        res.mountpoint = target;
+    } else if (S_ISBLK(st.st_mode)) {
+        res.mountpoint = mountPointOf(target);
+        res.mounted = !res.mountpoint.empty();
+    } else if (!S_ISREG(st.st_mode)) {
+        res.error = target + " is neither a block device, a filesystem image nor a directory";
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    const char* action = opts.discard ? "discard" : opts.pattern == WipeEngine::Pattern::Zero ? "zero" : "overwrite with random data";
+
+    if (Globals::g_dry_run) {
+
+        if (res.mounted) {
+            std::cout << YELLOW << "[DRY-RUN] Would fill the free space of " << res.mountpoint << " with filler files and " << action << " it" << RESET << "\n";
+        } else {
+            const auto map = readFreeMap(target);
+            std::cout << YELLOW << "[DRY-RUN] Would " << action << " " << humanBytes(map.free_bytes) << " of free space in " << map.free.size()
+                      << " ranges on " << target << " (" << fsTypeName(map.type) << ")" << RESET << "\n";
+        }
+
+        LOG_DRYRUN(std::string(action) + " the free space of " + target);
+        res.success = true;
+        return res;
+
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+
+    if (res.mounted) {
+        wipeMounted(res.mountpoint, opts, res);
+    } else {
+        wipeUnmounted(target, opts, res);
+    }
+
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    res.success = res.error.empty();
+
+    if (res.success) {
+        LOG_INFO("Free space of " + target + ": " + humanBytes(res.bytes) + " " + (res.discarded ? "discarded" : "overwritten"));
+    } else {
+        LOG_ERROR("Free space wipe of " + target + " failed: " + res.error);
+    }
+
+    return res;
+}
+
+void FreeSpaceWipe::printReport(const Result &res) {
+    if (!res.success) {
+        std::cout << RED << "[FREE SPACE WIPE FAILED] " << RESET << res.error << "\n";
+        if (res.bytes > 0) std::cout << "  " << humanBytes(res.bytes) << " were wiped before the failure\n";
+        return;
+    }
+
+    std::cout << GREEN << "[FREE SPACE WIPED] " << RESET << humanBytes(res.bytes) << " of free space "
+              << (res.discarded ? "discarded" : "overwritten") << " in " << ProgressMeter::formatDuration(res.seconds) << "\n";
+
+    if (res.mounted && res.files > 0) {
+        std::cout << "  " << res.mountpoint << " was filled with " << res.files << " file(s), they are removed again\n";
+    } else if (!res.mounted) {
+        std::cout << "  filesystem: " << fsTypeName(res.type) << ", files in use were not touched\n";
+    }
+
+    if (res.discarded) {
+        std::cout << YELLOW << "[Info]" << RESET << " Discarded blocks are only unmapped, the drive decides when the flash is erased\n";
+    }
+}
@@ -0,0 +1,571 @@
+#include "../include/HardwareErase.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/utils/DevicePassthrough.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <linux/fs.h>
+#include <openssl/sha.h>
+#include <random>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace BlockIOUtils;
+using DevicePassthrough::Status;
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr size_t SAMPLE_BLOCK = DIRECT_ALIGN;
+
+    // NVMe sanitize actions (CDW10 SANACT) and Format NVM secure erase settings
+    constexpr uint32_t NVME_SANACT_BLOCK = 2;
+    constexpr uint32_t NVME_SANACT_CRYPTO = 4;
+    constexpr uint32_t NVME_SES_USER_DATA = 1;
+    constexpr uint32_t NVME_SES_CRYPTO = 2;
+
+    // ATA SANITIZE DEVICE subcommands (FEATURE) and the signatures they expect in LBA
+    constexpr uint16_t ATA_SANITIZE_STATUS = 0x0000;
+    constexpr uint16_t ATA_CRYPTO_SCRAMBLE = 0x0011;
+    constexpr uint16_t ATA_BLOCK_ERASE = 0x0012;
+    constexpr uint32_t ATA_CRYPTO_KEY = 0x43727970;    // "Cryp"
+    constexpr uint32_t ATA_BLOCK_KEY = 0x426B4572;     // "BkEr"
+
+    uint64_t readSysU64(const fs::path &path) {
+        std::ifstream in(path);
+        uint64_t value = 0;
+        in >> value;
+        return in ? value : 0;
+    }
+
+    struct SampledBlock {
+        uint64_t offset = 0;
+        std::array<unsigned char, 32> digest{};
+        bool uniform = false;           ///< every byte the same before the erase
+        bool readable = false;
+    };
+
+    bool isUniform(const unsigned char* buf, size_t len) {
+        return std::all_of(buf, buf + len, [first = buf[0]](unsigned char c) { return c == first; });
+    }
+
+    /**
+     * @brief Reads the first, the last and count random blocks of the target
+     */
+    std::vector<SampledBlock> takeSamples(const std::string &target, uint64_t size, size_t count, std::vector<uint64_t> offsets = {}) {
+        std::vector<SampledBlock> out;
+        const uint64_t blocks = size / SAMPLE_BLOCK;
+        if (blocks == 0) return out;
+
+        if (offsets.empty()) {
+            std::mt19937_64 rng(std::random_device{}());
+            std::uniform_int_distribution<uint64_t> pick(0, blocks - 1);
+
+            offsets.push_back(0);
+            offsets.push_back((blocks - 1) * SAMPLE_BLOCK);
+            for (size_t i = 0; i < count; ++i) offsets.push_back(pick(rng) * SAMPLE_BLOCK);
+
+            std::sort(offsets.begin(), offsets.end());
+            offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+        }
+
+        bool is_direct = false;
+        const int fd = openDirectRead(target, is_direct);
+        AlignedBuffer buf(SAMPLE_BLOCK);
+
+        for (uint64_t off : offsets) {
+            SampledBlock s;
+            s.offset = off;
+
+            if (fd >= 0 && buf.valid() && preadFull(fd, buf.data(), SAMPLE_BLOCK, off) == static_cast<ssize_t>(SAMPLE_BLOCK)) {
+                SHA256(buf.data(), SAMPLE_BLOCK, s.digest.data());
+                s.uniform = isUniform(buf.data(), SAMPLE_BLOCK);
+                s.readable = true;
+            }
+
+            out.push_back(s);
+        }
+
+        if (fd >= 0) close(fd);
+        return out;
+    }
+
+    HardwareErase::SampleReport checkSamples(const std::string &target, uint64_t size, const std::vector<SampledBlock> &before, bool expect_zero) {
+        HardwareErase::SampleReport rep;
+
+        std::vector<uint64_t> offsets;
+        for (const auto &s : before) offsets.push_back(s.offset);
+
+        const auto after = takeSamples(target, size, 0, offsets);
+        static const std::array<unsigned char, 32> zero_digest = [] {
+            std::array<unsigned char, 32> d{};
+            std::vector<unsigned char> zeros(SAMPLE_BLOCK, 0);
+            SHA256(zeros.data(), zeros.size(), d.data());
+            return d;
+        }();
+
+        for (size_t i = 0; i < after.size(); ++i) {
+            const auto &a = after[i];
+            const auto &b = before[i];
+
+            ++rep.checked;
+            rep.offsets.push_back(a.offset);
+            rep.digests.push_back(a.digest);
+
+            if (!a.readable) {
+                ++rep.unreadable;
+            } else if (a.digest == zero_digest) {
+                ++rep.zeroed;
+            } else if (expect_zero) {
+                rep.failed.push_back(a.offset);
+            } else if (b.readable && a.digest == b.digest) {
+                // uniform blocks (typically zeros or 0xFF) look the same before and after any erase
+                if (b.uniform) ++rep.inconclusive;
+                else rep.failed.push_back(a.offset);
+            } else {
+                ++rep.changed;
+            }
+        }
+
+        rep.success = rep.checked > 0 && rep.failed.empty() && rep.unreadable < rep.checked;
+        return rep;
+    }
+
+    bool rangedIoctl(int fd, unsigned long request, uint64_t size, const char* label, HardwareErase::Result &res) {
+        // the kernel splits a range by discard_max_bytes itself, the steps only feed the progress line
+        constexpr uint64_t step = 1ULL << 30;
+        const uint64_t end = size / SECTOR_SIZE * SECTOR_SIZE;
+
+        ProgressMeter meter(label, end);
+        meter.start();
+
+        for (uint64_t pos = 0; pos < end; ) {
+            const uint64_t len = std::min(step, end - pos);
+            uint64_t range[2] = {pos, len};
+
+            if (ioctl(fd, request, range) < 0) {
+                const int e = errno;
+                meter.finish();
+                res.unsupported = pos == 0 && (e == EOPNOTSUPP || e == ENOTTY || e == EINVAL);
+                res.error = std::string(label) + " failed at offset " + std::to_string(pos) + ": " + strerror(e);
+                return false;
+            }
+
+            pos += len;
+            meter.set(pos);
+        }
+
+        meter.finish();
+        return true;
+    }
+
+    bool nvmeSanitize(int fd, uint32_t action, uint64_t size, HardwareErase::Result &res) {
+        DevicePassthrough::NvmeCommand cmd;
+        cmd.opcode = 0x84;
+        cmd.cdw10 = action | (1u << 3);     // AUSE: a failed sanitize can be left without another sanitize
+        cmd.timeout_ms = 60000;
+
+        const Status st = DevicePassthrough::nvmeAdmin(fd, cmd, res.error);
+
+        if (st != Status::Ok) {
+            res.unsupported = st == Status::Unsupported;
+            return false;
+        }
+
+        // the command only starts the sanitize, the sanitize status log (0x81) reports progress
+        ProgressMeter meter("Sanitizing", size);
+        meter.start();
+
+        unsigned idle_polls = 0, failed_polls = 0;
+
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+            unsigned char log[512] = {};
+            std::string err;
+
+            if (DevicePassthrough::nvmeLogPage(fd, 0x81, 0xFFFFFFFF, log, sizeof(log), err) != Status::Ok) {
+                if (++failed_polls < 10) continue;
+                meter.finish();
+                res.error = "Cannot read the sanitize status: " + err;
+                return false;
+            }
+
+            failed_polls = 0;
+            const unsigned progress = log[0] | (log[1] << 8);
+            const unsigned state = (log[2] | (log[3] << 8)) & 0x7;
+
+            if (state == 2) {
+                meter.set(size * progress / 65536);
+                continue;
+            }
+
+            if (state == 1 || state == 4) {
+                meter.set(size);
+                meter.finish();
+                return true;
+            }
+
+            if (state == 3) {
+                meter.finish();
+                res.error = "The drive reports that the sanitize failed, it has to be sanitized again before it can be used";
+                return false;
+            }
+
+            if (++idle_polls > 20) {
+                meter.finish();
+                res.error = "The drive never reported the sanitize as started";
+                return false;
+            }
+        }
+    }
+
+    bool nvmeFormat(int fd, uint32_t ses, HardwareErase::Result &res) {
+        const auto nsid = DevicePassthrough::nvmeNamespaceId(fd);
+
+        if (!nsid) {
+            res.error = "Cannot determine the NVMe namespace id";
+            return false;
+        }
+
+        std::array<unsigned char, 4096> ns{};
+        if (DevicePassthrough::nvmeIdentify(fd, 0, *nsid, ns, res.error) != Status::Ok) return false;
+
+        // keep the current LBA format, metadata and protection settings, only request the secure erase
+        const uint32_t flbas = ns[26];
+        const uint32_t dps = ns[29];
+
+        DevicePassthrough::NvmeCommand cmd;
+        cmd.opcode = 0x80;
+        cmd.nsid = *nsid;
+        cmd.cdw10 = (flbas & 0xF) | ((flbas >> 4) & 1) << 4 | (dps & 0x7) << 5 | ((dps >> 3) & 1) << 8 | ses << 9 | ((flbas >> 5) & 0x3) << 12;
+        cmd.timeout_ms = 4 * 3600 * 1000;   // a user data erase may rewrite the whole flash
+
+        std::cout << "[Info] The drive is formatting itself, this can take a few minutes...\n";
+
+        const Status st = DevicePassthrough::nvmeAdmin(fd, cmd, res.error);
+        res.unsupported = st == Status::Unsupported;
+        return st == Status::Ok;
+    }
+
+    bool ataSanitize(int fd, uint16_t feature, uint32_t key, uint64_t size, HardwareErase::Result &res) {
+        DevicePassthrough::AtaRegisters regs;
+        regs.ext = true;
+        regs.command = 0xB4;
+        regs.features = feature;
+        regs.lba = key;
+
+        const Status st = DevicePassthrough::ataCommand(fd, regs, nullptr, 0, 60000, res.error);
+
+        if (st != Status::Ok) {
+            res.unsupported = st == Status::Unsupported;
+            return false;
+        }
+
+        ProgressMeter meter("Sanitizing", size);
+        meter.start();
+
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+            DevicePassthrough::AtaRegisters status;
+            status.ext = true;
+            status.command = 0xB4;
+            status.features = ATA_SANITIZE_STATUS;
+
+            std::string err;
+
+            if (DevicePassthrough::ataCommand(fd, status, nullptr, 0, 10000, err) != Status::Ok) {
+                meter.finish();
+                res.error = "Sanitize failed: " + err;
+                return false;
+            }
+
+            // COUNT bit 14: in progress, bit 15: completed without error, LBA 15:0: progress in 1/65536
+            if (status.count & 0x4000) {
+                meter.set(size * (status.lba & 0xFFFF) / 65536);
+                continue;
+            }
+
+            meter.finish();
+
+            if (status.count & 0x8000) return true;
+
+            res.error = "The drive reports that the sanitize did not complete";
+            return false;
+        }
+    }
+}
+
+std::string HardwareErase::methodName(Method method) {
+    switch (method) {
+        case Method::NvmeSanitizeCrypto: return "NVMe sanitize (crypto erase)";
+        case Method::NvmeSanitizeBlock: return "NVMe sanitize (block erase)";
+        case Method::NvmeFormatCrypto: return "NVMe format (crypto erase)";
+        case Method::NvmeFormatErase: return "NVMe format (user data erase)";
+        case Method::AtaSanitizeCrypto: return "ATA sanitize (crypto scramble)";
+        case Method::AtaSanitizeBlock: return "ATA sanitize (block erase)";
+        case Method::SecureDiscard: return "secure discard (BLKSECDISCARD)";
+        case Method::ZeroOut: return "device zeroing (BLKZEROOUT)";
+        case Method::Discard: return "discard (BLKDISCARD)";
+    }
+
+    return "unknown";
+}
+
+bool HardwareErase::readsZeros(Method method) {
+    return method == Method::ZeroOut;
+}
+
+bool HardwareErase::destroysMedia(Method method) {
+    return method != Method::ZeroOut && method != Method::Discard;
+}
+
+HardwareErase::Capabilities HardwareErase::probe(const std::string &target) {
+    Capabilities caps;
+
+    struct stat st{};
+    if (stat(target.c_str(), &st) != 0 || !S_ISBLK(st.st_mode)) {
+        caps.notes.push_back(target + " is not a block device");
+        return caps;
+    }
+
+    caps.block_device = true;
+    caps.size = sizeOfPath(target);
+
+    std::error_code ec;
+    const fs::path sys = fs::canonical("/sys/dev/block/" + std::to_string(major(st.st_rdev)) + ":" + std::to_string(minor(st.st_rdev)), ec);
+
+    if (ec) {
+        caps.notes.push_back("No sysfs entry for " + target);
+        return caps;
+    }
+
+    // a partition has no queue of its own, its parent directory is the disk
+    caps.partition = fs::exists(sys / "partition", ec);
+    const fs::path disk = caps.partition ? sys.parent_path() : sys;
+    const fs::path queue = disk / "queue";
+
+    caps.discard_granularity = readSysU64(queue / "discard_granularity");
+    caps.discard_max_bytes = readSysU64(queue / "discard_max_bytes");
+    caps.write_zeroes_max_bytes = readSysU64(queue / "write_zeroes_max_bytes");
+    caps.rotational = readSysU64(queue / "rotational") != 0;
+
+    const std::string disk_name = disk.filename().string();
+    const int fd = open(target.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (disk_name.rfind("nvme", 0) == 0) {
+        caps.transport = "nvme";
+
+        std::array<unsigned char, 4096> ctrl{}, ns_list{};
+        std::string err;
+
+        if (caps.partition) {
+            caps.notes.push_back("NVMe sanitize and format erase the whole namespace, they are not used for a partition");
+        } else if (fd >= 0 && DevicePassthrough::nvmeIdentify(fd, 1, 0, ctrl, err) == Status::Ok && DevicePassthrough::nvmeIdentify(fd, 2, 0, ns_list, err) == Status::Ok) {
+            const unsigned oacs = ctrl[256] | (ctrl[257] << 8);
+            const unsigned sanicap = ctrl[328];
+            const unsigned fna = ctrl[524];
+
+            size_t active = 0;
+            for (size_t i = 0; i + 4 <= ns_list.size(); i += 4) {
+                if (ns_list[i] | ns_list[i + 1] | ns_list[i + 2] | ns_list[i + 3]) ++active;
+            }
+
+            if (sanicap & 0x3) {
+                if (active <= 1) {
+                    if (sanicap & 0x1) caps.methods.push_back(Method::NvmeSanitizeCrypto);
+                    if (sanicap & 0x2) caps.methods.push_back(Method::NvmeSanitizeBlock);
+                } else {
+                    caps.notes.push_back("NVMe sanitize would also erase the other " + std::to_string(active - 1) + " namespace(s) of the controller");
+                }
+            }
+
+            if (oacs & 0x2) {
+                // FNA bit 0: any format, bit 1: a secure erase format applies to every namespace
+                if ((fna & 0x3) && active > 1) {
+                    caps.notes.push_back("NVMe format would also erase the other " + std::to_string(active - 1) + " namespace(s) of the controller");
+                } else {
+                    if (fna & 0x4) caps.methods.push_back(Method::NvmeFormatCrypto);
+                    caps.methods.push_back(Method::NvmeFormatErase);
+                }
+            }
+        } else {
+            caps.notes.push_back("NVMe identify failed: " + (fd < 0 ? std::string(strerror(errno)) : err));
+        }
+
+    } else if (fs::exists(disk / "device" / "vpd_pg89", ec)) {
+        // VPD page 0x89 only exists behind a SCSI/ATA translation layer
+        caps.transport = "ata";
+
+        std::array<uint16_t, 256> id{};
+        std::string err;
+
+        if (caps.partition) {
+            caps.notes.push_back("ATA sanitize erases the whole disk, it is not used for a partition");
+        } else if (fd >= 0 && DevicePassthrough::ataIdentify(fd, id, err) == Status::Ok) {
+            // word 59: bit 12 sanitize feature set, 13 crypto scramble, 15 block erase
+            const uint16_t w59 = id[59];
+
+            if (w59 & 0x1000) {
+                if (w59 & 0x2000) caps.methods.push_back(Method::AtaSanitizeCrypto);
+                if (w59 & 0x8000) caps.methods.push_back(Method::AtaSanitizeBlock);
+            }
+        } else {
+            caps.notes.push_back("ATA identify failed: " + (fd < 0 ? std::string(strerror(errno)) : err));
+        }
+    }
+
+    if (fd >= 0) close(fd);
+
+    // there is no sysfs attribute for secure erase, BLKSECDISCARD is tried and skipped if refused
+    if (caps.discard_max_bytes > 0) caps.methods.push_back(Method::SecureDiscard);
+
+    // without hardware write zeroes BLKZEROOUT writes zero pages, which is the normal overwrite
+    if (caps.write_zeroes_max_bytes > 0) caps.methods.push_back(Method::ZeroOut);
+    else caps.notes.push_back("The device has no write zeroes offload");
+
+    if (caps.discard_max_bytes > 0) caps.methods.push_back(Method::Discard);
+    else caps.notes.push_back("The device does not support discard");
+
+    return caps;
+}
+
+HardwareErase::Result HardwareErase::erase(const std::string &target, Method method, const Capabilities &caps) {
+    Result res;
+    res.method = method;
+
+    if (Globals::g_dry_run) {
+
+        std::cout << YELLOW << "[DRY-RUN] Would erase " << target << " with " << methodName(method) << RESET << "\n";
+        LOG_DRYRUN("erase " + target + " with " + methodName(method));
+        res.success = true;
+        return res;
+
+    }
+
+    // O_EXCL on a block device fails with EBUSY while it (or a partition of it) is mounted
+    const int fd = open(target.c_str(), O_RDWR | O_EXCL | O_CLOEXEC);
+
+    if (fd < 0) {
+        res.error = "Cannot open " + target + " exclusively: " + strerror(errno) + (errno == EBUSY ? " (mounted or in use)" : "");
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    LOG_INFO("Erasing " + target + " with " + methodName(method));
+    const auto started = std::chrono::steady_clock::now();
+
+    switch (method) {
+        case Method::NvmeSanitizeCrypto: res.success = nvmeSanitize(fd, NVME_SANACT_CRYPTO, caps.size, res); break;
+        case Method::NvmeSanitizeBlock: res.success = nvmeSanitize(fd, NVME_SANACT_BLOCK, caps.size, res); break;
+        case Method::NvmeFormatCrypto: res.success = nvmeFormat(fd, NVME_SES_CRYPTO, res); break;
+        case Method::NvmeFormatErase: res.success = nvmeFormat(fd, NVME_SES_USER_DATA, res); break;
+        case Method::AtaSanitizeCrypto: res.success = ataSanitize(fd, ATA_CRYPTO_SCRAMBLE, ATA_CRYPTO_KEY, caps.size, res); break;
+        case Method::AtaSanitizeBlock: res.success = ataSanitize(fd, ATA_BLOCK_ERASE, ATA_BLOCK_KEY, caps.size, res); break;
+        case Method::SecureDiscard: res.success = rangedIoctl(fd, BLKSECDISCARD, caps.size, "Secure discard", res); break;
+        case Method::ZeroOut: res.success = rangedIoctl(fd, BLKZEROOUT, caps.size, "Zeroing (device)", res); break;
+        case Method::Discard: res.success = rangedIoctl(fd, BLKDISCARD, caps.size, "Discarding", res); break;
+    }
+
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    // the device changed under the page cache and the partition table is gone
+    ioctl(fd, BLKFLSBUF, 0);
+    if (res.success && !caps.partition) ioctl(fd, BLKRRPART, 0);
+
+    close(fd);
+
+    if (res.success) LOG_INFO(methodName(method) + " of " + target + " finished in " + std::to_string(res.seconds) + "s");
+    else LOG_ERROR(methodName(method) + " of " + target + " failed: " + res.error);
+
+    return res;
+}
+
+HardwareErase::Result HardwareErase::run(const std::string &target, size_t sample_count) {
+    const Capabilities caps = probe(target);
+
+    if (caps.methods.empty()) {
+        Result res;
+        res.unsupported = true;
+        res.error = target + " supports no hardware erase";
+        return res;
+    }
+
+    const auto before = Globals::g_dry_run ? std::vector<SampledBlock>{} : takeSamples(target, caps.size, sample_count);
+
+    Result res;
+
+    for (Method method : caps.methods) {
+        res = erase(target, method, caps);
+        if (res.success || !res.unsupported) break;
+
+        std::cout << YELLOW << "[Info] " << RESET << target << " refused " << methodName(method) << ", trying the next method\n";
+    }
+
+    if (!res.success || Globals::g_dry_run) return res;
+
+    res.samples = checkSamples(target, caps.size, before, readsZeros(res.method));
+
+    if (!res.samples.success) {
+        res.success = false;
+        res.error = res.samples.failed.empty() ? "The sampled blocks could not be read back"
+                                              : std::to_string(res.samples.failed.size()) + " of " + std::to_string(res.samples.checked) + " sampled blocks still hold their old content";
+        LOG_ERROR(methodName(res.method) + " of " + target + ": " + res.error);
+    }
+
+    return res;
+}
+
+void HardwareErase::printCapabilities(const std::string &target, const Capabilities &caps) {
+    std::cout << BOLD << "Hardware erase methods of " << target << RESET;
+    if (!caps.transport.empty()) std::cout << " (" << caps.transport << (caps.rotational ? ", rotational" : "") << ")";
+    std::cout << ":\n";
+
+    for (size_t i = 0; i < caps.methods.size(); ++i) {
+        if (i == 0) std::cout << "  " << GREEN << "* " << RESET;
+        else std::cout << "    ";
+
+        std::cout << methodName(caps.methods[i]) << "\n";
+    }
+
+    if (caps.methods.empty()) std::cout << "  none\n";
+
+    for (const auto &note : caps.notes) std::cout << "  - " << note << "\n";
+}
+
+void HardwareErase::printReport(const Result &res) {
+    if (!res.success) {
+        ERR(ErrorCode::ProcessFailure, res.error);
+    } else {
+        std::cout << GREEN << "[Success] " << RESET << methodName(res.method) << " finished in " << ProgressMeter::formatDuration(res.seconds) << "\n";
+    }
+
+    const auto &s = res.samples;
+    if (s.checked == 0) return;
+
+    std::cout << "[Info] " << s.checked << " sampled blocks read back: " << s.zeroed << " zeroed, " << s.changed << " changed, "
+              << s.inconclusive << " uniform before and after, " << s.unreadable << " unreadable";
+
+    if (!s.failed.empty()) std::cout << ", " << RED << s.failed.size() << " unchanged" << RESET;
+    std::cout << "\n";
+
+    constexpr size_t max_lines = 10;
+
+    for (size_t i = 0; i < s.failed.size() && i < max_lines; ++i) {
+        std::cout << "  block at offset " << s.failed[i] << " still holds its old content\n";
+    }
+
+    if (!res.success && res.method == Method::Discard) {
+        std::cout << YELLOW << "[Info] " << RESET << "The drive does not clear discarded blocks, use an overwrite scheme instead\n";
+    }
+}
@@ -0,0 +1,171 @@
+#include "../include/InventoryCache.hpp"
+#include "../include/globals.h"
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr int CACHE_VERSION = 1;
+    constexpr size_t FIELDS = 10;
+
+    std::string readSysfs(const fs::path &path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+
+        const size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos) return "";
+        return line.substr(start, line.find_last_not_of(" \t") - start + 1);
+    }
+
+    /**
+     * @brief Fields are tab separated, mount points may hold tabs and newlines themselves
+     */
+    std::string escape(const std::string &s) {
+        std::string out;
+        out.reserve(s.size());
+
+        for (char c : s) {
+            switch (c) {
+                case '\\': out += "\\\\"; break;
+                case '\t': out += "\\t"; break;
+                case '\n': out += "\\n"; break;
+                default: out += c; break;
+            }
+        }
+
+        return out;
+    }
+
+    std::vector<std::string> splitFields(const std::string &line) {
+        std::vector<std::string> fields(1);
+
+        for (size_t i = 0; i < line.size(); ++i) {
+            const char c = line[i];
+
+            if (c == '\t') {
+                fields.emplace_back();
+            } else if (c == '\\' && i + 1 < line.size()) {
+                const char e = line[++i];
+                fields.back() += e == 't' ? '\t' : e == 'n' ? '\n' : e;
+            } else {
+                fields.back() += c;
+            }
+        }
+
+        return fields;
+    }
+}
+
+std::string InventoryCache::defaultPath() {
+    return (Globals::dmgr_root / "data" / "inventory.cache").string();
+}
+
+std::optional<DriveStamp> InventoryCache::stamp(const std::string &dev) {
+    std::error_code ec;
+    const fs::path sys = fs::canonical("/sys/block/" + dev, ec);
+    if (ec) return std::nullopt;
+
+    DriveStamp s;
+    s.syspath = sys.string();
+    s.devt = readSysfs(sys / "dev");
+
+    try {
+        s.bytes = std::stoull(readSysfs(sys / "size")) * 512;
+    } catch (const std::exception&) {
+        s.bytes = 0;
+    }
+
+    // the same sources the operation journal identifies hardware by, without udev or ioctls
+    for (const char* key : {"wwid", "device/wwid", "device/serial", "serial"}) {
+        const std::string v = readSysfs(sys / key);
+
+        if (!v.empty()) {
+            s.identity = std::string(key) + "=" + v;
+            break;
+        }
+    }
+
+    return s;
+}
+
+std::optional<std::vector<InventoryCache::Entry>> InventoryCache::load(const std::string &path, std::string &err) {
+    std::ifstream in(path);
+
+    if (!in) {
+        err = "No inventory cache at " + path;
+        return std::nullopt;
+    }
+
+    std::string line;
+    std::getline(in, line);
+
+    if (line != "version=" + std::to_string(CACHE_VERSION)) {
+        err = "Inventory cache " + path + " was written by an incompatible version";
+        return std::nullopt;
+    }
+
+    std::vector<Entry> entries;
+
+    // device, bytes, size, type, mount, fstype, status, devt, syspath, identity
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        auto f = splitFields(line);
+
+        if (f.size() != FIELDS || f[0].compare(0, 5, "/dev/") != 0) {
+            err = "Inventory cache " + path + " is damaged";
+            return std::nullopt;
+        }
+
+        Entry e;
+
+        try {
+            e.info.bytes = std::stoull(f[1]);
+        } catch (const std::exception&) {
+            err = "Inventory cache " + path + " is damaged";
+            return std::nullopt;
+        }
+
+        e.info.device = std::move(f[0]);
+        e.info.size = std::move(f[2]);
+        e.info.type = std::move(f[3]);
+        e.info.mount = std::move(f[4]);
+        e.info.fstype = std::move(f[5]);
+        e.info.status = std::move(f[6]);
+        e.stamp.devt = std::move(f[7]);
+        e.stamp.syspath = std::move(f[8]);
+        e.stamp.identity = std::move(f[9]);
+        e.stamp.bytes = e.info.bytes;
+
+        entries.push_back(std::move(e));
+    }
+
+    return entries;
+}
+
+std::string InventoryCache::serialize(const std::vector<Entry> &entries) {
+    std::ostringstream out;
+    out << "version=" << CACHE_VERSION << "\n"
+        << "# DriveMgr drive inventory, rebuilt by every scan; safe to delete\n";
+
+    for (const auto &e : entries) {
+        const DiskInfo &i = e.info;
+        out << escape(i.device) << '\t' << i.bytes << '\t' << escape(i.size) << '\t' << escape(i.type) << '\t'
+            << escape(i.mount) << '\t' << escape(i.fstype) << '\t' << escape(i.status) << '\t'
+            << escape(e.stamp.devt) << '\t' << escape(e.stamp.syspath) << '\t' << escape(e.stamp.identity) << '\n';
+    }
+
+    return out.str();
+}
+
+bool InventoryCache::save(const std::string &path, const std::string &data) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    return BlockIOUtils::replaceFile(path, data);
+}
@@ -0,0 +1,218 @@
+#include "../include/IoStats.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr double SECTOR_KIB = 512.0 / 1024.0;
+
+    /** @brief Counter difference; a counter that went backwards was reset (device re-added), count from zero */
+    uint64_t delta(uint64_t prev, uint64_t cur) {
+        return cur >= prev ? cur - prev : 0;
+    }
+
+    bool listed(const std::string &name) {
+        return name.compare(0, 4, "loop") != 0 && name.compare(0, 3, "ram") != 0 && name.compare(0, 4, "zram") != 0;
+    }
+
+    /**
+     * @brief Reads a whole (proc/sysfs) file from offset 0 into buf, which grows as needed
+     */
+    bool preadAll(int fd, std::string &buf) {
+        if (buf.size() < 4096) buf.resize(4096);
+        size_t len = 0;
+
+        while (true) {
+            const ssize_t n = pread(fd, &buf[len], buf.size() - len - 1, static_cast<off_t>(len));
+            if (n < 0) return false;
+            if (n == 0) break;
+
+            len += static_cast<size_t>(n);
+            if (len + 1 >= buf.size()) buf.resize(buf.size() * 2);
+        }
+
+        buf[len] = '\0';
+        return true;
+    }
+}
+
+IoStatSampler::IoStatSampler(const std::vector<std::string> &devices, bool partitions) : partitions(partitions) {
+    std::vector<std::string> names = devices;
+
+    if (names.empty()) {
+        std::error_code ec;
+        for (const auto &entry : fs::directory_iterator("/sys/block", ec)) {
+            const std::string name = entry.path().filename().string();
+            if (listed(name)) names.push_back(name);
+        }
+
+        std::sort(names.begin(), names.end());
+    }
+
+    // /sys/class/block has partitions too, /sys/block only whole disks
+    for (const auto &name : names) {
+        const std::string path = "/sys/class/block/" + name + "/stat";
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0 && open_error.empty()) open_error = "Cannot open " + path + ": " + strerror(errno);
+        disks.push_back({name, fd});
+    }
+
+    if (!partitions) return;
+
+    diskstats_fd = open("/proc/diskstats", O_RDONLY | O_CLOEXEC);
+    if (diskstats_fd < 0 && open_error.empty()) open_error = std::string("Cannot open /proc/diskstats: ") + strerror(errno);
+
+    // looked up once, a sample only matches names
+    for (const auto &src : disks) {
+        std::error_code ec;
+        for (const auto &entry : fs::directory_iterator("/sys/class/block/" + src.name, ec)) {
+            if (fs::exists(entry.path() / "partition")) partition_disk[entry.path().filename().string()] = src.name;
+        }
+    }
+}
+
+IoStatSampler::~IoStatSampler() {
+    for (auto &src : disks) {
+        if (src.fd >= 0) close(src.fd);
+    }
+
+    if (diskstats_fd >= 0) close(diskstats_fd);
+}
+
+std::optional<DiskStat> IoStatSampler::parseStat(const std::string &name, const char* line) {
+    uint64_t f[17] = {};
+    size_t n = 0;
+    char* end = nullptr;
+
+    for (const char* p = line; n < 17; p = end) {
+        f[n] = std::strtoull(p, &end, 10);
+        if (end == p) break;
+        ++n;
+    }
+
+    // the first eleven fields exist since 2.6, discards and flushes came later
+    if (n < 11) return std::nullopt;
+
+    DiskStat s;
+    s.name = name;
+    s.reads = f[0];
+    s.read_merges = f[1];
+    s.read_sectors = f[2];
+    s.read_ms = f[3];
+    s.writes = f[4];
+    s.write_merges = f[5];
+    s.write_sectors = f[6];
+    s.write_ms = f[7];
+    s.in_flight = f[8];
+    s.io_ms = f[9];
+    s.weighted_ms = f[10];
+    s.discards = f[11];
+    s.discard_sectors = f[13];
+    s.flushes = f[15];
+    return s;
+}
+
+std::vector<DiskStat> IoStatSampler::sample() {
+    std::vector<DiskStat> out;
+    out.reserve(disks.size());
+
+    for (const auto &src : disks) {
+        std::optional<DiskStat> s;
+        if (src.fd >= 0 && preadAll(src.fd, buf)) s = parseStat(src.name, buf.c_str());
+
+        out.push_back(s ? std::move(*s) : DiskStat{src.name});
+    }
+
+    if (!partitions || diskstats_fd < 0 || !preadAll(diskstats_fd, buf)) return out;
+
+    // "major minor name counters..."
+    std::unordered_map<std::string, std::vector<DiskStat>> parts;
+
+    for (char* line = &buf[0]; *line; ) {
+        char* next = std::strchr(line, '\n');
+        if (next) *next = '\0';
+
+        unsigned major = 0, minor = 0;
+        char name[64];
+        int consumed = 0;
+
+        if (sscanf(line, "%u %u %63s %n", &major, &minor, name, &consumed) == 3) {
+            const auto disk = partition_disk.find(name);
+
+            if (disk != partition_disk.end()) {
+                if (auto s = parseStat(name, line + consumed)) parts[disk->second].push_back(std::move(*s));
+            }
+        }
+
+        if (!next) break;
+        line = next + 1;
+    }
+
+    std::vector<DiskStat> merged;
+    merged.reserve(out.size());
+
+    for (auto &disk : out) {
+        auto it = parts.find(disk.name);
+        merged.push_back(std::move(disk));
+        if (it != parts.end()) for (auto &p : it->second) merged.push_back(std::move(p));
+    }
+
+    return merged;
+}
+
+std::vector<IoRates> IoStatSampler::rates(const std::vector<DiskStat> &prev, const std::vector<DiskStat> &cur, double seconds) {
+    std::vector<IoRates> out;
+    out.reserve(cur.size());
+
+    std::unordered_map<std::string, const DiskStat*> before;
+    for (const auto &p : prev) before[p.name] = &p;
+
+    for (const auto &c : cur) {
+        IoRates r;
+        r.name = c.name;
+        r.in_flight = c.in_flight;
+
+        const auto it = before.find(c.name);
+
+        if (it == before.end() || seconds <= 0) {
+            out.push_back(r);
+            continue;
+        }
+
+        const DiskStat &p = *it->second;
+
+        const uint64_t reads = delta(p.reads, c.reads);
+        const uint64_t writes = delta(p.writes, c.writes);
+        const uint64_t rsec = delta(p.read_sectors, c.read_sectors);
+        const uint64_t wsec = delta(p.write_sectors, c.write_sectors);
+
+        r.r_s = reads / seconds;
+        r.w_s = writes / seconds;
+        r.d_s = delta(p.discards, c.discards) / seconds;
+        r.f_s = delta(p.flushes, c.flushes) / seconds;
+        r.rkb_s = rsec * SECTOR_KIB / seconds;
+        r.wkb_s = wsec * SECTOR_KIB / seconds;
+        r.dkb_s = delta(p.discard_sectors, c.discard_sectors) * SECTOR_KIB / seconds;
+        r.rrqm_s = delta(p.read_merges, c.read_merges) / seconds;
+        r.wrqm_s = delta(p.write_merges, c.write_merges) / seconds;
+        r.r_await = reads ? static_cast<double>(delta(p.read_ms, c.read_ms)) / reads : 0;
+        r.w_await = writes ? static_cast<double>(delta(p.write_ms, c.write_ms)) / writes : 0;
+        r.rareq_sz = reads ? rsec * SECTOR_KIB / reads : 0;
+        r.wareq_sz = writes ? wsec * SECTOR_KIB / writes : 0;
+        r.aqu_sz = delta(p.weighted_ms, c.weighted_ms) / (seconds * 1000.0);
+        r.util = std::min(100.0, delta(p.io_ms, c.io_ms) / (seconds * 10.0));
+
+        out.push_back(r);
+    }
+
+    return out;
+}
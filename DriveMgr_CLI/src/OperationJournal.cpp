@@ -0,0 +1,392 @@
+#include "../include/OperationJournal.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+using namespace BlockIOUtils;
+
+namespace {
+    constexpr int JOURNAL_VERSION = 1;
+    constexpr size_t SAMPLE_SIZE = 1024 * 1024;
+
+    const char* DIGEST_SUFFIX = ".sha";
+
+    std::filesystem::path journalDir() {
+        return Globals::dmgr_root / "data" / "journal";
+    }
+
+    std::string readSysfs(const std::filesystem::path &path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+
+        // sysfs pads model/vendor with spaces
+        const size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos) return "";
+        return line.substr(start, line.find_last_not_of(" \t") - start + 1);
+    }
+
+    /**
+     * @brief WWN, serial or vendor+model of the disk a block device belongs to, plus the partition position
+     */
+    std::string hardwareId(dev_t rdev) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+
+        const fs::path node = fs::canonical("/sys/dev/block/" + std::to_string(major(rdev)) + ":" + std::to_string(minor(rdev)), ec);
+        if (ec) return "";
+
+        std::string part;
+        fs::path disk = node;
+
+        if (fs::exists(node / "partition", ec)) {
+            part = " part=" + readSysfs(node / "partition") + "@" + readSysfs(node / "start");
+            disk = node.parent_path();
+        }
+
+        for (const char* key : {"wwid", "device/wwid", "device/serial", "serial"}) {
+            const std::string v = readSysfs(disk / key);
+            if (!v.empty()) return std::string(key) + "=" + v + part;
+        }
+
+        const std::string model = readSysfs(disk / "device" / "vendor") + " " + readSysfs(disk / "device" / "model");
+        return "model=" + model + part;
+    }
+
+    /**
+     * @brief Hash of the first, middle and last MiB, cheap evidence that the content didnt change
+     */
+    std::string sampleHash(int fd, uint64_t size) {
+        const uint64_t offsets[] = {0, size / 2 & ~(DIRECT_ALIGN - 1), size > SAMPLE_SIZE ? (size - SAMPLE_SIZE) & ~(DIRECT_ALIGN - 1) : 0};
+        std::vector<unsigned char> buf(SAMPLE_SIZE * 3);
+        size_t used = 0;
+
+        for (uint64_t off : offsets) {
+            const ssize_t n = preadFull(fd, buf.data() + used, SAMPLE_SIZE, off);
+            // an unreadable sample must hash the same way on the next run
+            if (n < 0) { std::memcpy(buf.data() + used, "EIO", 3); used += 3; }
+            else used += static_cast<size_t>(n);
+        }
+
+        unsigned char sha[SHA256_DIGEST_LENGTH];
+        SHA256(buf.data(), used, sha);
+
+        char hex[17];
+        for (int i = 0; i < 8; ++i) snprintf(hex + 2 * i, 3, "%02x", sha[i]);
+        return hex;
+    }
+
+    bool fromHex(const std::string &hex, unsigned char* out, size_t len) {
+        if (hex.size() != len * 2) return false;
+
+        for (size_t i = 0; i < len; ++i) {
+            unsigned v = 0;
+            if (sscanf(hex.c_str() + 2 * i, "%2x", &v) != 1) return false;
+            out[i] = static_cast<unsigned char>(v);
+        }
+
+        return true;
+    }
+
+    std::string digestLine(const BlockCopy::ChunkDigest &d) {
+        return std::to_string(d.offset) + " " + std::to_string(d.length) + " " + toHex(d.sha.data(), d.sha.size()) + "\n";
+    }
+
+    bool writeAll(int fd, const std::string &data) {
+        return pwriteFull(fd, reinterpret_cast<const unsigned char*>(data.data()), data.size(), static_cast<uint64_t>(lseek(fd, 0, SEEK_END)));
+    }
+
+    std::optional<OperationJournal::Operation> parseOperation(const std::string &name) {
+        for (auto op : {OperationJournal::Operation::Clone, OperationJournal::Operation::Burn, OperationJournal::Operation::Wipe, OperationJournal::Operation::Image}) {
+            if (OperationJournal::operationName(op) == name) return op;
+        }
+        return std::nullopt;
+    }
+}
+
+std::string OperationJournal::operationName(Operation op) {
+    switch (op) {
+        case Operation::Clone: return "clone";
+        case Operation::Burn: return "burn";
+        case Operation::Wipe: return "wipe";
+        default: return "image";
+    }
+}
+
+std::string OperationJournal::defaultPath(Operation op, const std::string &source, const std::string &target) {
+    auto flatten = [](std::string s) {
+        std::replace(s.begin(), s.end(), '/', '_');
+        s.erase(0, s.find_first_not_of('_'));
+        return s;
+    };
+
+    const std::string name = operationName(op) + "_" + (source.empty() ? "" : flatten(source) + "_to_") + flatten(target) + ".journal";
+    return (journalDir() / name).string();
+}
+
+std::string OperationJournal::identify(const std::string &path, bool with_content) {
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) return "";
+
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return "";
+
+    const uint64_t size = sizeOfFd(fd);
+    std::string id;
+
+    if (S_ISBLK(st.st_mode)) {
+        id = "blk size=" + std::to_string(size) + " " + hardwareId(st.st_rdev);
+    } else {
+        // a file target grows while it is written, only its inode identifies it
+        id = "file ino=" + std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino);
+        if (with_content) id += " size=" + std::to_string(size) + " mtime=" + std::to_string(st.st_mtime);
+    }
+
+    if (with_content && size > 0) id += " sample=" + sampleHash(fd, size);
+
+    close(fd);
+    return id;
+}
+
+std::vector<std::string> OperationJournal::pending() {
+    std::vector<std::string> out;
+    std::error_code ec;
+
+    for (const auto &entry : std::filesystem::directory_iterator(journalDir(), ec)) {
+        if (entry.path().extension() == ".journal") out.push_back(entry.path().string());
+    }
+
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+std::optional<OperationJournal::State> OperationJournal::load(const std::string &path, std::string &err) {
+    std::ifstream in(path);
+
+    if (!in) {
+        err = "Cannot open journal " + path + ": " + strerror(errno);
+        return std::nullopt;
+    }
+
+    std::map<std::string, std::string> kv;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        const size_t eq = line.find('=');
+        if (eq != std::string::npos) kv[line.substr(0, eq)] = line.substr(eq + 1);
+    }
+
+    State s;
+
+    try {
+        if (std::stoi(kv.at("version")) != JOURNAL_VERSION) {
+            err = "Journal " + path + " was written by an incompatible version";
+            return std::nullopt;
+        }
+
+        const auto op = parseOperation(kv.at("operation"));
+
+        if (!op) {
+            err = "Unknown operation in journal " + path + ": " + kv.at("operation");
+            return std::nullopt;
+        }
+
+        s.op = *op;
+        s.source = kv["source"];
+        s.source_id = kv["source_id"];
+        s.target = kv.at("target");
+        s.target_id = kv.at("target_id");
+        s.block_size = std::stoull(kv.at("block_size"));
+        s.total = std::stoull(kv.at("total"));
+        s.pass = static_cast<unsigned>(std::stoul(kv.at("pass")));
+        s.committed = std::stoull(kv.at("committed"));
+        s.map_path = kv["map"];
+        s.scheme = kv["scheme"];
+        s.seed = kv["seed"];
+        // absent in journals of older runs, which were all started without these options
+        s.compare_before_write = kv["compare_before_write"] == "1";
+        s.decompress = kv["decompress"] == "1";
+        s.validate_header = kv["validate_header"] == "1";
+    } catch (const std::exception&) {
+        err = "Journal " + path + " is incomplete or damaged";
+        return std::nullopt;
+    }
+
+    if (s.op != Operation::Clone && s.op != Operation::Burn) return s;
+
+    // only the digests below committed count, later lines were written before the header caught up
+    std::ifstream sums(path + DIGEST_SUFFIX);
+    uint64_t expected = 0;
+
+    while (expected < s.committed && std::getline(sums, line)) {
+        std::istringstream iss(line);
+        BlockCopy::ChunkDigest d;
+        std::string hex;
+
+        if (!(iss >> d.offset >> d.length >> hex) || d.offset != expected || !fromHex(hex, d.sha.data(), d.sha.size())) break;
+
+        s.digests.push_back(d);
+        expected += d.length;
+    }
+
+    if (expected != s.committed) {
+        err = "The digest record of " + path + " doesnt cover the committed range";
+        return std::nullopt;
+    }
+
+    return s;
+}
+
+bool OperationJournal::validate(const State &state, std::string &why) {
+    if (!state.source.empty()) {
+        const std::string id = identify(state.source, state.op != Operation::Image);
+
+        if (id != state.source_id) {
+            why = "Source " + state.source + " changed since the interrupted run (" + (id.empty() ? "not found" : id) + ")";
+            return false;
+        }
+    }
+
+    const std::string id = identify(state.target, false);
+
+    if (id != state.target_id) {
+        why = "Target " + state.target + " changed since the interrupted run (" + (id.empty() ? "not found" : id) + ")";
+        return false;
+    }
+
+    if (state.digests.empty()) return true;
+
+    // proves the target still holds what we wrote, not just the same hardware
+    const BlockCopy::ChunkDigest &last = state.digests.back();
+    std::vector<unsigned char> buf(last.length);
+    const int fd = open(state.target.c_str(), O_RDONLY | O_CLOEXEC);
+    const ssize_t n = fd < 0 ? -1 : preadFull(fd, buf.data(), buf.size(), last.offset);
+    if (fd >= 0) close(fd);
+
+    unsigned char sha[SHA256_DIGEST_LENGTH];
+    if (n == static_cast<ssize_t>(buf.size())) SHA256(buf.data(), buf.size(), sha);
+
+    if (n != static_cast<ssize_t>(buf.size()) || std::memcmp(sha, last.sha.data(), SHA256_DIGEST_LENGTH) != 0) {
+        why = "The last committed block on " + state.target + " no longer matches what was written";
+        return false;
+    }
+
+    return true;
+}
+
+OperationJournal::OperationJournal(std::string path) : journal_path(std::move(path)) {}
+
+bool OperationJournal::writeHeader() const {
+    std::ostringstream out;
+    out << "# DriveMgr operation journal, continue with --resume\n"
+        << "version=" << JOURNAL_VERSION << "\n"
+        << "operation=" << operationName(header.op) << "\n"
+        << "source=" << header.source << "\n"
+        << "source_id=" << header.source_id << "\n"
+        << "target=" << header.target << "\n"
+        << "target_id=" << header.target_id << "\n"
+        << "block_size=" << header.block_size << "\n"
+        << "total=" << header.total << "\n"
+        << "pass=" << header.pass << "\n"
+        << "committed=" << header.committed << "\n"
+        << "map=" << header.map_path << "\n"
+        << "scheme=" << header.scheme << "\n"
+        << "seed=" << header.seed << "\n"
+        << "compare_before_write=" << header.compare_before_write << "\n"
+        << "decompress=" << header.decompress << "\n"
+        << "validate_header=" << header.validate_header << "\n";
+
+    return replaceFile(journal_path, out.str());
+}
+
+bool OperationJournal::appendDigests(const std::vector<BlockCopy::ChunkDigest> &digests) const {
+    if (digests.empty()) return true;
+
+    std::string data;
+    for (const auto &d : digests) data += digestLine(d);
+
+    const int fd = open((journal_path + DIGEST_SUFFIX).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    const bool ok = writeAll(fd, data) && fdatasync(fd) == 0;
+    close(fd);
+
+    return ok;
+}
+
+bool OperationJournal::begin(const State &state) {
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(journal_path).parent_path(), ec);
+
+    header = state;
+    header.committed = 0;
+    header.digests.clear();
+
+    if (!replaceFile(journal_path + DIGEST_SUFFIX, "") || !writeHeader()) {
+        LOG_WARNING("Cannot write journal " + journal_path + ": " + strerror(errno) + ", the operation wont be resumable");
+        return false;
+    }
+
+    return true;
+}
+
+bool OperationJournal::resume(const State &state) {
+    header = state;
+    header.digests.clear();
+
+    // drops digest lines past the committed range before new ones are appended
+    std::string data;
+    for (const auto &d : state.digests) data += digestLine(d);
+
+    if (!replaceFile(journal_path + DIGEST_SUFFIX, data) || !writeHeader()) {
+        LOG_WARNING("Cannot update journal " + journal_path + ": " + strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool OperationJournal::commit(uint64_t committed, unsigned pass, const std::vector<BlockCopy::ChunkDigest> &new_digests) {
+    // digests first, the header must never claim a range whose digests are missing
+    if (!appendDigests(new_digests)) {
+        LOG_WARNING("Cannot append to journal " + journal_path + DIGEST_SUFFIX + ": " + strerror(errno));
+        return false;
+    }
+
+    header.committed = committed;
+    header.pass = pass;
+
+    if (!writeHeader()) {
+        LOG_WARNING("Cannot update journal " + journal_path + ": " + strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+void OperationJournal::remove() {
+    std::error_code ec;
+    std::string map_path = header.map_path;
+
+    // a journal opened only to discard it knows its map from the file
+    if (map_path.empty()) {
+        std::string err;
+        if (const auto s = load(journal_path, err)) map_path = s->map_path;
+    }
+
+    if (!map_path.empty()) std::filesystem::remove(map_path, ec);
+    std::filesystem::remove(journal_path, ec);
+    std::filesystem::remove(journal_path + DIGEST_SUFFIX, ec);
+}
@@ -0,0 +1,786 @@
+#include "../include/RescueImager.hpp"
+#include "../include/OperationJournal.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+#include "../include/utils/IoQos.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <linux/fs.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace BlockIOUtils;
+using Status = RescueImager::BlockStatus;
+
+namespace {
+    /** @brief how often the map is written to disk while a pass is running */
+    constexpr auto MAP_SAVE_INTERVAL = std::chrono::seconds(5);
+
+    /** @brief how often the progress line is redrawn */
+    constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(250);
+
+    /**
+     * @brief The ddrescue "current_status" characters of the passes
+     */
+    enum class Phase : char {
+        Copying = '?', Trimming = '*', Scraping = '/', Retrying = '-', Finished = '+'
+    };
+
+    const char* phaseName(Phase p) {
+        switch (p) {
+            case Phase::Copying: return "copying";
+            case Phase::Trimming: return "trimming";
+            case Phase::Scraping: return "scraping";
+            case Phase::Retrying: return "retrying";
+            default: return "finished";
+        }
+    }
+
+    bool validStatus(char c) {
+        return c == '?' || c == '*' || c == '/' || c == '-' || c == '+';
+    }
+
+    // comment lines for ddrescue, they tie the map to the devices it was made for
+    constexpr std::string_view SOURCE_TAG = "# source: ";
+    constexpr std::string_view TARGET_TAG = "# target: ";
+
+    /**
+     * @brief Sorted, gap free and merged list of blocks covering [0, size)
+     */
+    class RescueMap {
+    private:
+        uint64_t total = 0;
+        std::map<uint64_t, RescueImager::Block> blocks; // keyed by pos
+
+        /** @brief makes sure a block starts at pos (if pos is inside the map) */
+        void splitAt(uint64_t pos) {
+            auto it = blocks.upper_bound(pos);
+            if (it == blocks.begin()) return;
+            --it;
+
+            auto &b = it->second;
+            if (b.pos == pos || pos >= b.pos + b.size) return;
+
+            RescueImager::Block tail{pos, b.pos + b.size - pos, b.status};
+            b.size = pos - b.pos;
+            blocks.emplace(pos, tail);
+        }
+
+        void mergeAround(uint64_t pos) {
+            auto it = blocks.find(pos);
+            if (it == blocks.end()) return;
+
+            auto next = std::next(it);
+            if (next != blocks.end() && next->second.status == it->second.status) {
+                it->second.size += next->second.size;
+                blocks.erase(next);
+            }
+
+            if (it != blocks.begin()) {
+                auto prev = std::prev(it);
+
+                if (prev->second.status == it->second.status) {
+                    prev->second.size += it->second.size;
+                    blocks.erase(it);
+                }
+            }
+        }
+
+    public:
+        Phase phase = Phase::Copying;
+        uint64_t current_pos = 0;
+        unsigned current_pass = 1;
+        std::string source_id;                  ///< OperationJournal::identify() of source and target
+        std::string target_id;
+
+        explicit RescueMap(uint64_t size) : total(size) {
+            if (size > 0) blocks.emplace(0, RescueImager::Block{0, size, Status::NonTried});
+        }
+
+        uint64_t size() const { return total; }
+
+        void set(uint64_t pos, uint64_t len, Status status) {
+            if (len == 0 || pos >= total) return;
+            len = std::min(len, total - pos);
+
+            splitAt(pos);
+            splitAt(pos + len);
+
+            blocks.erase(blocks.lower_bound(pos), blocks.lower_bound(pos + len));
+            blocks.emplace(pos, RescueImager::Block{pos, len, status});
+
+            if (pos + len < total) mergeAround(pos + len);
+            mergeAround(pos);
+        }
+
+        /**
+         * @brief First block with the given status that ends after pos, clipped to start at pos
+         */
+        bool findNext(uint64_t pos, Status status, RescueImager::Block &out) const {
+            auto it = blocks.upper_bound(pos);
+            if (it != blocks.begin()) --it;
+
+            for (; it != blocks.end(); ++it) {
+                const auto &b = it->second;
+                if (b.status != status || b.pos + b.size <= pos) continue;
+
+                out = b;
+                if (out.pos < pos) {
+                    out.size -= pos - out.pos;
+                    out.pos = pos;
+                }
+                return true;
+            }
+
+            return false;
+        }
+
+        uint64_t bytesWith(Status status) const {
+            uint64_t n = 0;
+            for (const auto &[pos, b] : blocks) if (b.status == status) n += b.size;
+            return n;
+        }
+
+        std::vector<RescueImager::Block> unfinished() const {
+            std::vector<RescueImager::Block> out;
+
+            for (const auto &[pos, b] : blocks) {
+                if (b.status == Status::Finished) continue;
+
+                if (!out.empty() && out.back().pos + out.back().size == b.pos) {
+                    out.back().size += b.size;
+                    out.back().status = Status::BadSector;
+                } else {
+                    out.push_back(b);
+                }
+            }
+
+            return out;
+        }
+
+        /**
+         * @brief Loads a ddrescue mapfile
+         * @returns empty string on success, the reason otherwise
+         */
+        std::string load(const std::string &path) {
+            std::ifstream in(path);
+            if (!in) return "Cannot open map " + path;
+
+            std::map<uint64_t, RescueImager::Block> loaded;
+            bool have_status_line = false;
+            uint64_t expected = 0;
+            std::string line;
+
+            while (std::getline(in, line)) {
+                if (line.rfind(SOURCE_TAG, 0) == 0) source_id = line.substr(SOURCE_TAG.size());
+                if (line.rfind(TARGET_TAG, 0) == 0) target_id = line.substr(TARGET_TAG.size());
+                if (line.empty() || line[0] == '#') continue;
+
+                std::istringstream iss(line);
+                std::string a, b, c;
+                iss >> a >> b >> c;
+
+                try {
+                    if (!have_status_line) {
+                        // current_pos  current_status  [current_pass]
+                        current_pos = std::stoull(a, nullptr, 0);
+                        phase = b.size() == 1 && validStatus(b[0]) ? static_cast<Phase>(b[0]) : Phase::Copying;
+                        current_pass = c.empty() ? 1 : static_cast<unsigned>(std::stoul(c));
+                        have_status_line = true;
+                        continue;
+                    }
+
+                    const uint64_t pos = std::stoull(a, nullptr, 0);
+                    const uint64_t len = std::stoull(b, nullptr, 0);
+
+                    if (c.size() != 1 || !validStatus(c[0]) || pos != expected || len == 0) {
+                        return "Map " + path + " is corrupted near: " + line;
+                    }
+
+                    loaded.emplace(pos, RescueImager::Block{pos, len, static_cast<Status>(c[0])});
+                    expected = pos + len;
+
+                } catch (const std::exception&) {
+                    return "Map " + path + " is corrupted near: " + line;
+                }
+            }
+
+            if (expected != total) {
+                return "Map " + path + " covers " + std::to_string(expected) + " bytes but the source has " + std::to_string(total);
+            }
+
+            blocks = std::move(loaded);
+            return "";
+        }
+
+        /**
+         * @brief Writes the map through replaceFile(), so a crash never leaves a torn or empty map
+         */
+        bool save(const std::string &path) const {
+            std::ostringstream out;
+            char line[96];
+
+            out << "# Mapfile. Created by DriveMgr\n";
+            out << SOURCE_TAG << source_id << "\n";
+            out << TARGET_TAG << target_id << "\n";
+            out << "# current_pos  current_status  current_pass\n";
+            snprintf(line, sizeof(line), "0x%08llX     %c               %u\n",
+                static_cast<unsigned long long>(current_pos), static_cast<char>(phase), current_pass);
+            out << line;
+            out << "#      pos        size  status\n";
+
+            for (const auto &[pos, b] : blocks) {
+                snprintf(line, sizeof(line), "0x%08llX  0x%08llX  %c\n",
+                    static_cast<unsigned long long>(b.pos), static_cast<unsigned long long>(b.size), static_cast<char>(b.status));
+                out << line;
+            }
+
+            return replaceFile(path, out.str());
+        }
+    };
+
+    /**
+     * @brief Runs every pread on a worker thread so a read the drive never answers can be given up on.
+     * A hung worker is abandoned with its own fd and buffer, and a fresh one takes over.
+     */
+    class TimedReader {
+    private:
+        struct Shared {
+            std::mutex mtx;
+            std::condition_variable cv;
+            AlignedBuffer buf;
+            int fd = -1;
+            bool has_request = false;
+            bool done = false;
+            bool abandoned = false;
+            uint64_t offset = 0;
+            size_t length = 0;
+            ssize_t result = 0;
+            int err = 0;
+
+            explicit Shared(size_t size) : buf(size) {}
+        };
+
+        int base_fd;
+        size_t capacity;
+        std::chrono::milliseconds timeout;
+        std::shared_ptr<Shared> cur;
+
+        static void workerLoop(std::shared_ptr<Shared> s) {
+            IoQos::enterThread();
+            std::unique_lock<std::mutex> lock(s->mtx);
+
+            while (true) {
+                s->cv.wait(lock, [&] { return s->has_request || s->abandoned; });
+                if (s->abandoned) break;
+
+                const uint64_t offset = s->offset;
+                const size_t length = s->length;
+                lock.unlock();
+
+                errno = 0;
+                const ssize_t n = preadFull(s->fd, s->buf.data(), length, offset);
+                const int err = errno;
+
+                lock.lock();
+                if (s->abandoned) break;
+
+                s->result = n;
+                s->err = err;
+                s->has_request = false;
+                s->done = true;
+                s->cv.notify_all();
+            }
+
+            close(s->fd);
+        }
+
+        bool startWorker() {
+            auto s = std::make_shared<Shared>(capacity);
+            if (!s->buf.valid()) return false;
+
+            s->fd = dup(base_fd);
+            if (s->fd < 0) return false;
+
+            std::thread(workerLoop, s).detach();
+            cur = std::move(s);
+            return true;
+        }
+
+    public:
+        unsigned hung = 0;
+
+        TimedReader(int fd, size_t max_len, unsigned timeout_ms) : base_fd(fd), capacity(max_len), timeout(timeout_ms) {}
+
+        ~TimedReader() {
+            if (!cur) return;
+            std::lock_guard<std::mutex> lock(cur->mtx);
+            cur->abandoned = true;
+            cur->cv.notify_all();
+        }
+
+        bool start() { return startWorker(); }
+
+        /**
+         * @brief Reads length bytes at offset
+         * @returns bytes read (data() holds them), -1 on error or timeout (timed_out tells which)
+         */
+        ssize_t read(uint64_t offset, size_t length, bool &timed_out) {
+            timed_out = false;
+
+            std::unique_lock<std::mutex> lock(cur->mtx);
+            cur->offset = offset;
+            cur->length = length;
+            cur->done = false;
+            cur->has_request = true;
+            cur->cv.notify_all();
+
+            if (!cur->cv.wait_for(lock, timeout, [&] { return cur->done; })) {
+                cur->abandoned = true;
+                lock.unlock();
+
+                timed_out = true;
+                ++hung;
+                LOG_WARNING("Read of " + std::to_string(length) + " bytes at offset " + std::to_string(offset) + " timed out, abandoning it");
+
+                if (!startWorker()) hung = UINT32_MAX;
+                return -1;
+            }
+
+            if (cur->result < 0) errno = cur->err;
+            return cur->result;
+        }
+
+        const unsigned char* data() const { return cur->buf.data(); }
+    };
+
+    /**
+     * @brief Everything one rescue run works with
+     */
+    struct RescueJob {
+        RescueImager::Options opts;
+        RescueMap map;
+        std::string map_path;
+        TimedReader reader;
+        int target_fd = -1;
+        uint64_t sector = SECTOR_SIZE;
+        bool direct = false;
+        std::string error;                      ///< set when the run has to stop
+
+        std::chrono::steady_clock::time_point last_save = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point last_print{};
+        ProgressMeter::RateTracker rate;
+
+        RescueJob(const RescueImager::Options &o, uint64_t size, int src_fd, size_t max_read)
+            : opts(o), map(size), reader(src_fd, max_read, o.read_timeout_ms) {}
+
+        bool stopped() const { return !error.empty(); }
+
+        void printProgress(bool force) {
+            const auto now = std::chrono::steady_clock::now();
+            if (!force && now - last_print < PROGRESS_INTERVAL) return;
+            last_print = now;
+
+            const uint64_t rescued = map.bytesWith(Status::Finished);
+            const uint64_t bad = map.bytesWith(Status::BadSector);
+            const uint64_t pending = map.size() - rescued - bad;
+
+            // the ETA assumes the rest reads like what was rescued so far, which only holds in the copy passes
+            rate.update(rescued);
+
+            std::cout << "\r\033[K  pass " << map.current_pass << " (" << phaseName(map.phase) << ")  rescued "
+                << ProgressMeter::formatStats(map.size(), rate)
+                << "  bad " << (bad > 0 ? RED : "") << humanBytes(bad) << RESET
+                << "  pending " << humanBytes(pending) << std::flush;
+        }
+
+        void checkpoint(bool force) {
+            printProgress(force);
+
+            const auto now = std::chrono::steady_clock::now();
+            if (!force && now - last_save < MAP_SAVE_INTERVAL) return;
+            last_save = now;
+
+            // the map must never call something finished that is still only in the page cache
+            if (fdatasync(target_fd) != 0) {
+                LOG_WARNING(std::string("fdatasync on the rescue target failed, map not updated: ") + strerror(errno));
+                return;
+            }
+
+            if (!map.save(map_path)) {
+                LOG_WARNING("Failed to save rescue map " + map_path + ": " + strerror(errno));
+            }
+        }
+
+        /**
+         * @brief Reads [pos, pos + len) and writes what could be read to the target
+         * @returns number of leading bytes that were read and written (a multiple of the sector size unless at the end)
+         */
+        uint64_t transfer(uint64_t pos, uint64_t len) {
+            // O_DIRECT needs sector aligned lengths, the tail of an image file may be shorter
+            const size_t read_len = direct ? roundUp(len, sector) : len;
+
+            bool timed_out = false;
+            ssize_t n = reader.read(pos, read_len, timed_out);
+
+            if (reader.hung >= opts.max_hung_reads) {
+                error = "Source stopped responding (" + std::to_string(reader.hung) + " reads hung), stopping. Resume later with the same map";
+                return 0;
+            }
+
+            if (n <= 0) return 0;
+
+            uint64_t good = std::min<uint64_t>(static_cast<uint64_t>(n), len);
+            if (good < len) good -= good % sector;
+            if (good == 0) return 0;
+
+            if (!pwriteFull(target_fd, reader.data(), good, pos)) {
+                error = std::string("Write error on target at offset ") + std::to_string(pos) + ": " + strerror(errno);
+                return 0;
+            }
+
+            return good;
+        }
+
+        /**
+         * @brief Pass 1/2: large reads over non-tried areas, failed blocks become non-trimmed
+         * @param skipping jump over the area behind a failed read (pass 1)
+         */
+        void copyPass(bool skipping) {
+            map.phase = Phase::Copying;
+            const uint64_t max_skip = std::max<uint64_t>(opts.skip_min, map.size() / 100);
+            uint64_t skip = opts.skip_min;
+            uint64_t pos = 0;
+            RescueImager::Block b;
+
+            while (!stopped() && map.findNext(pos, Status::NonTried, b)) {
+                const uint64_t len = std::min<uint64_t>(opts.copy_block, b.size);
+                const uint64_t good = transfer(b.pos, len);
+                if (stopped()) break;
+
+                map.current_pos = b.pos;
+                map.set(b.pos, good, Status::Finished);
+                pos = b.pos + len;
+
+                if (good < len) {
+                    map.set(b.pos + good, len - good, Status::NonTrimmed);
+
+                    if (skipping) {
+                        pos += skip;
+                        skip = std::min(skip * 2, max_skip);
+                    }
+                } else {
+                    skip = opts.skip_min;
+                }
+
+                checkpoint(false);
+            }
+        }
+
+        /**
+         * @brief Reads single sectors from pos in direction dir (+1/-1) until one fails
+         * @returns the position where it stopped (first failed sector, or the opposite edge)
+         */
+        uint64_t trimEdge(uint64_t begin, uint64_t end, bool forward) {
+            while (!stopped() && begin < end) {
+                const uint64_t pos = forward ? begin : end - std::min<uint64_t>(sector, end - begin);
+                const uint64_t len = std::min<uint64_t>(sector, end - pos);
+
+                const uint64_t good = transfer(pos, len);
+                if (stopped()) break;
+
+                map.current_pos = pos;
+
+                if (good < len) {
+                    map.set(pos, len, Status::BadSector);
+                    return forward ? pos : pos + len;
+                }
+
+                map.set(pos, len, Status::Finished);
+                if (forward) begin += len; else end -= len;
+
+                checkpoint(false);
+            }
+
+            return forward ? begin : end;
+        }
+
+        /**
+         * @brief Trim pass: narrows every non-trimmed block from both edges, the middle becomes non-scraped
+         */
+        void trimPass() {
+            map.phase = Phase::Trimming;
+            RescueImager::Block b;
+
+            while (!stopped() && map.findNext(0, Status::NonTrimmed, b)) {
+                const uint64_t end = b.pos + b.size;
+                const uint64_t first_bad = trimEdge(b.pos, end, true);
+                if (stopped() || first_bad >= end) continue;
+
+                // first_bad is already marked bad, work backwards from the end up to it
+                const uint64_t inner_begin = first_bad + std::min<uint64_t>(sector, end - first_bad);
+                const uint64_t last_bad = trimEdge(inner_begin, end, false);
+                if (stopped()) break;
+
+                // between the two failed sectors: leave it to the scraper
+                if (last_bad > inner_begin) {
+                    const uint64_t inner_end = last_bad - std::min<uint64_t>(sector, last_bad - inner_begin);
+                    map.set(inner_begin, inner_end - inner_begin, Status::NonScraped);
+                }
+            }
+        }
+
+        /**
+         * @brief Reads every sector of all blocks with status from, good ones become finished, failing ones bad
+         */
+        void sectorPass(Status from) {
+            uint64_t pos = 0;
+            RescueImager::Block b;
+
+            while (!stopped() && map.findNext(pos, from, b)) {
+                const uint64_t len = std::min<uint64_t>(sector, b.size);
+                const uint64_t good = transfer(b.pos, len);
+                if (stopped()) break;
+
+                map.current_pos = b.pos;
+                map.set(b.pos, len, good == len ? Status::Finished : Status::BadSector);
+                pos = b.pos + len;
+
+                checkpoint(false);
+            }
+        }
+    };
+}
+
+// ========== rescue ==========
+
+std::string RescueImager::defaultMapPath(const std::string &source, const std::string &target) {
+    auto flatten = [](std::string s) {
+        std::replace(s.begin(), s.end(), '/', '_');
+        s.erase(0, s.find_first_not_of('_'));
+        return s;
+    };
+
+    return (Globals::dmgr_root / "data" / "rescue" / (flatten(source) + "_to_" + flatten(target) + ".map")).string();
+}
+
+RescueImager::Result RescueImager::rescue(const std::string &source, const std::string &target, const std::string &map_path, const Options &opts) {
+    Result res;
+    res.map_path = map_path;
+
+    if (Globals::g_dry_run) {
+
+        std::cout << YELLOW << "[DRY-RUN] Would rescue: " << source << " -> " << target << " (map: " << map_path << ")" << RESET << "\n";
+        LOG_DRYRUN("rescue " + source + " -> " + target + " map " + map_path);
+        res.success = res.completed = true;
+        return res;
+
+    }
+
+    bool direct = false;
+    const int src_fd = openDirectRead(source, direct);
+
+    if (src_fd < 0) {
+        res.error = "Cannot open source " + source + ": " + strerror(errno);
+        return res;
+    }
+
+    res.source_size = sizeOfFd(src_fd);
+
+    if (res.source_size == 0) {
+        close(src_fd);
+        res.error = "Cannot determine the size of " + source;
+        return res;
+    }
+
+    uint64_t sector = SECTOR_SIZE;
+    struct stat src_st{};
+
+    if (fstat(src_fd, &src_st) == 0 && S_ISBLK(src_st.st_mode)) {
+        int logical = 0;
+        if (ioctl(src_fd, BLKSSZGET, &logical) == 0 && logical > 0) sector = static_cast<uint64_t>(logical);
+    } else if (direct) {
+        // filesystems may want O_DIRECT aligned to their block size rather than 512
+        sector = DIRECT_ALIGN;
+    }
+
+    Options o = opts;
+    o.copy_block = std::max<size_t>(roundUp(o.copy_block, sector), sector);
+    o.skip_min = std::max<size_t>(o.skip_min, sector);
+
+    RescueJob job(o, res.source_size, src_fd, o.copy_block);
+    job.map_path = map_path;
+    job.sector = sector;
+    job.direct = direct;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(map_path).parent_path(), ec);
+
+    // a failing source may not be readable for sampling, size and serial identify it
+    const std::string source_id = OperationJournal::identify(source, false);
+
+    if (fileExists(map_path)) {
+        std::string err = job.map.load(map_path);
+
+        // the map only describes what is on the target it was made for
+        if (err.empty() && job.map.source_id != source_id) {
+            err = "Map " + map_path + " was made for a different source (" + job.map.source_id + "), remove it to start over";
+        } else if (err.empty() && !fileExists(target)) {
+            err = "Map " + map_path + " belongs to " + target + ", which no longer exists. Remove the map to start over";
+        } else if (err.empty() && job.map.target_id != OperationJournal::identify(target, false)) {
+            err = "Map " + map_path + " was made for a different " + target + " (" + job.map.target_id + "), remove it to start over";
+        }
+
+        if (!err.empty()) {
+            close(src_fd);
+            res.error = err;
+            return res;
+        }
+
+        res.resumed = true;
+        LOG_INFO("Resuming rescue of " + source + " from map " + map_path);
+    }
+
+    // a fresh run into an existing image file must not keep stale data where the source is unreadable
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    struct stat tgt_st{};
+    if (!res.resumed && stat(target.c_str(), &tgt_st) == 0 && S_ISREG(tgt_st.st_mode)) flags |= O_TRUNC;
+
+    job.target_fd = open(target.c_str(), flags, 0644);
+
+    if (job.target_fd < 0) {
+        close(src_fd);
+        res.error = "Cannot open target " + target + ": " + strerror(errno);
+        return res;
+    }
+
+    fstat(job.target_fd, &tgt_st);
+
+    job.map.source_id = source_id;
+    if (!res.resumed) job.map.target_id = OperationJournal::identify(target, false);
+
+    if (S_ISBLK(tgt_st.st_mode) && sizeOfFd(job.target_fd) < res.source_size) {
+        close(job.target_fd);
+        close(src_fd);
+        res.error = "Target " + target + " is smaller than " + source;
+        return res;
+    }
+
+    if (!job.reader.start()) {
+        close(job.target_fd);
+        close(src_fd);
+        res.error = std::string("Failed to start the reader: ") + strerror(errno);
+        return res;
+    }
+
+    LOG_INFO("Rescue " + source + " -> " + target + " map " + map_path);
+
+    // passes that a resumed map already finished find nothing to do and fall through
+    job.map.current_pass = 1;
+    job.copyPass(true);
+
+    if (!job.stopped()) {
+        job.map.current_pass = 2;
+        job.copyPass(false);
+    }
+
+    if (!job.stopped()) {
+        job.map.current_pass = 1;
+        job.trimPass();
+    }
+
+    if (!job.stopped()) {
+        job.map.phase = Phase::Scraping;
+        job.sectorPass(Status::NonScraped);
+    }
+
+    for (unsigned pass = 1; pass <= o.retry_passes && !job.stopped() && job.map.bytesWith(Status::BadSector) > 0; ++pass) {
+        job.map.phase = Phase::Retrying;
+        job.map.current_pass = pass;
+        job.sectorPass(Status::BadSector);
+    }
+
+    if (!job.stopped()) {
+        job.map.phase = Phase::Finished;
+        job.map.current_pos = 0;
+        res.completed = true;
+    }
+
+    job.checkpoint(true);
+    std::cout << "\n";
+
+    if (fsync(job.target_fd) != 0 && res.completed) {
+        job.error = std::string("fsync on target failed: ") + strerror(errno);
+        res.completed = false;
+    }
+
+    // unreadable areas at the end of an image file still have to exist
+    if (S_ISREG(tgt_st.st_mode) && ftruncate(job.target_fd, static_cast<off_t>(res.source_size)) != 0) {
+        LOG_WARNING("Failed to set the size of " + target + ": " + strerror(errno));
+    }
+
+    close(job.target_fd);
+    // abandoned readers hold their own dup() of src_fd
+    close(src_fd);
+
+    res.error = job.error;
+    res.bytes_rescued = job.map.bytesWith(Status::Finished);
+    res.bytes_bad = job.map.bytesWith(Status::BadSector);
+    res.bytes_non_tried = job.map.bytesWith(Status::NonTried);
+    res.bytes_pending = job.map.bytesWith(Status::NonTrimmed) + job.map.bytesWith(Status::NonScraped);
+    res.bad_areas = job.map.unfinished();
+    res.success = res.completed && res.bytes_rescued == res.source_size;
+
+    if (res.success) {
+        // nothing left to resume, a map full of '+' would only make the next run skip everything
+        std::filesystem::remove(map_path, ec);
+        LOG_SUCCESS("Rescued all " + std::to_string(res.bytes_rescued) + " bytes of " + source);
+    } else {
+        LOG_WARNING("Rescue of " + source + " left " + std::to_string(res.bytes_bad) + " bad, " + std::to_string(res.bytes_pending) + " not trimmed/scraped and "
+            + std::to_string(res.bytes_non_tried) + " untried bytes in " + std::to_string(res.bad_areas.size()) + " area(s), map: " + map_path);
+    }
+
+    return res;
+}
+
+void RescueImager::printReport(const Result &res) {
+    if (res.success) {
+        std::cout << GREEN << "[RESCUED] " << RESET << "all " << humanBytes(res.bytes_rescued) << " could be read\n";
+        return;
+    }
+
+    std::cout << (res.completed ? YELLOW : RED) << (res.completed ? "[PARTIAL] " : "[STOPPED] ") << RESET
+        << humanBytes(res.bytes_rescued) << " of " << humanBytes(res.source_size) << " rescued, "
+        << humanBytes(res.bytes_bad) << " unreadable, " << res.bad_areas.size() << " unfinished area(s)\n";
+
+    if (res.bytes_pending > 0) std::cout << "  " << humanBytes(res.bytes_pending) << " in failed blocks not yet trimmed or scraped\n";
+    if (res.bytes_non_tried > 0) std::cout << "  " << humanBytes(res.bytes_non_tried) << " not tried yet\n";
+
+    if (!res.error.empty()) std::cout << RED << "  " << res.error << RESET << "\n";
+
+    constexpr size_t max_lines = 50;
+
+    for (size_t i = 0; i < res.bad_areas.size() && i < max_lines; ++i) {
+        const auto &b = res.bad_areas[i];
+        std::cout << "  bytes " << b.pos << " - " << (b.pos + b.size - 1)
+            << " (sectors " << b.pos / SECTOR_SIZE << " - " << (b.pos + b.size - 1) / SECTOR_SIZE
+            << ", " << humanBytes(b.size) << ")\n";
+    }
+
+    if (res.bad_areas.size() > max_lines) std::cout << "  ... " << (res.bad_areas.size() - max_lines) << " more\n";
+
+    std::cout << "Map: " << res.map_path << (res.completed ? "" : " (run again to resume)") << "\n";
+}
@@ -0,0 +1,231 @@
+#include "../include/SpaceCache.hpp"
+#include "../include/globals.h"
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <openssl/sha.h>
+
+namespace {
+    const char MAGIC[8] = {'D', 'M', 'G', 'R', 'S', 'P', 'C', '\n'};
+    constexpr uint32_t CACHE_VERSION = 1;
+    constexpr size_t MIN_DIR_RECORD = 57;      ///< fixed fields plus the three lengths
+    constexpr size_t MAX_NAME = 200;           ///< file name length without ".cache", below NAME_MAX
+
+    template <typename T>
+    void put(std::string &out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putString(std::string &out, const std::string &s) {
+        put<uint32_t>(out, static_cast<uint32_t>(s.size()));
+        out += s;
+    }
+
+    /**
+     * @brief Bounds checked reads from the cache image, any short read marks it failed
+     */
+    class Reader {
+    public:
+        Reader(const std::string &data, size_t pos) : data(data), pos(pos) {}
+
+        template <typename T>
+        T get() {
+            T value{};
+            if (!ok || data.size() - pos < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+
+            std::memcpy(&value, data.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::string getString() {
+            const uint32_t len = get<uint32_t>();
+            if (!ok || data.size() - pos < len) {
+                ok = false;
+                return "";
+            }
+
+            std::string s = data.substr(pos, len);
+            pos += len;
+            return s;
+        }
+
+        bool good() const { return ok; }
+        bool atEnd() const { return pos == data.size(); }
+
+    private:
+        const std::string &data;
+        size_t pos;
+        bool ok = true;
+    };
+}
+
+std::string SpaceCache::defaultPath(const std::string &root) {
+    // '/' becomes '_', so a literal '_' and the '%' of its escape are escaped too: /a_b and /a/b get different files
+    std::string name;
+    name.reserve(root.size());
+
+    for (const char c : root) {
+        if (c == '/') name += '_';
+        else if (c == '_') name += "%5F";
+        else if (c == '%') name += "%25";
+        else name += c;
+    }
+
+    if (name.empty()) name = "_";
+
+    // past NAME_MAX the start of the name is kept readable and the digest of the root tells them apart
+    if (name.size() > MAX_NAME) {
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        SHA256(reinterpret_cast<const unsigned char*>(root.data()), root.size(), digest);
+        name = name.substr(0, MAX_NAME - 2 * SHA256_DIGEST_LENGTH - 1) + "-" + BlockIOUtils::toHex(digest, sizeof(digest));
+    }
+
+    return (Globals::dmgr_root / "data" / "space" / (name + ".cache")).string();
+}
+
+std::string SpaceCache::serialize(const SpaceTree &tree) {
+    std::string out(MAGIC, sizeof(MAGIC));
+    put(out, CACHE_VERSION);
+    putString(out, tree.root);
+    put<uint64_t>(out, tree.dev);
+    put<uint64_t>(out, tree.dirs.size());
+
+    for (const auto &d : tree.dirs) {
+        put(out, d.parent);
+        put(out, d.ino);
+        put(out, d.mtime_ns);
+        put(out, d.own_bytes);
+        put(out, d.own_apparent);
+        put(out, d.own_files);
+        put<uint8_t>(out, d.unreadable);
+        putString(out, d.name);
+
+        put<uint32_t>(out, static_cast<uint32_t>(d.largest.size()));
+        for (const auto &f : d.largest) {
+            putString(out, f.name);
+            put(out, f.bytes);
+            put(out, f.apparent);
+        }
+
+        put<uint32_t>(out, static_cast<uint32_t>(d.links.size()));
+        for (const auto &l : d.links) {
+            put(out, l.ino);
+            put(out, l.bytes);
+            put(out, l.apparent);
+            put<uint8_t>(out, l.counted);
+        }
+    }
+
+    return out;
+}
+
+std::optional<SpaceTree> SpaceCache::parse(const std::string &data, std::string &err) {
+    if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        err = "not a directory usage cache";
+        return std::nullopt;
+    }
+
+    Reader in(data, sizeof(MAGIC));
+
+    if (in.get<uint32_t>() != CACHE_VERSION) {
+        err = "written by an incompatible version";
+        return std::nullopt;
+    }
+
+    SpaceTree tree;
+    tree.root = in.getString();
+    tree.dev = in.get<uint64_t>();
+
+    const uint64_t count = in.get<uint64_t>();
+
+    // a damaged count cant make us allocate wildly
+    if (!in.good() || count == 0 || count > data.size() / MIN_DIR_RECORD) {
+        err = "damaged";
+        return std::nullopt;
+    }
+
+    tree.dirs.resize(count);
+
+    for (uint64_t i = 0; i < count && in.good(); ++i) {
+        SpaceDir &d = tree.dirs[i];
+        d.parent = in.get<uint32_t>();
+        d.ino = in.get<uint64_t>();
+        d.mtime_ns = in.get<int64_t>();
+        d.own_bytes = in.get<uint64_t>();
+        d.own_apparent = in.get<uint64_t>();
+        d.own_files = in.get<uint64_t>();
+        d.unreadable = in.get<uint8_t>() != 0;
+        d.name = in.getString();
+
+        const uint32_t files = in.get<uint32_t>();
+        if (files > SpaceWalker::TOP_FILES) {
+            err = "damaged";
+            return std::nullopt;
+        }
+
+        for (uint32_t f = 0; f < files && in.good(); ++f) {
+            SpaceFile file;
+            file.name = in.getString();
+            file.bytes = in.get<uint64_t>();
+            file.apparent = in.get<uint64_t>();
+            d.largest.push_back(std::move(file));
+        }
+
+        const uint32_t links = in.get<uint32_t>();
+        for (uint32_t l = 0; l < links && in.good(); ++l) {
+            SpaceLink link;
+            link.ino = in.get<uint64_t>();
+            link.bytes = in.get<uint64_t>();
+            link.apparent = in.get<uint64_t>();
+            link.counted = in.get<uint8_t>() != 0;
+            d.links.push_back(link);
+        }
+
+        // parents come first, anything else would loop in path() and finish()
+        if (i > 0 && d.parent >= i) {
+            err = "damaged";
+            return std::nullopt;
+        }
+
+        if (i > 0) tree.dirs[d.parent].children.push_back(static_cast<uint32_t>(i));
+    }
+
+    if (!in.good() || !in.atEnd()) {
+        err = "damaged";
+        return std::nullopt;
+    }
+
+    tree.dirs[0].parent = 0;
+    tree.finish();
+    return tree;
+}
+
+std::optional<SpaceTree> SpaceCache::load(const std::string &path, std::string &err) {
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in) {
+        err = "No directory usage cache at " + path;
+        return std::nullopt;
+    }
+
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto tree = parse(data, err);
+
+    if (!tree) err = "Directory usage cache " + path + " is " + err;
+    return tree;
+}
+
+bool SpaceCache::save(const std::string &path, const SpaceTree &tree) {
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    return BlockIOUtils::replaceFile(path, serialize(tree));
+}
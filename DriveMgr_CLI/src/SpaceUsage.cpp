@@ -0,0 +1,102 @@
+#include "../include/SpaceUsage.hpp"
+#include "../include/DiskLister.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/statvfs.h>
+
+namespace {
+    unsigned percentUp(uint64_t part, uint64_t whole) {
+        if (whole == 0) return 0;
+        return static_cast<unsigned>((part * 100 + whole - 1) / whole);
+    }
+}
+
+unsigned FsUsage::usedPercent() const {
+    return percentUp(used, used + available);
+}
+
+unsigned FsUsage::inodesUsedPercent() const {
+    return percentUp(inodes_used, inodes);
+}
+
+bool SpaceUsage::query(const std::string &mountpoint, FsUsage &usage, std::string &err) {
+    struct statvfs st{};
+
+    if (statvfs(mountpoint.c_str(), &st) != 0) {
+        err = "statvfs(" + mountpoint + ") failed: " + std::string(strerror(errno));
+        return false;
+    }
+
+    const uint64_t unit = st.f_frsize ? st.f_frsize : st.f_bsize;
+
+    usage.block_size = unit;
+    usage.total = static_cast<uint64_t>(st.f_blocks) * unit;
+    usage.free = static_cast<uint64_t>(st.f_bfree) * unit;
+    usage.available = static_cast<uint64_t>(st.f_bavail) * unit;
+    usage.used = usage.total > usage.free ? usage.total - usage.free : 0;
+
+    usage.inodes = st.f_files;
+    usage.inodes_free = st.f_ffree;
+    usage.inodes_used = st.f_files > st.f_ffree ? st.f_files - st.f_ffree : 0;
+
+    usage.read_only = (st.f_flag & ST_RDONLY) != 0;
+    return true;
+}
+
+std::vector<FsUsage> SpaceUsage::ofDisk(const BlockDevice &disk, const std::vector<BlockDevice> &partitions) {
+    const auto index = DiskLister::loadMountIndex();
+    std::vector<FsUsage> out;
+
+    std::vector<const BlockDevice*> devices{&disk};
+    for (const auto &part : partitions) devices.push_back(&part);
+
+    for (const BlockDevice* dev : devices) {
+        FsUsage usage;
+        usage.device = dev->path;
+
+        for (const auto &m : index.of(std::to_string(dev->major) + ":" + std::to_string(dev->minor), dev->path)) {
+            usage.mountpoints.push_back(m.mountpoint);
+            if (usage.fstype.empty()) usage.fstype = m.fstype;
+        }
+
+        if (usage.mountpoints.empty()) continue;
+
+        // all mounts share one superblock, any of them gives the same figures
+        for (const auto &mp : usage.mountpoints) {
+            usage.error.clear();
+            if (query(mp, usage, usage.error)) break;
+        }
+
+        out.push_back(std::move(usage));
+    }
+
+    return out;
+}
+
+void SpaceUsage::writeJson(JsonWriter &out, const FsUsage &usage) {
+    out.beginObject()
+       .field("record", "space")
+       .field("device", usage.device)
+       .field("fstype", usage.fstype)
+       .field("mountpoints", usage.mountpoints);
+
+    if (!usage.error.empty()) {
+        out.field("error", usage.error).endObject().endRecord();
+        return;
+    }
+
+    out.field("block_size", usage.block_size)
+       .field("total", usage.total)
+       .field("used", usage.used)
+       .field("free", usage.free)
+       .field("available", usage.available)
+       .field("used_percent", usage.usedPercent())
+       .field("inodes", usage.inodes)
+       .field("inodes_used", usage.inodes_used)
+       .field("inodes_free", usage.inodes_free)
+       .field("inodes_used_percent", usage.inodesUsedPercent())
+       .field("read_only", usage.read_only)
+       .endObject().endRecord();
+}
@@ -0,0 +1,448 @@
+#include "../include/SpaceWalker.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <optional>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    constexpr size_t DENTS_BUF = 64 * 1024;
+    constexpr size_t LINK_SHARDS = 64;
+    constexpr int MAX_QUEUED_DIRS = 1024;       ///< queued directories hold an fd each, beyond this they are listed in place
+
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    struct Task {
+        SpaceDir* dir;
+        uint32_t index;
+        int fd;
+        int64_t prev;           ///< the same directory in the previous tree, -1 if it wasnt there
+    };
+
+    int64_t mtimeNs(const struct stat &st) {
+        return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+
+    bool isDots(const char* name) {
+        return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+    }
+
+    /**
+     * @brief State shared by the workers of one walk
+     */
+    class Walk {
+    public:
+        Walk(SpaceTree &tree, const SpaceWalker::Options &opts, unsigned threads)
+            : tree(tree), meter(opts.meter), previous(opts.previous), dirty(opts.dirty), queues(threads) {}
+
+        void run(const struct stat &root_st, int root_fd) {
+            Task root = allocate(tree.root, 0, root_st);
+            root.fd = root_fd;
+
+            // a tree of another filesystem (or a recreated root) has nothing to offer
+            if (previous && !previous->dirs.empty() && previous->dev == tree.dev && previous->dirs[0].ino == root_st.st_ino) root.prev = 0;
+
+            pending = 1;
+            queued_fds = 1;
+            push(0, root);
+
+            std::vector<std::thread> pool;
+            for (size_t i = 1; i < queues.size(); ++i) pool.emplace_back([this, i] { worker(i); });
+            worker(0);
+            for (auto &t : pool) t.join();
+
+            tree.dirs.assign(std::make_move_iterator(nodes.begin()), std::make_move_iterator(nodes.end()));
+            tree.hardlinks = hardlinks;
+            tree.mountpoints = mountpoints;
+            tree.errors = errors;
+            tree.reused = reused;
+        }
+
+    private:
+        struct Queue {
+            std::mutex mtx;
+            std::deque<Task> tasks;
+        };
+
+        struct LinkShard {
+            std::mutex mtx;
+            std::unordered_set<uint64_t> inodes;
+        };
+
+        SpaceTree &tree;
+        ProgressMeter* meter;
+        const SpaceTree* previous;
+        const std::unordered_set<uint64_t>* dirty;
+        std::vector<Queue> queues;
+        LinkShard links[LINK_SHARDS];
+
+        // a deque keeps the nodes where they are, a worker writes its directory through the pointer without locking
+        std::mutex alloc_mtx;
+        std::deque<SpaceDir> nodes;
+
+        std::atomic<size_t> pending{0};         ///< queued plus running directories, the walk ends at 0
+        std::atomic<size_t> queued{0};          ///< tasks in the deques, what a parked worker waits for
+        std::atomic<unsigned> parked{0};
+
+        // idle workers sleep here until a directory is queued or the walk ends
+        std::mutex park_mtx;
+        std::condition_variable park_cv;
+        std::atomic<int> queued_fds{0};
+        std::atomic<uint64_t> hardlinks{0}, mountpoints{0}, errors{0}, reused{0};
+
+        Task allocate(const std::string &name, uint32_t parent, const struct stat &st) {
+            std::lock_guard<std::mutex> lock(alloc_mtx);
+
+            const uint32_t index = static_cast<uint32_t>(nodes.size());
+            SpaceDir &d = nodes.emplace_back();
+            d.name = name;
+            d.parent = index == 0 ? 0 : parent;
+            d.ino = st.st_ino;
+            d.mtime_ns = mtimeNs(st);
+            d.own_bytes = static_cast<uint64_t>(st.st_blocks) * 512;
+            d.own_apparent = static_cast<uint64_t>(st.st_size);
+
+            return {&d, index, -1, -1};
+        }
+
+        /**
+         * @brief Own deque newest first, then the oldest of the others
+         */
+        std::optional<Task> take(size_t self) {
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mtx);
+                auto &own = queues[self].tasks;
+
+                if (!own.empty()) {
+                    Task t = own.back();
+                    own.pop_back();
+                    queued--;
+                    return t;
+                }
+            }
+
+            for (size_t k = 1; k < queues.size(); ++k) {
+                Queue &victim = queues[(self + k) % queues.size()];
+                std::lock_guard<std::mutex> lock(victim.mtx);
+
+                if (!victim.tasks.empty()) {
+                    Task t = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    queued--;
+                    return t;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Queues a directory on the worker's own deque and wakes a parked worker to steal it
+         */
+        void push(size_t self, const Task &task) {
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mtx);
+                queues[self].tasks.push_back(task);
+                queued++;
+            }
+
+            // a worker counts itself parked before it checks queued, so one of the two sees the other
+            if (parked.load() == 0) return;
+
+            { std::lock_guard<std::mutex> lock(park_mtx); }
+            park_cv.notify_one();
+        }
+
+        void worker(size_t self) {
+            std::vector<char> buf(DENTS_BUF);
+
+            while (pending.load() > 0) {
+                const auto task = take(self);
+
+                if (!task) {
+                    std::unique_lock<std::mutex> lock(park_mtx);
+                    parked++;
+                    park_cv.wait(lock, [this] { return queued.load() > 0 || pending.load() == 0; });
+                    parked--;
+                    continue;
+                }
+
+                queued_fds--;
+                list(*task, self, buf);
+
+                // after list() queued the children, so the count cant touch 0 early
+                if (--pending == 0) {
+                    { std::lock_guard<std::mutex> lock(park_mtx); }
+                    park_cv.notify_all();
+                }
+            }
+        }
+
+        /**
+         * @returns false if another directory counted the inode already
+         */
+        bool claimLink(uint64_t ino) {
+            LinkShard &shard = links[ino % LINK_SHARDS];
+            std::lock_guard<std::mutex> lock(shard.mtx);
+
+            if (shard.inodes.insert(ino).second) return true;
+
+            hardlinks++;
+            return false;
+        }
+
+        void countFile(SpaceDir &dir, const char* name, const struct stat &st) {
+            const uint64_t bytes = static_cast<uint64_t>(st.st_blocks) * 512;
+
+            if (st.st_nlink > 1) {
+                const bool first = claimLink(st.st_ino);
+                dir.links.push_back({st.st_ino, bytes, static_cast<uint64_t>(st.st_size), first});
+                if (!first) return;
+            }
+
+            dir.own_bytes += bytes;
+            dir.own_apparent += static_cast<uint64_t>(st.st_size);
+            dir.own_files++;
+
+            if (dir.largest.size() == SpaceWalker::TOP_FILES && bytes <= dir.largest.back().bytes) return;
+
+            const auto pos = std::find_if(dir.largest.begin(), dir.largest.end(), [&](const SpaceFile &f) { return f.bytes < bytes; });
+            dir.largest.insert(pos, SpaceFile{name, bytes, static_cast<uint64_t>(st.st_size)});
+            if (dir.largest.size() > SpaceWalker::TOP_FILES) dir.largest.pop_back();
+        }
+
+        /**
+         * @brief A subdirectory of task's directory: allocated and queued, or deferred once MAX_QUEUED_DIRS are open
+         */
+        void enter(const Task &task, int fd, const char* name, const struct stat &st, int64_t prev, std::vector<Task> &deferred, size_t self) {
+            // a mount point of another filesystem, du -x leaves it out entirely
+            if (st.st_dev != tree.dev) {
+                mountpoints++;
+                return;
+            }
+
+            Task child = allocate(name, task.index, st);
+            child.prev = prev;
+            task.dir->children.push_back(child.index);
+
+            if (queued_fds.load() >= MAX_QUEUED_DIRS) {
+                deferred.push_back(child);
+                return;
+            }
+
+            child.fd = openat(fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+            if (child.fd < 0) {
+                child.dir->unreadable = true;
+                errors++;
+                return;
+            }
+
+            queued_fds++;
+            pending++;
+            push(self, child);
+        }
+
+        /**
+         * @brief Takes the files of an unchanged directory from the previous tree, only its subdirectories are stat'ed
+         */
+        void reuse(const Task &task, const SpaceDir &old, std::vector<Task> &deferred, size_t self) {
+            SpaceDir &dir = *task.dir;
+
+            dir.own_bytes = old.own_bytes;
+            dir.own_apparent = old.own_apparent;
+            dir.own_files = old.own_files;
+            dir.largest = old.largest;
+
+            // whoever claims a link first counts it, as in a full walk, which need not be the one that did before
+            for (SpaceLink l : old.links) {
+                const bool first = claimLink(l.ino);
+
+                if (first && !l.counted) {
+                    dir.own_bytes += l.bytes;
+                    dir.own_apparent += l.apparent;
+                    dir.own_files++;
+                } else if (!first && l.counted) {
+                    dir.own_bytes -= std::min(dir.own_bytes, l.bytes);
+                    dir.own_apparent -= std::min(dir.own_apparent, l.apparent);
+                    dir.own_files -= std::min<uint64_t>(dir.own_files, 1);
+                }
+
+                l.counted = first;
+                dir.links.push_back(l);
+            }
+
+            for (uint32_t c : old.children) {
+                const SpaceDir &child = previous->dirs[c];
+
+                struct stat st{};
+                if (fstatat(task.fd, child.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) continue;
+
+                enter(task, task.fd, child.name.c_str(), st, c, deferred, self);
+            }
+
+            reused++;
+        }
+
+        /**
+         * @brief Lists the entries of one directory: files are counted, subdirectories entered
+         */
+        void readEntries(const Task &task, std::vector<Task> &deferred, size_t self, std::vector<char> &buf) {
+            SpaceDir &dir = *task.dir;
+            const int fd = task.fd;
+            const SpaceDir* old = task.prev >= 0 ? &previous->dirs[static_cast<size_t>(task.prev)] : nullptr;
+
+            // the subdirectories of the old directory by name, to carry on the incremental walk below
+            std::unordered_map<std::string_view, uint32_t> old_children;
+            if (old) for (uint32_t c : old->children) old_children.emplace(previous->dirs[c].name, c);
+
+            while (true) {
+                const long n = syscall(SYS_getdents64, fd, buf.data(), buf.size());
+
+                if (n < 0) {
+                    dir.unreadable = true;
+                    errors++;
+                    break;
+                }
+
+                if (n == 0) break;
+
+                for (long off = 0; off < n; ) {
+                    const auto* d = reinterpret_cast<const LinuxDirent64*>(buf.data() + off);
+                    off += d->d_reclen;
+
+                    const char* name = d->d_name;
+                    if (isDots(name)) continue;
+
+                    struct stat st{};
+                    if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                        errors++;
+                        continue;
+                    }
+
+                    if (!S_ISDIR(st.st_mode)) {
+                        countFile(dir, name, st);
+                        continue;
+                    }
+
+                    const auto it = old ? old_children.find(name) : old_children.end();
+                    enter(task, fd, name, st, it == old_children.end() ? int64_t{-1} : int64_t{it->second}, deferred, self);
+                }
+            }
+        }
+
+        /**
+         * @brief Handles one directory, then the subdirectories it deferred (see MAX_QUEUED_DIRS)
+         */
+        void list(const Task &task, size_t self, std::vector<char> &buf) {
+            SpaceDir &dir = *task.dir;
+            const uint64_t before = dir.own_bytes;
+            const SpaceDir* old = task.prev >= 0 ? &previous->dirs[static_cast<size_t>(task.prev)] : nullptr;
+
+            std::vector<Task> deferred;        ///< buf is reused by them, they are listed once this directory is done
+
+            if (old && old->ino == dir.ino && old->mtime_ns == dir.mtime_ns && !old->unreadable && !(dirty && dirty->count(dir.ino))) {
+                reuse(task, *old, deferred, self);
+            } else {
+                readEntries(task, deferred, self, buf);
+            }
+
+            if (meter) meter->add(dir.own_bytes > before ? dir.own_bytes - before : 0);
+
+            for (Task &child : deferred) {
+                child.fd = openat(task.fd, child.dir->name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+                if (child.fd < 0) {
+                    child.dir->unreadable = true;
+                    errors++;
+                    continue;
+                }
+
+                list(child, self, buf);
+            }
+
+            close(task.fd);
+        }
+    };
+}
+
+std::string SpaceTree::path(uint32_t dir) const {
+    std::vector<uint32_t> chain;
+    for (uint32_t d = dir; d != 0; d = dirs[d].parent) chain.push_back(d);
+
+    std::string out = root;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (out.empty() || out.back() != '/') out += '/';
+        out += dirs[*it].name;
+    }
+
+    return out;
+}
+
+void SpaceTree::finish() {
+    for (auto &d : dirs) {
+        d.bytes = d.own_bytes;
+        d.apparent = d.own_apparent;
+        d.files = d.own_files;
+        d.dirs = 0;
+    }
+
+    // children come after their parent, one backwards pass sums every subtree
+    for (size_t i = dirs.size(); i-- > 1; ) {
+        SpaceDir &p = dirs[dirs[i].parent];
+        p.bytes += dirs[i].bytes;
+        p.apparent += dirs[i].apparent;
+        p.files += dirs[i].files;
+        p.dirs += dirs[i].dirs + 1;
+    }
+
+    for (auto &d : dirs) {
+        std::stable_sort(d.children.begin(), d.children.end(), [&](uint32_t a, uint32_t b) { return dirs[a].bytes > dirs[b].bytes; });
+    }
+}
+
+bool SpaceWalker::walk(const std::string &root, const Options &opts, SpaceTree &tree, std::string &err) {
+    const auto started = std::chrono::steady_clock::now();
+
+    const int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    struct stat st{};
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        err = "Cant open " + root + ": " + std::string(strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    tree = SpaceTree{};
+    tree.root = root;
+    tree.dev = st.st_dev;
+
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned threads = opts.threads ? opts.threads : std::clamp(cpus * 2, 4u, 32u);
+
+    Walk(tree, opts, threads).run(st, fd);
+    tree.finish();
+
+    tree.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
@@ -0,0 +1,876 @@
+#include "../include/WipeEngine.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+#include "../include/ui/ProgressMeter.hpp"
+#include "../include/utils/IoQos.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <random>
+#include <sys/random.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace BlockIOUtils;
+
+namespace {
+    /**
+     * @brief Fills buf from the kernel CSPRNG (same source as /dev/urandom)
+     */
+    bool fillRandom(unsigned char* buf, size_t len) {
+        size_t done = 0;
+
+        while (done < len) {
+            ssize_t n = getrandom(buf + done, len - done, 0);
+
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+
+            done += static_cast<size_t>(n);
+        }
+
+        return true;
+    }
+
+    struct GenSlot {
+        AlignedBuffer buf;
+        uint64_t chunk = UINT64_MAX;            ///< chunk the slot currently holds
+
+        explicit GenSlot(size_t size) : buf(size) {}
+    };
+
+    /**
+     * @brief Random chunks produced by generator threads ahead of the writer, chunk k lives in slot k % slots
+     * A generator only starts on chunk k once the writer has consumed chunk k - slots, so the ring never overruns.
+     */
+    class RandomRing {
+    private:
+        const WipeEngine::Seed seed;
+        const size_t chunk_size;
+        const uint64_t total;
+        const uint64_t end_chunk;
+
+        std::vector<std::unique_ptr<GenSlot>> slots;
+        std::vector<std::thread> generators;
+
+        std::mutex mtx;
+        std::condition_variable ready_cv;       ///< generators -> writer
+        std::condition_variable free_cv;        ///< writer -> generators
+        uint64_t next_chunk;                    ///< next chunk a generator claims
+        uint64_t consumed;                      ///< chunks the writer is done with
+        bool stopped = false;
+        std::string err;
+
+        void generatorLoop() {
+            while (true) {
+                uint64_t k;
+
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    if (stopped || next_chunk >= end_chunk) return;
+                    k = next_chunk++;
+
+                    free_cv.wait(lock, [&] { return stopped || k < consumed + slots.size(); });
+                    if (stopped) return;
+                }
+
+                GenSlot &slot = *slots[k % slots.size()];
+                const uint64_t offset = k * chunk_size;
+                const size_t len = static_cast<size_t>(std::min<uint64_t>(chunk_size, total - offset));
+                const bool ok = WipeEngine::generate(seed, offset, slot.buf.data(), len);
+
+                std::lock_guard<std::mutex> lock(mtx);
+
+                if (!ok) {
+                    err = "AES-CTR generation failed";
+                    stopped = true;
+                    ready_cv.notify_all();
+                    free_cv.notify_all();
+                    return;
+                }
+
+                slot.chunk = k;
+                ready_cv.notify_all();
+            }
+        }
+
+    public:
+        RandomRing(const WipeEngine::Seed &seed, size_t chunk_size, uint64_t total, uint64_t first_chunk)
+            : seed(seed), chunk_size(chunk_size), total(total), end_chunk((total + chunk_size - 1) / chunk_size),
+              next_chunk(first_chunk), consumed(first_chunk) {}
+
+        ~RandomRing() { stop(); }
+
+        bool start(unsigned threads, size_t slot_count) {
+            for (size_t i = 0; i < slot_count; ++i) {
+                slots.push_back(std::make_unique<GenSlot>(chunk_size));
+                if (!slots.back()->buf.valid()) return false;
+            }
+
+            for (unsigned t = 0; t < threads; ++t) generators.emplace_back(&RandomRing::generatorLoop, this);
+            return true;
+        }
+
+        /**
+         * @brief Blocks until chunk k is generated
+         * @returns the data, nullptr if generation failed
+         */
+        const unsigned char* wait(uint64_t k) {
+            GenSlot &slot = *slots[k % slots.size()];
+            std::unique_lock<std::mutex> lock(mtx);
+            ready_cv.wait(lock, [&] { return stopped || slot.chunk == k; });
+            return slot.chunk == k ? slot.buf.data() : nullptr;
+        }
+
+        /** @brief the writer is done with chunk k, its slot can take chunk k + slots */
+        void release(uint64_t k) {
+            std::lock_guard<std::mutex> lock(mtx);
+            consumed = k + 1;
+            free_cv.notify_all();
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopped = true;
+                ready_cv.notify_all();
+                free_cv.notify_all();
+            }
+
+            for (auto &t : generators) if (t.joinable()) t.join();
+            generators.clear();
+        }
+
+        std::string error() {
+            std::lock_guard<std::mutex> lock(mtx);
+            return err;
+        }
+    };
+
+    void appendRange(std::vector<WipeEngine::Range> &ranges, uint64_t offset, uint64_t length) {
+        if (!ranges.empty() && ranges.back().offset + ranges.back().length == offset) {
+            ranges.back().length += length;
+        } else {
+            ranges.push_back({offset, length});
+        }
+    }
+}
+
+std::string WipeEngine::schemeName(Scheme scheme) {
+    switch (scheme) {
+        case Scheme::Random: return "random";
+        case Scheme::Zero: return "zero";
+        case Scheme::RandomVerify: return "random-verify";
+        default: return "random-zero";
+    }
+}
+
+std::optional<WipeEngine::Scheme> WipeEngine::parseScheme(const std::string &name) {
+    for (auto scheme : {Scheme::Random, Scheme::Zero, Scheme::RandomVerify, Scheme::RandomZero}) {
+        if (schemeName(scheme) == name) return scheme;
+    }
+    return std::nullopt;
+}
+
+std::vector<WipeEngine::Pattern> WipeEngine::passes(Scheme scheme) {
+    switch (scheme) {
+        case Scheme::Zero: return {Pattern::Zero};
+        case Scheme::RandomZero: return {Pattern::Random, Pattern::Zero};
+        default: return {Pattern::Random};
+    }
+}
+
+WipeEngine::Seed WipeEngine::newSeed() {
+    Seed seed{};
+    fillRandom(seed.data(), seed.size());
+    return seed;
+}
+
+std::string WipeEngine::seedToHex(const Seed &seed) {
+    std::string out;
+    char byte[3];
+
+    for (unsigned char c : seed) {
+        snprintf(byte, sizeof(byte), "%02x", c);
+        out += byte;
+    }
+
+    return out;
+}
+
+std::optional<WipeEngine::Seed> WipeEngine::seedFromHex(const std::string &hex) {
+    Seed seed{};
+    if (hex.size() != seed.size() * 2) return std::nullopt;
+
+    for (size_t i = 0; i < seed.size(); ++i) {
+        unsigned v = 0;
+        if (sscanf(hex.c_str() + 2 * i, "%2x", &v) != 1) return std::nullopt;
+        seed[i] = static_cast<unsigned char>(v);
+    }
+
+    return seed;
+}
+
+bool WipeEngine::generate(const Seed &seed, uint64_t offset, unsigned char* buf, size_t len) {
+    // 16 byte key, then an 8 byte nonce in front of the 64 bit block counter
+    unsigned char iv[16];
+    std::memcpy(iv, seed.data() + 16, 8);
+
+    const uint64_t block = offset / 16;
+    for (int i = 0; i < 8; ++i) iv[15 - i] = static_cast<unsigned char>(block >> (8 * i));
+
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) return false;
+
+    // the keystream is the encryption of zeros, CTR mode works in place
+    std::memset(buf, 0, len);
+    bool ok = EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), nullptr, seed.data(), iv) == 1;
+
+    for (size_t done = 0; ok && done < len; ) {
+        const int n = static_cast<int>(std::min<size_t>(len - done, 1u << 30));
+        int out_len = 0;
+        ok = EVP_EncryptUpdate(ctx, buf + done, &out_len, buf + done, n) == 1;
+        done += static_cast<size_t>(n);
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+WipeEngine::Result WipeEngine::fill(const std::string &target, Pattern pattern, const Options &opts) {
+    Result res;
+    const char* pattern_name = pattern == Pattern::Zero ? "zeros" : "random data";
+
+    if (Globals::g_dry_run) {
+
+        std::cout << YELLOW << "[DRY-RUN] Would overwrite " << target << " with " << pattern_name << RESET << "\n";
+        LOG_DRYRUN("overwrite " + target + " with " + pattern_name);
+        res.success = true;
+        return res;
+
+    }
+
+    bool direct = true;
+    int fd = -1;
+
+    if (opts.fd >= 0) {
+        // a dup shares the open file description, and with it the claim the caller holds on the device
+        fd = fcntl(opts.fd, F_DUPFD_CLOEXEC, 0);
+        if (fd >= 0) direct = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_DIRECT) == 0;
+    } else {
+        fd = open(target.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+
+        if (fd < 0 && errno == EINVAL) {
+            direct = false;
+            fd = open(target.c_str(), O_WRONLY | O_CLOEXEC);
+        }
+    }
+
+    if (fd < 0) {
+        res.error = "Cannot open " + target + ": " + strerror(errno);
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    const uint64_t total = sizeOfFd(fd);
+
+    if (total == 0) {
+        close(fd);
+        res.error = "Cannot determine the size of " + target;
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    // chunks are addressed by index, a resume point between two chunks simply rewrites the partial one
+    const uint64_t start = std::min(opts.start_offset, total) / opts.chunk_size * opts.chunk_size;
+
+    AlignedBuffer zero_buf(pattern == Pattern::Zero ? opts.chunk_size : 0);
+    std::unique_ptr<RandomRing> ring;
+
+    if (pattern == Pattern::Zero) {
+
+        if (zero_buf.valid()) std::memset(zero_buf.data(), 0, zero_buf.size());
+
+    } else {
+
+        res.seed = opts.seed.value_or(newSeed());
+
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned threads = opts.generator_threads ? opts.generator_threads : std::min(4u, cores);
+        // every chunk in flight holds its slot until it is written
+        const size_t slot_count = std::max<size_t>(opts.ring_slots ? opts.ring_slots : 2 * threads, std::max(1u, opts.write_depth) + threads);
+
+        ring = std::make_unique<RandomRing>(res.seed, opts.chunk_size, total, start / opts.chunk_size);
+        if (!ring->start(threads, slot_count)) ring.reset();
+
+    }
+
+    if (pattern == Pattern::Zero ? !zero_buf.valid() : !ring) {
+        close(fd);
+        res.error = "Failed to allocate the wipe buffers";
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    ProgressMeter meter(pattern == Pattern::Zero ? "Zeroing" : "Writing random data", total - start);
+    if (!opts.progress) meter.start();
+
+    // O_DIRECT cant write the unaligned tail of a device whose size isnt a multiple of DIRECT_ALIGN
+    const int tail_fd = direct && total % DIRECT_ALIGN != 0 ? open(target.c_str(), O_WRONLY | O_CLOEXEC) : -1;
+
+    const uint64_t end_chunk = (total + opts.chunk_size - 1) / opts.chunk_size;
+
+    // the writers claim chunks in order and finish them in any order, prefix is the gap free part
+    // that checkpoints report and whose ring slots may be reused
+    std::mutex write_mtx;
+    std::condition_variable write_cv;       ///< writers -> checkpoint loop: a chunk finished, failed, or a writer exited
+    uint64_t next_claim = start / opts.chunk_size;
+    uint64_t prefix = next_claim;
+    std::vector<uint64_t> done_ahead;       ///< finished chunks past prefix, at most write_depth of them
+    bool failed = false;
+    const unsigned depth = std::max(1u, opts.write_depth);
+    unsigned writers_left = depth;
+
+    auto writer = [&]() {
+        IoQos::enterThread();
+
+        while (true) {
+            uint64_t k;
+
+            {
+                std::lock_guard<std::mutex> lock(write_mtx);
+                if (failed || next_claim >= end_chunk) break;
+                k = next_claim++;
+            }
+
+            const uint64_t pos = k * opts.chunk_size;
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(opts.chunk_size, total - pos));
+            const unsigned char* data = ring ? ring->wait(k) : zero_buf.data();
+
+            if (!data) {
+                std::lock_guard<std::mutex> lock(write_mtx);
+                // a stopped ring after another writer failed is not an error of its own
+                if (!failed) res.error = ring->error();
+                failed = true;
+                break;
+            }
+
+            const int wfd = tail_fd >= 0 && len % DIRECT_ALIGN != 0 ? tail_fd : fd;
+
+            if (!pwriteFull(wfd, data, len, pos)) {
+                const std::string why = strerror(errno);
+                std::lock_guard<std::mutex> lock(write_mtx);
+                if (!failed) res.error = "Write error on " + target + " at offset " + std::to_string(pos) + ": " + why;
+                failed = true;
+                break;
+            }
+
+            meter.add(len);
+            if (opts.progress) opts.progress(meter.done());
+
+            uint64_t released = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(write_mtx);
+                done_ahead.push_back(k);
+
+                for (auto it = std::find(done_ahead.begin(), done_ahead.end(), prefix); it != done_ahead.end(); it = std::find(done_ahead.begin(), done_ahead.end(), prefix)) {
+                    done_ahead.erase(it);
+                    released = ++prefix;
+                }
+            }
+
+            if (ring && released > 0) ring->release(released - 1);
+            write_cv.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(write_mtx);
+            writers_left--;
+        }
+
+        write_cv.notify_all();
+    };
+
+    const bool buffers_ok = tail_fd >= 0 || !(direct && total % DIRECT_ALIGN != 0);
+    if (!buffers_ok) res.error = "Cannot open " + target + " for its unaligned tail: " + strerror(errno);
+
+    std::vector<std::thread> writers;
+    if (buffers_ok) for (unsigned t = 0; t < depth; ++t) writers.emplace_back(writer);
+    else writers_left = 0;
+
+    auto last_sync = std::chrono::steady_clock::now();
+    uint64_t reported = start;
+
+    {
+        std::unique_lock<std::mutex> lock(write_mtx);
+
+        while (writers_left > 0) {
+            write_cv.wait_for(lock, std::chrono::milliseconds(std::max(50u, opts.checkpoint_interval_ms)));
+
+            if (failed) {
+                // wakes writers blocked on a chunk that will never be generated
+                lock.unlock();
+                if (ring) ring->stop();
+                lock.lock();
+                write_cv.wait(lock, [&] { return writers_left == 0; });
+                break;
+            }
+
+            const uint64_t committed = std::min(prefix * opts.chunk_size, total);
+            if (!opts.checkpoint || committed == reported || std::chrono::steady_clock::now() - last_sync < std::chrono::milliseconds(opts.checkpoint_interval_ms)) continue;
+
+            lock.unlock();
+
+            // everything below committed finished before this flush started
+            const bool synced = fdatasync(fd) == 0 && (tail_fd < 0 || fdatasync(tail_fd) == 0);
+            const std::string why = synced ? "" : strerror(errno);
+
+            if (synced) {
+                last_sync = std::chrono::steady_clock::now();
+                reported = committed;
+                opts.checkpoint(committed);
+            }
+
+            lock.lock();
+
+            if (!synced && !failed) {
+                res.error = std::string("fdatasync on ") + target + " failed: " + why;
+                failed = true;
+            }
+        }
+    }
+
+    for (auto &t : writers) t.join();
+
+    res.bytes_written = std::min(prefix * opts.chunk_size, total);
+
+    if (ring) ring->stop();
+    meter.finish();
+
+    if (res.error.empty() && (fsync(fd) != 0 || (tail_fd >= 0 && fsync(tail_fd) != 0))) {
+        res.error = std::string("fsync on ") + target + " failed: " + strerror(errno);
+    }
+
+    if (tail_fd >= 0) close(tail_fd);
+    close(fd);
+
+    res.success = res.error.empty();
+
+    if (res.success) {
+        LOG_INFO("Overwrote " + target + " with " + pattern_name + " (" + std::to_string(res.bytes_written) + " bytes)");
+    } else {
+        LOG_ERROR(res.error);
+    }
+
+    return res;
+}
+
+WipeEngine::VerifyResult WipeEngine::verify(const std::string &target, const std::optional<Seed> &seed, const Options &opts) {
+    VerifyResult res;
+
+    if (Globals::g_dry_run) {
+
+        std::cout << YELLOW << "[DRY-RUN] Would verify: " << target << RESET << "\n";
+        LOG_DRYRUN("verify wipe of " + target);
+        res.success = true;
+        return res;
+
+    }
+
+    const uint64_t total = sizeOfPath(target);
+
+    if (total == 0) {
+        res.error = "Cannot determine the size of " + target;
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    const uint64_t chunks = (total + opts.chunk_size - 1) / opts.chunk_size;
+    const unsigned thread_count = static_cast<unsigned>(std::max<uint64_t>(1, std::min<uint64_t>(opts.verify_threads, chunks)));
+
+    std::atomic<uint64_t> next_chunk{0};
+    std::mutex result_mtx;
+    std::vector<Range> mismatches;
+
+    ProgressMeter meter("Verifying", total);
+    if (!opts.progress) meter.start();
+
+    auto report = [&](size_t len) {
+        meter.add(len);
+        if (opts.progress) opts.progress(meter.done());
+    };
+
+    auto worker = [&]() {
+        IoQos::enterThread();
+        bool is_direct = false;
+        int fd = openDirectRead(target, is_direct);
+        int buffered_fd = -1;
+
+        AlignedBuffer buf(opts.chunk_size);
+        AlignedBuffer expected(opts.chunk_size);
+
+        if (fd < 0 || !buf.valid() || !expected.valid()) {
+            std::lock_guard<std::mutex> lock(result_mtx);
+            if (res.error.empty()) res.error = fd < 0 ? "Cannot open " + target + " for verification: " + strerror(errno) : "Failed to allocate the verify buffers";
+            if (fd >= 0) close(fd);
+            return;
+        }
+
+        if (!seed) std::memset(expected.data(), 0, expected.size());
+
+        std::vector<Range> local;
+
+        for (uint64_t k = next_chunk++; k < chunks; k = next_chunk++) {
+            const uint64_t offset = k * opts.chunk_size;
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(opts.chunk_size, total - offset));
+
+            // O_DIRECT needs an aligned length, whatever lies past the end is simply not returned
+            ssize_t n = preadFull(fd, buf.data(), std::min<size_t>(roundUp(len, DIRECT_ALIGN), buf.size()), offset);
+            size_t readable = n > 0 ? std::min<size_t>(static_cast<size_t>(n), len) : 0;
+
+            // the unaligned tail of a device (or a block size above DIRECT_ALIGN) needs a buffered read
+            if (readable < len && is_direct) {
+                if (buffered_fd < 0) buffered_fd = open(target.c_str(), O_RDONLY | O_CLOEXEC);
+                const ssize_t rest = buffered_fd < 0 ? -1 : preadFull(buffered_fd, buf.data() + readable, len - readable, offset + readable);
+                if (rest > 0) readable += static_cast<size_t>(rest);
+            }
+
+            if (seed && !generate(*seed, offset, expected.data(), len)) {
+                std::lock_guard<std::mutex> lock(result_mtx);
+                if (res.error.empty()) res.error = "AES-CTR generation failed";
+                break;
+            }
+
+            if (readable == len && std::memcmp(buf.data(), expected.data(), len) == 0) {
+                report(len);
+                continue;
+            }
+
+            // unreadable sectors count as not wiped
+            for (size_t pos = 0; pos < len; pos += SECTOR_SIZE) {
+                const size_t sector = std::min<size_t>(SECTOR_SIZE, len - pos);
+                if (pos + sector > readable || std::memcmp(buf.data() + pos, expected.data() + pos, sector) != 0) appendRange(local, offset + pos, sector);
+            }
+
+            report(len);
+        }
+
+        close(fd);
+        if (buffered_fd >= 0) close(buffered_fd);
+
+        std::lock_guard<std::mutex> lock(result_mtx);
+        mismatches.insert(mismatches.end(), local.begin(), local.end());
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < thread_count; ++t) workers.emplace_back(worker);
+    for (auto &w : workers) w.join();
+
+    meter.finish();
+
+    if (!res.error.empty()) {
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    std::sort(mismatches.begin(), mismatches.end(), [](const Range &a, const Range &b) { return a.offset < b.offset; });
+    for (const auto &r : mismatches) appendRange(res.mismatches, r.offset, r.length);
+
+    res.bytes_verified = meter.done();
+    res.success = res.mismatches.empty();
+
+    if (res.success) {
+        LOG_INFO("Wipe of " + target + " verified (" + std::to_string(res.bytes_verified) + " bytes)");
+    } else {
+        LOG_ERROR("Wipe verification of " + target + " failed: " + std::to_string(res.mismatches.size()) + " non-conforming range(s)");
+    }
+
+    return res;
+}
+
+WipeEngine::SampleResult WipeEngine::sampleVerify(const std::string &target, const std::optional<Seed> &seed, const SampleOptions &sopts, const Options &opts) {
+    SampleResult res;
+    res.confidence = sopts.confidence;
+
+    if (Globals::g_dry_run) {
+
+        std::cout << YELLOW << "[DRY-RUN] Would sample-verify: " << target << RESET << "\n";
+        LOG_DRYRUN("sample-verify wipe of " + target);
+        res.success = true;
+        return res;
+
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const uint64_t blocks = sizeOfPath(target) / DIRECT_ALIGN;
+
+    if (blocks == 0) {
+        res.error = "Cannot determine the size of " + target;
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    struct Pick {
+        uint64_t block;
+        bool random;
+    };
+
+    std::vector<Pick> picks = {{0, false}, {blocks - 1, false}};
+    std::mt19937_64 rng(std::random_device{}());
+    std::uniform_int_distribution<uint64_t> pick(0, blocks - 1);
+
+    // a fine stride over a large drive would mean billions of reads and as many picks in memory,
+    // random and stride blocks then share max_blocks and the stride is widened to fit its half
+    const size_t budget = std::max<size_t>(sopts.max_blocks, 2);
+    const size_t count = std::min(sopts.count, sopts.stride > 0 ? budget / 2 : budget);
+    uint64_t stride = sopts.stride;
+
+    if (stride > 0 && blocks / stride > budget / 2) {
+        stride = (blocks + budget / 2 - 1) / (budget / 2);
+        LOG_WARNING("Sampling every " + std::to_string(sopts.stride) + "th block of " + target + " exceeds " + std::to_string(budget) + " reads, using every " + std::to_string(stride) + "th");
+    }
+
+    for (size_t i = 0; i < count; ++i) picks.push_back({pick(rng), true});
+    if (stride > 0) for (uint64_t b = 0; b < blocks; b += stride) picks.push_back({b, false});
+
+    // ascending offsets keep the readers moving forward, a block drawn twice is read once
+    std::sort(picks.begin(), picks.end(), [](const Pick &a, const Pick &b) { return a.block < b.block; });
+
+    std::vector<Pick> unique;
+    for (const auto &p : picks) {
+        if (!unique.empty() && unique.back().block == p.block) unique.back().random = unique.back().random || p.random;
+        else unique.push_back(p);
+    }
+
+    std::vector<SampledBlock> sampled(sopts.keep_blocks ? unique.size() : 0);
+    std::vector<unsigned char> bad(unique.size(), 0);
+
+    std::atomic<size_t> next{0};
+    std::mutex err_mtx;
+
+    ProgressMeter meter("Sampling", unique.size() * DIRECT_ALIGN);
+    if (!opts.progress) meter.start();
+
+    auto worker = [&]() {
+        IoQos::enterThread();
+        bool is_direct = false;
+        const int fd = openDirectRead(target, is_direct);
+        AlignedBuffer buf(DIRECT_ALIGN);
+        std::vector<unsigned char> expected(DIRECT_ALIGN, 0);
+
+        if (fd < 0 || !buf.valid()) {
+            std::lock_guard<std::mutex> lock(err_mtx);
+            if (res.error.empty()) res.error = fd < 0 ? "Cannot open " + target + " for verification: " + strerror(errno) : "Failed to allocate the sample buffer";
+            if (fd >= 0) close(fd);
+            return;
+        }
+
+        constexpr size_t batch = 32;
+
+        for (size_t first = next.fetch_add(batch); first < unique.size(); first = next.fetch_add(batch)) {
+            for (size_t i = first; i < std::min(first + batch, unique.size()); ++i) {
+                const uint64_t offset = unique[i].block * DIRECT_ALIGN;
+                const bool readable = preadFull(fd, buf.data(), DIRECT_ALIGN, offset) == static_cast<ssize_t>(DIRECT_ALIGN);
+                const bool matches = readable && (!seed || generate(*seed, offset, expected.data(), expected.size()))
+                                     && std::memcmp(buf.data(), expected.data(), DIRECT_ALIGN) == 0;
+
+                bad[i] = !matches;
+
+                if (sopts.keep_blocks) {
+                    auto &b = sampled[i];
+                    b.offset = offset;
+                    b.readable = readable;
+                    b.matches = matches;
+                    if (readable) SHA256(buf.data(), DIRECT_ALIGN, b.sha256.data());
+                }
+
+                meter.add(DIRECT_ALIGN);
+                if (opts.progress) opts.progress(meter.done());
+            }
+        }
+
+        close(fd);
+    };
+
+    const unsigned thread_count = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(sopts.threads, unique.size() / 32 + 1)));
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < thread_count; ++t) workers.emplace_back(worker);
+    for (auto &w : workers) w.join();
+
+    meter.finish();
+
+    if (!res.error.empty()) {
+        LOG_ERROR(res.error);
+        return res;
+    }
+
+    for (size_t i = 0; i < unique.size(); ++i) {
+        res.blocks_checked++;
+        if (unique[i].random) res.random_checked++;
+        if (!bad[i]) continue;
+
+        res.blocks_bad++;
+        if (unique[i].random) res.random_bad++;
+    }
+
+    // follow each failing block into its neighbours to find the extent of the region, capped so a
+    // drive that wasnt wiped at all still answers in seconds
+    constexpr uint64_t follow_limit = 256;
+    constexpr size_t followed_max = 64;
+
+    bool is_direct = false;
+    const int fd = openDirectRead(target, is_direct);
+    AlignedBuffer buf(DIRECT_ALIGN);
+    std::vector<unsigned char> expected(DIRECT_ALIGN, 0);
+    std::vector<Range> ranges;
+    size_t followed = 0;
+
+    auto checkSectors = [&](uint64_t block) {
+        const uint64_t offset = block * DIRECT_ALIGN;
+        const ssize_t n = preadFull(fd, buf.data(), DIRECT_ALIGN, offset);
+        const size_t readable = n > 0 ? static_cast<size_t>(n) : 0;
+
+        if (seed && !generate(*seed, offset, expected.data(), expected.size())) return false;
+
+        bool clean = true;
+
+        // unreadable sectors count as not wiped
+        for (size_t pos = 0; pos < DIRECT_ALIGN; pos += SECTOR_SIZE) {
+            if (pos + SECTOR_SIZE <= readable && std::memcmp(buf.data() + pos, expected.data() + pos, SECTOR_SIZE) == 0) continue;
+            appendRange(ranges, offset + pos, SECTOR_SIZE);
+            clean = false;
+        }
+
+        return clean;
+    };
+
+    for (size_t i = 0; i < unique.size() && fd >= 0 && buf.valid() && followed < followed_max; ++i) {
+        if (!bad[i]) continue;
+        ++followed;
+
+        const uint64_t block = unique[i].block;
+        checkSectors(block);
+
+        for (uint64_t b = block + 1; b < blocks && b <= block + follow_limit && !checkSectors(b); ++b) {}
+        for (uint64_t b = block; b-- > 0 && b + follow_limit >= block && !checkSectors(b); ) {}
+    }
+
+    if (fd >= 0) close(fd);
+
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) { return a.offset < b.offset; });
+
+    for (const auto &r : ranges) {
+        auto &out = res.mismatches;
+        if (!out.empty() && r.offset <= out.back().offset + out.back().length) {
+            out.back().length = std::max(out.back().length, r.offset + r.length - out.back().offset);
+        } else {
+            out.push_back(r);
+        }
+    }
+
+    if (res.random_bad > 0) {
+        res.max_unwiped = static_cast<double>(res.random_bad) / static_cast<double>(res.random_checked);
+    } else if (res.random_checked > 0) {
+        // P(no failing block in n draws | share p unwiped) = (1 - p)^n, solved for the p at which that drops to 1 - confidence
+        res.max_unwiped = 1.0 - std::pow(1.0 - sopts.confidence, 1.0 / static_cast<double>(res.random_checked));
+    } else {
+        res.max_unwiped = 1.0;
+    }
+
+    if (stride > 1) res.max_missed_run = (stride - 1) * DIRECT_ALIGN;
+
+    res.blocks = std::move(sampled);
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    res.success = res.blocks_bad == 0;
+
+    if (res.success) {
+        LOG_INFO("Sampled " + std::to_string(res.blocks_checked) + " blocks of " + target + ", all hold the wipe pattern");
+    } else {
+        LOG_ERROR("Sample verification of " + target + " failed: " + std::to_string(res.blocks_bad) + " of " + std::to_string(res.blocks_checked) + " blocks dont hold the wipe pattern");
+    }
+
+    return res;
+}
+
+void WipeEngine::printVerifyReport(const VerifyResult &res) {
+    if (!res.error.empty()) {
+        ERR(ErrorCode::IOError, res.error);
+        return;
+    }
+
+    if (res.success) {
+        std::cout << GREEN << "[VERIFIED] " << RESET << humanBytes(res.bytes_verified) << " read back, every block holds the wipe pattern\n";
+        return;
+    }
+
+    uint64_t bad_bytes = 0;
+    for (const auto &r : res.mismatches) bad_bytes += r.length;
+
+    std::cout << RED << "[VERIFY FAILED] " << RESET << res.mismatches.size() << " non-conforming range(s), " << humanBytes(bad_bytes) << " total:\n";
+
+    constexpr size_t max_lines = 50;
+
+    for (size_t i = 0; i < res.mismatches.size() && i < max_lines; ++i) {
+        const auto &r = res.mismatches[i];
+        std::cout << "  bytes " << r.offset << " - " << (r.offset + r.length - 1) << " (" << humanBytes(r.length) << ")\n";
+    }
+
+    if (res.mismatches.size() > max_lines) {
+        std::cout << "  ... and " << (res.mismatches.size() - max_lines) << " more\n";
+    }
+}
+
+void WipeEngine::printSampleReport(const SampleResult &res) {
+    if (!res.error.empty()) {
+        ERR(ErrorCode::IOError, res.error);
+        return;
+    }
+
+    const uint64_t size = res.blocks_checked * DIRECT_ALIGN;
+    char share[32];
+    snprintf(share, sizeof(share), "%.3f%%", res.max_unwiped * 100.0);
+
+    if (res.success) {
+        std::cout << GREEN << "[SAMPLED] " << RESET << res.blocks_checked << " blocks (" << humanBytes(size) << ") read in "
+                  << ProgressMeter::formatDuration(res.seconds) << ", every one holds the wipe pattern\n";
+
+        if (res.random_checked > 0) {
+            std::cout << "  with " << static_cast<int>(res.confidence * 100.0 + 0.5) << "% confidence less than " << share << " of the drive is unwiped\n";
+        }
+    } else {
+        std::cout << RED << "[SAMPLE CHECK FAILED] " << RESET << res.blocks_bad << " of " << res.blocks_checked << " sampled blocks dont hold the wipe pattern";
+        if (res.random_checked > 0) std::cout << " (about " << share << " of the drive)";
+        std::cout << "\n";
+    }
+
+    if (res.max_missed_run > 0) {
+        std::cout << "  every stride block was read, no unwiped run longer than " << humanBytes(res.max_missed_run) << " can have been missed\n";
+    }
+
+    if (res.mismatches.empty()) return;
+
+    std::cout << "  non-conforming ranges (around the failing samples):\n";
+
+    constexpr size_t max_lines = 20;
+
+    for (size_t i = 0; i < res.mismatches.size() && i < max_lines; ++i) {
+        const auto &r = res.mismatches[i];
+        std::cout << "    bytes " << r.offset << " - " << (r.offset + r.length - 1) << " (" << humanBytes(r.length) << ")\n";
+    }
+
+    if (res.mismatches.size() > max_lines) {
+        std::cout << "    ... and " << (res.mismatches.size() - max_lines) << " more\n";
+    }
+}
@@ -25,12 +25,15 @@ bool Globals::g_config_src_flag = false;
 
 std::string Globals::g_config_src_path;
 
+std::string Globals::g_io_qos_spec;
+
 
 // === program state globals ===
 
 bool Globals::g_dry_run = false;
 bool Globals::g_no_log = false;
 bool Globals::g_debug =  false;
+bool Globals::g_json = false;
 
 std::filesystem::path Globals::dmgr_root = EnvSys::appRoot();
 std::filesystem::path Globals::log_path = dmgr_root / "data" / "log.dat";
@@ -0,0 +1,184 @@
+#include "../ui/IoDashboard.hpp"
+#include "../ui/TerminalSize.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <poll.h>
+#include <thread>
+
+namespace {
+    volatile sig_atomic_t interrupted = 0;
+
+    void onSigint(int) {
+        interrupted = 1;
+    }
+
+    std::string fixed(double value, int width, int precision) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%*.*f", width, precision, value);
+        return buf;
+    }
+
+    /**
+     * @brief Rewrites the lines that differ from what is on screen, shown holds the screen afterwards
+     */
+    void render(const std::vector<std::string> &lines, std::vector<std::string> &shown) {
+        TermSize term_size;
+        const size_t width = std::max<size_t>(20, term_size.width());
+        std::string out;
+
+        for (size_t i = 0; i < lines.size(); ++i) {
+            // a wrapped line would shift every row below it
+            const std::string text = lines[i].size() > width ? lines[i].substr(0, width) : lines[i];
+            if (i < shown.size() && shown[i] == text) continue;
+
+            out += "\033[" + std::to_string(i + 1) + ";1H" + text + "\033[K";
+            if (i < shown.size()) shown[i] = text;
+            else shown.push_back(text);
+        }
+
+        if (lines.size() < shown.size()) {
+            out += "\033[" + std::to_string(lines.size() + 1) + ";1H\033[J";
+            shown.resize(lines.size());
+        }
+
+        if (!out.empty()) std::cout << out << std::flush;
+    }
+}
+
+std::string IoDashboard::header() {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%-14s%8s %8s%10s%10s%8s%8s%8s%8s%9s%9s%7s%7s",
+             "Device", "r/s", "w/s", "rkB/s", "wkB/s", "rrqm/s", "wrqm/s", "r_await", "w_await", "rareq-sz", "wareq-sz", "aqu-sz", "%util");
+    return buf;
+}
+
+std::string IoDashboard::formatRow(const IoRates &r) {
+    char name[20];
+    snprintf(name, sizeof(name), "%-14s", r.name.c_str());
+
+    return std::string(name)
+         + fixed(r.r_s, 8, 1) + " " + fixed(r.w_s, 8, 1)
+         + fixed(r.rkb_s, 10, 1) + fixed(r.wkb_s, 10, 1)
+         + fixed(r.rrqm_s, 8, 1) + fixed(r.wrqm_s, 8, 1)
+         + fixed(r.r_await, 8, 2) + fixed(r.w_await, 8, 2)
+         + fixed(r.rareq_sz, 9, 1) + fixed(r.wareq_sz, 9, 1)
+         + fixed(r.aqu_sz, 7, 2) + fixed(r.util, 7, 1);
+}
+
+bool IoDashboard::run(const Options &opts, std::string &err) {
+    using clock = std::chrono::steady_clock;
+
+    const bool tty = isatty(STDOUT_FILENO) && isatty(STDIN_FILENO);
+    unsigned interval_ms = std::max(100u, opts.interval_ms);
+    bool partitions = opts.partitions;
+    bool hide_idle = opts.hide_idle;
+
+    auto sampler = std::make_unique<IoStatSampler>(opts.devices, partitions);
+
+    if (!sampler->error().empty()) {
+        err = sampler->error();
+        return false;
+    }
+
+    auto prev = sampler->sample();
+    auto prev_time = clock::now();
+    auto next = prev_time + std::chrono::milliseconds(interval_ms);
+
+    // Ctrl-C leaves the loop, so the cursor and the terminal mode are restored
+    interrupted = 0;
+    struct sigaction sa{}, old_sa{};
+    sa.sa_handler = onSigint;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_sa);
+
+    std::vector<std::string> shown;
+
+    if (tty) {
+        term.initiateTerminosInput();
+        term.enableRawMode();
+        std::cout << "\033[?25l\033[2J" << std::flush;
+    }
+
+    unsigned intervals = 0;
+    bool quit = false;
+
+    while (!quit && !interrupted && (opts.count == 0 || intervals < opts.count)) {
+        const auto now = clock::now();
+
+        if (now < next) {
+            const int wait = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count()) + 1;
+
+            if (!tty) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+                continue;
+            }
+
+            pollfd pfd{STDIN_FILENO, POLLIN, 0};
+            if (poll(&pfd, 1, wait) <= 0) continue;
+
+            char c;
+            if (read(STDIN_FILENO, &c, 1) != 1) continue;
+
+            switch (c) {
+                case 'q': quit = true; break;
+                case '+': interval_ms = std::min(60000u, interval_ms * 2); break;
+                case '-': interval_ms = std::max(100u, interval_ms / 2); break;
+                case 'i': hide_idle = !hide_idle; break;
+                case 'p':
+                    // a new set of sources, rates start over with the next interval
+                    partitions = !partitions;
+                    sampler = std::make_unique<IoStatSampler>(opts.devices, partitions);
+                    prev = sampler->sample();
+                    prev_time = clock::now();
+                    break;
+                default: break;
+            }
+
+            next = prev_time + std::chrono::milliseconds(interval_ms);
+            continue;
+        }
+
+        auto cur = sampler->sample();
+        const auto cur_time = clock::now();
+        const double seconds = std::chrono::duration<double>(cur_time - prev_time).count();
+
+        const auto rates = IoStatSampler::rates(prev, cur, seconds);
+        prev = std::move(cur);
+        prev_time = cur_time;
+        next = cur_time + std::chrono::milliseconds(interval_ms);
+        ++intervals;
+
+        std::vector<std::string> lines;
+        lines.reserve(rates.size() + 2);
+
+        if (tty) {
+            lines.push_back("Live I/O, every " + fixed(interval_ms / 1000.0, 0, 1) + "s" + (partitions ? ", partitions" : "")
+                            + (hide_idle ? ", idle hidden" : "") + "   q quit  +/- interval  p partitions  i idle");
+        }
+
+        lines.push_back(header());
+
+        for (const auto &r : rates) {
+            if (hide_idle && r.idle()) continue;
+            lines.push_back(formatRow(r));
+        }
+
+        if (tty) {
+            render(lines, shown);
+        } else {
+            for (const auto &line : lines) std::cout << line << "\n";
+            std::cout << std::endl;
+        }
+    }
+
+    if (tty) {
+        std::cout << "\033[" << shown.size() + 1 << ";1H\033[?25h" << std::flush;
+        term.restoreTerminal();
+    }
+
+    sigaction(SIGINT, &old_sa, nullptr);
+    return true;
+}
@@ -1,77 +1,364 @@
 #include "../ui/ListDrivesUtil.hpp"
 
+#include "../ui/TerminalSize.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <poll.h>
+
 // ========== TUI drive selection/listing ==========
 
-std::string ListDrivesUtil::tuiForListDrives(const std::vector<std::string> &drives, std::vector<ListDrivesUtil::Row> &rows) {
+namespace {
+    /**
+     * @brief Reads the rest of an escape sequence if one follows within a moment, a lone Esc key returns 0
+     */
+    size_t readEscape(char* seq, size_t max) {
+        size_t n = 0;
+
+        while (n < max) {
+            pollfd pfd{STDIN_FILENO, POLLIN, 0};
+            if (poll(&pfd, 1, 30) <= 0 || read(STDIN_FILENO, seq + n, 1) != 1) break;
+
+            ++n;
+            // CSI sequences end with a letter or '~'
+            if (n > 1 && (std::isalpha(static_cast<unsigned char>(seq[n - 1])) || seq[n - 1] == '~')) break;
+        }
+
+        return n;
+    }
+}
+
+const std::string& ListDrivesUtil::deviceAt(size_t pos) {
+    return disk_lister.getCachedDisks().text(DriveTable::Column::Device, view[pos]);
+}
+
+size_t ListDrivesUtil::windowHeight() {
+    TermSize term_size;
+    const size_t height = term_size.height();
+
+    // header (4 lines), status line and a couple of lines for what was printed above
+    return height > 10 ? height - 8 : 2;
+}
+
+void ListDrivesUtil::printTuiLine(size_t pos, bool is_selected) {
+    const auto& table = disk_lister.getCachedDisks();
+    const uint32_t r = view[pos];
+
+    std::cout << "\r\033[K";
+
+    // Arrow indicator
+    if (is_selected) {
+        if (!Globals::g_no_color) std::cout << Globals::g_SELECTION_COLOR;
+        std::cout << "> ";
+        if (!Globals::g_no_color) std::cout << RESET;
+    } else {
+        std::cout << "  ";
+    }
+
+    // Highlight row
+    if (is_selected && !Globals::g_no_color) std::cout << Globals::g_SELECTION_COLOR;
+
+    std::cout << std::left
+        << std::setw(3)  << pos
+        << std::setw(16) << table.text(DriveTable::Column::Device, r)
+        << std::setw(10) << table.text(DriveTable::Column::Size, r)
+        << std::setw(10) << table.text(DriveTable::Column::Type, r)
+        << std::setw(15) << table.text(DriveTable::Column::Mount, r)
+        << std::setw(10) << table.text(DriveTable::Column::FsType, r)
+        << table.text(DriveTable::Column::Status, r);
+
+    if (is_selected && !Globals::g_no_color) std::cout << RESET;
+}
+
+void ListDrivesUtil::drawTuiRows(size_t selected) {
+    const size_t total = view.size();
+    const size_t height = windowHeight();
+
+    // scroll just far enough to keep the selection visible
+    if (selected < top) top = selected;
+    if (selected >= top + height) top = selected - height + 1;
+    if (top + height > total) top = total > height ? total - height : 0;
+
+    window = std::min(height, total - top);
+
+    // clear below, the list may have shrunk since the last draw
+    std::cout << "\r\033[J";
+
+    for (size_t i = 0; i < window; i++) {
+        printTuiLine(top + i, top + i == selected);
+        std::cout << "\n";
+    }
+
+    if (total == 0) {
+        std::cout << (filter.empty() ? "  (no drives, waiting for one to be plugged in)" : "  (no drive matches \"" + filter + "\")");
+    } else {
+        std::cout << "  " << top + 1 << "-" << top + window << " of " << total
+                  << "  sort: " << DriveTable::columnName(sort_key) << (descending ? " desc" : "")
+                  << (filter.empty() && !editing ? "" : "  filter: " + filter + (editing ? "_" : "")) << "  (/ filter, s sort, r reverse)" << change_note;
+    }
+
+    std::cout << "\n";
+
+    // Move cursor back up
+    std::cout << "\033[" << (window + 1) << "A" << std::flush;
+}
+
+void ListDrivesUtil::moveSelection(size_t from, size_t to) {
+    for (const auto& [pos, is_selected] : {std::pair<size_t, bool>{from, false}, {to, true}}) {
+        const size_t line = pos - top;
+
+        if (line > 0) std::cout << "\033[" << line << "B";
+        printTuiLine(pos, is_selected);
+        std::cout << "\r";
+        if (line > 0) std::cout << "\033[" << line << "A";
+    }
+
+    std::cout << std::flush;
+}
+
+std::string ListDrivesUtil::tuiForListDrives() {
     term.enableRawMode();
 
-    int selected = 0;
-    int total = drives.size();
+    size_t selected = 0;
+    editing = false;
+    top = 0;
 
-    // Move cursor UP to the first drive row
-    std::cout << "\033[" << total << "A";
+    drawTuiRows(selected);
 
-    while (true) {
-        std::cout << "\r"; // go to start of line
-        for (int i = 0; i < total; i++) {
-
-            // Arrow indicator
-            if (i == selected) { 
-                if (!Globals::g_no_color) std::cout << Globals::g_SELECTION_COLOR;
-                std::cout << "> ";
-                if (!Globals::g_no_color) std::cout << RESET;
-            } else { 
-                std::cout << "  "; 
+    // the view changed under the cursor: stay on the same drive if it is still listed
+    auto reselect = [&](const std::string& current) {
+        selected = 0;
+        for (size_t i = 0; i < view.size(); ++i) {
+            if (deviceAt(i) == current) {
+                selected = i;
+                break;
             }
+        }
+    };
 
-            // Highlight row
-            if (i == selected && !Globals::g_no_color) std::cout << Globals::g_SELECTION_COLOR;
+    auto applyView = [&] {
+        const std::string current = view.empty() ? "" : deviceAt(selected);
+        view = disk_lister.getCachedDisks().view(filter, sort_key, descending);
+        reselect(current);
+        drawTuiRows(selected);
+    };
 
-            std::cout << std::left
-                << std::setw(3)  << i
-                << std::setw(16) << rows[i].device
-                << std::setw(10) << rows[i].size
-                << std::setw(10) << rows[i].type
-                << std::setw(15) << rows[i].mount
-                << std::setw(10) << rows[i].fstype
-                << rows[i].status;
+    while (true) {
+        // stdin, the hotplug monitor and the cache revalidation, a drive plugged in meanwhile shows up right away
+        // (poll skips the fds that are -1)
+        pollfd fds[3] = {
+            {STDIN_FILENO, POLLIN, 0},
+            {hotplug.notifyFd(), POLLIN, 0},
+            {disk_lister.revalidationFd(), POLLIN, 0}
+        };
+
+        if (poll(fds, 3, -1) < 0) continue;
+
+        if (fds[2].revents & POLLIN) {
+            const std::string current = view.empty() ? "" : deviceAt(selected);
+
+            if (disk_lister.finishRevalidation(false)) {
+                rebuildRows();
+                reselect(current);
+                drawTuiRows(selected);
+            }
+        }
 
-            if (i == selected && !Globals::g_no_color) std::cout << RESET;
+        if (fds[1].revents & POLLIN) {
+            const std::string current = view.empty() ? "" : deviceAt(selected);
 
-            std::cout << "\n"; 
+            if (syncDrives()) {
+                reselect(current);
+                drawTuiRows(selected);
+            }
         }
 
-        // Move cursor back up
-        std::cout << "\033[" << total << "A";
+        if (!(fds[0].revents & POLLIN)) continue;
                     
         // Read key
         char c;
-            if (read(STDIN_FILENO, &c, 1) <= 0) continue;
+        if (read(STDIN_FILENO, &c, 1) <= 0) continue;
+
+        const size_t total = view.size();
 
         if (c == '\x1b') {
-            char seq[2];
+            char seq[4];
+            const size_t n = readEscape(seq, sizeof(seq));
+
+            if (n == 0) {
+                // a lone Esc drops the filter being typed
+                if (editing) {
+                    editing = false;
+                    filter.clear();
+                    applyView();
+                }
+                continue;
+            }
 
-            if (read(STDIN_FILENO, &seq, 2) == 2) {
-                if (seq[1] == 'A') selected = (selected - 1 + total) % total; // up
-                if (seq[1] == 'B') selected = (selected + 1) % total;         // down
+            if (total == 0 || seq[0] != '[' || n < 2) continue;
+
+            const size_t page = std::max<size_t>(1, window);
+            size_t next = selected;
+
+            switch (seq[1]) {
+                case 'A': next = (selected + total - 1) % total; break;                 // up
+                case 'B': next = (selected + 1) % total; break;                         // down
+                case 'H': next = 0; break;                                              // home
+                case 'F': next = total - 1; break;                                      // end
+                case '5': next = selected > page ? selected - page : 0; break;          // page up
+                case '6': next = std::min(total - 1, selected + page); break;           // page down
+                default: continue;
             }
 
-        } else if (c == '\n' || c == '\r') {
+            if (next >= top && next < top + window) {
+                moveSelection(selected, next);
+                selected = next;
+            } else {
+                selected = next;
+                drawTuiRows(selected);
+            }
+
+        } else if (editing) {
+            if (c == '\n' || c == '\r') {
+                editing = false;
+            } else if ((c == 127 || c == '\b') && !filter.empty()) {
+                filter.pop_back();
+            } else if (std::isprint(static_cast<unsigned char>(c))) {
+                filter += c;
+            }
+
+            applyView();
+
+        } else if (c == '/') {
+            editing = true;
+            drawTuiRows(selected);
+        } else if (c == 's') {
+            sort_key = static_cast<DriveTable::Column>((static_cast<int>(sort_key) + 1) % static_cast<int>(DriveTable::Column::Count));
+            applyView();
+        } else if (c == 'r') {
+            descending = !descending;
+            applyView();
+        } else if ((c == '\n' || c == '\r') && total > 0) {
             break; // Enter
         }
     }  
 
     // Move cursor down past the table so next output prints normally
-    int tableheight = total + 3;
-    std::cout << "\033[" << tableheight << "B" << std::flush;
+    std::cout << "\033[" << (window + 1) << "B" << std::flush;
     std::cout << "\n";
 
     term.restoreTerminal();
 
-    auto tui_selected_drive = drives[selected];
-    return tui_selected_drive;
+    return deviceAt(selected);
 }
 
+bool ListDrivesUtil::syncDrives() {
+    if (!scanned) {
+        // the inventory of the last run is listed at once, the revalidation corrects stale rows in place
+        if (disk_lister.loadCache()) disk_lister.startRevalidation();
+        else disk_lister.refresh();
+
+        scanned = true;
+
+        std::string err;
+        if (!hotplug.start(err)) LOG_WARNING("Hotplug monitor unavailable, drives are rescanned for every listing: " + err);
+
+        rebuildRows();
+        return true;
+    }
+
+    if (!hotplug.running()) {
+        disk_lister.refresh();
+        rebuildRows();
+        return true;
+    }
+
+    bool changed = disk_lister.finishRevalidation(false);
+
+    for (const auto &event : hotplug.drain()) {
+        switch (event.action) {
+            case HotplugMonitor::Event::Action::Resync:
+                disk_lister.refresh();
+                changed = true;
+                break;
+            case HotplugMonitor::Event::Action::Mounts:
+                changed |= disk_lister.refreshMounts();
+                break;
+            default:
+                changed |= disk_lister.updateDisk(event.disk);
+                break;
+        }
+    }
+
+    if (changed) {
+        rebuildRows();
+        disk_lister.saveCache();
+    }
+
+    return changed;
+}
+
+void ListDrivesUtil::rebuildRows() {
+    const auto& table = disk_lister.getCachedDisks();
+
+    drives.clear();
+    drives.reserve(table.size());
+    for (size_t i = 0; i < table.size(); ++i) drives.push_back(table.text(DriveTable::Column::Device, i));
+
+    view = table.view(filter, sort_key, descending);
+
+    std::string note;
+
+    // g_last_drives is empty before the first scan, nothing "came" then
+    if (!Globals::g_last_drives.empty()) {
+        // both sorted, a diff of thousands of drives stays linear
+        std::vector<std::string> last = Globals::g_last_drives, came, went;
+        std::sort(last.begin(), last.end());
+
+        std::set_difference(drives.begin(), drives.end(), last.begin(), last.end(), std::back_inserter(came));
+        std::set_difference(last.begin(), last.end(), drives.begin(), drives.end(), std::back_inserter(went));
+
+        for (const auto &d : came) note += "  + " + d;
+        for (const auto &d : went) note += "  - " + d;
+    }
+
+    if (!note.empty()) {
+        change_note = note;
+        LOG_INFO("Drive list changed:" + note);
+    }
+
+    Globals::g_last_drives = drives;
+}
+
+
+size_t ListDrivesUtil::writeDrivesJson(JsonWriter &out) {
+    using Column = DriveTable::Column;
+
+    // no hotplug monitor, nothing will be listed a second time
+    DiskLister lister;
+    if (lister.loadCache()) lister.startRevalidation();
+    else lister.refresh();
+    lister.finishRevalidation(true);
+
+    const auto& table = lister.getCachedDisks();
+
+    for (size_t pos = 0; pos < table.size(); pos++) {
+        out.beginObject()
+           .field("record", "drive")
+           .field("device", table.text(Column::Device, pos))
+           .field("size", table.text(Column::Size, pos))
+           .field("bytes", table.bytes(pos))
+           .field("type", table.text(Column::Type, pos))
+           .field("mount", table.text(Column::Mount, pos))
+           .field("fstype", table.text(Column::FsType, pos))
+           .field("status", table.text(Column::Status, pos))
+           .endObject().endRecord(false);
+    }
+
+    out.flush();
+    return table.size();
+}
 
 void ListDrivesUtil::printDriveRow(int idx, const Row& r) {
     std::cout << std::left
@@ -116,61 +403,32 @@ std::string ListDrivesUtil::listDrives(bool input_mode) {
         return Globals::g_selected_drive;
     }
 
-    static std::vector<std::string> drives;
-
-    if (drive_cache.run_count_idx > 0) {
-        printDriveHeader();
-
-        for (int i = 0; i < drive_cache.rows.size(); i++) {
-            printDriveRow(i, drive_cache.rows[i]);
-        }
-
-        if (!input_mode) return "";
+    syncDrives();
 
-        Globals::g_selected_drive = tuiForListDrives(drives, drive_cache.rows);
-        return Globals::g_selected_drive;
+    // every listing starts unfiltered, the sort order sticks
+    if (!filter.empty()) {
+        filter.clear();
+        view = disk_lister.getCachedDisks().view(filter, sort_key, descending);
     }
 
-    drives.clear();
-
-    // Use DiskLister to fetch drives
-    disk_lister.refresh();
-    auto disk_info_rows = disk_lister.getPhysicalDisksInfoAsRows();
-            
-    drive_cache.run_count_idx = 1;
-
     printDriveHeader();
 
-    // Convert DiskLister::Row to ListDrivesUtil::Row
-    int idx = 1;
-    for (const auto& disk_row : disk_info_rows) {
-        ListDrivesUtil::Row r;
-        r.device = disk_row.device;
-        r.size = disk_row.size;
-        r.type = disk_row.type;
-        r.mount = disk_row.mount;
-        r.fstype = disk_row.fstype;
-        r.status = disk_row.status;
-
-        printDriveRow(idx, r);
-
-        drives.push_back(r.device);
-        rows.push_back(r);
-        idx++;
-    }
+    if (input_mode != true) {
+        // a printed list cant be corrected afterwards, it waits for the revalidation
+        if (disk_lister.finishRevalidation(true)) rebuildRows();
 
-    if (drives.empty()) {
-        ERR(ErrorCode::DeviceNotFound, "No drives found");
-        LOG_ERROR("No drives found");
-        return "";
-    }
+        const auto& table = disk_lister.getCachedDisks();
+        for (size_t i = 0; i < view.size(); i++) printDriveRow(static_cast<int>(i) + 1, table.row(view[i]));
 
-    drive_cache.rows = rows;
+        if (view.empty()) {
+            ERR(ErrorCode::DeviceNotFound, "No drives found");
+            LOG_ERROR("No drives found");
+        }
 
-    if (input_mode != true) {
         return "";
     }
 
-    Globals::g_selected_drive = tuiForListDrives(drives, rows);
+    // only the visible window is drawn, thousands of LUNs dont scroll the terminal away
+    Globals::g_selected_drive = tuiForListDrives();
     return Globals::g_selected_drive;
-}       
\ No newline at end of file
+}
@@ -0,0 +1,131 @@
+#include "../include/ui/ProgressMeter.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+
+// ========== RateTracker ==========
+
+void ProgressMeter::RateTracker::update(uint64_t done) {
+    const auto now = std::chrono::steady_clock::now();
+    const double dt = std::chrono::duration<double>(now - last_time).count();
+
+    total_done = done;
+    last_seen = now;
+
+    // very short intervals only add noise
+    if (dt < 0.2) return;
+
+    const double instant = static_cast<double>(done - std::min(done, last_done)) / dt;
+
+    if (!have_rate) {
+        smoothed = instant;
+        have_rate = true;
+    } else {
+        // exponential moving average with a time constant of ~3 s, independent of the redraw interval
+        const double alpha = 1.0 - std::exp(-dt / 3.0);
+        smoothed += alpha * (instant - smoothed);
+    }
+
+    last_time = now;
+    last_done = done;
+}
+
+double ProgressMeter::RateTracker::average() const {
+    const double elapsed = std::chrono::duration<double>(last_seen - started).count();
+    return elapsed > 0.0 ? static_cast<double>(total_done) / elapsed : 0.0;
+}
+
+
+// ========== ProgressMeter ==========
+
+std::string ProgressMeter::formatDuration(double seconds) {
+    if (!std::isfinite(seconds) || seconds < 0) return "--:--:--";
+
+    const uint64_t s = static_cast<uint64_t>(seconds + 0.5);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%llu:%02llu:%02llu",
+        static_cast<unsigned long long>(s / 3600), static_cast<unsigned long long>((s / 60) % 60), static_cast<unsigned long long>(s % 60));
+    return buf;
+}
+
+std::string ProgressMeter::formatStats(uint64_t total, const RateTracker &rate) {
+    const uint64_t done = rate.done();
+    std::string out = BlockIOUtils::humanBytes(done);
+    char buf[96];
+
+    if (total > 0) {
+        snprintf(buf, sizeof(buf), " / %s (%.0f%%)", BlockIOUtils::humanBytes(total).c_str(), 100.0 * static_cast<double>(done) / static_cast<double>(total));
+        out += buf;
+    }
+
+    snprintf(buf, sizeof(buf), "  %.1f MB/s (avg %.1f MB/s)", rate.current() / 1e6, rate.average() / 1e6);
+    out += buf;
+
+    if (total > 0 && done < total) {
+        const double speed = rate.current() > 0 ? rate.current() : rate.average();
+        out += "  ETA " + (speed > 0 ? formatDuration(static_cast<double>(total - done) / speed) : formatDuration(-1));
+    }
+
+    return out;
+}
+
+ProgressMeter::ProgressMeter(std::string label, uint64_t total, std::chrono::milliseconds interval)
+    : label(std::move(label)), interval(interval), total_bytes(total) {}
+
+ProgressMeter::~ProgressMeter() {
+    finish();
+}
+
+void ProgressMeter::start() {
+    if (renderer.joinable()) return;
+    renderer = std::thread(&ProgressMeter::renderLoop, this);
+}
+
+void ProgressMeter::setStatus(const std::string &s) {
+    std::lock_guard<std::mutex> lock(mtx);
+    status = s;
+    dirty = true;
+    cv.notify_one();
+}
+
+void ProgressMeter::print(const std::string &line) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::cout << "\r\033[K" << line << "\n";
+    if (renderer.joinable() && !finished) render();
+}
+
+void ProgressMeter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (finished) return;
+        finished = true;
+        cv.notify_one();
+    }
+
+    if (renderer.joinable()) {
+        renderer.join();
+        std::cout << "\n" << std::flush;
+    }
+}
+
+void ProgressMeter::render() {
+    rate.update(done());
+
+    std::cout << "\r\033[K" << label << " " << formatStats(total_bytes.load(std::memory_order_relaxed), rate);
+    if (!status.empty()) std::cout << "  " << status;
+    std::cout << std::flush;
+}
+
+void ProgressMeter::renderLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        cv.wait_for(lock, interval, [&] { return finished || dirty; });
+        dirty = false;
+
+        render();
+        if (finished) return;
+    }
+}
@@ -0,0 +1,283 @@
+#include "../ui/SpaceBrowser.hpp"
+#include "../ui/TerminalSize.hpp"
+#include "../DmgrLib.h"
+#include "../utils/BlockIOUtils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <poll.h>
+
+namespace {
+    constexpr size_t BAR_WIDTH = 20;
+
+    /**
+     * @brief The second and third byte of an arrow key escape sequence, 0 for a lone Esc
+     */
+    char readArrow() {
+        char seq[2];
+
+        for (char &c : seq) {
+            pollfd pfd{STDIN_FILENO, POLLIN, 0};
+            if (poll(&pfd, 1, 30) <= 0 || read(STDIN_FILENO, &c, 1) != 1) return 0;
+        }
+
+        return seq[0] == '[' ? seq[1] : 0;
+    }
+
+    std::string summary(const SpaceTree &tree, uint32_t dir) {
+        const SpaceDir &d = tree.dirs[dir];
+        return tree.path(dir) + "  " + BlockIOUtils::humanBytes(d.bytes) + " in " + std::to_string(d.files) + " files, "
+             + std::to_string(d.dirs) + " directories" + (d.unreadable ? "  (not fully readable)" : "");
+    }
+
+    /**
+     * @param path of dir, the names below it are appended and taken off again
+     */
+    void writeLevel(JsonWriter &out, const SpaceTree &tree, uint32_t dir, size_t top, unsigned level, unsigned depth, std::string &path) {
+        const SpaceDir &d = tree.dirs[dir];
+
+        out.beginObject()
+           .field("record", "dir")
+           .field("path", path)
+           .field("level", level)
+           .field("bytes", d.bytes)
+           .field("apparent", d.apparent)
+           .field("files", d.files)
+           .field("dirs", d.dirs)
+           .field("own_bytes", d.own_bytes)
+           .field("own_files", d.own_files)
+           .field("unreadable", d.unreadable);
+
+        out.key("largest").beginArray();
+        for (size_t i = 0; i < d.largest.size() && i < top; ++i) {
+            out.beginObject().field("name", d.largest[i].name).field("bytes", d.largest[i].bytes).field("apparent", d.largest[i].apparent).endObject();
+        }
+        out.endArray().endObject().endRecord(false);
+
+        if (level >= depth) return;
+
+        for (size_t i = 0; i < d.children.size() && i < top; ++i) {
+            const size_t len = path.size();
+            if (path.empty() || path.back() != '/') path += '/';
+            path += tree.dirs[d.children[i]].name;
+
+            writeLevel(out, tree, d.children[i], top, level + 1, depth, path);
+            path.resize(len);
+        }
+    }
+
+    void printLevel(const SpaceTree &tree, uint32_t dir, size_t top, unsigned depth, const std::string &indent) {
+        const auto list = SpaceBrowser::entries(tree, dir);
+        const uint64_t total = tree.dirs[dir].bytes;
+
+        for (size_t i = 0; i < list.size() && i < top; ++i) {
+            std::cout << indent << SpaceBrowser::formatEntry(list[i], total) << "\n";
+            if (list[i].dir >= 0 && depth > 1) printLevel(tree, static_cast<uint32_t>(list[i].dir), top, depth - 1, indent + "    ");
+        }
+    }
+}
+
+std::vector<SpaceBrowser::Entry> SpaceBrowser::entries(const SpaceTree &tree, uint32_t dir) {
+    const SpaceDir &d = tree.dirs[dir];
+    std::vector<Entry> out;
+    out.reserve(d.children.size() + d.largest.size() + 1);
+
+    for (uint32_t c : d.children) out.push_back({tree.dirs[c].name, tree.dirs[c].bytes, c});
+
+    uint64_t listed = 0;
+    for (const auto &f : d.largest) {
+        out.push_back({f.name, f.bytes, -1});
+        listed += f.bytes;
+    }
+
+    if (d.own_bytes > listed && d.own_files > d.largest.size()) {
+        out.push_back({"<" + std::to_string(d.own_files - d.largest.size()) + " other files>", d.own_bytes - listed, -1});
+    }
+
+    std::stable_sort(out.begin(), out.end(), [](const Entry &a, const Entry &b) { return a.bytes > b.bytes; });
+    return out;
+}
+
+std::string SpaceBrowser::formatEntry(const Entry &entry, uint64_t parent_bytes) {
+    const double share = parent_bytes ? static_cast<double>(entry.bytes) / static_cast<double>(parent_bytes) : 0.0;
+    const size_t filled = std::min(BAR_WIDTH, static_cast<size_t>(share * BAR_WIDTH + 0.5));
+
+    char head[48];
+    snprintf(head, sizeof(head), "%10s %6.1f%%  ", BlockIOUtils::humanBytes(entry.bytes).c_str(), share * 100.0);
+
+    return std::string(head) + "[" + std::string(filled, '#') + std::string(BAR_WIDTH - filled, ' ') + "]  "
+         + entry.name + (entry.dir >= 0 ? "/" : "");
+}
+
+void SpaceBrowser::print(const SpaceTree &tree, size_t top, unsigned depth) {
+    if (tree.dirs.empty()) return;
+
+    std::cout << summary(tree, 0) << "\n";
+    printLevel(tree, 0, top, std::max(1u, depth), "");
+}
+
+void SpaceBrowser::writeJson(JsonWriter &out, const SpaceTree &tree, size_t top, unsigned depth) {
+    if (tree.dirs.empty()) return;
+
+    const SpaceDir &root = tree.dirs.front();
+
+    out.beginObject()
+       .field("record", "walk")
+       .field("root", tree.root)
+       .field("bytes", root.bytes)
+       .field("apparent", root.apparent)
+       .field("files", root.files)
+       .field("dirs", root.dirs)
+       .field("reused", tree.reused)
+       .field("hardlinks", tree.hardlinks)
+       .field("mountpoints", tree.mountpoints)
+       .field("errors", tree.errors)
+       .field("milliseconds", static_cast<uint64_t>(tree.seconds * 1000))
+       .endObject().endRecord(false);
+
+    std::string path = tree.root;
+    writeLevel(out, tree, 0, top, 0, depth, path);
+    out.flush();
+}
+
+void SpaceBrowser::browse(SpaceTree &tree, SpaceMonitor* monitor, const SpaceWalker::Options &opts) {
+    using clock = std::chrono::steady_clock;
+
+    if (tree.dirs.empty()) return;
+
+    struct Level {
+        uint32_t dir;
+        size_t selected;
+        size_t top;
+    };
+
+    std::vector<Level> stack{{0, 0, 0}};
+
+    // live updates: what changed since the last walk, and since when
+    std::unordered_set<uint64_t> dirty;
+    bool overflow = false;
+    bool pending = false;
+    clock::time_point first_event, last_event;
+    std::string status = monitor ? "  live" : "";
+
+    term.initiateTerminosInput();
+    term.enableRawMode();
+    std::cout << "\033[?25l";
+
+    while (true) {
+        Level &cur = stack.back();
+        const auto list = entries(tree, cur.dir);
+
+        TermSize term_size;
+        const size_t width = std::max<size_t>(40, term_size.width());
+        const size_t height = term_size.height() > 6 ? term_size.height() - 4 : 2;
+
+        if (cur.selected >= list.size()) cur.selected = list.empty() ? 0 : list.size() - 1;
+        if (cur.selected < cur.top) cur.top = cur.selected;
+        if (cur.selected >= cur.top + height) cur.top = cur.selected - height + 1;
+
+        std::string out = "\033[H\033[J" + summary(tree, cur.dir).substr(0, width) + "\n"
+                        + ("Enter/-> open  <-/Backspace up  q quit" + status).substr(0, width) + "\n\n";
+
+        for (size_t i = cur.top; i < list.size() && i < cur.top + height; ++i) {
+            const std::string line = (i == cur.selected ? "> " : "  ") + formatEntry(list[i], tree.dirs[cur.dir].bytes);
+            out += (i == cur.selected && !Globals::g_no_color ? Globals::g_SELECTION_COLOR : "") + line.substr(0, width)
+                 + (i == cur.selected && !Globals::g_no_color ? std::string(RESET) : "") + "\n";
+        }
+
+        if (list.empty()) out += "  (empty)\n";
+        std::cout << out << std::flush;
+
+        // wait for a key, events, or the end of a burst of events
+        int timeout = -1;
+        if (pending) {
+            const auto now = clock::now();
+            const auto quiet = last_event + std::chrono::milliseconds(500);
+            const auto latest = first_event + std::chrono::seconds(2);
+            timeout = static_cast<int>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(std::min(quiet, latest) - now).count()));
+        }
+
+        pollfd fds[2] = {
+            {STDIN_FILENO, POLLIN, 0},
+            {monitor ? monitor->fd() : -1, POLLIN, 0}
+        };
+
+        if (poll(fds, 2, timeout) < 0) continue;
+
+        if (fds[1].revents & POLLIN) {
+            overflow |= !monitor->drain(dirty);
+            last_event = clock::now();
+            if (!pending) first_event = last_event;
+            pending = true;
+        }
+
+        if (pending && !(fds[0].revents & POLLIN)) {
+            const auto now = clock::now();
+            if (now < last_event + std::chrono::milliseconds(500) && now < first_event + std::chrono::seconds(2)) continue;
+
+            // walk again; after an overflow nothing of the old tree can be trusted
+            std::vector<std::string> names;
+            for (size_t i = 1; i < stack.size(); ++i) names.push_back(tree.dirs[stack[i].dir].name);
+
+            SpaceWalker::Options live = opts;
+            live.previous = overflow ? nullptr : &tree;
+            live.dirty = &dirty;
+
+            SpaceTree fresh;
+            std::string err;
+
+            if (SpaceWalker::walk(tree.root, live, fresh, err)) {
+                const size_t listed = fresh.dirs.size() - fresh.reused;
+                tree = std::move(fresh);
+
+                // back to the same path, as far as it still exists
+                stack.resize(1);
+                for (const auto &name : names) {
+                    const auto &children = tree.dirs[stack.back().dir].children;
+                    const auto it = std::find_if(children.begin(), children.end(), [&](uint32_t c) { return tree.dirs[c].name == name; });
+                    if (it == children.end()) break;
+                    stack.push_back({*it, 0, 0});
+                }
+
+                char when[16];
+                const std::time_t t = std::time(nullptr);
+                std::strftime(when, sizeof(when), "%H:%M:%S", std::localtime(&t));
+                status = "  live, updated " + std::string(when) + " (" + std::to_string(listed) + " directories listed)";
+            } else {
+                status = "  live, " + err;
+            }
+
+            dirty.clear();
+            overflow = false;
+            pending = false;
+            continue;
+        }
+
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        char c;
+        if (read(STDIN_FILENO, &c, 1) != 1) continue;
+
+        char key = c;
+        if (c == '\x1b') {
+            const char arrow = readArrow();
+            if (arrow == 0) break;
+            key = arrow == 'A' ? 'k' : arrow == 'B' ? 'j' : arrow == 'C' ? 'l' : arrow == 'D' ? 'h' : 0;
+        }
+
+        if (key == 'q') break;
+
+        if (key == 'k' && cur.selected > 0) cur.selected--;
+        else if (key == 'j' && cur.selected + 1 < list.size()) cur.selected++;
+        else if ((key == 'l' || key == '\r' || key == '\n') && !list.empty() && list[cur.selected].dir >= 0) {
+            stack.push_back({static_cast<uint32_t>(list[cur.selected].dir), 0, 0});
+        } else if ((key == 'h' || key == 127 || key == '\b') && stack.size() > 1) {
+            stack.pop_back();
+        }
+    }
+
+    std::cout << "\033[H\033[J\033[?25h" << std::flush;
+    term.restoreTerminal();
+}
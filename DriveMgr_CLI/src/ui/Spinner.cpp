@@ -1,25 +1,40 @@
 #include "../include/ui/Spinner.hpp"
+#include "../include/ui/ProgressMeter.hpp"
 
 
 std::array<std::string, 4> SimpleSpinner::frames = {"|", "/", "—", "\\"};
 int SimpleSpinner::idx = 0;
 
-void SimpleSpinner::tick() {
-    std::cout << "\r" << frames[idx++ % 4] << " Running..." << std::flush;
-    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+std::mutex SimpleSpinner::mtx;
+std::condition_variable SimpleSpinner::cv;
+
+void SimpleSpinner::tick(std::chrono::steady_clock::duration elapsed) {
+    std::cout << "\r" << frames[idx++ % 4] << " Running... " << ProgressMeter::formatDuration(std::chrono::duration<double>(elapsed).count()) << std::flush;
 }
 
 void SimpleSpinner::done() {
-    std::cout << GREEN << "\r✓ " << RESET << "Done       \n" << std::flush;
+    std::cout << GREEN << "\r✓ " << RESET << "Done                \n" << std::flush;
 }
 
 void SimpleSpinner::progressSpinner(std::atomic<bool> &b_done) {
+    const auto started = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mtx);
+
     while (!b_done) {
         
-        tick();
+        tick(std::chrono::steady_clock::now() - started);
+        cv.wait_for(lock, std::chrono::milliseconds(300), [&] { return b_done.load(); });
 
     }
 
     done();
     return;
-}
\ No newline at end of file
+}
+
+void SimpleSpinner::stop(std::atomic<bool> &b_done) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        b_done = true;
+    }
+    cv.notify_all();
+}
@@ -0,0 +1,172 @@
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+BlockIOUtils::AlignedBuffer::AlignedBuffer(size_t size) {
+    void* p = nullptr;
+
+    if (size > 0 && posix_memalign(&p, DIRECT_ALIGN, roundUp(size, DIRECT_ALIGN)) == 0) {
+        buf = static_cast<unsigned char*>(p);
+        len = size;
+    }
+}
+
+BlockIOUtils::AlignedBuffer::~AlignedBuffer() {
+    free(buf);
+}
+
+ssize_t BlockIOUtils::preadFull(int fd, unsigned char* buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t r = pread(fd, buf + done, len - done, static_cast<off_t>(offset + done));
+
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            // O_DIRECT reports the unaligned remainder after a short read at EOF as EINVAL
+            if (done > 0) break;
+            return -1;
+        }
+
+        if (r == 0) break; // EOF
+
+        done += static_cast<size_t>(r);
+    }
+
+    return static_cast<ssize_t>(done);
+}
+
+ssize_t BlockIOUtils::readFull(int fd, unsigned char* buf, size_t len) {
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t r = read(fd, buf + done, len - done);
+
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        if (r == 0) break; // EOF
+
+        done += static_cast<size_t>(r);
+    }
+
+    return static_cast<ssize_t>(done);
+}
+
+bool BlockIOUtils::pwriteFull(int fd, const unsigned char* buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t w = pwrite(fd, buf + done, len - done, static_cast<off_t>(offset + done));
+
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        if (w == 0) {
+            errno = ENOSPC;
+            return false;
+        }
+
+        done += static_cast<size_t>(w);
+    }
+
+    return true;
+}
+
+uint64_t BlockIOUtils::sizeOfFd(int fd) {
+    struct stat st{};
+    if (fstat(fd, &st) != 0) return 0;
+
+    if (S_ISBLK(st.st_mode)) {
+        uint64_t bytes = 0;
+        if (ioctl(fd, BLKGETSIZE64, &bytes) != 0) return 0;
+        return bytes;
+    }
+
+    return S_ISREG(st.st_mode) ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+uint64_t BlockIOUtils::sizeOfPath(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    const uint64_t size = sizeOfFd(fd);
+    close(fd);
+    return size;
+}
+
+int BlockIOUtils::openDirectRead(const std::string &path, bool &is_direct) {
+    is_direct = true;
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+
+    if (fd >= 0 || errno != EINVAL) return fd;
+
+    // tmpfs and a few fuse filesystems dont support O_DIRECT
+    is_direct = false;
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd >= 0) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    return fd;
+}
+
+bool BlockIOUtils::replaceFile(const std::string &path, const std::string &data) {
+    const std::string tmp = path + ".tmp";
+    const int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    const bool ok = pwriteFull(fd, reinterpret_cast<const unsigned char*>(data.data()), data.size(), 0) && fsync(fd) == 0;
+    close(fd);
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) return false;
+
+    const int dir_fd = open(std::filesystem::path(path).parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+    return true;
+}
+
+std::string BlockIOUtils::toHex(const unsigned char* data, size_t len) {
+    static const char* digits = "0123456789abcdef";
+    std::string out;
+    out.reserve(len * 2);
+
+    for (size_t i = 0; i < len; ++i) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0xF];
+    }
+
+    return out;
+}
+
+std::string BlockIOUtils::humanBytes(uint64_t bytes) {
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB"};
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+
+    while (value >= 1024.0 && unit < 5) {
+        value /= 1024.0;
+        ++unit;
+    }
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+    return buf;
+}
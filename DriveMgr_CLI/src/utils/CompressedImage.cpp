@@ -0,0 +1,214 @@
+#include "../include/utils/CompressedImage.hpp"
+#include "../include/utils/BlockIOUtils.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+namespace {
+    bool inPath(const std::string &tool) {
+        const char* path = getenv("PATH");
+        std::istringstream iss(path ? path : "/usr/bin:/bin");
+        std::string dir;
+
+        while (std::getline(iss, dir, ':')) {
+            if (!dir.empty() && access((dir + "/" + tool).c_str(), X_OK) == 0) return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief posix_spawnp with stdout and stderr redirected into pipes
+     * @returns 0 or the errno of the failed step
+     */
+    int spawnPiped(const std::vector<std::string> &args, CompressedImage::Decompressor &dec) {
+        int out[2], errp[2];
+
+        if (pipe2(out, O_CLOEXEC) != 0) return errno;
+
+        if (pipe2(errp, O_CLOEXEC) != 0) {
+            const int e = errno;
+            close(out[0]);
+            close(out[1]);
+            return e;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, errp[1], STDERR_FILENO);
+
+        std::vector<char*> argv;
+        for (const auto &a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+
+        pid_t pid = -1;
+        const int rc = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+
+        close(out[1]);
+        close(errp[1]);
+
+        if (rc != 0) {
+            close(out[0]);
+            close(errp[0]);
+            return rc;
+        }
+
+        dec.pid = pid;
+        dec.fd = out[0];
+        dec.err_fd = errp[0];
+
+        for (const auto &a : args) dec.tool += (dec.tool.empty() ? "" : " ") + a;
+
+        return 0;
+    }
+
+    std::string readAll(int fd) {
+        std::string out;
+        char buf[4096];
+        ssize_t n;
+
+        while ((n = read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+            if (n > 0) out.append(buf, static_cast<size_t>(n));
+        }
+
+        return out;
+    }
+}
+
+CompressedImage::Format CompressedImage::detect(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return Format::None;
+
+    unsigned char magic[6] = {};
+    const ssize_t n = BlockIOUtils::preadFull(fd, magic, sizeof(magic), 0);
+    close(fd);
+
+    if (n >= 6 && std::memcmp(magic, "\xFD" "7zXZ\0", 6) == 0) return Format::Xz;
+    if (n >= 2 && magic[0] == 0x1F && magic[1] == 0x8B) return Format::Gzip;
+    if (n >= 4 && std::memcmp(magic, "\x28\xB5\x2F\xFD", 4) == 0) return Format::Zstd;
+
+    return Format::None;
+}
+
+std::string CompressedImage::formatName(Format format) {
+    switch (format) {
+        case Format::Xz: return "xz";
+        case Format::Gzip: return "gzip";
+        case Format::Zstd: return "zstd";
+        default: return "uncompressed";
+    }
+}
+
+bool CompressedImage::toolAvailable(Format format) {
+    switch (format) {
+        case Format::Xz: return inPath("xz");
+        case Format::Gzip: return inPath("pigz") || inPath("gzip");
+        case Format::Zstd: return inPath("zstd");
+        default: return true;
+    }
+}
+
+std::optional<CompressedImage::Decompressor> CompressedImage::spawn(const std::string &path, Format format, std::string &err) {
+    std::vector<std::vector<std::string>> candidates;
+
+    switch (format) {
+        case Format::Xz: candidates = {{"xz", "-dc", "-T0", "--", path}}; break;
+        case Format::Gzip: candidates = {{"pigz", "-dc", "--", path}, {"gzip", "-dc", "--", path}}; break;
+        case Format::Zstd: candidates = {{"zstd", "-dcq", "--", path}}; break;
+        default:
+            err = path + " is not compressed";
+            return std::nullopt;
+    }
+
+    for (const auto &args : candidates) {
+        Decompressor dec;
+        const int rc = spawnPiped(args, dec);
+
+        if (rc == 0) return dec;
+
+        err = "Cannot start " + args[0] + ": " + strerror(rc);
+        if (rc != ENOENT) break;
+    }
+
+    if (!toolAvailable(format)) err = formatName(format) + " images need the " + (format == Format::Gzip ? "pigz or gzip" : formatName(format)) + " tool, which is not installed";
+
+    return std::nullopt;
+}
+
+bool CompressedImage::finish(Decompressor &dec, bool consumed, std::string &err) {
+    if (dec.fd >= 0) close(dec.fd);
+    dec.fd = -1;
+
+    // stopped early on purpose, make sure a child blocked on a full pipe doesnt linger
+    if (!consumed && dec.pid > 0) kill(dec.pid, SIGTERM);
+
+    // drained before waiting, a tool that fills the stderr pipe would otherwise never exit
+    const std::string messages = dec.err_fd >= 0 ? readAll(dec.err_fd) : "";
+    if (dec.err_fd >= 0) close(dec.err_fd);
+    dec.err_fd = -1;
+
+    int status = 0;
+    while (dec.pid > 0 && waitpid(dec.pid, &status, 0) < 0 && errno == EINTR) {}
+
+    if (dec.pid <= 0 || !consumed) {
+        dec.pid = -1;
+        return true;
+    }
+
+    dec.pid = -1;
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return true;
+
+    err = dec.tool + (WIFEXITED(status) ? " exited with status " + std::to_string(WEXITSTATUS(status)) : " was killed by signal " + std::to_string(WTERMSIG(status)));
+
+    std::string first_line = messages.substr(0, messages.find('\n'));
+    if (!first_line.empty()) err += ": " + first_line;
+
+    return false;
+}
+
+uint64_t CompressedImage::decompressedSize(const std::string &path, Format format) {
+    // gzip only keeps the size modulo 4 GiB and zstd frames may omit it, only the xz index is exact
+    if (format != Format::Xz) return 0;
+
+    Decompressor lister;
+    if (spawnPiped({"xz", "--robot", "--list", "--", path}, lister) != 0) return 0;
+
+    const std::string out = readAll(lister.fd);
+    std::string ignored;
+    if (!finish(lister, true, ignored)) return 0;
+
+    // "totals <streams> <blocks> <compressed> <uncompressed> ..." tab separated
+    std::istringstream lines(out);
+    std::string line;
+
+    while (std::getline(lines, line)) {
+        if (line.rfind("totals\t", 0) != 0) continue;
+
+        std::istringstream fields(line);
+        std::string field;
+
+        for (int i = 0; i < 5 && std::getline(fields, field, '\t'); ++i) {}
+
+        try {
+            return std::stoull(field);
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+
+    return 0;
+}
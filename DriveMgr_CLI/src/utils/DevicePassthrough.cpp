@@ -0,0 +1,237 @@
+#include "../include/utils/DevicePassthrough.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/nvme_ioctl.h>
+#include <scsi/sg.h>
+#include <sstream>
+#include <sys/ioctl.h>
+
+namespace {
+    constexpr unsigned char SCSI_INQUIRY = 0x12;
+    constexpr unsigned char ATA_PASS_THROUGH_16 = 0x85;
+    constexpr unsigned char ATA_PROTO_NON_DATA = 3;
+    constexpr unsigned char ATA_PROTO_PIO_IN = 4;
+    constexpr uint8_t ATA_STATUS_ERR = 0x01;
+    constexpr uint8_t ATA_ERROR_ABRT = 0x04;
+    constexpr unsigned SG_DRIVER_TIMEOUT = 0x06;
+
+    std::string hex(unsigned value) {
+        std::ostringstream oss;
+        oss << "0x" << std::hex << value;
+        return oss.str();
+    }
+
+    /**
+     * @brief Reads the ATA Status Return descriptor (SAT, code 0x09) out of descriptor format sense data
+     * @returns false if the sense data carries no such descriptor
+     */
+    bool parseAtaReturn(const unsigned char* sense, size_t len, DevicePassthrough::AtaRegisters &regs) {
+        if (len < 8 || (sense[0] & 0x7F) < 0x72) return false;
+
+        const size_t end = std::min<size_t>(len, 8 + sense[7]);
+
+        for (size_t i = 8; i + 2 <= end; i += 2 + sense[i + 1]) {
+            const unsigned char* d = sense + i;
+            if (d[0] != 0x09 || i + 14 > end) continue;
+
+            // byte pairs alternate between the previous (high) and current (low) register contents
+            regs.error = d[3];
+            regs.count = static_cast<uint16_t>((d[4] << 8) | d[5]);
+            regs.lba = static_cast<uint64_t>(d[7]) | static_cast<uint64_t>(d[9]) << 8 | static_cast<uint64_t>(d[11]) << 16
+                     | static_cast<uint64_t>(d[6]) << 24 | static_cast<uint64_t>(d[8]) << 32 | static_cast<uint64_t>(d[10]) << 40;
+            regs.device = d[12];
+            regs.status = d[13];
+            return true;
+        }
+
+        return false;
+    }
+}
+
+DevicePassthrough::Status DevicePassthrough::ataCommand(int fd, AtaRegisters &regs, unsigned char* buf, size_t len, unsigned timeout_ms, std::string &err) {
+    const bool data_in = buf && len > 0;
+
+    unsigned char cdb[16] = {};
+    unsigned char sense[64] = {};
+
+    cdb[0] = ATA_PASS_THROUGH_16;
+    cdb[1] = static_cast<unsigned char>(((data_in ? ATA_PROTO_PIO_IN : ATA_PROTO_NON_DATA) << 1) | (regs.ext ? 1 : 0));
+    // data-in: T_DIR=in, BYT_BLOK=blocks, T_LENGTH=count field. non-data: CK_COND so the registers come back
+    cdb[2] = data_in ? 0x0E : 0x20;
+    cdb[3] = static_cast<unsigned char>(regs.features >> 8);
+    cdb[4] = static_cast<unsigned char>(regs.features);
+    cdb[5] = static_cast<unsigned char>(regs.count >> 8);
+    cdb[6] = static_cast<unsigned char>(regs.count);
+    cdb[7] = static_cast<unsigned char>(regs.lba >> 24);
+    cdb[8] = static_cast<unsigned char>(regs.lba);
+    cdb[9] = static_cast<unsigned char>(regs.lba >> 32);
+    cdb[10] = static_cast<unsigned char>(regs.lba >> 8);
+    cdb[11] = static_cast<unsigned char>(regs.lba >> 40);
+    cdb[12] = static_cast<unsigned char>(regs.lba >> 16);
+    cdb[13] = regs.device;
+    cdb[14] = regs.command;
+
+    sg_io_hdr_t io{};
+    io.interface_id = 'S';
+    io.cmd_len = sizeof(cdb);
+    io.cmdp = cdb;
+    io.mx_sb_len = sizeof(sense);
+    io.sbp = sense;
+    io.dxfer_direction = data_in ? SG_DXFER_FROM_DEV : SG_DXFER_NONE;
+    io.dxferp = data_in ? buf : nullptr;
+    io.dxfer_len = static_cast<unsigned>(data_in ? len : 0);
+    io.timeout = timeout_ms;
+
+    if (ioctl(fd, SG_IO, &io) < 0) {
+        const int e = errno;
+        err = std::string("SG_IO failed: ") + strerror(e);
+        return e == ENOTTY || e == EINVAL ? Status::Unsupported : Status::Failed;
+    }
+
+    const bool have_regs = parseAtaReturn(sense, io.sb_len_wr, regs);
+
+    if (have_regs && (regs.status & ATA_STATUS_ERR)) {
+        err = "ATA command " + hex(regs.command) + " failed, status " + hex(regs.status) + " error " + hex(regs.error);
+        return (regs.error & ATA_ERROR_ABRT) ? Status::Unsupported : Status::Failed;
+    }
+
+    if (io.host_status != 0 || (io.driver_status & 0x0F) == SG_DRIVER_TIMEOUT) {
+        err = "ATA command " + hex(regs.command) + " did not complete (host status " + hex(io.host_status) + ")";
+        return Status::Failed;
+    }
+
+    // with CK_COND a CHECK CONDITION carrying the registers is the normal outcome
+    if (io.status != 0 && !have_regs) {
+        const unsigned key = io.sb_len_wr > 2 ? ((sense[0] & 0x7F) >= 0x72 ? sense[1] : sense[2]) & 0x0F : 0;
+        err = "ATA command " + hex(regs.command) + " rejected, sense key " + hex(key);
+        // ILLEGAL REQUEST: the bridge doesnt translate ATA passthrough
+        return key == 0x05 ? Status::Unsupported : Status::Failed;
+    }
+
+    return Status::Ok;
+}
+
+DevicePassthrough::Status DevicePassthrough::ataIdentify(int fd, std::array<uint16_t, 256> &words, std::string &err) {
+    unsigned char raw[512] = {};
+
+    AtaRegisters regs;
+    regs.count = 1;
+    regs.command = 0xEC;
+
+    const Status st = ataCommand(fd, regs, raw, sizeof(raw), 10000, err);
+    if (st != Status::Ok) return st;
+
+    for (size_t i = 0; i < words.size(); ++i) words[i] = static_cast<uint16_t>(raw[2 * i] | (raw[2 * i + 1] << 8));
+
+    // a bridge without ATA passthrough may "succeed" without filling the buffer
+    if (words[0] == 0 && words[1] == 0 && words[49] == 0) {
+        err = "IDENTIFY DEVICE returned no data";
+        return Status::Unsupported;
+    }
+
+    return Status::Ok;
+}
+
+DevicePassthrough::Status DevicePassthrough::scsiInquiry(int fd, bool evpd, uint8_t page, unsigned char* buf, uint16_t len, std::string &err) {
+    unsigned char cdb[6] = {};
+    unsigned char sense[32] = {};
+
+    cdb[0] = SCSI_INQUIRY;
+    cdb[1] = evpd ? 1 : 0;
+    cdb[2] = evpd ? page : 0;
+    cdb[3] = static_cast<unsigned char>(len >> 8);
+    cdb[4] = static_cast<unsigned char>(len);
+
+    sg_io_hdr_t io{};
+    io.interface_id = 'S';
+    io.cmd_len = sizeof(cdb);
+    io.cmdp = cdb;
+    io.mx_sb_len = sizeof(sense);
+    io.sbp = sense;
+    io.dxfer_direction = SG_DXFER_FROM_DEV;
+    io.dxferp = buf;
+    io.dxfer_len = len;
+    io.timeout = 5000;
+
+    if (ioctl(fd, SG_IO, &io) < 0) {
+        const int e = errno;
+        err = std::string("SG_IO failed: ") + strerror(e);
+        // virtio, loop, dm and partitions have no SCSI layer behind them
+        return e == ENOTTY || e == EINVAL ? Status::Unsupported : Status::Failed;
+    }
+
+    if (io.host_status != 0 || (io.driver_status & 0x0F) == SG_DRIVER_TIMEOUT) {
+        err = "INQUIRY did not complete (host status " + hex(io.host_status) + ")";
+        return Status::Failed;
+    }
+
+    if (io.status != 0) {
+        const unsigned key = io.sb_len_wr > 2 ? ((sense[0] & 0x7F) >= 0x72 ? sense[1] : sense[2]) & 0x0F : 0;
+        err = "INQUIRY" + (evpd ? " page " + hex(page) : std::string()) + " rejected, sense key " + hex(key);
+        // ILLEGAL REQUEST: the page isnt implemented
+        return key == 0x05 ? Status::Unsupported : Status::Failed;
+    }
+
+    return Status::Ok;
+}
+
+DevicePassthrough::Status DevicePassthrough::nvmeAdmin(int fd, NvmeCommand &cmd, std::string &err) {
+    nvme_admin_cmd raw{};
+    raw.opcode = cmd.opcode;
+    raw.nsid = cmd.nsid;
+    raw.cdw10 = cmd.cdw10;
+    raw.cdw11 = cmd.cdw11;
+    raw.addr = reinterpret_cast<uintptr_t>(cmd.data);
+    raw.data_len = cmd.data_len;
+    raw.timeout_ms = cmd.timeout_ms;
+
+    const int rc = ioctl(fd, NVME_IOCTL_ADMIN_CMD, &raw);
+
+    if (rc < 0) {
+        const int e = errno;
+        err = std::string("NVMe admin command failed: ") + strerror(e);
+        return e == ENOTTY || e == EINVAL ? Status::Unsupported : Status::Failed;
+    }
+
+    cmd.result = raw.result;
+    if (rc == 0) return Status::Ok;
+
+    // status field without the phase bit: SC in bits 7:0, SCT in bits 10:8
+    const unsigned sc = rc & 0xFF;
+    const unsigned sct = (rc >> 8) & 0x7;
+
+    err = "NVMe admin command " + hex(cmd.opcode) + " failed, status " + hex(static_cast<unsigned>(rc));
+
+    // generic: invalid command opcode / invalid field in command
+    return sct == 0 && (sc == 0x01 || sc == 0x02) ? Status::Unsupported : Status::Failed;
+}
+
+DevicePassthrough::Status DevicePassthrough::nvmeIdentify(int fd, uint32_t cns, uint32_t nsid, std::array<unsigned char, 4096> &out, std::string &err) {
+    NvmeCommand cmd;
+    cmd.opcode = 0x06;
+    cmd.nsid = nsid;
+    cmd.cdw10 = cns;
+    cmd.data = out.data();
+    cmd.data_len = static_cast<uint32_t>(out.size());
+
+    return nvmeAdmin(fd, cmd, err);
+}
+
+DevicePassthrough::Status DevicePassthrough::nvmeLogPage(int fd, uint8_t lid, uint32_t nsid, unsigned char* buf, uint32_t len, std::string &err) {
+    NvmeCommand cmd;
+    cmd.opcode = 0x02;
+    cmd.nsid = nsid;
+    cmd.cdw10 = lid | (((len / 4) - 1) & 0xFFFF) << 16;
+    cmd.data = buf;
+    cmd.data_len = len;
+
+    return nvmeAdmin(fd, cmd, err);
+}
+
+std::optional<uint32_t> DevicePassthrough::nvmeNamespaceId(int fd) {
+    const int id = ioctl(fd, NVME_IOCTL_ID);
+    if (id <= 0) return std::nullopt;
+    return static_cast<uint32_t>(id);
+}
@@ -0,0 +1,208 @@
+#include "../include/utils/HotplugMonitor.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    constexpr unsigned UEVENT_KERNEL_GROUP = 1;
+    constexpr int UEVENT_RCVBUF = 1024 * 1024;
+
+    std::string baseName(const std::string &path) {
+        const size_t slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    /** @brief adds one to an eventfd counter */
+    void bump(int fd) {
+        const uint64_t one = 1;
+        const ssize_t rc = write(fd, &one, sizeof(one));
+        (void)rc;
+    }
+
+    void closeFd(int &fd) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+}
+
+HotplugMonitor::~HotplugMonitor() {
+    stop();
+}
+
+bool HotplugMonitor::start(std::string &err) {
+    if (running()) return true;
+
+    sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+
+    if (sock < 0) {
+        err = std::string("uevent socket: ") + strerror(errno);
+        return false;
+    }
+
+    // a burst (a hub with a dozen drives) must not overrun the socket, FORCE only works as root
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &UEVENT_RCVBUF, sizeof(UEVENT_RCVBUF)) != 0) {
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &UEVENT_RCVBUF, sizeof(UEVENT_RCVBUF));
+    }
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = UEVENT_KERNEL_GROUP;
+
+    if (bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        err = std::string("uevent bind: ") + strerror(errno);
+        closeFd(sock);
+        return false;
+    }
+
+    notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (notify_fd < 0 || stop_fd < 0) {
+        err = std::string("eventfd: ") + strerror(errno);
+        closeFd(sock);
+        closeFd(notify_fd);
+        closeFd(stop_fd);
+        return false;
+    }
+
+    // mountinfo signals POLLPRI when the mount table changes, without it only the mount column goes stale
+    mounts_fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+
+    listener = std::thread(&HotplugMonitor::listen, this);
+    return true;
+}
+
+void HotplugMonitor::stop() {
+    if (!running()) return;
+
+    bump(stop_fd);
+    listener.join();
+
+    closeFd(sock);
+    closeFd(mounts_fd);
+    closeFd(notify_fd);
+    closeFd(stop_fd);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    queue.clear();
+}
+
+std::vector<HotplugMonitor::Event> HotplugMonitor::drain() {
+    // reset the counter before taking the queue, an event pushed in between keeps the fd readable
+    uint64_t count;
+    if (notify_fd >= 0) {
+        const ssize_t rc = read(notify_fd, &count, sizeof(count));
+        (void)rc;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<Event> out;
+    out.swap(queue);
+    return out;
+}
+
+std::optional<HotplugMonitor::Event> HotplugMonitor::parse(const char* msg, size_t len) {
+    // the header ("action@devpath") is followed by NUL separated KEY=VALUE pairs
+    const char* end = msg + len;
+    const char* p = msg;
+
+    const char* header_end = static_cast<const char*>(memchr(p, '\0', len));
+    if (!header_end || !memchr(p, '@', header_end - p)) return std::nullopt;
+    p = header_end + 1;
+
+    Event event;
+    std::string action, subsystem;
+
+    while (p < end) {
+        const size_t n = strnlen(p, end - p);
+        const std::string kv(p, n);
+        p += n + 1;
+
+        const size_t eq = kv.find('=');
+        if (eq == std::string::npos) continue;
+
+        const std::string key = kv.substr(0, eq);
+        const std::string value = kv.substr(eq + 1);
+
+        if (key == "ACTION") action = value;
+        else if (key == "SUBSYSTEM") subsystem = value;
+        else if (key == "DEVNAME") event.name = baseName(value);
+        else if (key == "DEVTYPE") event.devtype = value;
+        else if (key == "DEVPATH") event.devpath = value;
+    }
+
+    if (subsystem != "block" || event.devpath.empty()) return std::nullopt;
+
+    if (event.name.empty()) event.name = baseName(event.devpath);
+
+    if (event.devtype == "partition") {
+        const size_t slash = event.devpath.rfind('/');
+        event.disk = baseName(event.devpath.substr(0, slash));
+    } else {
+        event.disk = event.name;
+    }
+
+    if (action == "add") event.action = Event::Action::Add;
+    else if (action == "remove") event.action = Event::Action::Remove;
+    else if (action == "change") event.action = Event::Action::Change;
+    else if (action == "move") event.action = Event::Action::Resync;
+    else return std::nullopt;   // bind, online, ... dont change what the list shows
+
+    return event;
+}
+
+void HotplugMonitor::push(Event event) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back(std::move(event));
+    }
+
+    bump(notify_fd);
+}
+
+void HotplugMonitor::listen() {
+    char buf[8192];
+
+    while (true) {
+        pollfd fds[3] = {
+            {stop_fd, POLLIN, 0},
+            {sock, POLLIN, 0},
+            {mounts_fd, POLLPRI, 0}
+        };
+
+        if (poll(fds, mounts_fd >= 0 ? 3 : 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        if (fds[0].revents) return;
+
+        if (mounts_fd >= 0 && (fds[2].revents & (POLLPRI | POLLERR))) {
+            // poll() itself re-arms the mount table event
+            push({Event::Action::Mounts, "", "", "", ""});
+        }
+
+        if (!(fds[1].revents & POLLIN)) continue;
+
+        sockaddr_nl sender{};
+        socklen_t sender_len = sizeof(sender);
+        const ssize_t n = recvfrom(sock, buf, sizeof(buf) - 1, MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&sender), &sender_len);
+
+        if (n < 0) {
+            if (errno == ENOBUFS) push({Event::Action::Resync, "", "", "", ""});
+            continue;
+        }
+
+        // only the kernel speaks on this group, anything else is forged
+        if (sender.nl_pid != 0) continue;
+
+        buf[n] = '\0';
+        if (auto event = parse(buf, static_cast<size_t>(n))) push(std::move(*event));
+    }
+}
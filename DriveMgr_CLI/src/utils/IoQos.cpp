@@ -0,0 +1,417 @@
+#include "../include/utils/IoQos.hpp"
+#include "../include/DmgrLib.h"
+#include "../include/cmd_exec/exec_cmd.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    // from linux/ioprio.h, which older kernel headers dont ship
+    constexpr int IOPRIO_CLASS_SHIFT = 13;
+    constexpr int IOPRIO_CLASS_BE = 2;
+    constexpr int IOPRIO_CLASS_IDLE = 3;
+    constexpr int IOPRIO_WHO_PROCESS = 1;
+
+    const std::filesystem::path CGROUP_ROOT = "/sys/fs/cgroup";
+
+    std::mutex state_mtx;
+    std::map<IoQos::Operation, IoQosPolicy> policies;
+    std::optional<IoQosPolicy> active_policy;   ///< policy of the live Scope
+
+    /** @brief who = 0 means the calling thread, every thread has its own io context */
+    int getIoprio() {
+        return static_cast<int>(syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0));
+    }
+
+    bool setIoprio(int value) {
+        return syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value) == 0;
+    }
+
+    int ioprioValue(const IoQosPolicy &p) {
+        switch (p.io_class) {
+            case IoQosPolicy::Class::Idle: return IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+            case IoQosPolicy::Class::BestEffort: return (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | p.level;
+            default: return 0;
+        }
+    }
+
+    bool writeFile(const std::filesystem::path &path, const std::string &value) {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << value;
+        out.flush();
+        return static_cast<bool>(out);
+    }
+
+    std::string readFirstLine(const std::filesystem::path &path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    /**
+     * @brief "MAJ:MIN" of the whole disk path lives on (the device itself, or the disk under a file)
+     */
+    std::optional<std::string> wholeDiskOf(const std::string &path) {
+        struct stat st{};
+        if (stat(path.c_str(), &st) != 0) return std::nullopt;
+
+        const dev_t dev = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+        if (major(dev) == 0) return std::nullopt; // tmpfs, overlay, ...
+
+        std::filesystem::path sys = "/sys/dev/block/" + std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+        std::error_code ec;
+
+        // io.max only accepts whole disks, a partition's parent directory in sysfs is its disk
+        if (std::filesystem::exists(sys / "partition", ec)) {
+            const auto disk = std::filesystem::canonical(sys, ec).parent_path();
+            const std::string disk_dev = readFirstLine(disk / "dev");
+            if (!ec && !disk_dev.empty()) return disk_dev;
+        }
+
+        return std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+    }
+
+    /**
+     * @brief cgroup v2 directory of this process, empty if cgroup v2 isnt in use
+     */
+    std::filesystem::path ownCgroupDir() {
+        std::ifstream in("/proc/self/cgroup");
+        std::string line;
+
+        while (std::getline(in, line)) {
+            if (line.rfind("0::", 0) == 0) return CGROUP_ROOT / line.substr(3).erase(0, line[3] == '/' ? 1 : 0);
+        }
+
+        return {};
+    }
+
+    bool parseRate(const std::string &value, uint64_t &out) {
+        if (value.empty()) return false;
+        if (value == "max") { out = 0; return true; }
+
+        size_t idx = 0;
+        unsigned long long n = 0;
+
+        try {
+            n = std::stoull(value, &idx);
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        const std::string suffix = value.substr(idx);
+        unsigned shift = 0;
+
+        if (suffix.empty()) shift = 0;
+        else if (suffix == "k" || suffix == "K") shift = 10;
+        else if (suffix == "m" || suffix == "M") shift = 20;
+        else if (suffix == "g" || suffix == "G") shift = 30;
+        else if (suffix == "t" || suffix == "T") shift = 40;
+        else return false;
+
+        if (n > (UINT64_MAX >> shift)) return false;
+
+        out = static_cast<uint64_t>(n) << shift;
+        return true;
+    }
+
+    std::string ioMaxValue(uint64_t v) {
+        return v == 0 ? "max" : std::to_string(v);
+    }
+
+    /**
+     * @brief Asks systemd for a transient scope unit holding this process, the limits become its IO*Max properties
+     * @param disks "MAJ:MIN" of every whole disk to limit
+     */
+    bool startTransientScope(const std::string &unit, const std::vector<std::string> &disks, const IoQosPolicy &pol) {
+        const std::pair<const char*, uint64_t> limits[] = {
+            {"IOReadBandwidthMax", pol.rbps}, {"IOWriteBandwidthMax", pol.wbps},
+            {"IOReadIOPSMax", pol.riops}, {"IOWriteIOPSMax", pol.wiops}
+        };
+
+        std::string props = " PIDs au 1 " + std::to_string(getpid());
+        unsigned count = 1;
+
+        for (const auto &[name, value] : limits) {
+            if (value == 0) continue;
+
+            props += std::string(" ") + name + " 'a(st)' " + std::to_string(disks.size());
+            for (const auto &disk : disks) props += " /dev/block/" + disk + " " + std::to_string(value);
+            ++count;
+        }
+
+        const auto res = EXEC_QUIET("busctl call --quiet org.freedesktop.systemd1 /org/freedesktop/systemd1 org.freedesktop.systemd1.Manager"
+            " StartTransientUnit 'ssa(sv)a(sa(sv))' " + unit + " fail " + std::to_string(count) + props + " 0 2>&1");
+
+        if (!res.success) {
+            LOG_WARNING("systemd refused the scope " + unit + ": " + res.output);
+            return false;
+        }
+
+        return true;
+    }
+}
+
+std::optional<IoQosPolicy> IoQos::parse(const std::string &spec, std::string &err) {
+    IoQosPolicy p;
+    // StrUtils throws on empty strings, an empty spec simply means "normal"
+    if (spec.find_first_not_of(" \t") == std::string::npos) return p;
+
+    std::istringstream iss(StrUtils::toLowerString(spec));
+    std::string part;
+    bool first = true;
+
+    while (std::getline(iss, part, ',')) {
+        if (part.find_first_not_of(" \t") == std::string::npos) continue;
+
+        part = StrUtils::trimWhiteSpace(part);
+        const size_t eq = part.find('=');
+
+        if (first && eq == std::string::npos) {
+            first = false;
+
+            std::string cls = part;
+            const size_t colon = part.find(':');
+
+            if (colon != std::string::npos) {
+                cls = part.substr(0, colon);
+
+                try {
+                    p.level = std::stoi(part.substr(colon + 1));
+                } catch (const std::exception&) {
+                    err = "Invalid I/O priority level in: " + part;
+                    return std::nullopt;
+                }
+
+                if (p.level < 0 || p.level > 7) {
+                    err = "I/O priority level must be 0-7: " + part;
+                    return std::nullopt;
+                }
+            }
+
+            if (cls == "normal" || cls.empty()) p.io_class = IoQosPolicy::Class::Normal;
+            else if (cls == "best-effort" || cls == "be") p.io_class = IoQosPolicy::Class::BestEffort;
+            else if (cls == "idle") p.io_class = IoQosPolicy::Class::Idle;
+            else {
+                err = "Unknown I/O class: " + cls + " (expected normal, best-effort or idle)";
+                return std::nullopt;
+            }
+
+            continue;
+        }
+
+        first = false;
+
+        if (eq == std::string::npos) {
+            err = "Expected key=value in: " + part;
+            return std::nullopt;
+        }
+
+        const std::string key = part.substr(0, eq);
+        uint64_t *target = key == "rbps" ? &p.rbps : key == "wbps" ? &p.wbps : key == "riops" ? &p.riops : key == "wiops" ? &p.wiops : nullptr;
+
+        if (!target) {
+            err = "Unknown I/O limit: " + key + " (expected rbps, wbps, riops or wiops)";
+            return std::nullopt;
+        }
+
+        if (!parseRate(part.substr(eq + 1), *target)) {
+            err = "Invalid value for " + key + ": " + part.substr(eq + 1);
+            return std::nullopt;
+        }
+    }
+
+    return p;
+}
+
+std::string IoQos::describe(const IoQosPolicy &p) {
+    std::string out = p.io_class == IoQosPolicy::Class::Idle ? "idle"
+        : p.io_class == IoQosPolicy::Class::BestEffort ? "best-effort:" + std::to_string(p.level) : "normal";
+
+    if (p.rbps) out += ",rbps=" + std::to_string(p.rbps);
+    if (p.wbps) out += ",wbps=" + std::to_string(p.wbps);
+    if (p.riops) out += ",riops=" + std::to_string(p.riops);
+    if (p.wiops) out += ",wiops=" + std::to_string(p.wiops);
+
+    return out;
+}
+
+void IoQos::setPolicy(Operation op, const IoQosPolicy &policy) {
+    std::lock_guard<std::mutex> lock(state_mtx);
+    policies[op] = policy;
+}
+
+IoQosPolicy IoQos::policy(Operation op) {
+    std::lock_guard<std::mutex> lock(state_mtx);
+    auto it = policies.find(op);
+    return it != policies.end() ? it->second : IoQosPolicy{};
+}
+
+void IoQos::enterThread() {
+    std::optional<IoQosPolicy> p;
+
+    {
+        std::lock_guard<std::mutex> lock(state_mtx);
+        p = active_policy;
+    }
+
+    if (p && p->io_class != IoQosPolicy::Class::Normal && !setIoprio(ioprioValue(*p))) {
+        LOG_WARNING(std::string("ioprio_set failed: ") + strerror(errno));
+    }
+}
+
+IoQos::Scope::Scope(Operation op, const std::vector<std::string> &paths) : pol(IoQos::policy(op)) {
+    if (Globals::g_dry_run || !pol.active()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(state_mtx);
+
+        // nested operations (e.g. a rescue retry inside a clone) keep the outer scope
+        if (active_policy) return;
+        active_policy = pol;
+    }
+
+    active = true;
+
+    if (pol.io_class != IoQosPolicy::Class::Normal) {
+        saved_ioprio = getIoprio();
+        IoQos::enterThread();
+    }
+
+    if (pol.limited()) setupCgroup(paths);
+
+    LOG_INFO("I/O QoS " + describe(pol) + (cgroup_dir.empty() ? "" : " in cgroup " + cgroup_dir));
+}
+
+void IoQos::Scope::setupCgroup(const std::vector<std::string> &paths) {
+    std::error_code ec;
+
+    if (!std::filesystem::exists(CGROUP_ROOT / "cgroup.controllers", ec)) {
+        LOG_WARNING("cgroup v2 is not mounted, I/O limits are not applied");
+        return;
+    }
+
+    const std::string controllers = readFirstLine(CGROUP_ROOT / "cgroup.controllers");
+
+    if (controllers.find("io") == std::string::npos) {
+        LOG_WARNING("The cgroup io controller is not available, I/O limits are not applied");
+        return;
+    }
+
+    std::vector<std::string> disks;
+
+    for (const auto &path : paths) {
+        const auto disk = wholeDiskOf(path);
+        if (disk && std::find(disks.begin(), disks.end(), *disk) == disks.end()) disks.push_back(*disk);
+    }
+
+    const std::filesystem::path original = ownCgroupDir();
+
+    if (disks.empty() || original.empty()) {
+        LOG_WARNING("No disk to limit found for this operation, I/O limits are not applied");
+        return;
+    }
+
+    // under systemd the process has to stay in a unit it knows about, a transient scope carries the limits
+    if (std::filesystem::exists("/run/systemd/system", ec)) {
+        const std::string unit = "dmgr-" + std::to_string(getpid()) + ".scope";
+        if (!startTransientScope(unit, disks, pol)) return;
+
+        // the job that moves us runs asynchronously
+        for (int i = 0; i < 50 && ownCgroupDir() == original; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        if (ownCgroupDir() == original) {
+            LOG_WARNING("systemd did not move the process into " + unit + ", I/O limits are not applied");
+            return;
+        }
+
+        cgroup_dir = ownCgroupDir().string();
+        original_cgroup_dir = original.string();
+        scope_unit = unit;
+        return;
+    }
+
+    // without systemd a child of our own cgroup only works from the root, any other cgroup that
+    // holds processes cannot enable controllers for its children (no internal processes rule)
+    if (original != CGROUP_ROOT) {
+        LOG_WARNING("I/O limits need systemd or a process in the root cgroup, not applied from " + original.string());
+        return;
+    }
+
+    if (readFirstLine(CGROUP_ROOT / "cgroup.subtree_control").find("io") == std::string::npos) {
+        enabled_root_io = writeFile(CGROUP_ROOT / "cgroup.subtree_control", "+io");
+    }
+
+    const std::filesystem::path dir = CGROUP_ROOT / ("dmgr." + std::to_string(getpid()));
+
+    if (!std::filesystem::create_directory(dir, ec) && ec) {
+        LOG_WARNING("Cannot create cgroup " + dir.string() + ": " + ec.message() + ", I/O limits are not applied");
+        restoreRootController();
+        return;
+    }
+
+    bool limited_any = false;
+
+    for (const auto &disk : disks) {
+        const std::string line = disk + " rbps=" + ioMaxValue(pol.rbps) + " wbps=" + ioMaxValue(pol.wbps)
+            + " riops=" + ioMaxValue(pol.riops) + " wiops=" + ioMaxValue(pol.wiops);
+
+        if (writeFile(dir / "io.max", line)) {
+            limited_any = true;
+        } else {
+            LOG_WARNING("Cannot set io.max \"" + line + "\"");
+        }
+    }
+
+    if (!limited_any || !writeFile(dir / "cgroup.procs", std::to_string(getpid()))) {
+        LOG_WARNING("I/O limits could not be applied to " + dir.string());
+        std::filesystem::remove(dir, ec);
+        restoreRootController();
+        return;
+    }
+
+    cgroup_dir = dir.string();
+    original_cgroup_dir = original.string();
+}
+
+void IoQos::Scope::restoreRootController() {
+    if (!enabled_root_io) return;
+
+    // another cgroup may have started using it meanwhile, then it simply stays enabled
+    if (!writeFile(CGROUP_ROOT / "cgroup.subtree_control", "-io")) LOG_WARNING("Cannot disable the io controller of the root cgroup again");
+    enabled_root_io = false;
+}
+
+IoQos::Scope::~Scope() {
+    if (!active) return;
+
+    if (!cgroup_dir.empty()) {
+        if (!writeFile(std::filesystem::path(original_cgroup_dir) / "cgroup.procs", std::to_string(getpid()))) {
+            LOG_WARNING("Cannot move back to cgroup " + original_cgroup_dir + ", the I/O limits stay until exit");
+        } else if (scope_unit.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(cgroup_dir, ec);
+            if (ec) LOG_WARNING("Cannot remove cgroup " + cgroup_dir + ": " + ec.message());
+        }
+        // an empty transient scope is stopped and collected by systemd on its own
+    }
+
+    restoreRootController();
+
+    if (saved_ioprio >= 0) setIoprio(saved_ioprio);
+
+    std::lock_guard<std::mutex> lock(state_mtx);
+    active_policy.reset();
+}
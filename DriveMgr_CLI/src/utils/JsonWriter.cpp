@@ -0,0 +1,167 @@
+#include "../include/utils/JsonWriter.hpp"
+
+#include <charconv>
+
+namespace {
+    /**
+     * @brief Length of the well-formed UTF-8 sequence starting at s[i], 0 if there is none
+     */
+    size_t utf8Length(std::string_view s, size_t i) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        const size_t len = c >= 0xf0 && c <= 0xf4 ? 4 : c >= 0xe0 && c <= 0xef ? 3 : c >= 0xc2 && c <= 0xdf ? 2 : 0;
+        if (len == 0 || i + len > s.size()) return 0;
+
+        for (size_t k = 1; k < len; ++k) {
+            if ((static_cast<unsigned char>(s[i + k]) & 0xc0) != 0x80) return 0;
+        }
+
+        // overlong forms, surrogates and code points past U+10FFFF
+        const unsigned char c1 = static_cast<unsigned char>(s[i + 1]);
+        if (c == 0xe0 && c1 < 0xa0) return 0;
+        if (c == 0xed && c1 >= 0xa0) return 0;
+        if (c == 0xf0 && c1 < 0x90) return 0;
+        if (c == 0xf4 && c1 >= 0x90) return 0;
+
+        return len;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    out.put('{');
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    first.pop_back();
+    out.put('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    out.put('[');
+    first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    first.pop_back();
+    out.put(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    string(name);
+    out.put(':');
+    after_key = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view s) {
+    separate();
+    string(s);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+    separate();
+    out.write(b ? "true" : "false", b ? 4 : 5);
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out.write("null", 4);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(std::string_view name, const std::vector<std::string> &v) {
+    key(name);
+    beginArray();
+    for (const auto &s : v) value(s);
+    return endArray();
+}
+
+void JsonWriter::endRecord(bool flush) {
+    out.put('\n');
+    if (flush) out.flush();
+}
+
+void JsonWriter::separate() {
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+
+    if (first.empty()) return;
+
+    if (!first.back()) out.put(',');
+    first.back() = false;
+}
+
+void JsonWriter::string(std::string_view s) {
+    static const char HEX[] = "0123456789abcdef";
+
+    out.put('"');
+
+    // runs without anything to escape are written in one piece
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+
+        if (c >= 0x80) {
+            // file names and serials are bytes, JSON is UTF-8: what doesnt decode becomes U+FFFD
+            const size_t len = utf8Length(s, i);
+            if (len > 0) {
+                i += len - 1;
+                continue;
+            }
+
+            out.write(s.data() + run, static_cast<std::streamsize>(i - run));
+            out.write("\\ufffd", 6);
+            run = i + 1;
+            continue;
+        }
+
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out.write(s.data() + run, static_cast<std::streamsize>(i - run));
+        run = i + 1;
+
+        switch (c) {
+            case '"':  out.write("\\\"", 2); break;
+            case '\\': out.write("\\\\", 2); break;
+            case '\n': out.write("\\n", 2); break;
+            case '\r': out.write("\\r", 2); break;
+            case '\t': out.write("\\t", 2); break;
+            default: {
+                const char esc[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xf]};
+                out.write(esc, sizeof(esc));
+            }
+        }
+    }
+
+    out.write(s.data() + run, static_cast<std::streamsize>(s.size() - run));
+    out.put('"');
+}
+
+JsonWriter& JsonWriter::integer(int64_t n) {
+    separate();
+
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), n);
+    out.write(buf, res.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(uint64_t n) {
+    separate();
+
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), n);
+    out.write(buf, res.ptr - buf);
+    return *this;
+}
@@ -0,0 +1,106 @@
+#include "../include/utils/SpaceMonitor.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/fanotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr uint64_t EVENTS = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_MODIFY | FAN_ONDIR;
+}
+
+SpaceMonitor::~SpaceMonitor() {
+    stop();
+}
+
+bool SpaceMonitor::start(const std::string &root, std::string &err) {
+    stop();
+
+    fan_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DIR_FID, O_RDONLY | O_CLOEXEC);
+
+    if (fan_fd < 0) {
+        err = "fanotify_init failed: " + std::string(strerror(errno));
+        return false;
+    }
+
+    if (fanotify_mark(fan_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, EVENTS, AT_FDCWD, root.c_str()) != 0) {
+        err = "fanotify_mark(" + root + ") failed: " + std::string(strerror(errno));
+        stop();
+        return false;
+    }
+
+    root_fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (root_fd < 0) {
+        err = "Cant open " + root + ": " + std::string(strerror(errno));
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+void SpaceMonitor::stop() {
+    if (fan_fd >= 0) close(fan_fd);
+    if (root_fd >= 0) close(root_fd);
+
+    fan_fd = -1;
+    root_fd = -1;
+    handle_ino.clear();
+}
+
+bool SpaceMonitor::drain(std::unordered_set<uint64_t> &dirty) {
+    if (fan_fd < 0) return true;
+
+    alignas(fanotify_event_metadata) char buf[16384];
+    bool complete = true;
+
+    while (true) {
+        ssize_t len = read(fan_fd, buf, sizeof(buf));
+        if (len <= 0) break;
+
+        for (auto* ev = reinterpret_cast<fanotify_event_metadata*>(buf); FAN_EVENT_OK(ev, len); ev = FAN_EVENT_NEXT(ev, len)) {
+            if (ev->mask & FAN_Q_OVERFLOW) {
+                complete = false;
+                continue;
+            }
+
+            // fid reporting groups get no fds, only the info records after the metadata
+            for (size_t off = ev->metadata_len; off + sizeof(fanotify_event_info_header) <= ev->event_len; ) {
+                const auto* hdr = reinterpret_cast<const fanotify_event_info_header*>(reinterpret_cast<const char*>(ev) + off);
+                if (hdr->len == 0) break;
+                off += hdr->len;
+
+                // without FAN_REPORT_FID every handle is a directory, a modified file comes as a plain FID record of its parent
+                if (hdr->info_type != FAN_EVENT_INFO_TYPE_FID && hdr->info_type != FAN_EVENT_INFO_TYPE_DFID
+                    && hdr->info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) continue;
+
+                const auto* info = reinterpret_cast<const fanotify_event_info_fid*>(hdr);
+                auto* handle = reinterpret_cast<file_handle*>(const_cast<unsigned char*>(info->handle));
+                const std::string key(reinterpret_cast<const char*>(handle), sizeof(file_handle) + handle->handle_bytes);
+
+                const auto known = handle_ino.find(key);
+                if (known != handle_ino.end()) {
+                    dirty.insert(known->second);
+                    continue;
+                }
+
+                // a directory that is gone by now needs no update, its parent got an event too
+                const int dir_fd = open_by_handle_at(root_fd, handle, O_PATH | O_CLOEXEC);
+                if (dir_fd < 0) continue;
+
+                struct stat st{};
+                if (fstat(dir_fd, &st) == 0) {
+                    handle_ino.emplace(key, st.st_ino);
+                    dirty.insert(st.st_ino);
+                }
+
+                close(dir_fd);
+            }
+        }
+    }
+
+    return complete;
+}
@@ -0,0 +1,22 @@
+#include "../include/utils/StringPool.hpp"
+
+StringPool::StringPool() {
+    clear();
+}
+
+StringPool::Id StringPool::intern(std::string_view s) {
+    const auto it = index.find(s);
+    if (it != index.end()) return it->second;
+
+    const Id id = static_cast<Id>(strings.size());
+    strings.emplace_back(s);
+    index.emplace(strings.back(), id);
+    return id;
+}
+
+void StringPool::clear() {
+    index.clear();
+    strings.clear();
+    strings.emplace_back();
+    index.emplace(strings.back(), EMPTY);
+}